@@ -13,8 +13,15 @@
 #include "computation_kernels/second_order_computation_kernel.h"
 #include "computation_kernels/staggered_computation_kernel.h"
 #include "correlation_kernels/cross_correlation_kernel.h"
+#include "correlation_kernels/excitation_correlation_kernel.h"
+#include "correlation_kernels/frequency_correlation_kernel.h"
+#include "forward_collectors/checkpoint_propagation.h"
+#include "forward_collectors/excitation_propagation.h"
+#include "forward_collectors/frequency_propagation.h"
 #include "forward_collectors/reverse_injection_propagation.h"
 #include "forward_collectors/reverse_propagation.h"
+#include "forward_collectors/staggered_excitation_propagation.h"
+#include "forward_collectors/staggered_frequency_propagation.h"
 #include "forward_collectors/staggered_reverse_injection_propagation.h"
 #include "forward_collectors/staggered_reverse_propagation.h"
 #include "forward_collectors/staggered_two_propagation.h"
@@ -42,6 +42,7 @@ CPMLBoundaryManager ::CPMLBoundaryManager(bool use_top_layer,
   this->parameters = nullptr;
   this->grid = nullptr;
   this->max_vel = 0;
+  this->active_box = nullptr;
 }
 
 void CPMLBoundaryManager::InitializeVariables() {
@@ -312,9 +313,24 @@ void CPMLBoundaryManager::CalculateFirstAuxilary() {
     distance[i] = distance_unit * i;
   }
 
-  for (iy = y_start; iy < nyEnd; iy++) {
-    for (iz = z_start; iz < nzEnd; iz++) {
-      for (ix = x_start; ix < nxEnd; ix++) {
+  // Skip the points out of the active box, the wavefields are zero there.
+  int x_first = x_start, x_last = nxEnd;
+  int z_first = z_start, z_last = nzEnd;
+  int y_first = y_start, y_last = nyEnd;
+  if (this->active_box != nullptr) {
+    x_first = std::max(x_first, (int)this->active_box->start.x);
+    x_last = std::min(x_last, (int)this->active_box->end.x);
+    z_first = std::max(z_first, (int)this->active_box->start.z);
+    z_last = std::min(z_last, (int)this->active_box->end.z);
+    if (ny > 1) {
+      y_first = std::max(y_first, (int)this->active_box->start.y);
+      y_last = std::min(y_last, (int)this->active_box->end.y);
+    }
+  }
+
+  for (iy = y_first; iy < y_last; iy++) {
+    for (iz = z_first; iz < z_last; iz++) {
+      for (ix = x_first; ix < x_last; ix++) {
         int offset = iy * wnxnz + iz * wnx;
         float *curr = curr_base + offset;
         float value = 0.0;
@@ -522,9 +538,24 @@ void CPMLBoundaryManager::CalculateCpmlValue() {
     coeff_h[i] = this->parameters->second_derivative_fd_coeff[i] / dh2;
   }
 
-  for (iy = y_start; iy < nyEnd; iy++) {
-    for (iz = z_start; iz < nzEnd; iz++) {
-      for (ix = x_start; ix < nxEnd; ix++) {
+  // Skip the points out of the active box, the wavefields are zero there.
+  int x_first = x_start, x_last = nxEnd;
+  int z_first = z_start, z_last = nzEnd;
+  int y_first = y_start, y_last = nyEnd;
+  if (this->active_box != nullptr) {
+    x_first = std::max(x_first, (int)this->active_box->start.x);
+    x_last = std::min(x_last, (int)this->active_box->end.x);
+    z_first = std::max(z_first, (int)this->active_box->start.z);
+    z_last = std::min(z_last, (int)this->active_box->end.z);
+    if (ny > 1) {
+      y_first = std::max(y_first, (int)this->active_box->start.y);
+      y_last = std::min(y_last, (int)this->active_box->end.y);
+    }
+  }
+
+  for (iy = y_first; iy < y_last; iy++) {
+    for (iz = z_first; iz < z_last; iz++) {
+      for (ix = x_first; ix < x_last; ix++) {
         int offset = iy * wnxnz + iz * wnx;
         float *curr = curr_base + offset;
         float *vel = vel_base + iy * nxnz + iz * nx;
@@ -787,7 +818,62 @@ template <int half_length> void CPMLBoundaryManager::ApplyAllCpml() {
   }
 }
 
+void CPMLBoundaryManager::SetActiveBox(const ActiveBox *box) {
+  this->active_box = box;
+}
+
 void CPMLBoundaryManager::AdjustModelForBackward() {
   this->extension->AdjustPropertyForBackward();
   this->ResetVariables();
 }
+
+bool CPMLBoundaryManager::AltersModel() {
+  return this->extension->AltersTopLayer();
+}
+
+uint CPMLBoundaryManager::GetStateSize() {
+  int wnx = grid->window_size.window_nx;
+  int wny = grid->window_size.window_ny;
+  int wnz = grid->window_size.window_nz;
+  int width =
+      this->parameters->boundary_length + (2 * this->parameters->half_length);
+  uint size = 4 * width * wny * wnz + 4 * width * wnx * wny;
+  if (grid->grid_size.ny > 1) {
+    size += 4 * width * wnx * wnz;
+  }
+  return size;
+}
+
+void CPMLBoundaryManager::SaveState(float *state) {
+  this->CopyState(state, true);
+}
+
+void CPMLBoundaryManager::RestoreState(const float *state) {
+  this->CopyState((float *)state, false);
+}
+
+void CPMLBoundaryManager::CopyState(float *state, bool save) {
+  int wnx = grid->window_size.window_nx;
+  int wny = grid->window_size.window_ny;
+  int wnz = grid->window_size.window_nz;
+  int width =
+      this->parameters->boundary_length + (2 * this->parameters->half_length);
+  int y_size = width * wnx * wnz;
+  int x_size = width * wny * wnz;
+  int z_size = width * wnx * wny;
+  // Both auxiliary variables are updated recursively through the time-steps.
+  float *aux[] = {aux_1_x_up, aux_1_x_down, aux_2_x_up, aux_2_x_down,
+                  aux_1_z_up, aux_1_z_down, aux_2_z_up, aux_2_z_down,
+                  aux_1_y_up, aux_1_y_down, aux_2_y_up, aux_2_y_down};
+  int sizes[] = {x_size, x_size, x_size, x_size, z_size, z_size,
+                 z_size, z_size, y_size, y_size, y_size, y_size};
+  int count = grid->grid_size.ny > 1 ? 12 : 8;
+  for (int i = 0; i < count; i++) {
+    if (save) {
+      memcpy(state, aux[i], sizeof(float) * sizes[i]);
+    } else {
+      memcpy(aux[i], state, sizeof(float) * sizes[i]);
+    }
+    state += sizes[i];
+  }
+}
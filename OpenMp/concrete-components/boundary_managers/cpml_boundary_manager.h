@@ -32,6 +32,9 @@ private:
 
   float max_vel;
 
+  // The box of the window the wavefields are restricted to, if any.
+  const ActiveBox *active_box;
+
   float relax_cp;
   float shift_ratio;
   float reflect_coeff;
@@ -54,6 +57,8 @@ private:
 
   void ResetVariables();
 
+  void CopyState(float *state, bool save);
+
 public:
   CPMLBoundaryManager(bool use_top_layer = true, float reflect_coeff = 0.1,
                       float shift_ratio = 0.1, float relax_cp = 1);
@@ -68,6 +73,16 @@ public:
 
   void AdjustModelForBackward() override;
 
+  bool AltersModel() override;
+
+  void SetActiveBox(const ActiveBox *box) override;
+
+  uint GetStateSize() override;
+
+  void SaveState(float *state) override;
+
+  void RestoreState(const float *state) override;
+
   void SetComputationParameters(ComputationParameters *parameters) override;
 
   void SetGridBox(GridBox *grid_box) override;
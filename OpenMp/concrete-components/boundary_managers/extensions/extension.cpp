@@ -7,6 +7,7 @@
 // Constructor.
 Extension::Extension() {
   this->backup_array = nullptr;
+  this->backup_size = 0;
   this->start_point = {0, 0, 0};
   this->end_point = {0, 0, 0};
 }
@@ -29,6 +30,9 @@ void Extension::SetProperty(float *property) {
   this->property_array = property;
 }
 
+// The top layer helpers do nothing by default.
+bool Extension::AltersTopLayer() { return false; }
+
 // Save the original_array values at the boundaries to backup_array.
 void Extension::SaveBoundary(float *original_array, int nx, int nz, int ny) {
   /*! reading the values of the start and end of the window in all dimensions
@@ -40,29 +44,34 @@ void Extension::SaveBoundary(float *original_array, int nx, int nz, int ny) {
   int end_x = this->end_point.x;
   int end_y = this->end_point.y;
   int end_z = this->end_point.z;
-  // it is nullptr in the first shot
-  if (this->backup_array == nullptr) {
-    int wnx = end_x - start_x;
-    int wny = end_y - start_y;
-    int wnz = end_z - start_z;
-    int size_of_backup = 0;
-    if (ny == 1) {
-      wny = 1;
-    } else {
-      /*!the boundaries area in y direction is rectangular of x and z covering
-       * only the BOUND_LENGTH area for  y direction the 2(both sides)
-       */
-      size_of_backup = 2 * boundary_length * (wnx * wnz);
-    }
-    /*!increment the boundaries area with the sum of areas of the
-     * rectangles of z and y covering only the BOUND_LENGTH area for  x
-     * direction rectangles of x and y covering only the BOUND_LENGTH area for
-     * z direction
+  int wnx = end_x - start_x;
+  int wny = end_y - start_y;
+  int wnz = end_z - start_z;
+  int size_of_backup = 0;
+  if (ny == 1) {
+    wny = 1;
+  } else {
+    /*!the boundaries area in y direction is rectangular of x and z covering
+     * only the BOUND_LENGTH area for  y direction the 2(both sides)
      */
-    size_of_backup += 2 * boundary_length * (wnz * wny + wnx * wny);
+    size_of_backup = 2 * boundary_length * (wnx * wnz);
+  }
+  /*!increment the boundaries area with the sum of areas of the
+   * rectangles of z and y covering only the BOUND_LENGTH area for  x
+   * direction rectangles of x and y covering only the BOUND_LENGTH area for
+   * z direction
+   */
+  size_of_backup += 2 * boundary_length * (wnz * wny + wnx * wny);
+  // it is nullptr in the first shot, the windows of the shots may differ in
+  // size so it is grown when a larger window comes.
+  if ((uint)size_of_backup > this->backup_size) {
+    if (this->backup_array != nullptr) {
+      mem_free((void *)this->backup_array);
+    }
     // allocate memory for the backup_array with the size of the boundaries area
     this->backup_array = (float *)mem_allocate(sizeof(float), size_of_backup,
                                                "Boundary backup values");
+    this->backup_size = size_of_backup;
   }
   // the general case for the upcoming shots
   int nz_nx = nz * nx;
@@ -295,6 +304,12 @@ void Extension::ReExtendProperty() {
   int wnz = window_size.window_nz;
   if (wnx == nx && wny == ny && wnz == nz) {
     // No window model, no need to re-extend so return from function
+    /*!the previous shot may have used a window, restore its boundaries and
+     * mark that no window is in use anymore.
+     */
+    this->RestoreBoundary(this->property_array, nx, nz, ny);
+    this->start_point = {0, 0, 0};
+    this->end_point = {0, 0, 0};
     /*!the nx , ny and nz includes the inner domain + BOUND_LENGTH +HALF_LENGTH
      * in all dimensions and we want to extend the velocities at boundaries only
      * with the HALF_LENGTH excluded
@@ -305,6 +320,10 @@ void Extension::ReExtendProperty() {
     int end_x = nx - half_length;
     int end_y = ny - half_length;
     int end_z = nz - half_length;
+    if (ny == 1) {
+      end_y = 1;
+      start_y = 0;
+    }
     // No window model, no need to re-extend
     // Just re-extend the top boundary.
     this->top_layer_extension_helper(this->property_array, start_x, start_z,
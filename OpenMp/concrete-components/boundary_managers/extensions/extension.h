@@ -17,6 +17,8 @@ class Extension {
 private:
   // used to store the values of velocities before changing them to zeros
   float *backup_array;
+  // the number of values backup_array can hold, it grows with the windows
+  uint backup_size;
   // used to point to the start and end point of the last used window
   Point3D start_point;
   Point3D end_point;
@@ -80,6 +82,9 @@ public:
   void SetGridBox(GridBox *grid);
   // Sets the property that will be extended by this extensions object.
   void SetProperty(float *property);
+  // Whether ReExtendProperty and AdjustPropertyForBackward change the property
+  // when no window is used, by extending and removing its top layer.
+  virtual bool AltersTopLayer();
 };
 
 #endif // ACOUSTIC2ND_RTM_EXTENSION_H
@@ -7,6 +7,9 @@
 HomogenousExtension::HomogenousExtension(bool use_top_layer) {
   this->use_top = use_top_layer;
 }
+
+bool HomogenousExtension::AltersTopLayer() { return this->use_top; }
+
 void HomogenousExtension::velocity_extension_helper(
     float *property_array, int start_x, int start_z, int start_y, int end_x,
     int end_y, int end_z, int nx, int nz, int ny, uint boundary_length) {
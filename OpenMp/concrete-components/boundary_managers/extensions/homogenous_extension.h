@@ -11,6 +11,8 @@ class HomogenousExtension : public Extension {
 public:
   HomogenousExtension(bool use_top_layer = true);
 
+  bool AltersTopLayer() override;
+
 private:
   bool use_top;
   void velocity_extension_helper(float *property_array, int start_x,
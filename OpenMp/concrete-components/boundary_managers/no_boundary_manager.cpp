@@ -61,3 +61,18 @@ void NoBoundaryManager::AdjustModelForBackward() {
     extension->AdjustPropertyForBackward();
   }
 };
+
+bool NoBoundaryManager::AltersWavefield() { return false; }
+
+bool NoBoundaryManager::AltersModel() {
+  for (auto const &extension : this->extensions) {
+    if (extension->AltersTopLayer()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool NoBoundaryManager::SupportsShotBatch() { return true; }
+
+bool NoBoundaryManager::SupportsNarrowWavefields() { return true; }
@@ -33,7 +33,15 @@ public:
 
   void SetGridBox(GridBox *grid_box) override;
 
+  bool SupportsShotBatch() override;
+
+  bool SupportsNarrowWavefields() override;
+
   void AdjustModelForBackward() override;
+
+  bool AltersWavefield() override;
+
+  bool AltersModel() override;
 };
 
 #endif // RTM_FRAMEWORK_DUMMY_BOUNDARY_MANAGER_H
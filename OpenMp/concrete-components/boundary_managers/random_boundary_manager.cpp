@@ -67,4 +67,10 @@ void RandomBoundaryManager::AdjustModelForBackward() {
   for (auto const &extension : this->extensions) {
     extension->AdjustPropertyForBackward();
   }
-};
\ No newline at end of file
+};
+
+bool RandomBoundaryManager::AltersWavefield() { return false; }
+
+bool RandomBoundaryManager::SupportsShotBatch() { return true; }
+
+bool RandomBoundaryManager::SupportsNarrowWavefields() { return true; }
@@ -34,7 +34,13 @@ public:
 
   void SetGridBox(GridBox *grid_box) override;
 
+  bool SupportsShotBatch() override;
+
+  bool SupportsNarrowWavefields() override;
+
   void AdjustModelForBackward() override;
+
+  bool AltersWavefield() override;
 };
 
 #endif // ACOUSTIC2ND_RTM_RANDOM_BOUNDARY_MANAGER_H
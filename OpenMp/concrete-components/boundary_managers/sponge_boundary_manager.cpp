@@ -3,6 +3,7 @@
 //
 
 #include "sponge_boundary_manager.h"
+#include <algorithm>
 #include <cmath>
 #include <concrete-components/boundary_managers/extensions/homogenous_extension.h>
 #include <iostream>
@@ -19,6 +20,9 @@ SpongeBoundaryManager ::SpongeBoundaryManager(bool use_top_layer,
   if (is_staggered) {
     this->extensions.push_back(new HomogenousExtension(use_top_layer));
   }
+  // Only allocated once the grid box is set, which the other shots of a batch
+  // never do.
+  this->sponge_coeffs = nullptr;
 }
 
 float SpongeBoundaryManager ::calculation(int index) {
@@ -28,7 +32,18 @@ float SpongeBoundaryManager ::calculation(int index) {
   return value;
 }
 
-void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
+/*!
+ * Damps the point at the given index of the field, in each of the shots of a
+ * batch interleaved in it.
+ */
+inline void Damp(float *field, uint index, float coeff, uint batch) {
+  float *point = field + (size_t)index * batch;
+  for (uint lane = 0; lane < batch; lane++) {
+    point[lane] *= coeff;
+  }
+}
+
+void SpongeBoundaryManager::ApplyBoundaryOnField(float *next, uint batch) {
   /*! sponge boundary implementation */
   int nx = grid->window_size.window_nx;
   int ny = grid->window_size.window_ny;
@@ -45,10 +60,10 @@ void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
     for (int iz = half_length + bound_length - 1; iz >= half_length; iz--) {
       for (int ix = half_length + bound_length;
            ix <= nx - half_length - bound_length; ix++) {
-        next[iy * nx * nz + iz * nx + ix] *=
-            this->sponge_coeffs[iz - half_length];
-        next[iy * nx * nz + (iz + nz - 2 * iz - 1) * nx + ix] *=
-            this->sponge_coeffs[iz - half_length];
+        Damp(next, iy * nx * nz + iz * nx + ix,
+             this->sponge_coeffs[iz - half_length], batch);
+        Damp(next, iy * nx * nz + (iz + nz - 2 * iz - 1) * nx + ix,
+             this->sponge_coeffs[iz - half_length], batch);
       }
     }
   }
@@ -56,10 +71,10 @@ void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
     for (int iz = half_length + bound_length;
          iz <= nz - half_length - bound_length; iz++) {
       for (int ix = half_length + bound_length - 1; ix >= half_length; ix--) {
-        next[iy * nx * nz + iz * nx + ix] *=
-            this->sponge_coeffs[ix - half_length];
-        next[iy * nx * nz + iz * nx + (ix + nx - 2 * ix - 1)] *=
-            this->sponge_coeffs[ix - half_length];
+        Damp(next, iy * nx * nz + iz * nx + ix,
+             this->sponge_coeffs[ix - half_length], batch);
+        Damp(next, iy * nx * nz + iz * nx + (ix + nx - 2 * ix - 1),
+             this->sponge_coeffs[ix - half_length], batch);
       }
     }
   }
@@ -69,10 +84,10 @@ void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
            iz <= nz - half_length - bound_length; iz++) {
         for (int ix = half_length + bound_length;
              ix <= nx - half_length - bound_length; ix++) {
-          next[iy * nx * nz + iz * nx + ix] *=
-              this->sponge_coeffs[iy - half_length];
-          next[(iy + ny - 2 * iy - 1) * nx * nz + iz * nx + ix] *=
-              this->sponge_coeffs[iy - half_length];
+          Damp(next, iy * nx * nz + iz * nx + ix,
+               this->sponge_coeffs[iy - half_length], batch);
+          Damp(next, (iy + ny - 2 * iy - 1) * nx * nz + iz * nx + ix,
+               this->sponge_coeffs[iy - half_length], batch);
         }
       }
     }
@@ -92,25 +107,26 @@ void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
         /*!for values from z = half_length TO z = half_length +BOUND_LENGTH */
         /*! and for x = half_length to x = half_length + BOUND_LENGTH */
         /*! Top left boundary in other words */
-        next[depth * nz_nx + (start_z + row) * nx + column + start_x] *=
-            min(this->sponge_coeffs[column], this->sponge_coeffs[row]);
+        Damp(next, depth * nz_nx + (start_z + row) * nx + column + start_x,
+             min(this->sponge_coeffs[column], this->sponge_coeffs[row]), batch);
         /*!for values from z = nz-half_length TO z =
          * nz-half_length-BOUND_LENGTH*/
         /*! and for x = half_length to x = half_length + BOUND_LENGTH */
         /*! Bottom left boundary in other words */
-        next[depth * nz_nx + (end_z - 1 - row) * nx + column + start_x] *=
-            min(this->sponge_coeffs[column], this->sponge_coeffs[row]);
+        Damp(next, depth * nz_nx + (end_z - 1 - row) * nx + column + start_x,
+             min(this->sponge_coeffs[column], this->sponge_coeffs[row]), batch);
         /*!for values from z = half_length TO z = half_length +BOUND_LENGTH */
         /*! and for x = nx-half_length to x = nx-half_length - BOUND_LENGTH */
         /*! Top right boundary in other words */
-        next[depth * nz_nx + (start_z + row) * nx + (end_x - 1 - column)] *=
-            min(this->sponge_coeffs[column], this->sponge_coeffs[row]);
+        Damp(next, depth * nz_nx + (start_z + row) * nx + (end_x - 1 - column),
+             min(this->sponge_coeffs[column], this->sponge_coeffs[row]), batch);
         /*!for values from z = nz-half_length TO z =
          * nz-half_length-BOUND_LENGTH*/
         /*! and for x = nx-half_length to x = nx - half_length - BOUND_LENGTH */
         /*! Bottom right boundary in other words */
-        next[depth * nz_nx + (end_z - 1 - row) * nx + (end_x - 1 - column)] *=
-            min(this->sponge_coeffs[column], this->sponge_coeffs[row]);
+        Damp(next,
+             depth * nz_nx + (end_z - 1 - row) * nx + (end_x - 1 - column),
+             min(this->sponge_coeffs[column], this->sponge_coeffs[row]), batch);
       }
     }
   }
@@ -123,23 +139,30 @@ void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
         for (int column = start_x; column < end_x; column++) {
           /*!for values from z = half_length TO z = half_length +BOUND_LENGTH */
           /*! and for y = half_length to y = half_length + BOUND_LENGTH */
-          next[(depth + start_y) * nz_nx + (start_z + row) * nx + column] *=
-              min(this->sponge_coeffs[depth], this->sponge_coeffs[row]);
+          Damp(next, (depth + start_y) * nz_nx + (start_z + row) * nx + column,
+               min(this->sponge_coeffs[depth], this->sponge_coeffs[row]),
+               batch);
           /*!for values from z = nz-half_length TO z =
            * nz-half_length-BOUND_LENGTH*/
           /*! and for y = half_length to y = half_length + BOUND_LENGTH */
-          next[(depth + start_y) * nz_nx + (end_z - 1 - row) * nx + column] *=
-              min(this->sponge_coeffs[depth], this->sponge_coeffs[row]);
+          Damp(next,
+               (depth + start_y) * nz_nx + (end_z - 1 - row) * nx + column,
+               min(this->sponge_coeffs[depth], this->sponge_coeffs[row]),
+               batch);
           /*!for values from z = half_length TO z = half_length +BOUND_LENGTH */
           /*! and for y = ny-half_length to y = ny-half_length - BOUND_LENGTH */
-          next[(end_y - 1 - depth) * nz_nx + (start_z + row) * nx + column] *=
-              min(this->sponge_coeffs[depth], this->sponge_coeffs[row]);
+          Damp(next,
+               (end_y - 1 - depth) * nz_nx + (start_z + row) * nx + column,
+               min(this->sponge_coeffs[depth], this->sponge_coeffs[row]),
+               batch);
           /*!for values from z = nz-half_length TO z =
            * nz-half_length-BOUND_LENGTH */
           /*! and for y = ny-half_length to y = ny - half_length - BOUND_LENGTH
            */
-          next[(end_y - 1 - depth) * nz_nx + (end_z - 1 - row) * nx + column] *=
-              min(this->sponge_coeffs[depth], this->sponge_coeffs[row]);
+          Damp(next,
+               (end_y - 1 - depth) * nz_nx + (end_z - 1 - row) * nx + column,
+               min(this->sponge_coeffs[depth], this->sponge_coeffs[row]),
+               batch);
         }
       }
     }
@@ -150,23 +173,29 @@ void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
         for (int column = 0; column < bound_length; column++) {
           /*!for values from y = half_length TO y = half_length +BOUND_LENGTH */
           /*! and for x = half_length to x = half_length + BOUND_LENGTH */
-          next[(depth + start_y) * nz_nx + row * nx + column + start_x] *=
-              min(this->sponge_coeffs[column], this->sponge_coeffs[depth]);
+          Damp(next, (depth + start_y) * nz_nx + row * nx + column + start_x,
+               min(this->sponge_coeffs[column], this->sponge_coeffs[depth]),
+               batch);
           /*!for values from y = ny-half_length TO y =
            * ny-half_length-BOUND_LENGTH*/
           /*! and for x = half_length to x = half_length + BOUND_LENGTH */
-          next[(end_y - 1 - depth) * nz_nx + row * nx + column + start_x] *=
-              min(this->sponge_coeffs[column], this->sponge_coeffs[depth]);
+          Damp(next, (end_y - 1 - depth) * nz_nx + row * nx + column + start_x,
+               min(this->sponge_coeffs[column], this->sponge_coeffs[depth]),
+               batch);
           /*!for values from y = half_length TO y = half_length +BOUND_LENGTH */
           /*! and for x = nx-half_length to x = nx-half_length - BOUND_LENGTH */
-          next[(depth + start_y) * nz_nx + row * nx + (end_x - 1 - column)] *=
-              min(this->sponge_coeffs[column], this->sponge_coeffs[depth]);
+          Damp(next,
+               (depth + start_y) * nz_nx + row * nx + (end_x - 1 - column),
+               min(this->sponge_coeffs[column], this->sponge_coeffs[depth]),
+               batch);
           /*!for values from y = ny-half_length TO y =
            * ny-half_length-BOUND_LENGTH*/
           /*! and for x = nx-half_length to x = nx - half_length - BOUND_LENGTH
            */
-          next[(end_y - 1 - depth) * nz_nx + row * nx + (end_x - 1 - column)] *=
-              min(this->sponge_coeffs[column], this->sponge_coeffs[depth]);
+          Damp(next,
+               (end_y - 1 - depth) * nz_nx + row * nx + (end_x - 1 - column),
+               min(this->sponge_coeffs[column], this->sponge_coeffs[depth]),
+               batch);
         }
       }
     }
@@ -175,7 +204,7 @@ void SpongeBoundaryManager::ApplyBoundaryOnField(float *next) {
 
 void SpongeBoundaryManager ::ApplyBoundary(uint kernel_id) {
   if (kernel_id == 0) {
-    ApplyBoundaryOnField(grid->pressure_current);
+    ApplyBoundaryOnField(grid->pressure_current, parameters->shot_batch);
   }
 }
 
@@ -229,3 +258,24 @@ void SpongeBoundaryManager::AdjustModelForBackward() {
     extension->AdjustPropertyForBackward();
   }
 }
+
+bool SpongeBoundaryManager::AltersModel() {
+  for (auto const &extension : this->extensions) {
+    if (extension->AltersTopLayer()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SpongeBoundaryManager::SupportsShotBatch() { return true; }
+
+bool SpongeBoundaryManager::DampsWavefield() { return !this->is_staggered; }
+
+void SpongeBoundaryManager::GetDamping(float *damping) {
+  // The points damped more than once get the product of their coefficients.
+  size_t size = (size_t)grid->window_size.window_nx *
+                grid->window_size.window_nz * grid->window_size.window_ny;
+  fill(damping, damping + size, 1.0f);
+  ApplyBoundaryOnField(damping, 1);
+}
@@ -24,7 +24,7 @@ private:
 
   GridBox *grid;
 
-  void ApplyBoundaryOnField(float *next);
+  void ApplyBoundaryOnField(float *next, uint batch);
 
 public:
   SpongeBoundaryManager(bool use_top_layer = true, bool is_staggered = false);
@@ -41,7 +41,15 @@ public:
 
   void SetGridBox(GridBox *grid_box) override;
 
+  bool SupportsShotBatch() override;
+
   void AdjustModelForBackward() override;
+
+  bool AltersModel() override;
+
+  bool DampsWavefield() override;
+
+  void GetDamping(float *damping) override;
 };
 
 #endif // ACOUSTIC2ND_RTM_SPONGE_BOUNDARY_MANAGER_H
@@ -685,6 +685,15 @@ void StaggeredCPMLBoundaryManager::AdjustModelForBackward() {
   zero_auxiliary_variables();
 }
 
+bool StaggeredCPMLBoundaryManager::AltersModel() {
+  for (auto const &extension : this->extensions) {
+    if (extension->AltersTopLayer()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void StaggeredCPMLBoundaryManager::fillCpmlCoeff(
     float *coeff_a, float *coeff_b, int boundary_length, float dh, float dt,
     float max_vel, float shift_ratio, float reflect_coeff, float relax_cp) {
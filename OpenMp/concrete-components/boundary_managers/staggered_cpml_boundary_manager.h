@@ -59,6 +59,8 @@ public:
 
   void AdjustModelForBackward() override;
 
+  bool AltersModel() override;
+
   void SetComputationParameters(ComputationParameters *parameters) override;
 
   void SetGridBox(GridBox *grid_box) override;
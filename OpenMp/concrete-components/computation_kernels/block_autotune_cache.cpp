@@ -0,0 +1,88 @@
+#include "block_autotune_cache.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+
+/*!
+ * Reads the model name of the cpu from /proc/cpuinfo, with the spaces replaced
+ * so it can be used in a single word key.
+ */
+static string GetCpuModel() {
+  ifstream cpu_info("/proc/cpuinfo");
+  string line;
+  string model = "unknown";
+  while (getline(cpu_info, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      size_t start = line.find(':');
+      if (start != string::npos) {
+        start = line.find_first_not_of(' ', start + 1);
+        if (start != string::npos) {
+          model = line.substr(start);
+        }
+      }
+      break;
+    }
+  }
+  for (char &c : model) {
+    if (c == ' ' || c == '\t') {
+      c = '_';
+    }
+  }
+  return model;
+}
+
+string GetAutotuneKey(uint nx, uint nz, uint ny, uint half_length,
+                      uint n_threads) {
+  stringstream key;
+  key << "nx=" << nx << ",nz=" << nz << ",ny=" << ny << ",hl=" << half_length
+      << ",threads=" << n_threads << ",cpu=" << GetCpuModel();
+  return key.str();
+}
+
+bool ReadTunedBlocks(const string &cache_file, const string &key,
+                     TunedBlocks &blocks) {
+  ifstream cache(cache_file);
+  string line;
+  while (getline(cache, line)) {
+    stringstream entry(line);
+    string entry_key;
+    TunedBlocks entry_blocks;
+    if (entry >> entry_key >> entry_blocks.block_x >> entry_blocks.block_z >>
+        entry_blocks.block_y) {
+      if (entry_key == key) {
+        blocks = entry_blocks;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void WriteTunedBlocks(const string &cache_file, const string &key,
+                      const TunedBlocks &blocks) {
+  // Keep the entries of the other keys.
+  vector<string> lines;
+  ifstream cache_in(cache_file);
+  string line;
+  while (getline(cache_in, line)) {
+    stringstream entry(line);
+    string entry_key;
+    if (entry >> entry_key && entry_key != key) {
+      lines.push_back(line);
+    }
+  }
+  cache_in.close();
+  ofstream cache_out(cache_file, ios::trunc);
+  if (!cache_out) {
+    cout << "Couldn't write the autotuning cache file " << cache_file << endl;
+    return;
+  }
+  for (auto &l : lines) {
+    cache_out << l << endl;
+  }
+  cache_out << key << " " << blocks.block_x << " " << blocks.block_z << " "
+            << blocks.block_y << endl;
+}
@@ -0,0 +1,38 @@
+#ifndef ACOUSTIC2ND_RTM_BLOCK_AUTOTUNE_CACHE_H
+#define ACOUSTIC2ND_RTM_BLOCK_AUTOTUNE_CACHE_H
+
+#include <string>
+#include <sys/types.h>
+
+/*!
+ * The blocking factors found by the autotuning of the computation kernel.
+ */
+struct TunedBlocks {
+  uint block_x;
+  uint block_z;
+  uint block_y;
+};
+
+/*!
+ * Builds the key identifying a tuning : the grid size, the half length of the
+ * stencil, the number of threads and the cpu model.
+ */
+std::string GetAutotuneKey(uint nx, uint nz, uint ny, uint half_length,
+                           uint n_threads);
+
+/*!
+ * Looks the key up in the autotuning cache file.
+ * @return
+ * True if found, with the blocks of the entry written to blocks.
+ */
+bool ReadTunedBlocks(const std::string &cache_file, const std::string &key,
+                     TunedBlocks &blocks);
+
+/*!
+ * Adds the entry of the key to the autotuning cache file, replacing any
+ * previous entry of the same key.
+ */
+void WriteTunedBlocks(const std::string &cache_file, const std::string &key,
+                      const TunedBlocks &blocks);
+
+#endif // ACOUSTIC2ND_RTM_BLOCK_AUTOTUNE_CACHE_H
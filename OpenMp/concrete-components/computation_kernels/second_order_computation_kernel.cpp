@@ -1,46 +1,329 @@
 #include "second_order_computation_kernel.h"
+#include "block_autotune_cache.h"
+#include <algorithm>
 #include <cmath>
+#include <concrete-components/computation_kernels/simd/simd_stencil.h>
+#include <concrete-components/forward_collectors/half_precision/half_precision.h>
+#include <cstring>
 #include <iostream>
+#include <omp.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
 #include <skeleton/helpers/timer/timer.hpp>
+#include <vector>
 
 #define fma(a, b, c) (a) * (b) + (c)
+// The number of time-steps timed for each candidate block of the autotuning.
+#define AUTOTUNE_STEPS 3
 
-SecondOrderComputationKernel::~SecondOrderComputationKernel() = default;
+SecondOrderComputationKernel::~SecondOrderComputationKernel() {
+  for (auto &frame : this->temporal_frames) {
+    if (frame != nullptr) {
+      mem_free((void *)frame);
+    }
+  }
+  if (this->temporal_scratch != nullptr) {
+    mem_free((void *)this->temporal_scratch);
+  }
+  if (this->temporal_damping != nullptr) {
+    mem_free((void *)this->temporal_damping);
+  }
+  if (this->narrow_velocity != nullptr) {
+    mem_free((void *)this->narrow_velocity);
+  }
+  if (this->narrow_scratch != nullptr) {
+    mem_free((void *)this->narrow_scratch);
+  }
+}
 
 using namespace std;
 
 SecondOrderComputationKernel::SecondOrderComputationKernel() {
   this->boundary_manager = nullptr;
+  this->temporal_frames[0] = nullptr;
+  this->temporal_frames[1] = nullptr;
+  this->temporal_scratch = nullptr;
+  this->temporal_scratch_size = 0;
+  this->temporal_damping = nullptr;
+  this->damping_ready = false;
+  this->parameters = nullptr;
+  this->blocks_tuned = false;
+  this->next_injection = 0;
+  this->imaging = nullptr;
+  this->active_box = nullptr;
+  this->narrow_velocity = nullptr;
+  this->narrow_scratch = nullptr;
+  this->narrow_scratch_size = 0;
 }
+/*!
+ * Computes the next pressure values of a row of n points, given pointers to
+ * the start of the row in the current, previous and next frames and in the
+ * velocity. The next frame may be the same as the previous one.
+ */
+template <bool is_2D, HALF_LENGTH half_length>
+inline void StencilRow(const float *curr, const float *prev, float *next,
+                       const float *vel, int n, const float *coeff_x,
+                       const float *coeff_z, const float *coeff_y,
+                       const int *vertical, const int *front,
+                       float coeff_xyz) {
+#pragma vector aligned
+#pragma vector vecremainder
+#pragma omp simd
+#pragma ivdep
+  for (int ix = 0; ix < n; ++ix) {
+    // Calculate the finite difference using sequence of fma
+    // instructions.
+    float value = 0;
+    // 1 floating point operation
+    value = fma(curr[ix], coeff_xyz, value);
+    // Calculate Finite Difference in the x-direction.
+    // 3 floating point operations
+    value = fma(curr[ix - 1] + curr[ix + 1], coeff_x[0], value);
+    if (half_length > 1) {
+      value = fma(curr[ix - 2] + curr[ix + 2], coeff_x[1], value);
+    }
+    if (half_length > 2) {
+      value = fma(curr[ix - 3] + curr[ix + 3], coeff_x[2], value);
+      value = fma(curr[ix - 4] + curr[ix + 4], coeff_x[3], value);
+    }
+    if (half_length > 4) {
+      value = fma(curr[ix - 5] + curr[ix + 5], coeff_x[4], value);
+      value = fma(curr[ix - 6] + curr[ix + 6], coeff_x[5], value);
+    }
+    if (half_length > 6) {
+      value = fma(curr[ix - 7] + curr[ix + 7], coeff_x[6], value);
+      value = fma(curr[ix - 8] + curr[ix + 8], coeff_x[7], value);
+    }
+    // Calculate Finite Difference in the z-direction.
+    // 3 floating point operations
+    value = fma(curr[ix - vertical[0]] + curr[ix + vertical[0]], coeff_z[0],
+                value);
+    if (half_length > 1) {
+      value = fma(curr[ix - vertical[1]] + curr[ix + vertical[1]], coeff_z[1],
+                  value);
+    }
+    if (half_length > 2) {
+      value = fma(curr[ix - vertical[2]] + curr[ix + vertical[2]], coeff_z[2],
+                  value);
+      value = fma(curr[ix - vertical[3]] + curr[ix + vertical[3]], coeff_z[3],
+                  value);
+    }
+    if (half_length > 4) {
+      value = fma(curr[ix - vertical[4]] + curr[ix + vertical[4]], coeff_z[4],
+                  value);
+      value = fma(curr[ix - vertical[5]] + curr[ix + vertical[5]], coeff_z[5],
+                  value);
+    }
+    if (half_length > 6) {
+      value = fma(curr[ix - vertical[6]] + curr[ix + vertical[6]], coeff_z[6],
+                  value);
+      value = fma(curr[ix - vertical[7]] + curr[ix + vertical[7]], coeff_z[7],
+                  value);
+    }
+    if (!is_2D) {
+      // Calculate Finite Difference in the y-direction.
+      // 3 floating point operations
+      value = fma(curr[ix - front[0]] + curr[ix + front[0]], coeff_y[0], value);
+      if (half_length > 1) {
+        value =
+            fma(curr[ix - front[1]] + curr[ix + front[1]], coeff_y[1], value);
+      }
+      if (half_length > 2) {
+        value =
+            fma(curr[ix - front[2]] + curr[ix + front[2]], coeff_y[2], value);
+        value =
+            fma(curr[ix - front[3]] + curr[ix + front[3]], coeff_y[3], value);
+      }
+      if (half_length > 4) {
+        value =
+            fma(curr[ix - front[4]] + curr[ix + front[4]], coeff_y[4], value);
+        value =
+            fma(curr[ix - front[5]] + curr[ix + front[5]], coeff_y[5], value);
+      }
+      if (half_length > 6) {
+        value =
+            fma(curr[ix - front[6]] + curr[ix + front[6]], coeff_y[6], value);
+        value =
+            fma(curr[ix - front[7]] + curr[ix + front[7]], coeff_y[7], value);
+      }
+    }
+    // Calculate the next pressure value according to the second
+    // order acoustic wave equation.
+    // 4 floating point operations
+    next[ix] = (2 * curr[ix]) - prev[ix] + (vel[ix] * value);
+  }
+}
+
+/*!
+ * Pre-computes the coefficients of each direction scaled by the cell
+ * dimensions, along with the offsets of the neighbours in z and y for rows
+ * of the given strides.
+ */
+template <bool is_2D, HALF_LENGTH half_length>
+inline void PrepareStencil(AcousticSecondGrid *grid, const float *coeff,
+                           int stride_z, int stride_y, float *coeff_x,
+                           float *coeff_z, float *coeff_y, int *vertical,
+                           int *front, float &coeff_xyz) {
+  float dx = grid->cell_dimensions.dx;
+  float dz = grid->cell_dimensions.dz;
+  float dx2 = 1 / (dx * dx);
+  float dz2 = 1 / (dz * dz);
+  float dy2 = 0;
+  if (!is_2D) {
+    float dy = grid->cell_dimensions.dy;
+    dy2 = 1 / (dy * dy);
+  }
+  for (int i = 0; i < half_length; i++) {
+    coeff_x[i] = coeff[i + 1] * dx2;
+    coeff_z[i] = coeff[i + 1] * dz2;
+    vertical[i] = (i + 1) * stride_z;
+    if (!is_2D) {
+      coeff_y[i] = coeff[i + 1] * dy2;
+      front[i] = (i + 1) * stride_y;
+    }
+  }
+  if (is_2D) {
+    coeff_xyz = coeff[0] * (dx2 + dz2);
+  } else {
+    coeff_xyz = coeff[0] * (dx2 + dy2 + dz2);
+  }
+}
+
+/*!
+ * The regions of the window a time-step works on : the box it is restricted
+ * to, the computed region, which is the computational domain clipped to the
+ * box, the region zeroed around it and the region imaged.
+ */
+struct StepRegions {
+  int box_x, box_xEnd, box_z, box_zEnd, box_y, box_yEnd;
+  int x_start, nxEnd, z_start, nzEnd, y_start, nyEnd;
+  int zero_x, zero_xEnd, zero_z, zero_zEnd, zero_y, zero_yEnd;
+  int image_x, image_xEnd, image_z, image_zEnd, image_y, image_yEnd;
+};
+
+/*!
+ * Gets the regions of a time-step of the given box and imaging, if any.
+ */
+template <bool is_2D, HALF_LENGTH half_length>
+inline StepRegions GetStepRegions(const AcousticSecondGrid *grid,
+                                  const FusedImaging *imaging,
+                                  const ActiveBox *box) {
+  int wnx = grid->window_size.window_nx;
+  int wny = grid->window_size.window_ny;
+  int wnz = grid->window_size.window_nz;
+  StepRegions r;
+  // The box of the window, the whole window if none is given.
+  r.box_x = 0, r.box_xEnd = wnx;
+  r.box_z = 0, r.box_zEnd = wnz;
+  r.box_y = 0, r.box_yEnd = wny;
+  if (box != nullptr) {
+    r.box_x = box->start.x;
+    r.box_xEnd = box->end.x;
+    r.box_z = box->start.z;
+    r.box_zEnd = box->end.z;
+    r.box_y = box->start.y;
+    r.box_yEnd = box->end.y;
+  }
+  r.y_start = 0;
+  r.nyEnd = 1;
+  // The computed region : the computational domain clipped to the box.
+  r.x_start = max((int)half_length, r.box_x);
+  r.z_start = max((int)half_length, r.box_z);
+  r.nxEnd = min(wnx - (int)half_length, r.box_xEnd);
+  r.nzEnd = min(wnz - (int)half_length, r.box_zEnd);
+  if (!is_2D) {
+    r.y_start = max((int)half_length, r.box_y);
+    r.nyEnd = min(wny - (int)half_length, r.box_yEnd);
+  }
+  r.nxEnd = max(r.nxEnd, r.x_start);
+  r.nzEnd = max(r.nzEnd, r.z_start);
+  r.nyEnd = max(r.nyEnd, r.y_start);
+  // The region zeroed around it.
+  int reach = 2 * half_length;
+  r.zero_x = max(r.x_start - reach, 0);
+  r.zero_xEnd = min(r.nxEnd + reach, wnx);
+  r.zero_z = max(r.z_start - reach, 0);
+  r.zero_zEnd = min(r.nzEnd + reach, wnz);
+  r.zero_y = 0;
+  r.zero_yEnd = 1;
+  if (!is_2D) {
+    r.zero_y = max(r.y_start - reach, 0);
+    r.zero_yEnd = min(r.nyEnd + reach, wny);
+  }
+  // The region of the imaging.
+  r.image_x = 0, r.image_xEnd = wnx;
+  r.image_z = 0, r.image_zEnd = wnz;
+  r.image_y = 0, r.image_yEnd = wny;
+  if (imaging != nullptr && imaging->region != nullptr) {
+    r.image_x = imaging->region->start.x;
+    r.image_xEnd = imaging->region->end.x;
+    r.image_z = imaging->region->start.z;
+    r.image_zEnd = imaging->region->end.z;
+    r.image_y = imaging->region->start.y;
+    r.image_yEnd = imaging->region->end.y;
+  }
+  return r;
+}
+
+/*!
+ * Zeroes the points of the next frame around the computed region, must be
+ * called by all the threads of the parallel region of the step.
+ */
+template <typename T>
+inline void ZeroAroundRegion(T *next_base, const StepRegions &r, int wnx,
+                             int wnxnz) {
+#pragma omp for schedule(static) collapse(2)
+  for (int iy = r.zero_y; iy < r.zero_yEnd; ++iy) {
+    for (int iz = r.zero_z; iz < r.zero_zEnd; ++iz) {
+      T *row = next_base + iy * wnxnz + iz * wnx;
+      if (iy >= r.y_start && iy < r.nyEnd && iz >= r.z_start &&
+          iz < r.nzEnd) {
+        memset(row + r.zero_x, 0, (r.x_start - r.zero_x) * sizeof(T));
+        memset(row + r.nxEnd, 0, (r.zero_xEnd - r.nxEnd) * sizeof(T));
+      } else {
+        memset(row + r.zero_x, 0, (r.zero_xEnd - r.zero_x) * sizeof(T));
+      }
+    }
+  }
+}
+
+/*!
+ * Advances the wavefields by one time-step, the rows are computed by the given
+ * intrinsics stencil row if any, or by the compiler vectorized one otherwise.
+ * The injection, if any, is added to the current frame by the threads of the
+ * step before the blocks read it, and the imaging, if any, correlates each
+ * block while it's still in cache.
+ * If a box is given, only the points of the computational domain inside it
+ * are computed, and the points around them up to twice the reach of the
+ * stencil are zeroed, so the frames are zero wherever the next time-steps may
+ * read them out of their box.
+ * The step is only recorded by the timer if timed is set, which the block
+ * autotuning doesn't.
+ */
 template <bool is_2D, HALF_LENGTH half_length>
 void Computation(AcousticSecondGrid *grid,
-                 AcousticOmpComputationParameters *parameters) {
+                 AcousticOmpComputationParameters *parameters,
+                 StencilRowFunction stencil_row,
+                 const InjectionList *injection, const FusedImaging *imaging,
+                 const ActiveBox *box, bool timed) {
   // Read parameters into local variables to be shared.
   float *prev_base = grid->pressure_previous;
   float *curr_base = grid->pressure_current;
   float *next_base = grid->pressure_next;
   float *vel_base = grid->velocity;
   int wnx = grid->window_size.window_nx;
-  int wny = grid->window_size.window_ny;
   int wnz = grid->window_size.window_nz;
-  float dx = grid->cell_dimensions.dx;
-  float dy;
-  float dz = grid->cell_dimensions.dz;
   int nx = grid->grid_size.nx;
   int nz = grid->grid_size.nz;
-  float dx2 = 1 / (dx * dx);
-  float dy2;
-  float dz2 = 1 / (dz * dz);
-  float *coeff = parameters->second_derivative_fd_coeff;
   int block_x = parameters->block_x;
   int block_y = parameters->block_y;
   int block_z = parameters->block_z;
-  int nxEnd = wnx - half_length;
-  int nyEnd = 1;
-  int nzEnd = wnz - half_length;
   int wnxnz = wnx * wnz;
   int nxnz = nx * nz;
   int size = (nx - 2 * half_length) * (nz - 2 * half_length);
+  StepRegions r = GetStepRegions<is_2D, half_length>(grid, imaging, box);
+  int x_start = r.x_start, nxEnd = r.nxEnd;
+  int z_start = r.z_start, nzEnd = r.nzEnd;
+  int y_start = r.y_start, nyEnd = r.nyEnd;
 
   // General note: floating point operations for forward is the same as backward
   // (calculated below are for forward). number of floating point operations for
@@ -52,13 +335,14 @@ void Computation(AcousticSecondGrid *grid,
   vel_base = vel_base + (grid->window_size.window_start.y * nxnz) +
              (grid->window_size.window_start.z * nx) +
              grid->window_size.window_start.x;
-  int y_start = 0;
+  // The image moves like the velocity.
+  float *image_base = nullptr;
+  const float *source_base = nullptr;
+  if (imaging != nullptr) {
+    image_base = imaging->image + (vel_base - grid->velocity);
+    source_base = imaging->source;
+  }
   if (!is_2D) {
-    dy = grid->cell_dimensions.dy;
-    dy2 = 1 / (dy * dy);
-    y_start = half_length;
-    nyEnd = wny - half_length;
-
     // General note: floating point operations for forward is the same as
     // backward (calculated below are for forward). number of floating point
     // operations for the computation kernel in 3D for the half_length loop:9*K
@@ -73,36 +357,34 @@ void Computation(AcousticSecondGrid *grid,
   int vertical[half_length];
   int front[half_length];
   float coeff_xyz;
-  for (int i = 0; i < half_length; i++) {
-    coeff_x[i] = coeff[i + 1] * dx2;
-    coeff_z[i] = coeff[i + 1] * dz2;
-    vertical[i] = (i + 1) * wnx;
-    if (!is_2D) {
-      coeff_y[i] = coeff[i + 1] * dy2;
-      front[i] = (i + 1) * wnxnz;
-    }
-  }
-  if (is_2D) {
-    coeff_xyz = coeff[0] * (dx2 + dz2);
-  } else {
-    coeff_xyz = coeff[0] * (dx2 + dy2 + dz2);
-  }
+  PrepareStencil<is_2D, half_length>(grid, parameters->second_derivative_fd_coeff,
+                                     wnx, wnxnz, coeff_x, coeff_z, coeff_y,
+                                     vertical, front, coeff_xyz);
 
   Timer *timer = Timer::getInstance();
-  timer->_start_timer_for_kernel("ComputationKernel::kernel", size, 4, true,
-                                 flops_per_second);
+  if (timed) {
+    timer->_start_timer_for_kernel("ComputationKernel::kernel", size, 4, true,
+                                   flops_per_second);
+  }
 
   // Start the computation by creating the threads.
 #pragma omp parallel default(shared)
   {
-
-    float *prev, *curr, *next, *vel;
+    // The blocks read the points of the current frame around them, so all the
+    // points are injected before any block is computed.
+    if (injection != nullptr) {
+      int num_points = injection->num_points;
+#pragma omp for schedule(static)
+      for (int i = 0; i < num_points; ++i) {
+        curr_base[injection->offsets[i]] += injection->amplitudes[i];
+      }
+    }
 // Three loops for cache blocking : utilizing the cache to the maximum to speed
 // up computation.
 #pragma omp for schedule(static, 1) collapse(2)
     for (int by = y_start; by < nyEnd; by += block_y) {
-      for (int bz = half_length; bz < nzEnd; bz += block_z) {
-        for (int bx = half_length; bx < nxEnd; bx += block_x) {
+      for (int bz = z_start; bz < nzEnd; bz += block_z) {
+        for (int bx = x_start; bx < nxEnd; bx += block_x) {
           // Calculate the endings appropriately (Handle remainder of the cache
           // blocking loops).
           int ixEnd = fmin(block_x, nxEnd - bx);
@@ -115,179 +397,777 @@ void Computation(AcousticSecondGrid *grid,
               // start point of the processing.
               int offset = iy * wnxnz + iz * wnx + bx;
               // Velocity moves with the full nx and nz not the windows ones.
-              vel = vel_base + iy * nxnz + iz * nx + bx;
-              prev = prev_base + offset;
-              curr = curr_base + offset;
-              next = next_base + offset;
-
-#pragma vector aligned
-#pragma vector vecremainder
+              if (stencil_row != nullptr) {
+                stencil_row(curr_base + offset, prev_base + offset,
+                            next_base + offset,
+                            vel_base + iy * nxnz + iz * nx + bx, ixEnd,
+                            coeff_x, coeff_z, coeff_y, vertical, front,
+                            coeff_xyz);
+              } else {
+                StencilRow<is_2D, half_length>(
+                    curr_base + offset, prev_base + offset, next_base + offset,
+                    vel_base + iy * nxnz + iz * nx + bx, ixEnd, coeff_x,
+                    coeff_z, coeff_y, vertical, front, coeff_xyz);
+              }
+            }
+          }
+          if (imaging != nullptr) {
+            int jx = max(bx, r.image_x);
+            int jxEnd = min(bx + ixEnd, r.image_xEnd);
+            int jzEnd = min(izEnd, r.image_zEnd);
+            int jyEnd = min(iyEnd, r.image_yEnd);
+            for (int iy = max(by, r.image_y); iy < jyEnd; ++iy) {
+              for (int iz = max(bz, r.image_z); iz < jzEnd; ++iz) {
+                int offset = iy * wnxnz + iz * wnx;
+                const float *source = source_base + offset;
+                const float *receiver = next_base + offset;
+                float *image = image_base + iy * nxnz + iz * nx;
 #pragma omp simd
-#pragma ivdep
-              for (int ix = 0; ix < ixEnd; ++ix) {
-                // Calculate the finite difference using sequence of fma
-                // instructions.
-                float value = 0;
-                // 1 floating point operation
-                value = fma(curr[ix], coeff_xyz, value);
-                // Calculate Finite Difference in the x-direction.
-                // 3 floating point operations
-                value = fma(curr[ix - 1] + curr[ix + 1], coeff_x[0], value);
-                if (half_length > 1) {
-                  value = fma(curr[ix - 2] + curr[ix + 2], coeff_x[1], value);
-                }
-                if (half_length > 2) {
-                  value = fma(curr[ix - 3] + curr[ix + 3], coeff_x[2], value);
-                  value = fma(curr[ix - 4] + curr[ix + 4], coeff_x[3], value);
-                }
-                if (half_length > 4) {
-                  value = fma(curr[ix - 5] + curr[ix + 5], coeff_x[4], value);
-                  value = fma(curr[ix - 6] + curr[ix + 6], coeff_x[5], value);
+                for (int ix = jx; ix < jxEnd; ++ix) {
+                  image[ix] += source[ix] * receiver[ix];
                 }
-                if (half_length > 6) {
-                  value = fma(curr[ix - 7] + curr[ix + 7], coeff_x[6], value);
-                  value = fma(curr[ix - 8] + curr[ix + 8], coeff_x[7], value);
-                }
-                // Calculate Finite Difference in the z-direction.
-                // 3 floating point operations
-                value = fma(curr[ix - vertical[0]] + curr[ix + vertical[0]],
-                            coeff_z[0], value);
-                if (half_length > 1) {
-                  value = fma(curr[ix - vertical[1]] + curr[ix + vertical[1]],
-                              coeff_z[1], value);
-                }
-                if (half_length > 2) {
-                  value = fma(curr[ix - vertical[2]] + curr[ix + vertical[2]],
-                              coeff_z[2], value);
-                  value = fma(curr[ix - vertical[3]] + curr[ix + vertical[3]],
-                              coeff_z[3], value);
-                }
-                if (half_length > 4) {
-                  value = fma(curr[ix - vertical[4]] + curr[ix + vertical[4]],
-                              coeff_z[4], value);
-                  value = fma(curr[ix - vertical[5]] + curr[ix + vertical[5]],
-                              coeff_z[5], value);
-                }
-                if (half_length > 6) {
-                  value = fma(curr[ix - vertical[6]] + curr[ix + vertical[6]],
-                              coeff_z[6], value);
-                  value = fma(curr[ix - vertical[7]] + curr[ix + vertical[7]],
-                              coeff_z[7], value);
+              }
+            }
+          }
+        }
+      }
+    }
+    if (box != nullptr) {
+      // Zero the points around the computed region.
+      ZeroAroundRegion(next_base, r, wnx, wnxnz);
+    }
+  }
+  if (timed) {
+    timer->stop_timer("ComputationKernel::kernel");
+  }
+}
+
+/*!
+ * Adds the points of the injection falling in the region of the window loaded
+ * into a frame of the temporal blocking scratch to it. The points of the
+ * region that the time-step doesn't compute are never read by the computed
+ * ones, so the region is taken as a whole.
+ */
+inline void InjectRegion(const InjectionList *injection, float *frame, int lx,
+                         int lz, int ly, int sx, int sz, int sy, int wnx,
+                         int wnxnz) {
+  if (injection == nullptr || injection->num_points == 0) {
+    return;
+  }
+  // The offsets are sorted, so only the ones between the first and the last
+  // rows of the region are looked at.
+  const uint *offsets = injection->offsets;
+  const uint *end = offsets + injection->num_points;
+  uint region_start = ly * wnxnz + lz * wnx + lx;
+  uint region_end = (ly + sy - 1) * wnxnz + (lz + sz - 1) * wnx + lx + sx;
+  const uint *first = lower_bound(offsets, end, region_start);
+  const uint *last = lower_bound(first, end, region_end);
+  for (const uint *point = first; point < last; ++point) {
+    int iy = *point / wnxnz;
+    int iz = (*point - iy * wnxnz) / wnx;
+    int ix = *point - iy * wnxnz - iz * wnx;
+    if (ix >= lx && ix < lx + sx && iz >= lz && iz < lz + sz) {
+      frame[(iy - ly) * sx * sz + (iz - lz) * sx + ix - lx] +=
+          injection->amplitudes[point - offsets];
+    }
+  }
+}
+
+/*!
+ * Temporal blocking : advances the wavefields by time_steps time-steps, each
+ * cache block is loaded with a halo of time_steps * half_length points into a
+ * thread private scratch, where it is advanced all the time-steps shrinking the
+ * computed region by half_length each step. The two last time-steps of the
+ * block are then written to prev_out and curr_out, which must be different
+ * from the grid frames as the neighbouring blocks still read them.
+ * The injection of each time-step, if any, is added to the current frame of
+ * the scratch before it is advanced, and the computed rows are scaled by the
+ * damping of the boundary, if any, as the steps would do.
+ */
+template <bool is_2D, HALF_LENGTH half_length>
+void TemporalComputation(AcousticSecondGrid *grid,
+                         AcousticOmpComputationParameters *parameters,
+                         uint time_steps, float *prev_out, float *curr_out,
+                         float *scratch, size_t scratch_per_thread,
+                         StencilRowFunction stencil_row,
+                         const InjectionList *const *injections,
+                         const float *damping) {
+  float *prev_base = grid->pressure_previous;
+  float *curr_base = grid->pressure_current;
+  float *vel_base = grid->velocity;
+  int wnx = grid->window_size.window_nx;
+  int wny = grid->window_size.window_ny;
+  int wnz = grid->window_size.window_nz;
+  int nx = grid->grid_size.nx;
+  int nz = grid->grid_size.nz;
+  int block_x = parameters->block_x;
+  int block_y = parameters->block_y;
+  int block_z = parameters->block_z;
+  int nxEnd = wnx - half_length;
+  int nyEnd = 1;
+  int nzEnd = wnz - half_length;
+  int wnxnz = wnx * wnz;
+  int nxnz = nx * nz;
+  int size = (nx - 2 * half_length) * (nz - 2 * half_length);
+  int flops_per_second = 6 * half_length + 5;
+  vel_base = vel_base + (grid->window_size.window_start.y * nxnz) +
+             (grid->window_size.window_start.z * nx) +
+             grid->window_size.window_start.x;
+  int y_start = 0;
+  if (!is_2D) {
+    y_start = half_length;
+    nyEnd = wny - half_length;
+    flops_per_second = 9 * half_length + 5;
+  }
+  // The distance the stencil reaches over all the time-steps.
+  int reach = time_steps * half_length;
+  const float *coeff = parameters->second_derivative_fd_coeff;
+
+  Timer *timer = Timer::getInstance();
+  timer->_start_timer_for_kernel("ComputationKernel::TemporalKernel",
+                                 (double)size * time_steps, 4, true,
+                                 flops_per_second);
+#pragma omp parallel default(shared)
+  {
+    float coeff_x[half_length];
+    float coeff_y[half_length];
+    float coeff_z[half_length];
+    int vertical[half_length];
+    int front[half_length];
+    float coeff_xyz;
+    // Each frame of the scratch is padded by a vector on both sides for the
+    // loads of the stencil row running over the loaded region.
+    float *scratch_prev =
+        scratch + omp_get_thread_num() * scratch_per_thread + 16;
+    float *scratch_curr = scratch_prev + scratch_per_thread / 2;
+#pragma omp for schedule(static, 1) collapse(2)
+    for (int by = y_start; by < nyEnd; by += block_y) {
+      for (int bz = half_length; bz < nzEnd; bz += block_z) {
+        for (int bx = half_length; bx < nxEnd; bx += block_x) {
+          int ixEnd = fmin(bx + block_x, nxEnd);
+          int izEnd = fmin(bz + block_z, nzEnd);
+          int iyEnd = fmin(by + block_y, nyEnd);
+          // The region loaded into the scratch : the block grown by the reach
+          // of the stencil, clamped to the window.
+          int lx = fmax(bx - reach, 0);
+          int lz = fmax(bz - reach, 0);
+          int ly = 0;
+          int sx = fmin(ixEnd + reach, wnx) - lx;
+          int sz = fmin(izEnd + reach, wnz) - lz;
+          int sy = 1;
+          if (!is_2D) {
+            ly = fmax(by - reach, 0);
+            sy = fmin(iyEnd + reach, wny) - ly;
+          }
+          PrepareStencil<is_2D, half_length>(grid, coeff, sx, sx * sz, coeff_x,
+                                             coeff_z, coeff_y, vertical, front,
+                                             coeff_xyz);
+          float *p = scratch_prev;
+          float *c = scratch_curr;
+          for (int iy = 0; iy < sy; ++iy) {
+            for (int iz = 0; iz < sz; ++iz) {
+              int offset = (iy + ly) * wnxnz + (iz + lz) * wnx + lx;
+              int s_offset = iy * sx * sz + iz * sx;
+              memcpy(p + s_offset, prev_base + offset, sx * sizeof(float));
+              memcpy(c + s_offset, curr_base + offset, sx * sizeof(float));
+            }
+          }
+          for (int t = 1; t <= (int)time_steps; ++t) {
+            InjectRegion(injections[t - 1], c, lx, lz, ly, sx, sz, sy, wnx,
+                         wnxnz);
+            // Region valid at this time-step : the block grown by the reach of
+            // the remaining time-steps, clamped to the computational domain.
+            int grow = (time_steps - t) * half_length;
+            int cx = fmax(bx - grow, (int)half_length);
+            int cxEnd = fmin(ixEnd + grow, nxEnd);
+            int cz = fmax(bz - grow, (int)half_length);
+            int czEnd = fmin(izEnd + grow, nzEnd);
+            int cy = 0;
+            int cyEnd = 1;
+            if (!is_2D) {
+              cy = fmax(by - grow, (int)half_length);
+              cyEnd = fmin(iyEnd + grow, nyEnd);
+            }
+            for (int iy = cy; iy < cyEnd; ++iy) {
+              for (int iz = cz; iz < czEnd; ++iz) {
+                int s_offset = (iy - ly) * sx * sz + (iz - lz) * sx + cx - lx;
+                if (stencil_row != nullptr) {
+                  stencil_row(c + s_offset, p + s_offset, p + s_offset,
+                              vel_base + iy * nxnz + iz * nx + cx, cxEnd - cx,
+                              coeff_x, coeff_z, coeff_y, vertical, front,
+                              coeff_xyz);
+                } else {
+                  StencilRow<is_2D, half_length>(
+                      c + s_offset, p + s_offset, p + s_offset,
+                      vel_base + iy * nxnz + iz * nx + cx, cxEnd - cx,
+                      coeff_x, coeff_z, coeff_y, vertical, front, coeff_xyz);
                 }
-                if (!is_2D) {
-                  // Calculate Finite Difference in the y-direction.
-                  // 3 floating point operations
-                  value = fma(curr[ix - front[0]] + curr[ix + front[0]],
-                              coeff_y[0], value);
-                  if (half_length > 1) {
-                    value = fma(curr[ix - front[1]] + curr[ix + front[1]],
-                                coeff_y[1], value);
-                  }
-                  if (half_length > 2) {
-                    value = fma(curr[ix - front[2]] + curr[ix + front[2]],
-                                coeff_y[2], value);
-                    value = fma(curr[ix - front[3]] + curr[ix + front[3]],
-                                coeff_y[3], value);
-                  }
-                  if (half_length > 4) {
-                    value = fma(curr[ix - front[4]] + curr[ix + front[4]],
-                                coeff_y[4], value);
-                    value = fma(curr[ix - front[5]] + curr[ix + front[5]],
-                                coeff_y[5], value);
-                  }
-                  if (half_length > 6) {
-                    value = fma(curr[ix - front[6]] + curr[ix + front[6]],
-                                coeff_y[6], value);
-                    value = fma(curr[ix - front[7]] + curr[ix + front[7]],
-                                coeff_y[7], value);
+                if (damping != nullptr) {
+                  const float *factors = damping + iy * wnxnz + iz * wnx + cx;
+                  float *row = p + s_offset;
+#pragma omp simd
+                  for (int ix = 0; ix < cxEnd - cx; ++ix) {
+                    row[ix] *= factors[ix];
                   }
                 }
-                // Calculate the next pressure value according to the second
-                // order acoustic wave equation.
-                // 4 floating point operations
-                next[ix] = (2 * curr[ix]) - prev[ix] + (vel[ix] * value);
               }
             }
+            float *temp = p;
+            p = c;
+            c = temp;
+          }
+          // Write back the last two time-steps of the block.
+          for (int iy = by; iy < iyEnd; ++iy) {
+            for (int iz = bz; iz < izEnd; ++iz) {
+              int offset = iy * wnxnz + iz * wnx + bx;
+              int s_offset = (iy - ly) * sx * sz + (iz - lz) * sx + bx - lx;
+              memcpy(prev_out + offset, p + s_offset,
+                     (ixEnd - bx) * sizeof(float));
+              memcpy(curr_out + offset, c + s_offset,
+                     (ixEnd - bx) * sizeof(float));
+            }
           }
         }
       }
     }
   }
-  timer->stop_timer("ComputationKernel::kernel");
+  timer->stop_timer("ComputationKernel::TemporalKernel");
 }
 
 template void
 Computation<false, O_2>(AcousticSecondGrid *grid,
-                        AcousticOmpComputationParameters *parameters);
+                        AcousticOmpComputationParameters *parameters,
+                        StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<false, O_4>(AcousticSecondGrid *grid,
-                        AcousticOmpComputationParameters *parameters);
+                        AcousticOmpComputationParameters *parameters,
+                        StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<false, O_8>(AcousticSecondGrid *grid,
-                        AcousticOmpComputationParameters *parameters);
+                        AcousticOmpComputationParameters *parameters,
+                        StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<false, O_12>(AcousticSecondGrid *grid,
-                         AcousticOmpComputationParameters *parameters);
+                         AcousticOmpComputationParameters *parameters,
+                         StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<false, O_16>(AcousticSecondGrid *grid,
-                         AcousticOmpComputationParameters *parameters);
+                         AcousticOmpComputationParameters *parameters,
+                         StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<true, O_2>(AcousticSecondGrid *grid,
-                       AcousticOmpComputationParameters *parameters);
+                       AcousticOmpComputationParameters *parameters,
+                       StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<true, O_4>(AcousticSecondGrid *grid,
-                       AcousticOmpComputationParameters *parameters);
+                       AcousticOmpComputationParameters *parameters,
+                       StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<true, O_8>(AcousticSecondGrid *grid,
-                       AcousticOmpComputationParameters *parameters);
+                       AcousticOmpComputationParameters *parameters,
+                       StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<true, O_12>(AcousticSecondGrid *grid,
-                        AcousticOmpComputationParameters *parameters);
+                        AcousticOmpComputationParameters *parameters,
+                        StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 template void
 Computation<true, O_16>(AcousticSecondGrid *grid,
-                        AcousticOmpComputationParameters *parameters);
+                        AcousticOmpComputationParameters *parameters,
+                        StencilRowFunction stencil_row,
+                        const InjectionList *injection,
+                        const FusedImaging *imaging, const ActiveBox *box,
+                        bool timed);
 
-void SecondOrderComputationKernel::Step() {
-  Timer *timer = Timer::getInstance();
-  timer->start_timer("ComputationKernel::Step");
+/*!
+ * Dispatches the time-step to the computation of the dimensions and order of
+ * the grid.
+ */
+void ComputeStep(AcousticSecondGrid *grid,
+                 AcousticOmpComputationParameters *parameters,
+                 StencilRowFunction stencil_row,
+                 const InjectionList *injection, const FusedImaging *imaging,
+                 const ActiveBox *box, bool timed) {
   // Take a step in time.
   if ((grid->grid_size.ny) == 1) {
     switch (parameters->half_length) {
     case O_2:
-      Computation<true, O_2>(grid, parameters);
+      Computation<true, O_2>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_4:
+      Computation<true, O_4>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_8:
+      Computation<true, O_8>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_12:
+      Computation<true, O_12>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_16:
+      Computation<true, O_16>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    }
+  } else {
+    switch (parameters->half_length) {
+    case O_2:
+      Computation<false, O_2>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_4:
+      Computation<false, O_4>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_8:
+      Computation<false, O_8>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_12:
+      Computation<false, O_12>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    case O_16:
+      Computation<false, O_16>(grid, parameters, stencil_row, injection,
+                              imaging, box, timed);
+      break;
+    }
+  }
+}
+
+/*!
+ * Advances the wavefields held in 16 bits by one time-step, like Computation.
+ * Each block of the current frame is converted to fp32 with its halo into a
+ * thread private scratch, and each row of the previous frame and of the
+ * velocity into fp32 rows, so the stencil rows compute in fp32 while only the
+ * 16 bit values are moved from and to the memory. The imaging source is read
+ * in 16 bits too, and each next row is imaged before being converted back.
+ */
+template <bool is_2D, HALF_LENGTH half_length>
+void NarrowComputation(AcousticSecondGrid *grid,
+                       AcousticOmpComputationParameters *parameters,
+                       StencilRowFunction stencil_row,
+                       const uint16_t *narrow_velocity, float *scratch,
+                       size_t scratch_per_thread, size_t row_stride,
+                       const InjectionList *injection,
+                       const FusedImaging *imaging, const ActiveBox *box) {
+  STORAGE_PRECISION precision = parameters->wavefield_precision;
+  const uint16_t *prev_base = (const uint16_t *)grid->pressure_previous;
+  uint16_t *curr_base = (uint16_t *)grid->pressure_current;
+  uint16_t *next_base = (uint16_t *)grid->pressure_next;
+  int wnx = grid->window_size.window_nx;
+  int wnz = grid->window_size.window_nz;
+  int nx = grid->grid_size.nx;
+  int nz = grid->grid_size.nz;
+  int block_x = parameters->block_x;
+  int block_y = parameters->block_y;
+  int block_z = parameters->block_z;
+  int wnxnz = wnx * wnz;
+  int nxnz = nx * nz;
+  int size = (nx - 2 * half_length) * (nz - 2 * half_length);
+  int flops_per_second = is_2D ? 6 * half_length + 5 : 9 * half_length + 5;
+  StepRegions r = GetStepRegions<is_2D, half_length>(grid, imaging, box);
+  int x_start = r.x_start, nxEnd = r.nxEnd;
+  int z_start = r.z_start, nzEnd = r.nzEnd;
+  int y_start = r.y_start, nyEnd = r.nyEnd;
+  size_t window_offset = (grid->window_size.window_start.y * nxnz) +
+                         (grid->window_size.window_start.z * nx) +
+                         grid->window_size.window_start.x;
+  const uint16_t *vel_base = narrow_velocity + window_offset;
+  float *image_base = nullptr;
+  const uint16_t *source_base = nullptr;
+  if (imaging != nullptr) {
+    image_base = imaging->image + window_offset;
+    source_base = (const uint16_t *)imaging->source;
+  }
+  const float *coeff = parameters->second_derivative_fd_coeff;
+
+  Timer *timer = Timer::getInstance();
+  // The frames and the velocity moved are half the size of the fp32 ones.
+  timer->_start_timer_for_kernel("ComputationKernel::kernel", size, 2, true,
+                                 flops_per_second);
+#pragma omp parallel default(shared)
+  {
+    float coeff_x[half_length];
+    float coeff_y[half_length];
+    float coeff_z[half_length];
+    int vertical[half_length];
+    int front[half_length];
+    float coeff_xyz;
+    // The rows of the block are aligned at the start of the scratch, followed
+    // by the current frame of the block where each row starts a vector before
+    // its first computed point.
+    float *prev_row = scratch + omp_get_thread_num() * scratch_per_thread;
+    float *vel_row = prev_row + row_stride;
+    float *next_row = vel_row + row_stride;
+    float *source_row = next_row + row_stride;
+    float *block = source_row + row_stride;
+    if (injection != nullptr) {
+      int num_points = injection->num_points;
+#pragma omp for schedule(static)
+      for (int i = 0; i < num_points; ++i) {
+        uint offset = injection->offsets[i];
+        curr_base[offset] =
+            AddHalf(curr_base[offset], injection->amplitudes[i], precision);
+      }
+    }
+#pragma omp for schedule(static, 1) collapse(2)
+    for (int by = y_start; by < nyEnd; by += block_y) {
+      for (int bz = z_start; bz < nzEnd; bz += block_z) {
+        for (int bx = x_start; bx < nxEnd; bx += block_x) {
+          int ixEnd = fmin(block_x, nxEnd - bx);
+          int izEnd = fmin(bz + block_z, nzEnd);
+          int iyEnd = fmin(by + block_y, nyEnd);
+          // The block grown by the reach of the stencil.
+          int lz = bz - half_length;
+          int sz = izEnd + half_length - lz;
+          int ly = is_2D ? by : by - half_length;
+          int lyEnd = is_2D ? iyEnd : iyEnd + half_length;
+          PrepareStencil<is_2D, half_length>(grid, coeff, row_stride,
+                                             row_stride * sz, coeff_x,
+                                             coeff_z, coeff_y, vertical,
+                                             front, coeff_xyz);
+          for (int iy = ly; iy < lyEnd; ++iy) {
+            for (int iz = lz; iz < lz + sz; ++iz) {
+              UnpackHalfRow(curr_base + iy * wnxnz + iz * wnx + bx -
+                                half_length,
+                            block + ((iy - ly) * sz + iz - lz) * row_stride +
+                                16 - half_length,
+                            ixEnd + 2 * half_length, precision);
+            }
+          }
+          for (int iy = by; iy < iyEnd; ++iy) {
+            for (int iz = bz; iz < izEnd; ++iz) {
+              int offset = iy * wnxnz + iz * wnx + bx;
+              const float *curr =
+                  block + ((iy - ly) * sz + iz - lz) * row_stride + 16;
+              // The previous row is read before the next one is written, as
+              // they may be the same.
+              UnpackHalfRow(prev_base + offset, prev_row, ixEnd, precision);
+              UnpackHalfRow(vel_base + iy * nxnz + iz * nx + bx, vel_row,
+                            ixEnd, precision);
+              if (stencil_row != nullptr) {
+                stencil_row(curr, prev_row, next_row, vel_row, ixEnd, coeff_x,
+                            coeff_z, coeff_y, vertical, front, coeff_xyz);
+              } else {
+                StencilRow<is_2D, half_length>(
+                    curr, prev_row, next_row, vel_row, ixEnd, coeff_x, coeff_z,
+                    coeff_y, vertical, front, coeff_xyz);
+              }
+              int jx = max(bx, r.image_x);
+              int jxEnd = min(bx + ixEnd, r.image_xEnd);
+              if (imaging != nullptr && jx < jxEnd && iy >= r.image_y &&
+                  iy < r.image_yEnd && iz >= r.image_z && iz < r.image_zEnd) {
+                UnpackHalfRow(source_base + iy * wnxnz + iz * wnx + jx,
+                              source_row, jxEnd - jx, precision);
+                float *image = image_base + iy * nxnz + iz * nx + jx;
+                const float *receiver = next_row + jx - bx;
+#pragma omp simd
+                for (int ix = 0; ix < jxEnd - jx; ++ix) {
+                  image[ix] += source_row[ix] * receiver[ix];
+                }
+              }
+              PackHalfRow(next_row, next_base + offset, ixEnd, precision);
+            }
+          }
+        }
+      }
+    }
+    if (box != nullptr) {
+      ZeroAroundRegion(next_base, r, wnx, wnxnz);
+    }
+  }
+  timer->stop_timer("ComputationKernel::kernel");
+}
+
+/*!
+ * Dispatches the time-step of the narrow wavefields to the computation of the
+ * dimensions and order of the grid.
+ */
+void ComputeNarrowStep(AcousticSecondGrid *grid,
+                       AcousticOmpComputationParameters *parameters,
+                       StencilRowFunction stencil_row,
+                       const uint16_t *narrow_velocity, float *scratch,
+                       size_t scratch_per_thread, size_t row_stride,
+                       const InjectionList *injection,
+                       const FusedImaging *imaging, const ActiveBox *box) {
+  if ((grid->grid_size.ny) == 1) {
+    switch (parameters->half_length) {
+    case O_2:
+      NarrowComputation<true, O_2>(grid, parameters, stencil_row,
+                                   narrow_velocity, scratch, scratch_per_thread,
+                                   row_stride, injection, imaging, box);
+      break;
+    case O_4:
+      NarrowComputation<true, O_4>(grid, parameters, stencil_row,
+                                   narrow_velocity, scratch, scratch_per_thread,
+                                   row_stride, injection, imaging, box);
+      break;
+    case O_8:
+      NarrowComputation<true, O_8>(grid, parameters, stencil_row,
+                                   narrow_velocity, scratch, scratch_per_thread,
+                                   row_stride, injection, imaging, box);
+      break;
+    case O_12:
+      NarrowComputation<true, O_12>(grid, parameters, stencil_row,
+                                    narrow_velocity, scratch,
+                                    scratch_per_thread, row_stride, injection,
+                                    imaging, box);
+      break;
+    case O_16:
+      NarrowComputation<true, O_16>(grid, parameters, stencil_row,
+                                    narrow_velocity, scratch,
+                                    scratch_per_thread, row_stride, injection,
+                                    imaging, box);
+      break;
+    }
+  } else {
+    switch (parameters->half_length) {
+    case O_2:
+      NarrowComputation<false, O_2>(grid, parameters, stencil_row,
+                                    narrow_velocity, scratch,
+                                    scratch_per_thread, row_stride, injection,
+                                    imaging, box);
+      break;
+    case O_4:
+      NarrowComputation<false, O_4>(grid, parameters, stencil_row,
+                                    narrow_velocity, scratch,
+                                    scratch_per_thread, row_stride, injection,
+                                    imaging, box);
+      break;
+    case O_8:
+      NarrowComputation<false, O_8>(grid, parameters, stencil_row,
+                                    narrow_velocity, scratch,
+                                    scratch_per_thread, row_stride, injection,
+                                    imaging, box);
+      break;
+    case O_12:
+      NarrowComputation<false, O_12>(grid, parameters, stencil_row,
+                                     narrow_velocity, scratch,
+                                     scratch_per_thread, row_stride, injection,
+                                     imaging, box);
+      break;
+    case O_16:
+      NarrowComputation<false, O_16>(grid, parameters, stencil_row,
+                                     narrow_velocity, scratch,
+                                     scratch_per_thread, row_stride, injection,
+                                     imaging, box);
+      break;
+    }
+  }
+}
+
+/*!
+ * Computes the next pressure values of n consecutive values of a row holding
+ * a batch of shots interleaved innermost, like the stencil row of a single
+ * shot but with the neighbours in x side points away. The velocity is given
+ * for each value, repeated for the shots of a point.
+ */
+template <bool is_2D, HALF_LENGTH half_length>
+inline void BatchStencilRow(const float *curr, const float *prev, float *next,
+                            const float *vel, int n, const float *coeff_x,
+                            const float *coeff_z, const float *coeff_y,
+                            const int *side, const int *vertical,
+                            const int *front, float coeff_xyz) {
+#pragma omp simd
+#pragma ivdep
+  for (int ix = 0; ix < n; ++ix) {
+    float value = 0;
+    value = fma(curr[ix], coeff_xyz, value);
+    for (int i = 0; i < half_length; ++i) {
+      value = fma(curr[ix - side[i]] + curr[ix + side[i]], coeff_x[i], value);
+    }
+    for (int i = 0; i < half_length; ++i) {
+      value = fma(curr[ix - vertical[i]] + curr[ix + vertical[i]], coeff_z[i],
+                  value);
+    }
+    if (!is_2D) {
+      for (int i = 0; i < half_length; ++i) {
+        value =
+            fma(curr[ix - front[i]] + curr[ix + front[i]], coeff_y[i], value);
+      }
+    }
+    next[ix] = (2 * curr[ix]) - prev[ix] + (vel[ix] * value);
+  }
+}
+
+/*!
+ * Advances the wavefields of a batch of shots by one time-step. The shots are
+ * interleaved innermost in the frames, so a row holds the values of all the
+ * shots of each point one after the other and is computed as a whole : the
+ * velocity of each point is loaded once and repeated for its shots in a
+ * thread private row, then the shots fill the vector lanes.
+ */
+template <bool is_2D, HALF_LENGTH half_length>
+void BatchComputation(AcousticSecondGrid *grid,
+                      AcousticOmpComputationParameters *parameters) {
+  float *prev_base = grid->pressure_previous;
+  float *curr_base = grid->pressure_current;
+  float *next_base = grid->pressure_next;
+  const float *vel_base = grid->velocity;
+  int batch = parameters->shot_batch;
+  int nx = grid->grid_size.nx;
+  int ny = grid->grid_size.ny;
+  int nz = grid->grid_size.nz;
+  int block_x = parameters->block_x;
+  int block_y = parameters->block_y;
+  int block_z = parameters->block_z;
+  int nxEnd = nx - half_length;
+  int nzEnd = nz - half_length;
+  int y_start = 0;
+  int nyEnd = 1;
+  int nxnz = nx * nz;
+  int size = (nx - 2 * half_length) * (nz - 2 * half_length) * batch;
+  int flops_per_second = 6 * half_length + 5;
+  if (!is_2D) {
+    y_start = half_length;
+    nyEnd = ny - half_length;
+    flops_per_second = 9 * half_length + 5;
+  }
+  float coeff_x[half_length];
+  float coeff_y[half_length];
+  float coeff_z[half_length];
+  int side[half_length];
+  int vertical[half_length];
+  int front[half_length];
+  float coeff_xyz;
+  PrepareStencil<is_2D, half_length>(
+      grid, parameters->second_derivative_fd_coeff, nx * batch,
+      nxnz * batch, coeff_x, coeff_z, coeff_y, vertical, front, coeff_xyz);
+  for (int i = 0; i < half_length; i++) {
+    side[i] = (i + 1) * batch;
+  }
+
+  Timer *timer = Timer::getInstance();
+  timer->_start_timer_for_kernel("ComputationKernel::kernel", size, 4, true,
+                                 flops_per_second);
+#pragma omp parallel default(shared)
+  {
+    vector<float> vel_row(block_x * batch);
+#pragma omp for schedule(static, 1) collapse(2)
+    for (int by = y_start; by < nyEnd; by += block_y) {
+      for (int bz = half_length; bz < nzEnd; bz += block_z) {
+        for (int bx = half_length; bx < nxEnd; bx += block_x) {
+          int ixEnd = min(block_x, nxEnd - bx);
+          int izEnd = min(bz + block_z, nzEnd);
+          int iyEnd = min(by + block_y, nyEnd);
+          for (int iy = by; iy < iyEnd; ++iy) {
+            for (int iz = bz; iz < izEnd; ++iz) {
+              int row = iy * nxnz + iz * nx + bx;
+              const float *vel = vel_base + row;
+              for (int ix = 0; ix < ixEnd; ++ix) {
+                for (int lane = 0; lane < batch; ++lane) {
+                  vel_row[ix * batch + lane] = vel[ix];
+                }
+              }
+              int offset = row * batch;
+              BatchStencilRow<is_2D, half_length>(
+                  curr_base + offset, prev_base + offset, next_base + offset,
+                  vel_row.data(), ixEnd * batch, coeff_x, coeff_z, coeff_y,
+                  side, vertical, front, coeff_xyz);
+            }
+          }
+        }
+      }
+    }
+  }
+  timer->stop_timer("ComputationKernel::kernel");
+}
+
+/*!
+ * Dispatches the time-step of a batch of shots to the computation of the
+ * dimensions and order of the grid.
+ */
+void ComputeBatchStep(AcousticSecondGrid *grid,
+                      AcousticOmpComputationParameters *parameters) {
+  if ((grid->grid_size.ny) == 1) {
+    switch (parameters->half_length) {
+    case O_2:
+      BatchComputation<true, O_2>(grid, parameters);
       break;
     case O_4:
-      Computation<true, O_4>(grid, parameters);
+      BatchComputation<true, O_4>(grid, parameters);
       break;
     case O_8:
-      Computation<true, O_8>(grid, parameters);
+      BatchComputation<true, O_8>(grid, parameters);
       break;
     case O_12:
-      Computation<true, O_12>(grid, parameters);
+      BatchComputation<true, O_12>(grid, parameters);
       break;
     case O_16:
-      Computation<true, O_16>(grid, parameters);
+      BatchComputation<true, O_16>(grid, parameters);
       break;
     }
   } else {
     switch (parameters->half_length) {
     case O_2:
-      Computation<false, O_2>(grid, parameters);
+      BatchComputation<false, O_2>(grid, parameters);
       break;
     case O_4:
-      Computation<false, O_4>(grid, parameters);
+      BatchComputation<false, O_4>(grid, parameters);
       break;
     case O_8:
-      Computation<false, O_8>(grid, parameters);
+      BatchComputation<false, O_8>(grid, parameters);
       break;
     case O_12:
-      Computation<false, O_12>(grid, parameters);
+      BatchComputation<false, O_12>(grid, parameters);
       break;
     case O_16:
-      Computation<false, O_16>(grid, parameters);
+      BatchComputation<false, O_16>(grid, parameters);
       break;
     }
   }
+}
+
+void SecondOrderComputationKernel::Step() {
+  Timer *timer = Timer::getInstance();
+  timer->start_timer("ComputationKernel::Step");
+  // Take a step in time.
+  const InjectionList *injection = this->NextInjection();
+  if (parameters->shot_batch > 1) {
+    ComputeBatchStep(grid, parameters);
+  } else if (parameters->narrow_wavefields) {
+    this->NarrowStep(injection);
+  } else {
+    StencilRowFunction stencil_row = GetSimdStencilRow(
+        parameters->simd_isa, grid->grid_size.ny == 1, parameters->half_length);
+    ComputeStep(grid, parameters, stencil_row, injection, this->imaging,
+                this->active_box, true);
+  }
+  if (this->next_injection == this->injections.size()) {
+    this->injections.clear();
+    this->next_injection = 0;
+  }
+  this->imaging = nullptr;
   // Swap pointers : Next to current, current to prev and unwanted prev to next
   // to be overwritten.
   if (grid->pressure_previous == grid->pressure_next) {
@@ -311,8 +1191,401 @@ void SecondOrderComputationKernel::Step() {
   timer->stop_timer("BoundaryManager::ApplyBoundary");
 }
 
+const InjectionList *SecondOrderComputationKernel::NextInjection() {
+  if (this->next_injection == this->injections.size()) {
+    return nullptr;
+  }
+  return &this->injections[this->next_injection++];
+}
+
+void SecondOrderComputationKernel::NarrowStep(const InjectionList *injection) {
+  bool is_2D = grid->grid_size.ny == 1;
+  uint half_length = parameters->half_length;
+  // Each thread needs the rows of a block and its current frame grown by the
+  // reach of the stencil, each row with a vector of padding on both sides so
+  // that they share the alignment of the rows.
+  uint nx = grid->grid_size.nx;
+  uint nz = grid->grid_size.nz;
+  uint ny = grid->grid_size.ny;
+  size_t row_stride =
+      ((min(parameters->block_x, nx - 2 * half_length) + 15) / 16) * 16 + 32;
+  size_t block_rows = min(parameters->block_z, nz - 2 * half_length) +
+                      2 * half_length;
+  if (!is_2D) {
+    block_rows *= min(parameters->block_y, ny - 2 * half_length) +
+                  2 * half_length;
+  }
+  size_t scratch_per_thread = (4 + block_rows) * row_stride;
+  size_t scratch_size = scratch_per_thread * omp_get_max_threads();
+  if (scratch_size > this->narrow_scratch_size) {
+    if (this->narrow_scratch != nullptr) {
+      mem_free((void *)this->narrow_scratch);
+    }
+    this->narrow_scratch = (float *)mem_allocate(sizeof(float), scratch_size,
+                                                 "narrow_wavefields_scratch");
+    this->narrow_scratch_size = scratch_size;
+  }
+  StencilRowFunction stencil_row =
+      GetSimdStencilRow(parameters->simd_isa, is_2D, parameters->half_length);
+  ComputeNarrowStep(grid, parameters, stencil_row, this->narrow_velocity,
+                    this->narrow_scratch, scratch_per_thread, row_stride,
+                    injection, this->imaging, this->active_box);
+}
+
+void SecondOrderComputationKernel::MultiStep(uint time_steps) {
+  // Temporal blocking is only valid if the boundary manager applies nothing to
+  // the wavefields between the time-steps but a fixed damping.
+  bool damped = this->boundary_manager != nullptr &&
+                this->boundary_manager->AltersWavefield();
+  if (time_steps < 2 || parameters->shot_batch > 1 ||
+      parameters->narrow_wavefields || this->imaging != nullptr ||
+      this->active_box != nullptr ||
+      (damped && !this->boundary_manager->DampsWavefield())) {
+    ComputationKernel::MultiStep(time_steps);
+    return;
+  }
+  // The queued injections of the time-steps, in order.
+  vector<const InjectionList *> step_injections(time_steps);
+  for (uint t = 0; t < time_steps; t++) {
+    step_injections[t] = this->NextInjection();
+  }
+  Timer *timer = Timer::getInstance();
+  timer->start_timer("ComputationKernel::MultiStep");
+  uint half_length = parameters->half_length;
+  uint reach = time_steps * half_length;
+  uint wnx = grid->window_size.window_nx;
+  uint wnz = grid->window_size.window_nz;
+  uint wny = grid->window_size.window_ny;
+  bool is_2D = grid->grid_size.ny == 1;
+  // The frames receiving the result are allocated for the full grid, so they
+  // fit any window.
+  if (this->temporal_frames[0] == nullptr) {
+    uint nx = grid->grid_size.nx;
+    uint nz = grid->grid_size.nz;
+    uint ny = grid->grid_size.ny;
+    for (int i = 0; i < 2; i++) {
+      this->temporal_frames[i] =
+          (float *)mem_allocate(sizeof(float), nx * nz * ny,
+                                "temporal_blocking_frame", half_length, 16 * i);
+      this->FirstTouch(this->temporal_frames[i], nx, nz, ny);
+      memset(this->temporal_frames[i], 0, nx * nz * ny * sizeof(float));
+    }
+  }
+  // Each thread needs two frames of the largest block grown by the reach,
+  // each rounded to a multiple of the vector length with a vector of padding
+  // on both sides, so that the frames share the same alignment.
+  size_t frame_size = (size_t)min(parameters->block_x + 2 * reach, wnx) *
+                      min(parameters->block_z + 2 * reach, wnz);
+  if (!is_2D) {
+    frame_size *= min(parameters->block_y + 2 * reach, wny);
+  }
+  frame_size = ((frame_size + 15) / 16) * 16 + 32;
+  size_t scratch_per_thread = 2 * frame_size;
+  size_t scratch_size = scratch_per_thread * omp_get_max_threads();
+  if (scratch_size > this->temporal_scratch_size) {
+    if (this->temporal_scratch != nullptr) {
+      mem_free((void *)this->temporal_scratch);
+    }
+    this->temporal_scratch =
+        (float *)mem_allocate(sizeof(float), scratch_size,
+                              "temporal_blocking_scratch", half_length);
+    this->temporal_scratch_size = scratch_size;
+  }
+  // The damping of the boundary is taken once for the window of the
+  // propagation.
+  const float *damping = nullptr;
+  if (damped) {
+    if (this->temporal_damping == nullptr) {
+      this->temporal_damping = (float *)mem_allocate(
+          sizeof(float),
+          grid->grid_size.nx * grid->grid_size.nz * grid->grid_size.ny,
+          "temporal_blocking_damping", half_length);
+    }
+    if (!this->damping_ready) {
+      this->boundary_manager->GetDamping(this->temporal_damping);
+      this->damping_ready = true;
+    }
+    damping = this->temporal_damping;
+  }
+  // The result needs two frames that are not read by the computation, the
+  // next frame is only one of them if it is not the previous frame too.
+  float *prev_out = this->temporal_frames[0];
+  float *curr_out = this->temporal_frames[1];
+  bool three_pointers = grid->pressure_previous != grid->pressure_next;
+  if (three_pointers) {
+    curr_out = grid->pressure_next;
+  }
+  StencilRowFunction stencil_row =
+      GetSimdStencilRow(parameters->simd_isa, is_2D, parameters->half_length);
+  if (is_2D) {
+    switch (parameters->half_length) {
+    case O_2:
+      TemporalComputation<true, O_2>(grid, parameters, time_steps, prev_out,
+                                     curr_out, temporal_scratch,
+                                     scratch_per_thread, stencil_row,
+                                     step_injections.data(), damping);
+      break;
+    case O_4:
+      TemporalComputation<true, O_4>(grid, parameters, time_steps, prev_out,
+                                     curr_out, temporal_scratch,
+                                     scratch_per_thread, stencil_row,
+                                     step_injections.data(), damping);
+      break;
+    case O_8:
+      TemporalComputation<true, O_8>(grid, parameters, time_steps, prev_out,
+                                     curr_out, temporal_scratch,
+                                     scratch_per_thread, stencil_row,
+                                     step_injections.data(), damping);
+      break;
+    case O_12:
+      TemporalComputation<true, O_12>(grid, parameters, time_steps, prev_out,
+                                      curr_out, temporal_scratch,
+                                      scratch_per_thread, stencil_row,
+                                      step_injections.data(), damping);
+      break;
+    case O_16:
+      TemporalComputation<true, O_16>(grid, parameters, time_steps, prev_out,
+                                      curr_out, temporal_scratch,
+                                      scratch_per_thread, stencil_row,
+                                      step_injections.data(), damping);
+      break;
+    }
+  } else {
+    switch (parameters->half_length) {
+    case O_2:
+      TemporalComputation<false, O_2>(grid, parameters, time_steps, prev_out,
+                                      curr_out, temporal_scratch,
+                                      scratch_per_thread, stencil_row,
+                                      step_injections.data(), damping);
+      break;
+    case O_4:
+      TemporalComputation<false, O_4>(grid, parameters, time_steps, prev_out,
+                                      curr_out, temporal_scratch,
+                                      scratch_per_thread, stencil_row,
+                                      step_injections.data(), damping);
+      break;
+    case O_8:
+      TemporalComputation<false, O_8>(grid, parameters, time_steps, prev_out,
+                                      curr_out, temporal_scratch,
+                                      scratch_per_thread, stencil_row,
+                                      step_injections.data(), damping);
+      break;
+    case O_12:
+      TemporalComputation<false, O_12>(grid, parameters, time_steps, prev_out,
+                                       curr_out, temporal_scratch,
+                                       scratch_per_thread, stencil_row,
+                                       step_injections.data(), damping);
+      break;
+    case O_16:
+      TemporalComputation<false, O_16>(grid, parameters, time_steps, prev_out,
+                                       curr_out, temporal_scratch,
+                                       scratch_per_thread, stencil_row,
+                                       step_injections.data(), damping);
+      break;
+    }
+  }
+  // The frames that were read become the spare frames for the next call,
+  // keeping the two/three pointers layout of the grid.
+  if (three_pointers) {
+    this->temporal_frames[0] = grid->pressure_current;
+    grid->pressure_next = grid->pressure_previous;
+    grid->pressure_previous = prev_out;
+    grid->pressure_current = curr_out;
+  } else {
+    this->temporal_frames[0] = grid->pressure_previous;
+    this->temporal_frames[1] = grid->pressure_current;
+    grid->pressure_previous = prev_out;
+    grid->pressure_current = curr_out;
+    grid->pressure_next = prev_out;
+  }
+  this->injections.clear();
+  this->next_injection = 0;
+  timer->stop_timer("ComputationKernel::MultiStep");
+}
+
+void SecondOrderComputationKernel::TuneBlocks(uint nx, uint nz, uint ny) {
+  this->blocks_tuned = true;
+  uint half_length = parameters->half_length;
+  bool is_2D = ny == 1;
+  string key =
+      GetAutotuneKey(nx, nz, ny, half_length, omp_get_max_threads());
+  TunedBlocks blocks;
+  if (ReadTunedBlocks(parameters->autotune_cache, key, blocks)) {
+    cout << "Using the tuned blocking factors of " << parameters->autotune_cache
+         << " : " << blocks.block_x << "x" << blocks.block_z << "x"
+         << blocks.block_y << endl;
+    parameters->block_x = blocks.block_x;
+    parameters->block_z = blocks.block_z;
+    parameters->block_y = blocks.block_y;
+    return;
+  }
+  cout << "Autotuning the blocking factors of the plain stencil..." << endl;
+  Timer *timer = Timer::getInstance();
+  timer->start_timer("ComputationKernel::Autotune");
+  // Time-steps of the plain stencil are taken on a grid of the same size, all
+  // zeros so that the timings aren't affected by denormals. The variants
+  // fused with the injection or the imaging, temporally blocked or on narrow
+  // wavefields use the blocks tuned for it.
+  uint size = nx * nz * ny;
+  float *curr = (float *)mem_allocate(sizeof(float), size, "autotune_curr",
+                                      half_length);
+  float *prev = (float *)mem_allocate(sizeof(float), size, "autotune_prev",
+                                      half_length, 16);
+  float *vel = (float *)mem_allocate(sizeof(float), size, "autotune_vel",
+                                     half_length, 32);
+  for (float *ptr : {curr, prev, vel}) {
+    this->FirstTouch(ptr, nx, nz, ny);
+    memset(ptr, 0, size * sizeof(float));
+  }
+  AcousticSecondGrid tune_grid;
+  tune_grid.grid_size.nx = nx;
+  tune_grid.grid_size.nz = nz;
+  tune_grid.grid_size.ny = ny;
+  tune_grid.window_size.window_start = {0, 0, 0};
+  tune_grid.window_size.window_nx = nx;
+  tune_grid.window_size.window_nz = nz;
+  tune_grid.window_size.window_ny = ny;
+  tune_grid.cell_dimensions = {1, 1, 1};
+  tune_grid.velocity = vel;
+  tune_grid.pressure_current = curr;
+  tune_grid.pressure_previous = prev;
+  tune_grid.pressure_next = prev;
+  StencilRowFunction stencil_row =
+      GetSimdStencilRow(parameters->simd_isa, is_2D, parameters->half_length);
+  // The fastest of a few time-steps after a warm up one.
+  auto measure = [&]() {
+    ComputeStep(&tune_grid, parameters, stencil_row, nullptr, nullptr,
+                nullptr, false);
+    double best = 0;
+    for (int i = 0; i < AUTOTUNE_STEPS; i++) {
+      double start = omp_get_wtime();
+      ComputeStep(&tune_grid, parameters, stencil_row, nullptr, nullptr,
+                nullptr, false);
+      double elapsed = omp_get_wtime() - start;
+      if (i == 0 || elapsed < best) {
+        best = elapsed;
+      }
+    }
+    return best;
+  };
+  // The candidates of each direction, limited by the computational domain.
+  auto candidates = [](std::initializer_list<uint> values, uint limit) {
+    vector<uint> result;
+    for (uint value : values) {
+      if (value < limit) {
+        result.push_back(value);
+      }
+    }
+    result.push_back(limit);
+    return result;
+  };
+  uint *factors[3] = {&parameters->block_x, &parameters->block_z,
+                      &parameters->block_y};
+  vector<uint> directions[3] = {
+      candidates({32, 64, 128, 256, 512, 1024}, nx - 2 * half_length),
+      candidates({4, 8, 16, 32, 64, 128}, nz - 2 * half_length),
+      candidates({1, 2, 4, 8, 16, 32}, is_2D ? 1 : ny - 2 * half_length)};
+  // Start from the given blocks limited to the domain, then tune one
+  // direction at a time.
+  for (int d = 0; d < 3; d++) {
+    *factors[d] = min(*factors[d], directions[d].back());
+  }
+  double best_time = measure();
+  for (int d = 0; d < (is_2D ? 2 : 3); d++) {
+    uint best_factor = *factors[d];
+    for (uint factor : directions[d]) {
+      if (factor == best_factor) {
+        continue;
+      }
+      *factors[d] = factor;
+      double time = measure();
+      if (time < best_time) {
+        best_time = time;
+        best_factor = factor;
+      }
+    }
+    *factors[d] = best_factor;
+  }
+  mem_free(curr);
+  mem_free(prev);
+  mem_free(vel);
+  timer->stop_timer("ComputationKernel::Autotune");
+  blocks = {parameters->block_x, parameters->block_z, parameters->block_y};
+  cout << "Tuned blocking factors : " << blocks.block_x << "x"
+       << blocks.block_z << "x" << blocks.block_y << " ("
+       << best_time * 1000 << " ms per time-step)" << endl;
+  WriteTunedBlocks(parameters->autotune_cache, key, blocks);
+}
+
+bool SecondOrderComputationKernel::SupportsInjection() {
+  // The batched step computes all the shots at once.
+  return parameters->shot_batch == 1;
+}
+
+void SecondOrderComputationKernel::SetInjection(InjectionList *injection) {
+  // The list is copied, as the components reuse its buffers for the next one.
+  size_t index = this->injections.size();
+  if (this->injection_offsets.size() <= index) {
+    this->injection_offsets.resize(index + 1);
+    this->injection_amplitudes.resize(index + 1);
+  }
+  this->injection_offsets[index].assign(
+      injection->offsets, injection->offsets + injection->num_points);
+  this->injection_amplitudes[index].assign(
+      injection->amplitudes, injection->amplitudes + injection->num_points);
+  InjectionList queued;
+  queued.num_points = injection->num_points;
+  queued.offsets = this->injection_offsets[index].data();
+  queued.amplitudes = this->injection_amplitudes[index].data();
+  this->injections.push_back(queued);
+}
+
+bool SecondOrderComputationKernel::SupportsImaging() {
+  // The batched step computes all the shots at once.
+  return parameters->shot_batch == 1;
+}
+
+
+void SecondOrderComputationKernel::SetImaging(FusedImaging *imaging) {
+  this->imaging = imaging;
+}
+
+bool SecondOrderComputationKernel::SupportsActiveBox() {
+  // The batched step computes all the shots at once.
+  return parameters->shot_batch == 1;
+}
+
+void SecondOrderComputationKernel::SetActiveBox(const ActiveBox *box) {
+  this->active_box = box;
+}
+
+void SecondOrderComputationKernel::PreparePropagation() {
+  // The window, and so the damping of its boundary, may change with the shot.
+  this->damping_ready = false;
+  if (!parameters->narrow_wavefields) {
+    return;
+  }
+  // The velocity is read by the stencil in the precision of the wavefields,
+  // allocated for the full grid so that it fits the window of any shot.
+  size_t size = (size_t)grid->grid_size.nx * grid->grid_size.nz *
+                grid->grid_size.ny;
+  if (this->narrow_velocity == nullptr) {
+    this->narrow_velocity = (uint16_t *)mem_allocate(
+        sizeof(uint16_t), size, "narrow_velocity", parameters->half_length);
+  }
+  PackHalf(grid->velocity, this->narrow_velocity, size,
+           parameters->wavefield_precision, 1.0f);
+}
+
+bool SecondOrderComputationKernel::SupportsNarrowWavefields() { return true; }
+
 void SecondOrderComputationKernel::FirstTouch(float *ptr, uint nx, uint nz,
                                               uint ny) {
+  // The blocks are tuned before the first touch, so that the memory is placed
+  // the way the computation accesses it.
+  if (parameters->autotune && !this->blocks_tuned) {
+    this->TuneBlocks(nx, nz, ny);
+  }
   float *curr_base = ptr;
   float *curr;
   int wnx = nx;
@@ -367,10 +1640,21 @@ void SecondOrderComputationKernel::SetComputationParameters(
               << std::endl;
     exit(-1);
   }
+  // Resolve the instruction set of the stencil kernels.
+  SIMD_ISA supported = DetectSimdIsa();
+  if (this->parameters->simd_isa == ISA_AUTO) {
+    this->parameters->simd_isa = supported;
+  } else if (this->parameters->simd_isa > supported) {
+    std::cout << "Instruction set " << GetSimdIsaName(this->parameters->simd_isa)
+              << " is not supported by the cpu, using "
+              << GetSimdIsaName(supported) << " instead" << std::endl;
+    this->parameters->simd_isa = supported;
+  }
+  std::cout << "Stencil instruction set : "
+            << GetSimdIsaName(this->parameters->simd_isa) << std::endl;
 }
 
 void SecondOrderComputationKernel::SetGridBox(GridBox *grid_box) {
-  ;
   this->grid = (AcousticSecondGrid *)(grid_box);
   if (this->grid == nullptr) {
     std::cout << "Not a compatible gridbox : "
@@ -379,3 +1663,5 @@ void SecondOrderComputationKernel::SetGridBox(GridBox *grid_box) {
     exit(-1);
   }
 }
+
+bool SecondOrderComputationKernel::SupportsShotBatch() { return true; }
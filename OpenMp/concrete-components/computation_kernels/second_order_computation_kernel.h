@@ -7,12 +7,62 @@
 
 #include <concrete-components/data_units/acoustic_openmp_computation_parameters.h>
 #include <concrete-components/data_units/acoustic_second_grid.h>
+#include <cstddef>
+#include <cstdint>
 #include <skeleton/components/computation_kernel.h>
+#include <vector>
 
 class SecondOrderComputationKernel : public ComputationKernel {
 private:
   AcousticSecondGrid *grid;
   AcousticOmpComputationParameters *parameters;
+  // Spare frames receiving the results of the temporal blocking.
+  float *temporal_frames[2];
+  // Thread private scratch of the temporal blocking.
+  float *temporal_scratch;
+  size_t temporal_scratch_size;
+  // The factors the boundary manager scales each point by, for the temporal
+  // blocking, and whether they were taken for the current propagation.
+  float *temporal_damping;
+  bool damping_ready;
+  // The injections of the current frames of the next steps, in order.
+  std::vector<InjectionList> injections;
+  // The first of the injections not used yet.
+  size_t next_injection;
+  // The copies of the queued injections, as the given lists are only valid
+  // till the components build the next one.
+  std::vector<std::vector<uint>> injection_offsets;
+  std::vector<std::vector<float>> injection_amplitudes;
+  // The imaging to apply in the next step.
+  FusedImaging *imaging;
+  // The box of the window the time-steps are restricted to, if any.
+  const ActiveBox *active_box;
+  // Whether the blocking factors were tuned already.
+  bool blocks_tuned;
+  // The velocity in the precision of the narrow wavefields.
+  uint16_t *narrow_velocity;
+  // Thread private scratch of the narrow wavefields steps.
+  float *narrow_scratch;
+  size_t narrow_scratch_size;
+
+  /*!
+   * Takes the time-step of the narrow wavefields, converting them to fp32
+   * block by block.
+   */
+  void NarrowStep(const InjectionList *injection);
+
+  /*!
+   * @return
+   * The injection of the next step, nullptr if none was set.
+   */
+  const InjectionList *NextInjection();
+
+  /*!
+   * Tunes the blocking factors of the computation parameters for a grid of
+   * the given size by timing a few time-steps of candidate blocks, or takes
+   * them from the autotuning cache file if that grid was tuned before.
+   */
+  void TuneBlocks(uint nx, uint nz, uint ny);
 
 public:
   SecondOrderComputationKernel();
@@ -20,11 +70,31 @@ public:
 
   void Step() override;
 
+  void MultiStep(uint time_steps) override;
+
+  bool SupportsInjection() override;
+
+  void SetInjection(InjectionList *injection) override;
+
+  bool SupportsImaging() override;
+
+  void SetImaging(FusedImaging *imaging) override;
+
+  bool SupportsActiveBox() override;
+
+  void SetActiveBox(const ActiveBox *box) override;
+
+  void PreparePropagation() override;
+
   void FirstTouch(float *ptr, uint nx, uint nz, uint ny) override;
 
   void SetComputationParameters(ComputationParameters *parameters) override;
 
   void SetGridBox(GridBox *grid_box) override;
+
+  bool SupportsShotBatch() override;
+
+  bool SupportsNarrowWavefields() override;
 };
 
 #endif // ACOUSTIC2ND_RTM_COMPUTATION_KERNEL_RTM_COMPUTATION_KERNEL_H
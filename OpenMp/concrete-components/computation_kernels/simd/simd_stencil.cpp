@@ -0,0 +1,387 @@
+#include "simd_stencil.h"
+#include <cstdint>
+#include <immintrin.h>
+
+/*!
+ * Intrinsics implementations of the stencil row. The functions are compiled
+ * for their instruction set through the target attribute, so the binary runs
+ * on any cpu and the implementation is selected at runtime by DetectSimdIsa.
+ *
+ * The x-neighbours are register blocked : when the rows of the current,
+ * previous and next frames share the same alignment, each iteration loads a
+ * single aligned vector of the current frame to the right, and the shifted
+ * neighbours are extracted from the three vectors in registers. Otherwise, the
+ * neighbours are loaded directly with unaligned loads.
+ */
+
+// Computes a single point, used to peel the row to the vector alignment and
+// for the remainder of the row.
+template <bool is_2D, HALF_LENGTH half_length>
+inline void StencilPoint(const float *curr, const float *prev, float *next,
+                         const float *vel, int ix, const float *coeff_x,
+                         const float *coeff_z, const float *coeff_y,
+                         const int *vertical, const int *front,
+                         float coeff_xyz) {
+  float value = curr[ix] * coeff_xyz;
+  for (int i = 0; i < half_length; i++) {
+    value += (curr[ix - (i + 1)] + curr[ix + (i + 1)]) * coeff_x[i];
+    value += (curr[ix - vertical[i]] + curr[ix + vertical[i]]) * coeff_z[i];
+    if (!is_2D) {
+      value += (curr[ix - front[i]] + curr[ix + front[i]]) * coeff_y[i];
+    }
+  }
+  next[ix] = (2 * curr[ix]) - prev[ix] + (vel[ix] * value);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////////// AVX-512 ////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+// Returns the 16 elements starting at element k of the concatenation of low
+// and high.
+template <int k>
+__attribute__((target("avx512f"))) inline __m512 Shift512(__m512 low,
+                                                          __m512 high) {
+  return _mm512_castsi512_ps(_mm512_alignr_epi32(
+      _mm512_castps_si512(high), _mm512_castps_si512(low), k));
+}
+
+// Accumulates the x-neighbours at distance s given the vectors to the left,
+// center and right of the computed points.
+template <int s>
+__attribute__((target("avx512f"))) inline __m512
+AccumulateX512(__m512 left, __m512 center, __m512 right, __m512 coeff,
+               __m512 value) {
+  __m512 neighbours = _mm512_add_ps(Shift512<16 - s>(left, center),
+                                    Shift512<s>(center, right));
+  return _mm512_fmadd_ps(neighbours, coeff, value);
+}
+
+template <bool is_2D, HALF_LENGTH half_length, bool aligned>
+__attribute__((target("avx512f"))) inline int
+Avx512Vectors(const float *curr, const float *prev, float *next,
+              const float *vel, int ix, int n, const __m512 *coeff_x,
+              const __m512 *coeff_z, const __m512 *coeff_y,
+              const int *vertical, const int *front, __m512 coeff_xyz) {
+  __m512 left, center, right;
+  if (aligned) {
+    left = _mm512_load_ps(curr + ix - 16);
+    center = _mm512_load_ps(curr + ix);
+  }
+  for (; ix + 16 <= n; ix += 16) {
+    __m512 value;
+    if (aligned) {
+      right = _mm512_load_ps(curr + ix + 16);
+      value = _mm512_mul_ps(center, coeff_xyz);
+      value = AccumulateX512<1>(left, center, right, coeff_x[0], value);
+      if (half_length > 1) {
+        value = AccumulateX512<2>(left, center, right, coeff_x[1], value);
+      }
+      if (half_length > 2) {
+        value = AccumulateX512<3>(left, center, right, coeff_x[2], value);
+        value = AccumulateX512<4>(left, center, right, coeff_x[3], value);
+      }
+      if (half_length > 4) {
+        value = AccumulateX512<5>(left, center, right, coeff_x[4], value);
+        value = AccumulateX512<6>(left, center, right, coeff_x[5], value);
+      }
+      if (half_length > 6) {
+        value = AccumulateX512<7>(left, center, right, coeff_x[6], value);
+        value = AccumulateX512<8>(left, center, right, coeff_x[7], value);
+      }
+    } else {
+      center = _mm512_loadu_ps(curr + ix);
+      value = _mm512_mul_ps(center, coeff_xyz);
+      for (int i = 0; i < half_length; i++) {
+        value = _mm512_fmadd_ps(
+            _mm512_add_ps(_mm512_loadu_ps(curr + ix - (i + 1)),
+                          _mm512_loadu_ps(curr + ix + (i + 1))),
+            coeff_x[i], value);
+      }
+    }
+    for (int i = 0; i < half_length; i++) {
+      value = _mm512_fmadd_ps(
+          _mm512_add_ps(_mm512_loadu_ps(curr + ix - vertical[i]),
+                        _mm512_loadu_ps(curr + ix + vertical[i])),
+          coeff_z[i], value);
+    }
+    if (!is_2D) {
+      for (int i = 0; i < half_length; i++) {
+        value = _mm512_fmadd_ps(
+            _mm512_add_ps(_mm512_loadu_ps(curr + ix - front[i]),
+                          _mm512_loadu_ps(curr + ix + front[i])),
+            coeff_y[i], value);
+      }
+    }
+    __m512 previous =
+        aligned ? _mm512_load_ps(prev + ix) : _mm512_loadu_ps(prev + ix);
+    __m512 result = _mm512_fmadd_ps(
+        _mm512_loadu_ps(vel + ix), value,
+        _mm512_sub_ps(_mm512_add_ps(center, center), previous));
+    if (aligned) {
+      _mm512_store_ps(next + ix, result);
+      left = center;
+      center = right;
+    } else {
+      _mm512_storeu_ps(next + ix, result);
+    }
+  }
+  return ix;
+}
+
+template <bool is_2D, HALF_LENGTH half_length>
+__attribute__((target("avx512f"))) void
+Avx512StencilRow(const float *curr, const float *prev, float *next,
+                 const float *vel, int n, const float *coeff_x,
+                 const float *coeff_z, const float *coeff_y,
+                 const int *vertical, const int *front, float coeff_xyz) {
+  int ix = 0;
+  // Peel the row till the next frame is aligned.
+  while (ix < n && ((uintptr_t)(next + ix) % 64) != 0) {
+    StencilPoint<is_2D, half_length>(curr, prev, next, vel, ix, coeff_x,
+                                     coeff_z, coeff_y, vertical, front,
+                                     coeff_xyz);
+    ix++;
+  }
+  __m512 v_coeff_x[half_length];
+  __m512 v_coeff_z[half_length];
+  __m512 v_coeff_y[half_length];
+  for (int i = 0; i < half_length; i++) {
+    v_coeff_x[i] = _mm512_set1_ps(coeff_x[i]);
+    v_coeff_z[i] = _mm512_set1_ps(coeff_z[i]);
+    v_coeff_y[i] = _mm512_set1_ps(is_2D ? 0 : coeff_y[i]);
+  }
+  __m512 v_coeff_xyz = _mm512_set1_ps(coeff_xyz);
+  if (((uintptr_t)(curr + ix) % 64) == 0 &&
+      ((uintptr_t)(prev + ix) % 64) == 0) {
+    ix = Avx512Vectors<is_2D, half_length, true>(
+        curr, prev, next, vel, ix, n, v_coeff_x, v_coeff_z, v_coeff_y,
+        vertical, front, v_coeff_xyz);
+  } else {
+    ix = Avx512Vectors<is_2D, half_length, false>(
+        curr, prev, next, vel, ix, n, v_coeff_x, v_coeff_z, v_coeff_y,
+        vertical, front, v_coeff_xyz);
+  }
+  for (; ix < n; ix++) {
+    StencilPoint<is_2D, half_length>(curr, prev, next, vel, ix, coeff_x,
+                                     coeff_z, coeff_y, vertical, front,
+                                     coeff_xyz);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// AVX2 /////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+// Returns the 8 elements starting at element k of the concatenation of low
+// and high, alignr only shifts inside the 128 bits lanes so the middle
+// of the concatenation is built first.
+template <int k>
+__attribute__((target("avx2,fma"))) inline __m256 Shift256(__m256 low,
+                                                           __m256 high) {
+  if (k == 0) {
+    return low;
+  }
+  if (k == 8) {
+    return high;
+  }
+  __m256 middle = _mm256_permute2f128_ps(low, high, 0x21);
+  if (k == 4) {
+    return middle;
+  }
+  if (k < 4) {
+    return _mm256_castsi256_ps(_mm256_alignr_epi8(
+        _mm256_castps_si256(middle), _mm256_castps_si256(low), (k & 3) * 4));
+  }
+  return _mm256_castsi256_ps(_mm256_alignr_epi8(
+      _mm256_castps_si256(high), _mm256_castps_si256(middle), (k & 3) * 4));
+}
+
+template <int s>
+__attribute__((target("avx2,fma"))) inline __m256
+AccumulateX256(__m256 left, __m256 center, __m256 right, __m256 coeff,
+               __m256 value) {
+  __m256 neighbours = _mm256_add_ps(Shift256<8 - s>(left, center),
+                                    Shift256<s>(center, right));
+  return _mm256_fmadd_ps(neighbours, coeff, value);
+}
+
+template <bool is_2D, HALF_LENGTH half_length, bool aligned>
+__attribute__((target("avx2,fma"))) inline int
+Avx2Vectors(const float *curr, const float *prev, float *next,
+            const float *vel, int ix, int n, const __m256 *coeff_x,
+            const __m256 *coeff_z, const __m256 *coeff_y, const int *vertical,
+            const int *front, __m256 coeff_xyz) {
+  __m256 left, center, right;
+  if (aligned) {
+    left = _mm256_load_ps(curr + ix - 8);
+    center = _mm256_load_ps(curr + ix);
+  }
+  for (; ix + 8 <= n; ix += 8) {
+    __m256 value;
+    if (aligned) {
+      right = _mm256_load_ps(curr + ix + 8);
+      value = _mm256_mul_ps(center, coeff_xyz);
+      value = AccumulateX256<1>(left, center, right, coeff_x[0], value);
+      if (half_length > 1) {
+        value = AccumulateX256<2>(left, center, right, coeff_x[1], value);
+      }
+      if (half_length > 2) {
+        value = AccumulateX256<3>(left, center, right, coeff_x[2], value);
+        value = AccumulateX256<4>(left, center, right, coeff_x[3], value);
+      }
+      if (half_length > 4) {
+        value = AccumulateX256<5>(left, center, right, coeff_x[4], value);
+        value = AccumulateX256<6>(left, center, right, coeff_x[5], value);
+      }
+      if (half_length > 6) {
+        value = AccumulateX256<7>(left, center, right, coeff_x[6], value);
+        value = AccumulateX256<8>(left, center, right, coeff_x[7], value);
+      }
+    } else {
+      center = _mm256_loadu_ps(curr + ix);
+      value = _mm256_mul_ps(center, coeff_xyz);
+      for (int i = 0; i < half_length; i++) {
+        value = _mm256_fmadd_ps(
+            _mm256_add_ps(_mm256_loadu_ps(curr + ix - (i + 1)),
+                          _mm256_loadu_ps(curr + ix + (i + 1))),
+            coeff_x[i], value);
+      }
+    }
+    for (int i = 0; i < half_length; i++) {
+      value = _mm256_fmadd_ps(
+          _mm256_add_ps(_mm256_loadu_ps(curr + ix - vertical[i]),
+                        _mm256_loadu_ps(curr + ix + vertical[i])),
+          coeff_z[i], value);
+    }
+    if (!is_2D) {
+      for (int i = 0; i < half_length; i++) {
+        value = _mm256_fmadd_ps(
+            _mm256_add_ps(_mm256_loadu_ps(curr + ix - front[i]),
+                          _mm256_loadu_ps(curr + ix + front[i])),
+            coeff_y[i], value);
+      }
+    }
+    __m256 previous =
+        aligned ? _mm256_load_ps(prev + ix) : _mm256_loadu_ps(prev + ix);
+    __m256 result = _mm256_fmadd_ps(
+        _mm256_loadu_ps(vel + ix), value,
+        _mm256_sub_ps(_mm256_add_ps(center, center), previous));
+    if (aligned) {
+      _mm256_store_ps(next + ix, result);
+      left = center;
+      center = right;
+    } else {
+      _mm256_storeu_ps(next + ix, result);
+    }
+  }
+  return ix;
+}
+
+template <bool is_2D, HALF_LENGTH half_length>
+__attribute__((target("avx2,fma"))) void
+Avx2StencilRow(const float *curr, const float *prev, float *next,
+               const float *vel, int n, const float *coeff_x,
+               const float *coeff_z, const float *coeff_y, const int *vertical,
+               const int *front, float coeff_xyz) {
+  int ix = 0;
+  // Peel the row till the next frame is aligned.
+  while (ix < n && ((uintptr_t)(next + ix) % 32) != 0) {
+    StencilPoint<is_2D, half_length>(curr, prev, next, vel, ix, coeff_x,
+                                     coeff_z, coeff_y, vertical, front,
+                                     coeff_xyz);
+    ix++;
+  }
+  __m256 v_coeff_x[half_length];
+  __m256 v_coeff_z[half_length];
+  __m256 v_coeff_y[half_length];
+  for (int i = 0; i < half_length; i++) {
+    v_coeff_x[i] = _mm256_set1_ps(coeff_x[i]);
+    v_coeff_z[i] = _mm256_set1_ps(coeff_z[i]);
+    v_coeff_y[i] = _mm256_set1_ps(is_2D ? 0 : coeff_y[i]);
+  }
+  __m256 v_coeff_xyz = _mm256_set1_ps(coeff_xyz);
+  if (((uintptr_t)(curr + ix) % 32) == 0 &&
+      ((uintptr_t)(prev + ix) % 32) == 0) {
+    ix = Avx2Vectors<is_2D, half_length, true>(
+        curr, prev, next, vel, ix, n, v_coeff_x, v_coeff_z, v_coeff_y,
+        vertical, front, v_coeff_xyz);
+  } else {
+    ix = Avx2Vectors<is_2D, half_length, false>(
+        curr, prev, next, vel, ix, n, v_coeff_x, v_coeff_z, v_coeff_y,
+        vertical, front, v_coeff_xyz);
+  }
+  for (; ix < n; ix++) {
+    StencilPoint<is_2D, half_length>(curr, prev, next, vel, ix, coeff_x,
+                                     coeff_z, coeff_y, vertical, front,
+                                     coeff_xyz);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////////// Dispatch //////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+SIMD_ISA DetectSimdIsa() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return ISA_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return ISA_AVX2;
+  }
+  return ISA_SCALAR;
+}
+
+template <bool is_2D>
+StencilRowFunction GetStencilRow(SIMD_ISA isa, HALF_LENGTH half_length) {
+  if (isa == ISA_AVX512) {
+    switch (half_length) {
+    case O_2:
+      return Avx512StencilRow<is_2D, O_2>;
+    case O_4:
+      return Avx512StencilRow<is_2D, O_4>;
+    case O_8:
+      return Avx512StencilRow<is_2D, O_8>;
+    case O_12:
+      return Avx512StencilRow<is_2D, O_12>;
+    case O_16:
+      return Avx512StencilRow<is_2D, O_16>;
+    }
+  } else if (isa == ISA_AVX2) {
+    switch (half_length) {
+    case O_2:
+      return Avx2StencilRow<is_2D, O_2>;
+    case O_4:
+      return Avx2StencilRow<is_2D, O_4>;
+    case O_8:
+      return Avx2StencilRow<is_2D, O_8>;
+    case O_12:
+      return Avx2StencilRow<is_2D, O_12>;
+    case O_16:
+      return Avx2StencilRow<is_2D, O_16>;
+    }
+  }
+  return nullptr;
+}
+
+StencilRowFunction GetSimdStencilRow(SIMD_ISA isa, bool is_2D,
+                                     HALF_LENGTH half_length) {
+  if (is_2D) {
+    return GetStencilRow<true>(isa, half_length);
+  }
+  return GetStencilRow<false>(isa, half_length);
+}
+
+const char *GetSimdIsaName(SIMD_ISA isa) {
+  switch (isa) {
+  case ISA_AVX512:
+    return "avx512";
+  case ISA_AVX2:
+    return "avx2";
+  case ISA_SCALAR:
+    return "scalar";
+  default:
+    return "auto";
+  }
+}
@@ -0,0 +1,61 @@
+#ifndef ACOUSTIC2ND_RTM_SIMD_STENCIL_H
+#define ACOUSTIC2ND_RTM_SIMD_STENCIL_H
+
+#include <concrete-components/data_units/acoustic_openmp_computation_parameters.h>
+#include <skeleton/base/datatypes.h>
+
+/*!
+ * Computes the next pressure values of a row of n points of the second order
+ * acoustic wave equation.
+ * @param curr
+ * Pointer to the start of the row in the current frame.
+ * @param prev
+ * Pointer to the start of the row in the previous frame.
+ * @param next
+ * Pointer to the start of the row in the next frame, may be the same as prev.
+ * @param vel
+ * Pointer to the start of the row in the velocity(multiplied by dt^2).
+ * @param n
+ * The number of points in the row.
+ * @param coeff_x
+ * The coefficients in the x-direction, scaled by the cell dimensions.
+ * @param coeff_z
+ * The coefficients in the z-direction, scaled by the cell dimensions.
+ * @param coeff_y
+ * The coefficients in the y-direction, scaled by the cell dimensions.
+ * @param vertical
+ * The offsets of the neighbours in the z-direction.
+ * @param front
+ * The offsets of the neighbours in the y-direction.
+ * @param coeff_xyz
+ * The coefficient of the center point.
+ */
+typedef void (*StencilRowFunction)(const float *curr, const float *prev,
+                                   float *next, const float *vel, int n,
+                                   const float *coeff_x, const float *coeff_z,
+                                   const float *coeff_y, const int *vertical,
+                                   const int *front, float coeff_xyz);
+
+/*!
+ * Detects the widest instruction set the stencil kernels support on the
+ * running cpu.
+ * @return
+ * ISA_AVX512, ISA_AVX2 or ISA_SCALAR.
+ */
+SIMD_ISA DetectSimdIsa();
+
+/*!
+ * Gets the intrinsics implementation of the stencil row for the given
+ * instruction set.
+ * @return
+ * The stencil row function, nullptr for ISA_SCALAR.
+ */
+StencilRowFunction GetSimdStencilRow(SIMD_ISA isa, bool is_2D,
+                                     HALF_LENGTH half_length);
+
+/*!
+ * Gets a printable name of the instruction set.
+ */
+const char *GetSimdIsaName(SIMD_ISA isa);
+
+#endif // ACOUSTIC2ND_RTM_SIMD_STENCIL_H
@@ -2,6 +2,7 @@
 // Created by mirnamoawad on 10/30/19.
 //
 #include "cross_correlation_kernel.h"
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <iostream>
@@ -13,7 +14,8 @@ using namespace std;
 
 template <bool is_2D>
 void Correlation(float *out, GridBox *in_1, GridBox *in_2,
-                 AcousticOmpComputationParameters *parameters) {
+                 AcousticOmpComputationParameters *parameters,
+                 const ActiveBox *box) {
 
   GridBox *in_grid_1 = in_1;
   GridBox *in_grid_2 = in_2;
@@ -27,12 +29,18 @@ void Correlation(float *out, GridBox *in_1, GridBox *in_2,
   float *frame_2 = in_grid_2->pressure_current;
   float *curr_1;
   float *curr_2;
+  // The shots of a batch are interleaved innermost, so each row holds the
+  // points of all of them one after the other.
+  int batch = parameters->shot_batch;
   float *output = out;
-  output = output + (in_grid_2->window_size.window_start.y * nx * nz) +
-           (in_grid_2->window_size.window_start.z * nx) +
-           in_grid_2->window_size.window_start.x;
+  output = output + ((in_grid_2->window_size.window_start.y * nx * nz) +
+                     (in_grid_2->window_size.window_start.z * nx) +
+                     in_grid_2->window_size.window_start.x) *
+                        batch;
   float *curr_o;
   uint offset = parameters->half_length;
+  int x_start = offset;
+  int z_start = offset;
   int nxEnd = wnx - offset;
   int nyEnd;
   int nzEnd = wnz - offset;
@@ -44,6 +52,17 @@ void Correlation(float *out, GridBox *in_1, GridBox *in_2,
     y_start = 0;
     nyEnd = 1;
   }
+  if (box != nullptr) {
+    // Only correlate inside the box.
+    x_start = max(x_start, (int)box->start.x);
+    z_start = max(z_start, (int)box->start.z);
+    nxEnd = min(nxEnd, (int)box->end.x);
+    nzEnd = min(nzEnd, (int)box->end.z);
+    if (!is_2D) {
+      y_start = max(y_start, (int)box->start.y);
+      nyEnd = min(nyEnd, (int)box->end.y);
+    }
+  }
 #pragma omp parallel default(shared)
   {
     const uint block_x = parameters->block_x;
@@ -52,8 +71,8 @@ void Correlation(float *out, GridBox *in_1, GridBox *in_2,
 
 #pragma omp for schedule(static, 1) collapse(2)
     for (int by = y_start; by < nyEnd; by += block_y) {
-      for (int bz = offset; bz < nzEnd; bz += block_z) {
-        for (int bx = offset; bx < nxEnd; bx += block_x) {
+      for (int bz = z_start; bz < nzEnd; bz += block_z) {
+        for (int bx = x_start; bx < nxEnd; bx += block_x) {
 
           int izEnd = fmin(bz + block_z, nzEnd);
           int iyEnd = fmin(by + block_y, nyEnd);
@@ -61,12 +80,12 @@ void Correlation(float *out, GridBox *in_1, GridBox *in_2,
 
           for (int iy = by; iy < iyEnd; ++iy) {
             for (int iz = bz; iz < izEnd; ++iz) {
-              curr_1 = frame_1 + iy * wnx * wnz + iz * wnx;
-              curr_2 = frame_2 + iy * wnx * wnz + iz * wnx;
-              curr_o = output + iy * nx * nz + iz * nx;
+              curr_1 = frame_1 + (iy * wnx * wnz + iz * wnx) * batch;
+              curr_2 = frame_2 + (iy * wnx * wnz + iz * wnx) * batch;
+              curr_o = output + (iy * nx * nz + iz * nx) * batch;
 #pragma vector aligned
 #pragma ivdep
-              for (int ix = bx; ix < ixEnd; ++ix) {
+              for (int ix = bx * batch; ix < ixEnd * batch; ++ix) {
                 float value;
                 value = curr_1[ix] * curr_2[ix];
                 curr_o[ix] += value;
@@ -83,19 +102,38 @@ void CrossCorrelationKernel ::Correlate(GridBox *in_1) {
   Timer *timer = Timer::getInstance();
   timer->start_timer("CrossCorrelationKernel::Correlate");
   if (grid->grid_size.ny == 1) {
-    Correlation<true>(this->shot_correlation, in_1, grid, parameters);
+    Correlation<true>(this->shot_correlation, in_1, grid, parameters,
+                      this->active_box);
   } else {
-    Correlation<false>(this->shot_correlation, in_1, grid, parameters);
+    Correlation<false>(this->shot_correlation, in_1, grid, parameters,
+                       this->active_box);
   }
   timer->stop_timer("CrossCorrelationKernel::Correlate");
 }
 
 void CrossCorrelationKernel ::Stack() {
+  // Each shot of a batch is stacked from its lane of the correlation. Only
+  // one time-step of each imaging step was correlated, so the correlation is
+  // scaled to the amplitude of all of them.
+  uint batch = parameters->shot_batch;
+  float scale = parameters->imaging_step;
+  for (uint lane = 0; lane < batch; lane++) {
+    this->Accumulate(this->shot_correlation, this->total_correlation, batch,
+                     lane, scale);
+  }
+}
+
+bool CrossCorrelationKernel::StackCorrelation(CorrelationKernel *correlation) {
+  this->Accumulate(correlation->GetStackedShotCorrelation(),
+                   this->total_correlation);
+  return true;
+}
+
+void CrossCorrelationKernel::Accumulate(float *in, float *out, uint stride,
+                                        uint lane, float scale) {
   int nx = grid->grid_size.nx;
   int ny = grid->grid_size.ny;
   int nz = grid->grid_size.nz;
-  float *in = this->shot_correlation;
-  float *out = this->total_correlation;
   float *input;
   float *output;
   uint block_x = parameters->block_x;
@@ -124,12 +162,18 @@ void CrossCorrelationKernel ::Stack() {
 
         for (int iy = by; iy < iyEnd; iy++) {
           for (int iz = bz; iz < izEnd; iz++) {
-            input = in + iy * nx * nz + iz * nx;
+            input = in + (iy * nx * nz + iz * nx) * stride + lane;
             output = out + iy * nx * nz + iz * nx;
+            if (stride == 1) {
 #pragma ivdep
 #pragma vector aligned
-            for (int ix = bx; ix < ixEnd; ix++) {
-              output[ix] += input[ix];
+              for (int ix = bx; ix < ixEnd; ix++) {
+                output[ix] += input[ix] * scale;
+              }
+            } else {
+              for (int ix = bx; ix < ixEnd; ix++) {
+                output[ix] += input[ix * stride] * scale;
+              }
             }
           }
         }
@@ -150,9 +194,11 @@ void CrossCorrelationKernel::SetComputationParameters(
 
 void CrossCorrelationKernel::SetGridBox(GridBox *grid_box) {
   this->grid = grid_box;
+  // The correlation of a shot holds all the shots of a batch.
   shot_correlation = (float *)mem_allocate(
       sizeof(float),
-      grid_box->grid_size.nx * grid_box->grid_size.nz * grid_box->grid_size.ny,
+      grid_box->grid_size.nx * grid_box->grid_size.nz *
+          grid_box->grid_size.ny * parameters->shot_batch,
       "shot_correlation");
   total_correlation = (float *)mem_allocate(
       sizeof(float),
@@ -163,10 +209,21 @@ void CrossCorrelationKernel::SetGridBox(GridBox *grid_box) {
   memset(total_correlation, 0, num_bytes);
 }
 
-CrossCorrelationKernel::CrossCorrelationKernel() {}
+CrossCorrelationKernel::CrossCorrelationKernel(bool fused) {
+  this->fused = fused;
+  this->active_box = nullptr;
+  this->shot_correlation = nullptr;
+  this->total_correlation = nullptr;
+}
+
+bool CrossCorrelationKernel::IsFused() { return this->fused; }
+
+void CrossCorrelationKernel::SetActiveBox(const ActiveBox *box) {
+  this->active_box = box;
+}
 
 void CrossCorrelationKernel::ResetShotCorrelation() {
-  memset(shot_correlation, 0, num_bytes);
+  memset(shot_correlation, 0, num_bytes * parameters->shot_batch);
 }
 
 float *CrossCorrelationKernel::GetShotCorrelation() {
@@ -183,3 +240,10 @@ MigrationData *CrossCorrelationKernel::GetMigrationData() {
       grid->cell_dimensions.dx, grid->cell_dimensions.dz,
       grid->cell_dimensions.dy, grid->dt, this->total_correlation);
 }
+
+bool CrossCorrelationKernel::SupportsShotBatch() { return true; }
+
+bool CrossCorrelationKernel::SupportsNarrowWavefields() {
+  // Only the imaging fused in the computation kernel reads the narrow frames.
+  return this->fused;
+}
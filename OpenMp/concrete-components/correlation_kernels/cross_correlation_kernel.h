@@ -11,33 +11,52 @@
 #include <skeleton/components/correlation_kernel.h>
 
 class CrossCorrelationKernel : public CorrelationKernel {
-private:
+protected:
   AcousticOmpComputationParameters *parameters;
   GridBox *grid;
   float *shot_correlation;
   float *total_correlation;
   size_t num_bytes;
+  bool fused;
+  // The box of the window to correlate, if any.
+  const ActiveBox *active_box;
+  // Adds the correlation in to the correlation out, inside of the boundaries.
+  // The correlation in may hold several shots interleaved, in which case
+  // only the given lane of each stride points is added, multiplied by the
+  // scale.
+  void Accumulate(float *in, float *out, uint stride = 1, uint lane = 0,
+                  float scale = 1.0f);
 
 public:
   void Stack() override;
 
   void Correlate(GridBox *in_1) override;
 
+  bool IsFused() override;
+
+  void SetActiveBox(const ActiveBox *box) override;
+
   void ResetShotCorrelation() override;
 
   float *GetShotCorrelation() override;
 
   float *GetStackedShotCorrelation() override;
 
+  bool StackCorrelation(CorrelationKernel *correlation) override;
+
   void SetComputationParameters(ComputationParameters *parameters) override;
 
   void SetGridBox(GridBox *grid_box) override;
 
+  bool SupportsShotBatch() override;
+
+  bool SupportsNarrowWavefields() override;
+
   MigrationData *GetMigrationData() override;
 
   ~CrossCorrelationKernel() override;
 
-  CrossCorrelationKernel();
+  explicit CrossCorrelationKernel(bool fused = false);
 };
 
 #endif // ACOUSTIC2ND_RTM_RTM_CORRELATION_KERNEL_H
@@ -0,0 +1,26 @@
+#include "excitation_correlation_kernel.h"
+#include <skeleton/helpers/timer/timer.hpp>
+
+ExcitationCorrelationKernel::ExcitationCorrelationKernel()
+    : CrossCorrelationKernel(false) {}
+
+ExcitationCorrelationKernel::~ExcitationCorrelationKernel() = default;
+
+void ExcitationCorrelationKernel::Correlate(GridBox *in_1) {
+  Timer *timer = Timer::getInstance();
+  timer->start_timer("ExcitationCorrelationKernel::Correlate");
+  ExcitationGrid *forward = (ExcitationGrid *)in_1;
+  forward->map->Sample(grid->pressure_current, forward->time_step,
+                       grid->grid_size, shot_correlation);
+  timer->stop_timer("ExcitationCorrelationKernel::Correlate");
+}
+
+void ExcitationCorrelationKernel::Stack() {
+  // Every point is sampled once whatever the imaging step, so the image
+  // isn't scaled by it.
+  uint batch = parameters->shot_batch;
+  for (uint lane = 0; lane < batch; lane++) {
+    this->Accumulate(this->shot_correlation, this->total_correlation, batch,
+                     lane);
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef ACOUSTIC2ND_RTM_EXCITATION_CORRELATION_KERNEL_H
+#define ACOUSTIC2ND_RTM_EXCITATION_CORRELATION_KERNEL_H
+
+#include "cross_correlation_kernel.h"
+#include <concrete-components/forward_collectors/excitation_time/excitation_map.h>
+
+/*!
+ * Correlation kernel of the excitation time forward collectors : each point
+ * of the image is the backward wavefield at its excitation time, the time the
+ * source wavefield is the largest at it, multiplied or optionally divided by
+ * the source wavefield then. It keeps the strongest term of the cross
+ * correlation only, dropping the crosstalk of the later arrivals of the
+ * source wavefield.
+ */
+class ExcitationCorrelationKernel : public CrossCorrelationKernel {
+public:
+  void Stack() override;
+
+  /*!
+   * Samples the current backward frame at the points excited at its
+   * time-step.
+   * @param in_1
+   * The forward grid of an excitation time forward collector.
+   */
+  void Correlate(GridBox *in_1) override;
+
+  ~ExcitationCorrelationKernel() override;
+
+  ExcitationCorrelationKernel();
+};
+
+#endif // ACOUSTIC2ND_RTM_EXCITATION_CORRELATION_KERNEL_H
@@ -0,0 +1,51 @@
+#include "frequency_correlation_kernel.h"
+#include <skeleton/helpers/timer/timer.hpp>
+
+FrequencyCorrelationKernel::FrequencyCorrelationKernel()
+    : CrossCorrelationKernel(false) {
+  this->receiver_slices = new FrequencySlices();
+  this->source_slices = nullptr;
+}
+
+FrequencyCorrelationKernel::~FrequencyCorrelationKernel() {
+  delete receiver_slices;
+}
+
+void FrequencyCorrelationKernel::ResetShotCorrelation() {
+  CrossCorrelationKernel::ResetShotCorrelation();
+  // The backward slices take the layout of the forward ones at the first
+  // correlation of the shot.
+  source_slices = nullptr;
+}
+
+void FrequencyCorrelationKernel::Correlate(GridBox *in_1) {
+  Timer *timer = Timer::getInstance();
+  timer->start_timer("FrequencyCorrelationKernel::Correlate");
+  FrequencyGrid *forward = (FrequencyGrid *)in_1;
+  if (source_slices == nullptr) {
+    source_slices = forward->slices;
+    receiver_slices->Reset(*source_slices);
+  }
+  // The backward frame takes the phase of the forward one it images with.
+  receiver_slices->Add(grid->pressure_current, forward->time_step);
+  timer->stop_timer("FrequencyCorrelationKernel::Correlate");
+}
+
+void FrequencyCorrelationKernel::Stack() {
+  if (source_slices != nullptr) {
+    // The sum over the evenly spaced positive frequencies approximates the
+    // integral of the cross spectrum, twice over the positive ones, the
+    // frames being sampled every imaging step.
+    receiver_slices->Flush();
+    float step = parameters->imaging_step;
+    float scale = 2 * source_slices->GetFrequencyStep() * grid->dt * step *
+                  step;
+    source_slices->Correlate(*receiver_slices, scale, grid->grid_size,
+                             shot_correlation);
+  }
+  uint batch = parameters->shot_batch;
+  for (uint lane = 0; lane < batch; lane++) {
+    this->Accumulate(this->shot_correlation, this->total_correlation, batch,
+                     lane);
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef ACOUSTIC2ND_RTM_FREQUENCY_CORRELATION_KERNEL_H
+#define ACOUSTIC2ND_RTM_FREQUENCY_CORRELATION_KERNEL_H
+
+#include "cross_correlation_kernel.h"
+#include <concrete-components/forward_collectors/frequency_domain/frequency_slices.h>
+
+/*!
+ * Correlation kernel of the frequency domain forward collectors : the same
+ * frequency slices as the forward ones are accumulated from the backward
+ * propagation, the image of a shot being the sum over the frequencies of
+ * the product of the forward slices by the conjugate of the backward ones.
+ * It approximates the cross correlation of the frames, as well as the
+ * frequencies sample the spectrum of the source.
+ */
+class FrequencyCorrelationKernel : public CrossCorrelationKernel {
+private:
+  // The slices of the backward propagation, and the forward ones of the shot.
+  FrequencySlices *receiver_slices;
+  FrequencySlices *source_slices;
+
+public:
+  void Stack() override;
+
+  /*!
+   * Accumulates the current backward frame in the backward slices.
+   * @param in_1
+   * The forward grid of a frequency domain forward collector.
+   */
+  void Correlate(GridBox *in_1) override;
+
+  void ResetShotCorrelation() override;
+
+  ~FrequencyCorrelationKernel() override;
+
+  FrequencyCorrelationKernel();
+};
+
+#endif // ACOUSTIC2ND_RTM_FREQUENCY_CORRELATION_KERNEL_H
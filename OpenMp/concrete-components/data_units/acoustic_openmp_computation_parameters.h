@@ -5,7 +5,14 @@
 #ifndef ACOUSTIC2ND_RTM_ACOUSTIC_OPENMP_COMPUTATION_PARAMETERS_H
 #define ACOUSTIC2ND_RTM_ACOUSTIC_OPENMP_COMPUTATION_PARAMETERS_H
 
+#include <concrete-components/forward_collectors/half_precision/half_precision.h>
 #include <skeleton/base/datatypes.h>
+#include <string>
+
+/*!
+ * The instruction sets of the stencil kernels, ordered by their width.
+ */
+enum SIMD_ISA { ISA_AUTO, ISA_SCALAR, ISA_AVX2, ISA_AVX512 };
 
 class AcousticOmpComputationParameters : public ComputationParameters {
 public:
@@ -13,12 +20,26 @@ public:
   uint block_y;
   uint block_z;
   uint n_threads;
+  // The instruction set of the stencil kernels, ISA_AUTO uses the widest one
+  // supported by the cpu.
+  SIMD_ISA simd_isa;
+  // If set, the blocking factors are tuned by the computation kernel for the
+  // grid, the results are kept in the autotune_cache file.
+  bool autotune;
+  std::string autotune_cache;
+  // The precision of the live wavefields and of the velocity read by the
+  // stencil, narrow_wavefields is set for the 16 bit ones.
+  STORAGE_PRECISION wavefield_precision;
   explicit AcousticOmpComputationParameters(HALF_LENGTH half_length)
       : ComputationParameters(half_length) {
     block_x = 512;
     block_y = 15;
     block_z = 44;
     n_threads = 16;
+    simd_isa = ISA_AUTO;
+    autotune = false;
+    autotune_cache = "block_autotune_cache.txt";
+    wavefield_precision = STORAGE_FP32;
   }
 };
 
@@ -0,0 +1,239 @@
+#include "boundary_store.h"
+
+#include <bfp.h>
+#include <concrete-components/forward_collectors/half_precision/half_precision.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+
+const char *GetBoundaryCodecName(BOUNDARY_CODEC codec) {
+  switch (codec) {
+  case BOUNDARY_FP16:
+    return "fp16";
+  case BOUNDARY_BFP:
+    return "bfp";
+  default:
+    return "none";
+  }
+}
+
+// Decodes the n values of a chunk compressed by the codec.
+static void DecodeChunk(BOUNDARY_CODEC codec, const char *data, size_t n,
+                        float scale, float *values) {
+  if (codec == BOUNDARY_FP16) {
+    UnpackHalf((const uint16_t *)data, values, n, STORAGE_FP16, scale);
+  } else if (codec == BOUNDARY_BFP) {
+    zfp::decompressBFP(values, n, data);
+  } else {
+    memcpy(values, data, n * sizeof(float));
+  }
+}
+
+BoundaryStore::BoundaryStore(string write_path, size_t memory_budget,
+                             BOUNDARY_CODEC codec, double tolerance)
+    : chunk_io(BOUNDARY_CHUNKS) {
+  this->write_path = write_path;
+  this->memory_budget = memory_budget;
+  this->codec = codec;
+  this->tolerance = tolerance;
+  this->step_size = 0;
+  this->steps = 0;
+  this->chunk_nt = 0;
+  this->chunk_budget = 0;
+  this->memory_bytes = 0;
+  this->first_in_memory = 0;
+  this->file_bytes = 0;
+  this->decoded_chunks = nullptr;
+  this->decoded_capacity = 0;
+  for (int i = 0; i < BOUNDARY_CHUNKS; i++) {
+    resident_chunk[i] = -1;
+  }
+}
+
+BoundaryStore::~BoundaryStore() {
+  chunk_io.WaitAll();
+  if (decoded_chunks != nullptr) {
+    mem_free(decoded_chunks);
+  }
+}
+
+void BoundaryStore::Reset(uint steps, size_t step_size) {
+  // The chunks of the previous shot may still be written.
+  chunk_io.WaitAll();
+  if (file.is_open()) {
+    file.close();
+  }
+  size_t held_bytes = memory_bytes + decoded_capacity;
+  chunks.clear();
+  memory_bytes = 0;
+  first_in_memory = 0;
+  file_bytes = 0;
+  this->steps = steps;
+  this->step_size = step_size;
+  size_t budget = GetStoreBudget(memory_budget, held_bytes);
+  // The decoded chunks take at most a quarter of the budget.
+  size_t step_bytes = step_size * sizeof(float);
+  size_t chunk_bytes = min((size_t)BOUNDARY_CHUNK_BYTES,
+                           budget / (4 * BOUNDARY_CHUNKS));
+  chunk_nt = max((size_t)1, min((size_t)steps, chunk_bytes / step_bytes));
+  size_t decoded_bytes = BOUNDARY_CHUNKS * chunk_nt * step_bytes;
+  if (decoded_bytes > budget) {
+    cout << "The memory budget of " << budget / (1024 * 1024)
+         << " MB can't hold the chunks of the boundaries" << endl;
+    cout << "Terminating..." << endl;
+    exit(-1);
+  }
+  chunk_budget = budget - decoded_bytes;
+  if (decoded_bytes > decoded_capacity) {
+    if (decoded_chunks != nullptr) {
+      mem_free(decoded_chunks);
+    }
+    decoded_chunks = (float *)mem_allocate(
+        sizeof(float), BOUNDARY_CHUNKS * chunk_nt * step_size,
+        "boundary memory");
+    if (decoded_chunks == nullptr) {
+      cout << "Could not allocate the " << decoded_bytes / (1024 * 1024)
+           << " MB of the boundary chunks" << endl;
+      cout << "Terminating..." << endl;
+      exit(-1);
+    }
+    decoded_capacity = decoded_bytes;
+  }
+  for (int i = 0; i < BOUNDARY_CHUNKS; i++) {
+    resident_chunk[i] = -1;
+  }
+}
+
+float *BoundaryStore::GetDecodedChunk(uint chunk) {
+  return decoded_chunks + (chunk % BOUNDARY_CHUNKS) * chunk_nt * step_size;
+}
+
+float *BoundaryStore::GetStep(uint time_step) {
+  uint chunk = time_step / chunk_nt;
+  resident_chunk[chunk % BOUNDARY_CHUNKS] = chunk;
+  return GetDecodedChunk(chunk) + (time_step % chunk_nt) * step_size;
+}
+
+void BoundaryStore::Save(uint time_step) {
+  // A chunk left incomplete is the first one fetched, it stays decoded.
+  if (time_step % chunk_nt == chunk_nt - 1) {
+    Encode(time_step / chunk_nt);
+  }
+}
+
+void BoundaryStore::Encode(uint chunk) {
+  const float *values = GetDecodedChunk(chunk);
+  size_t n = chunk_nt * step_size;
+  chunks.resize(chunk + 1);
+  Chunk &record = chunks[chunk];
+  record.on_disk = false;
+  record.offset = 0;
+  record.scale = 1.0f;
+  if (codec == BOUNDARY_FP16) {
+    record.scale = GetStorageScale(STORAGE_FP16, GetMaxAbs(values, n));
+    record.data.resize(n * sizeof(uint16_t));
+    PackHalf(values, (uint16_t *)record.data.data(), n, STORAGE_FP16,
+             record.scale);
+    record.bytes = record.data.size();
+  } else if (codec == BOUNDARY_BFP) {
+    record.data.resize(zfp::getBFPMaxSize(n));
+    record.bytes = zfp::compressBFP(values, n, tolerance, false,
+                                    record.data.data());
+    record.data.resize(record.bytes);
+    record.data.shrink_to_fit();
+  } else {
+    record.data.assign((const char *)values, (const char *)(values + n));
+    record.bytes = record.data.size();
+  }
+  memory_bytes += record.bytes;
+  // The oldest chunks are fetched last, they are the ones spilled.
+  while (memory_bytes > chunk_budget && first_in_memory <= chunk) {
+    SpillChunk(first_in_memory);
+    first_in_memory++;
+  }
+}
+
+void BoundaryStore::SpillChunk(uint chunk) {
+  if (!file.is_open()) {
+    string path = write_path + "/boundaries.bin";
+    file.open(path, ios::in | ios::out | ios::trunc | ios::binary);
+    if (!file.is_open()) {
+      cout << "Could not open " << path << " to spill the boundaries" << endl;
+      cout << "Terminating..." << endl;
+      exit(-1);
+    }
+  }
+  Chunk &record = chunks[chunk];
+  record.offset = file_bytes;
+  record.on_disk = true;
+  file_bytes += record.bytes;
+  memory_bytes -= record.bytes;
+  // The data is freed once written.
+  auto data = make_shared<vector<char>>(move(record.data));
+  record.data = vector<char>();
+  size_t offset = record.offset;
+  chunk_io.Start([this, data, offset]() {
+    file.seekp(offset);
+    file.write(data->data(), data->size());
+    data->clear();
+    data->shrink_to_fit();
+  });
+}
+
+void BoundaryStore::LoadChunk(uint chunk) {
+  uint buffer = chunk % BOUNDARY_CHUNKS;
+  resident_chunk[buffer] = chunk;
+  const Chunk &record = chunks[chunk];
+  float *values = GetDecodedChunk(chunk);
+  size_t n = chunk_nt * step_size;
+  BOUNDARY_CODEC codec = this->codec;
+  float scale = record.scale;
+  if (record.on_disk) {
+    size_t offset = record.offset;
+    size_t bytes = record.bytes;
+    chunk_io.Start(buffer, [this, codec, offset, bytes, n, scale, values]() {
+      vector<char> data(bytes);
+      file.seekg(offset);
+      file.read(data.data(), bytes);
+      DecodeChunk(codec, data.data(), n, scale, values);
+    });
+  } else {
+    const char *data = record.data.data();
+    chunk_io.Start(buffer, [codec, data, n, scale, values]() {
+      DecodeChunk(codec, data, n, scale, values);
+    });
+  }
+}
+
+float *BoundaryStore::Fetch(uint time_step) {
+  uint chunk = time_step / chunk_nt;
+  uint buffer = chunk % BOUNDARY_CHUNKS;
+  if (resident_chunk[buffer] != (int)chunk) {
+    LoadChunk(chunk);
+  }
+  chunk_io.Wait(buffer);
+  // The chunk before it is decoded in the other buffer while this one is used.
+  if (chunk > 0) {
+    uint previous = chunk - 1;
+    if (resident_chunk[previous % BOUNDARY_CHUNKS] != (int)previous) {
+      LoadChunk(previous);
+    }
+  }
+  return GetDecodedChunk(chunk) + (time_step % chunk_nt) * step_size;
+}
+
+void BoundaryStore::Report() {
+  if (codec == BOUNDARY_RAW && file_bytes == 0) {
+    return;
+  }
+  size_t raw_bytes = chunks.size() * chunk_nt * step_size * sizeof(float);
+  cout << "Forward boundaries : " << chunks.size() << " chunks of " << chunk_nt
+       << " time-steps in " << GetBoundaryCodecName(codec) << ", "
+       << memory_bytes / (1024 * 1024) << " MB in memory and "
+       << file_bytes / (1024 * 1024) << " MB on the disk out of "
+       << raw_bytes / (1024 * 1024) << " MB" << endl;
+}
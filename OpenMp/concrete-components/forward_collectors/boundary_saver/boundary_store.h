@@ -0,0 +1,132 @@
+#ifndef ACOUSTIC2ND_RTM_BOUNDARY_STORE_H
+#define ACOUSTIC2ND_RTM_BOUNDARY_STORE_H
+
+#include <concrete-components/forward_collectors/chunk_io/chunk_io.h>
+#include <skeleton/base/datatypes.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// The chunks of time-steps held decoded in memory : the one in use and the one
+// before it, read and decoded in the background.
+#define BOUNDARY_CHUNKS 2
+// The largest bytes of a chunk of boundaries before being compressed.
+#define BOUNDARY_CHUNK_BYTES (4 * 1024 * 1024)
+
+/*!
+ * The codec the saved boundaries are compressed with : none keeps them exact,
+ * fp16 and bfp bound their error.
+ */
+enum BOUNDARY_CODEC { BOUNDARY_RAW, BOUNDARY_FP16, BOUNDARY_BFP };
+
+/*!
+ * Gets a printable name of the boundary codec.
+ */
+const char *GetBoundaryCodecName(BOUNDARY_CODEC codec);
+
+/*!
+ * Stores the boundaries saved at each time-step of the forward propagation of a
+ * shot within a memory budget, for the backward propagation to read them from
+ * the last time-step to the first.
+ *
+ * The time-steps are grouped in chunks compressed once they are complete. The
+ * compressed chunks stay in memory while the budget holds them, the oldest ones
+ * being written to a single file in the background otherwise. The chunk before
+ * the one in use by the backward propagation is read and decoded in the
+ * background.
+ */
+class BoundaryStore {
+private:
+  // A compressed chunk, in memory or at an offset of the file.
+  struct Chunk {
+    std::vector<char> data;
+    size_t bytes;
+    size_t offset;
+    bool on_disk;
+    // The scale of the values of the chunk stored in fp16.
+    float scale;
+  };
+
+  std::string write_path;
+  // The bytes of memory the boundaries may use, 0 for the available memory.
+  size_t memory_budget;
+  BOUNDARY_CODEC codec;
+  // The absolute error of the values compressed by bfp.
+  double tolerance;
+
+  // The values of the boundaries of a time-step.
+  size_t step_size;
+  uint steps;
+  // The time-steps of a chunk.
+  uint chunk_nt;
+  // The bytes the compressed chunks in memory may use.
+  size_t chunk_budget;
+  std::vector<Chunk> chunks;
+  size_t memory_bytes;
+  // The chunks before it are on the disk.
+  uint first_in_memory;
+  std::fstream file;
+  size_t file_bytes;
+
+  // The decoded chunks, the boundaries are saved to and read from them.
+  float *decoded_chunks;
+  size_t decoded_capacity;
+  // The chunk held by each decoded chunk, -1 if none.
+  int resident_chunk[BOUNDARY_CHUNKS];
+
+  // The background reads and writes of the chunks.
+  ChunkIO chunk_io;
+
+  float *GetDecodedChunk(uint chunk);
+  void Encode(uint chunk);
+  void SpillChunk(uint chunk);
+  void LoadChunk(uint chunk);
+
+public:
+  /*!
+   * @param write_path
+   * The directory of the file the chunks are spilled to.
+   * @param memory_budget
+   * The bytes of memory the boundaries may use, 0 for the memory available
+   * when a shot starts.
+   * @param codec
+   * The codec of the saved boundaries.
+   * @param tolerance
+   * The absolute error of the boundaries compressed by bfp.
+   */
+  BoundaryStore(std::string write_path, size_t memory_budget,
+                BOUNDARY_CODEC codec = BOUNDARY_RAW, double tolerance = 1e-6);
+  /*!
+   * Prepares the store for the boundaries of a shot, waiting for the disk
+   * operations of the previous shot.
+   * @param steps
+   * The most time-steps saved.
+   * @param step_size
+   * The number of values of the boundaries of a time-step.
+   */
+  void Reset(uint steps, size_t step_size);
+  /*!
+   * @return
+   * Where the boundaries of the time-step are saved to, the time-steps being
+   * saved by increasing time-step.
+   */
+  float *GetStep(uint time_step);
+  /*!
+   * Stores the boundaries of the time-step, saved to its step.
+   */
+  void Save(uint time_step);
+  /*!
+   * @return
+   * The boundaries of the time-step, the time-steps being fetched from the last
+   * saved one backwards. They are valid until the next fetch.
+   */
+  float *Fetch(uint time_step);
+  /*!
+   * Prints the bytes the boundaries of the shot were stored in.
+   */
+  void Report();
+  ~BoundaryStore();
+};
+
+#endif // ACOUSTIC2ND_RTM_BOUNDARY_STORE_H
@@ -0,0 +1,344 @@
+#include "checkpoint_propagation.h"
+#include <cstring>
+#include <iostream>
+#include <skeleton/helpers/timer/timer.hpp>
+
+using namespace std;
+
+// The number of time-steps reversed with the given checkpoints when each
+// time-step is recomputed at most the given times, the binomial coefficient of
+// (checkpoints + repetitions) over checkpoints.
+static double GetReversibleSteps(uint checkpoints, uint repetitions) {
+  double steps = 1;
+  for (uint i = 1; i <= checkpoints; i++) {
+    steps = steps * (repetitions + i) / i;
+  }
+  return steps;
+}
+
+// The distance of the next checkpoint to reverse the given time-steps with the
+// free checkpoints, with the fewest repetitions : the time-steps after it are
+// reversed with one checkpoint less, the ones before it with one repetition
+// less.
+static uint GetCheckpointDistance(uint time_steps, uint free) {
+  uint repetitions = 0;
+  while (GetReversibleSteps(free, repetitions) < time_steps) {
+    repetitions++;
+  }
+  double after = GetReversibleSteps(free - 1, repetitions);
+  if (after >= time_steps) {
+    return 1;
+  }
+  return time_steps - (uint)after;
+}
+
+CheckpointPropagation::CheckpointPropagation(ComputationKernel *kernel,
+                                             BoundaryManager *boundary_manager,
+                                             uint max_checkpoints) {
+  this->internal_grid = (AcousticSecondGrid *)mem_allocate(
+      sizeof(AcousticSecondGrid), 1, "forward_collector_gridbox");
+  this->internal_grid->pressure_current = nullptr;
+  this->computation_kernel = kernel;
+  this->computation_kernel->SetGridBox(internal_grid);
+  this->boundary_manager = boundary_manager;
+  this->computation_kernel->SetBoundaryManager(boundary_manager);
+  this->forward_boundary_manager = nullptr;
+  this->source_injector = nullptr;
+  this->velocity = nullptr;
+  this->frames[0] = this->frames[1] = this->frames[2] = nullptr;
+  this->slots = nullptr;
+  this->max_checkpoints = max_checkpoints;
+  this->num_slots = 0;
+  this->allocated_slot_size = 0;
+  this->slot_size = 0;
+  this->frame_size = 0;
+  this->state_size = 0;
+  this->next_forward_step = 0;
+  this->pending_frame = false;
+  this->time_step = 0;
+  this->replay_step = 0;
+}
+
+void CheckpointPropagation::Setup() {
+  uint nx = main_grid->grid_size.nx;
+  uint nz = main_grid->grid_size.nz;
+  uint ny = main_grid->grid_size.ny;
+  unsigned int const full_size = nx * nz * ny;
+  velocity = (float *)mem_allocate(sizeof(float), full_size,
+                                   "forward_collector_velocity",
+                                   parameters->half_length, 0);
+  computation_kernel->FirstTouch(velocity, nx, nz, ny);
+  memcpy(velocity, main_grid->velocity, full_size * sizeof(float));
+  string names[] = {"forward_collector_pressure_prev",
+                    "forward_collector_pressure_curr",
+                    "forward_collector_pressure_next"};
+  // Allocated for the full grid so that the frames fit the window of any
+  // shot.
+  for (int i = 0; i < 3; i++) {
+    frames[i] = (float *)mem_allocate(sizeof(float), full_size, names[i],
+                                      parameters->half_length, 16 * (i + 1));
+    computation_kernel->FirstTouch(frames[i], nx, nz, ny);
+  }
+  internal_grid->pressure_previous = frames[0];
+  internal_grid->pressure_current = frames[1];
+  internal_grid->pressure_next = frames[2];
+  internal_grid->nt = main_grid->nt;
+  internal_grid->dt = main_grid->dt;
+  memcpy(&internal_grid->grid_size, &main_grid->grid_size,
+         sizeof(main_grid->grid_size));
+  memcpy(&internal_grid->cell_dimensions, &main_grid->cell_dimensions,
+         sizeof(main_grid->cell_dimensions));
+  internal_grid->window_size.window_start = {0, 0, 0};
+  internal_grid->window_size.window_nx = nx;
+  internal_grid->window_size.window_nz = nz;
+  internal_grid->window_size.window_ny = ny;
+  internal_grid->velocity = velocity;
+  // Extended on the full window like the forward one, the model is then
+  // replaced by the forward one of each shot.
+  boundary_manager->SetGridBox(internal_grid);
+  boundary_manager->ExtendModel();
+  cout << "Storing up to " << max_checkpoints
+       << " checkpoints of the forward propagation" << endl;
+}
+
+void CheckpointPropagation::AllocateSlots() {
+  WindowSize *window = &main_grid->window_size;
+  frame_size = window->window_nx * window->window_nz * window->window_ny;
+  state_size = 0;
+  if (forward_boundary_manager != nullptr) {
+    state_size = forward_boundary_manager->GetStateSize();
+  }
+  slot_size = 2 * (size_t)frame_size + state_size;
+  if (slots != nullptr && slot_size > allocated_slot_size) {
+    mem_free((void *)slots);
+    slots = nullptr;
+  }
+  if (slots == nullptr) {
+    num_slots = max_checkpoints;
+    slots = (float *)mem_allocate(sizeof(float), num_slots * slot_size,
+                                  "checkpoints");
+    while (slots == nullptr && num_slots > 1) {
+      num_slots = num_slots / 2;
+      slots = (float *)mem_allocate(sizeof(float), num_slots * slot_size,
+                                    "checkpoints");
+    }
+    if (slots == nullptr) {
+      cout << "Not enough memory for a single checkpoint of the forward "
+              "propagation"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(-1);
+    }
+    if (num_slots < max_checkpoints) {
+      cout << "Only " << num_slots << " checkpoints fit in memory" << endl;
+    }
+    allocated_slot_size = slot_size;
+  }
+}
+
+float *CheckpointPropagation::GetSlot(uint slot) {
+  return slots + slot * slot_size;
+}
+
+void CheckpointPropagation::StoreCheckpoint(uint slot) {
+  float *data = GetSlot(slot);
+  memcpy(data, internal_grid->pressure_previous, frame_size * sizeof(float));
+  memcpy(data + frame_size, internal_grid->pressure_current,
+         frame_size * sizeof(float));
+  if (state_size > 0) {
+    boundary_manager->SaveState(data + 2 * frame_size);
+  }
+}
+
+void CheckpointPropagation::RestoreCheckpoint(const Checkpoint &checkpoint) {
+  float *data = GetSlot(checkpoint.slot);
+  memcpy(frames[0], data, frame_size * sizeof(float));
+  memcpy(frames[1], data + frame_size, frame_size * sizeof(float));
+  internal_grid->pressure_previous = frames[0];
+  internal_grid->pressure_current = frames[1];
+  internal_grid->pressure_next = frames[2];
+  if (state_size > 0) {
+    boundary_manager->RestoreState(data + 2 * frame_size);
+  }
+  replay_step = checkpoint.time_step;
+}
+
+void CheckpointPropagation::Advance(uint time_steps) {
+  for (uint i = 0; i < time_steps; i++) {
+    computation_kernel->Step();
+    replay_step++;
+    // As in the forward propagation, the source is injected in all the frames
+    // but the last one.
+    if (replay_step < internal_grid->nt) {
+      InjectionList *injection = source_injector->GetInjection(replay_step);
+      if (injection != nullptr) {
+        float *pressure = internal_grid->pressure_current;
+        for (uint p = 0; p < injection->num_points; p++) {
+          pressure[injection->offsets[p]] += injection->amplitudes[p];
+        }
+      }
+    }
+  }
+}
+
+void CheckpointPropagation::FetchForward(void) {
+  uint target = time_step--;
+  // The checkpoints after the fetched time-step won't be needed anymore.
+  while (!checkpoints.empty() && checkpoints.back().time_step > target) {
+    free_slots.push_back(checkpoints.back().slot);
+    checkpoints.pop_back();
+  }
+  if (replay_step == target) {
+    return;
+  }
+  Checkpoint last = checkpoints.back();
+  if (last.time_step == target) {
+    internal_grid->pressure_current = GetSlot(last.slot) + frame_size;
+    replay_step = 0;
+    return;
+  }
+  Timer *timer = Timer::getInstance();
+  timer->start_timer("ForwardCollector::Recomputation");
+  if (replay_step < last.time_step || replay_step > target) {
+    RestoreCheckpoint(last);
+  }
+  // Recompute up to the fetched time-step, storing the checkpoints on the
+  // way while there are free ones.
+  while (replay_step < target) {
+    uint steps = target - replay_step;
+    if (!free_slots.empty() && steps > 1) {
+      steps = GetCheckpointDistance(steps, free_slots.size());
+    }
+    Advance(steps);
+    if (replay_step < target) {
+      uint slot = free_slots.back();
+      free_slots.pop_back();
+      StoreCheckpoint(slot);
+      checkpoints.push_back({replay_step, slot});
+    }
+  }
+  timer->stop_timer("ForwardCollector::Recomputation");
+}
+
+void CheckpointPropagation::ResetGrid(bool forward_run) {
+  unsigned int const grid_size = main_grid->window_size.window_nx *
+                                 main_grid->window_size.window_ny *
+                                 main_grid->window_size.window_nz;
+  if (forward_run) {
+    if (velocity == nullptr) {
+      Setup();
+    }
+    internal_grid->nt = main_grid->nt;
+    memcpy(&internal_grid->window_size, &main_grid->window_size,
+           sizeof(main_grid->window_size));
+    boundary_manager->ReExtendModel();
+    AllocateSlots();
+    checkpoints.clear();
+    free_slots.clear();
+    for (uint slot = num_slots; slot > 0; slot--) {
+      free_slots.push_back(slot - 1);
+    }
+    // The checkpoints the backward propagation starts with : the first
+    // time-step, then each one at the distance given by the checkpoints left
+    // till the last time-step.
+    forward_steps.clear();
+    forward_steps.push_back(1);
+    uint step = 1;
+    uint free = num_slots - 1;
+    while (free > 0 && main_grid->nt > step + 1) {
+      step += GetCheckpointDistance(main_grid->nt - step, free);
+      forward_steps.push_back(step);
+      free--;
+    }
+    next_forward_step = 0;
+    pending_frame = false;
+    time_step = 0;
+    replay_step = 0;
+  } else {
+    if (pending_frame) {
+      memcpy(GetSlot(checkpoints.back().slot) + frame_size,
+             main_grid->pressure_previous, grid_size * sizeof(float));
+      pending_frame = false;
+    }
+    // The last frames of the forward propagation are the first fetched.
+    memcpy(frames[0], main_grid->pressure_previous,
+           grid_size * sizeof(float));
+    memcpy(frames[1], main_grid->pressure_current, grid_size * sizeof(float));
+    internal_grid->pressure_previous = frames[0];
+    internal_grid->pressure_current = frames[1];
+    internal_grid->pressure_next = frames[2];
+    time_step = main_grid->nt;
+    replay_step = main_grid->nt;
+    // Taken before the model is adjusted for the backward propagation.
+    memcpy(velocity, main_grid->velocity,
+           main_grid->grid_size.nx * main_grid->grid_size.nz *
+               main_grid->grid_size.ny * sizeof(float));
+  }
+  memset(main_grid->pressure_previous, 0.0f, grid_size * sizeof(float));
+  memset(main_grid->pressure_current, 0.0f, grid_size * sizeof(float));
+  memset(main_grid->pressure_next, 0.0f, grid_size * sizeof(float));
+}
+
+void CheckpointPropagation::SaveForward() {
+  time_step++;
+  // The frames are stored once they are the previous frame, with the source
+  // of their time-step injected.
+  if (pending_frame) {
+    memcpy(GetSlot(checkpoints.back().slot) + frame_size,
+           main_grid->pressure_previous, frame_size * sizeof(float));
+    pending_frame = false;
+  }
+  if (next_forward_step < forward_steps.size() &&
+      forward_steps[next_forward_step] == time_step) {
+    uint slot = free_slots.back();
+    free_slots.pop_back();
+    float *data = GetSlot(slot);
+    memcpy(data, main_grid->pressure_previous, frame_size * sizeof(float));
+    if (state_size > 0) {
+      forward_boundary_manager->SaveState(data + 2 * frame_size);
+    }
+    checkpoints.push_back({time_step, slot});
+    next_forward_step++;
+    pending_frame = true;
+  }
+}
+
+CheckpointPropagation::~CheckpointPropagation() {
+  if (velocity != nullptr) {
+    mem_free((void *)velocity);
+    for (int i = 0; i < 3; i++) {
+      mem_free((void *)frames[i]);
+    }
+  }
+  if (slots != nullptr) {
+    mem_free((void *)slots);
+  }
+  mem_free((void *)internal_grid);
+  delete computation_kernel;
+  delete boundary_manager;
+}
+
+void CheckpointPropagation::SetComputationParameters(
+    ComputationParameters *parameters) {
+  this->parameters = parameters;
+  this->computation_kernel->SetComputationParameters(parameters);
+  this->boundary_manager->SetComputationParameters(parameters);
+}
+
+void CheckpointPropagation::SetGridBox(GridBox *grid_box) {
+  this->main_grid = (AcousticSecondGrid *)(grid_box);
+  if (this->main_grid == nullptr) {
+    std::cout << "Not a compatible gridbox : "
+                 "expected AcousticSecondGrid"
+              << std::endl;
+    exit(-1);
+  }
+}
+
+void CheckpointPropagation::SetForwardComponents(
+    BoundaryManager *boundary_manager, SourceInjector *source_injector) {
+  this->forward_boundary_manager = boundary_manager;
+  this->source_injector = source_injector;
+}
+
+GridBox *CheckpointPropagation::GetForwardGrid() { return internal_grid; }
@@ -0,0 +1,83 @@
+#ifndef ACOUSTIC2ND_RTM_CHECKPOINT_PROPAGATION_H
+#define ACOUSTIC2ND_RTM_CHECKPOINT_PROPAGATION_H
+
+#include <concrete-components/data_units/acoustic_second_grid.h>
+#include <skeleton/components/boundary_manager.h>
+#include <skeleton/components/computation_kernel.h>
+#include <skeleton/components/forward_collector.h>
+#include <skeleton/components/source_injector.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <vector>
+
+/*!
+ * Forward collector storing the full forward states at a limited number of
+ * checkpoints, placed by the binomial rule of Griewank's revolve, and
+ * recomputing the forward wavefields in between during the backward
+ * propagation. The recomputation has its own kernel and boundary manager on
+ * the model of the forward propagation, so it works with any boundary.
+ */
+class CheckpointPropagation : public ForwardCollector {
+private:
+  // A stored forward state : the frames of the time-step and of the one
+  // before it, followed by the state of the boundary manager.
+  typedef struct {
+    uint time_step;
+    uint slot;
+  } Checkpoint;
+
+  AcousticSecondGrid *main_grid;
+  AcousticSecondGrid *internal_grid;
+  ComputationParameters *parameters;
+  ComputationKernel *computation_kernel;
+  // The boundary manager of the recomputation, on the internal grid.
+  BoundaryManager *boundary_manager;
+  BoundaryManager *forward_boundary_manager;
+  SourceInjector *source_injector;
+  // The model of the forward propagation, the main one is adjusted for the
+  // backward propagation.
+  float *velocity;
+  float *frames[3];
+  float *slots;
+  uint max_checkpoints;
+  uint num_slots;
+  size_t allocated_slot_size;
+  size_t slot_size;
+  uint frame_size;
+  uint state_size;
+  // The checkpoints held in the slots, by increasing time-step.
+  std::vector<Checkpoint> checkpoints;
+  std::vector<uint> free_slots;
+  // The time-steps of the checkpoints stored by the forward propagation.
+  std::vector<uint> forward_steps;
+  uint next_forward_step;
+  // Whether the frame of the last checkpoint is still to be stored.
+  bool pending_frame;
+  // The time-step of the forward propagation or the next one to fetch.
+  uint time_step;
+  // The time-step the internal frames are at, zero if they aren't valid.
+  uint replay_step;
+
+  void Setup();
+  void AllocateSlots();
+  float *GetSlot(uint slot);
+  void StoreCheckpoint(uint slot);
+  void RestoreCheckpoint(const Checkpoint &checkpoint);
+  void Advance(uint time_steps);
+
+public:
+  CheckpointPropagation(ComputationKernel *kernel,
+                        BoundaryManager *boundary_manager,
+                        uint max_checkpoints);
+  void FetchForward(void) override;
+  void SaveForward() override;
+  void ResetGrid(bool forward_run) override;
+  void SetComputationParameters(ComputationParameters *parameters) override;
+  void SetGridBox(GridBox *grid_box) override;
+  void SetForwardComponents(BoundaryManager *boundary_manager,
+                            SourceInjector *source_injector) override;
+  GridBox *GetForwardGrid() override;
+  ~CheckpointPropagation() override;
+};
+
+#endif // ACOUSTIC2ND_RTM_CHECKPOINT_PROPAGATION_H
@@ -0,0 +1,56 @@
+#include "chunk_io.h"
+
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+#include <skeleton/helpers/timer/timer.hpp>
+
+#include <omp.h>
+
+using namespace std;
+
+size_t GetStoreBudget(size_t memory_budget, size_t held_bytes) {
+  if (memory_budget != 0) {
+    return memory_budget;
+  }
+  // The memory already held by the store is available to it, and a tenth of
+  // the rest is left to the other allocations of the migration.
+  return mem_available() / 10 * 9 + held_bytes;
+}
+
+ChunkIO::ChunkIO(int buffers) : chunk_io(buffers) {}
+
+void ChunkIO::Start(function<void()> io) {
+  shared_future<void> previous = last_io;
+  last_io = async(launch::async, [previous, io]() {
+              if (previous.valid()) {
+                previous.wait();
+              }
+              // The parallel regions of the codecs run on this thread alone.
+              omp_set_num_threads(1);
+              io();
+            }).share();
+}
+
+void ChunkIO::Start(unsigned int buffer, function<void()> io) {
+  Start(io);
+  chunk_io[buffer] = last_io;
+}
+
+void ChunkIO::Wait(unsigned int buffer) {
+  if (chunk_io[buffer].valid()) {
+    Timer *timer = Timer::getInstance();
+    timer->start_timer("ForwardCollector::SpillWait");
+    chunk_io[buffer].wait();
+    timer->stop_timer("ForwardCollector::SpillWait");
+    chunk_io[buffer] = shared_future<void>();
+  }
+}
+
+void ChunkIO::WaitAll() {
+  if (last_io.valid()) {
+    last_io.wait();
+    last_io = shared_future<void>();
+  }
+  for (shared_future<void> &io : chunk_io) {
+    io = shared_future<void>();
+  }
+}
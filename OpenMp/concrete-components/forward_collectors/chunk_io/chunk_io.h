@@ -0,0 +1,54 @@
+#ifndef ACOUSTIC2ND_RTM_CHUNK_IO_H
+#define ACOUSTIC2ND_RTM_CHUNK_IO_H
+
+#include <functional>
+#include <future>
+#include <vector>
+
+/*!
+ * Gets the bytes of memory a store of the forward collectors may use for a
+ * shot.
+ * @param memory_budget
+ * The bytes given by the configuration, 0 for the memory available.
+ * @param held_bytes
+ * The bytes already held by the store, from the previous shots.
+ */
+size_t GetStoreBudget(size_t memory_budget, size_t held_bytes);
+
+/*!
+ * Runs the reads and writes of the chunks of a store in the background, one at
+ * a time in the order they were started, each on a helper thread using a
+ * single OpenMP thread so the compression doesn't compete with the threads
+ * computing the time-steps.
+ */
+class ChunkIO {
+private:
+  // The last operation started on the chunk held by each buffer.
+  std::vector<std::shared_future<void>> chunk_io;
+  std::shared_future<void> last_io;
+
+public:
+  /*!
+   * @param buffers
+   * The buffers of the chunks of the store.
+   */
+  explicit ChunkIO(int buffers);
+  /*!
+   * Starts an operation no buffer waits for.
+   */
+  void Start(std::function<void()> io);
+  /*!
+   * Starts an operation on the chunk of the buffer.
+   */
+  void Start(unsigned int buffer, std::function<void()> io);
+  /*!
+   * Waits for the last operation started on the buffer.
+   */
+  void Wait(unsigned int buffer);
+  /*!
+   * Waits for all the operations started.
+   */
+  void WaitAll();
+};
+
+#endif // ACOUSTIC2ND_RTM_CHUNK_IO_H
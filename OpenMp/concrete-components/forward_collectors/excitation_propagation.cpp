@@ -0,0 +1,117 @@
+#include "excitation_propagation.h"
+
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_region.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+ExcitationPropagation::ExcitationPropagation(bool normalized) {
+  this->internal_grid = (ExcitationGrid *)mem_allocate(
+      sizeof(ExcitationGrid), 1, "forward_collector_gridbox");
+  this->internal_grid->pressure_current = nullptr;
+  this->map = new ExcitationMap();
+  this->internal_grid->map = this->map;
+  this->internal_grid->time_step = 0;
+  this->normalized = normalized;
+  time_counter = 0;
+  imaging_step = 1;
+  reported = false;
+}
+
+// The frame fetched at a backward time-step is the one after it, so the
+// tracked frames follow the time-steps correlated by the engine.
+bool ExcitationPropagation::IsImaged(uint frame) {
+  return frame > 0 && (frame - 1) % imaging_step == 0;
+}
+
+void ExcitationPropagation::ClearFrames() {
+  memset(main_grid->pressure_previous, 0.0f, pressure_size * sizeof(float));
+  memset(main_grid->pressure_current, 0.0f, pressure_size * sizeof(float));
+  memset(main_grid->pressure_next, 0.0f, pressure_size * sizeof(float));
+}
+
+void ExcitationPropagation::FetchForward(void) {
+  // The correlation kernel samples the backward frame at the points excited
+  // by the forward one.
+  internal_grid->time_step = time_counter;
+  time_counter--;
+}
+
+void ExcitationPropagation::ResetGrid(bool forward_run) {
+  if (forward_run) {
+    // The frames hold all the shots of a batch.
+    uint batch = parameters->shot_batch;
+    pressure_size = main_grid->window_size.window_nx *
+                    main_grid->window_size.window_ny *
+                    main_grid->window_size.window_nz * batch;
+    time_counter = 0;
+    imaging_step = parameters->imaging_step;
+    WindowSize region = GetImagingRegion(main_grid, parameters);
+    map->Reset(main_grid->window_size, region, batch);
+    if (!reported) {
+      cout << "Forward excitation times : " << map->GetBytes() / (1024 * 1024)
+           << " MB" << endl;
+      reported = true;
+    }
+    // The frames hold the backward propagation of the previous shot.
+    ClearFrames();
+    internal_grid->nt = main_grid->nt;
+    internal_grid->dt = main_grid->dt;
+    memcpy(&internal_grid->grid_size, &main_grid->grid_size,
+           sizeof(main_grid->grid_size));
+    memcpy(&internal_grid->window_size, &main_grid->window_size,
+           sizeof(main_grid->window_size));
+    memcpy(&internal_grid->cell_dimensions, &main_grid->cell_dimensions,
+           sizeof(main_grid->cell_dimensions));
+    internal_grid->velocity = main_grid->velocity;
+  } else {
+    // The last two frames of the forward propagation aren't followed by
+    // SaveForward calls.
+    if (IsImaged(time_counter)) {
+      map->Add(main_grid->pressure_previous, time_counter);
+    }
+    if (IsImaged(time_counter + 1)) {
+      map->Add(main_grid->pressure_current, time_counter + 1);
+    }
+    map->Finish(main_grid->nt + 1, normalized);
+    // The first fetched frame is the last one of the forward propagation.
+    time_counter++;
+    ClearFrames();
+  }
+}
+
+void ExcitationPropagation::SaveForward() {
+  time_counter++;
+  // The frame before the current one is complete, its source being injected.
+  uint frame = time_counter - 1;
+  if (IsImaged(frame)) {
+    map->Add(main_grid->pressure_previous, frame);
+  }
+}
+
+ExcitationPropagation::~ExcitationPropagation() {
+  delete map;
+  mem_free((void *)internal_grid);
+}
+
+void ExcitationPropagation::SetComputationParameters(
+    ComputationParameters *parameters) {
+  this->parameters = parameters;
+}
+
+void ExcitationPropagation::SetGridBox(GridBox *grid_box) {
+  this->main_grid = (AcousticSecondGrid *)(grid_box);
+  if (this->main_grid == nullptr) {
+    std::cout << "Not a compatible gridbox : "
+                 "expected AcousticSecondGrid"
+              << std::endl;
+    exit(-1);
+  }
+}
+
+GridBox *ExcitationPropagation::GetForwardGrid() { return internal_grid; }
+
+bool ExcitationPropagation::SupportsShotBatch() { return true; }
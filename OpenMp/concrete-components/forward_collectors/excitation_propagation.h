@@ -0,0 +1,51 @@
+#ifndef ACOUSTIC2ND_RTM_EXCITATION_PROPAGATION_H
+#define ACOUSTIC2ND_RTM_EXCITATION_PROPAGATION_H
+
+#include <concrete-components/data_units/acoustic_second_grid.h>
+#include <concrete-components/forward_collectors/excitation_time/excitation_map.h>
+#include <skeleton/components/forward_collector.h>
+
+/*!
+ * Forward collector storing no forward wavefield : the excitation time of each
+ * point of the imaging region, when the source wavefield is the largest at it,
+ * is tracked while the forward propagation runs, for the excitation time
+ * correlation kernel to sample the backward propagation at it. Its memory is
+ * two grids whatever the number of time-steps.
+ */
+class ExcitationPropagation : public ForwardCollector {
+private:
+  AcousticSecondGrid *main_grid;
+  ExcitationGrid *internal_grid;
+  ComputationParameters *parameters;
+  ExcitationMap *map;
+  // Whether the image is normalized by the excitation amplitudes.
+  bool normalized;
+  uint pressure_size;
+  unsigned int time_counter;
+  // The time-steps between the tracked frames.
+  uint imaging_step;
+  bool reported;
+
+  bool IsImaged(uint frame);
+  void ClearFrames();
+
+public:
+  /*!
+   * @param normalized
+   * Whether the backward wavefield sampled at the excitation time of a point
+   * is divided by the amplitude of the source wavefield then, making the
+   * image an estimate of the reflection coefficients, instead of being
+   * multiplied by it.
+   */
+  explicit ExcitationPropagation(bool normalized = false);
+  void FetchForward(void) override;
+  void SaveForward() override;
+  void ResetGrid(bool forward_run) override;
+  void SetComputationParameters(ComputationParameters *parameters) override;
+  void SetGridBox(GridBox *grid_box) override;
+  bool SupportsShotBatch() override;
+  GridBox *GetForwardGrid() override;
+  ~ExcitationPropagation() override;
+};
+
+#endif // ACOUSTIC2ND_RTM_EXCITATION_PROPAGATION_H
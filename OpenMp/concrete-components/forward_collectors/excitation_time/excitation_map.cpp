@@ -0,0 +1,154 @@
+#include "excitation_map.h"
+
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_region.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+ExcitationMap::ExcitationMap() {
+  window = {{0, 0, 0}, 0, 0, 0};
+  region = window;
+  batch = 1;
+  region_size = 0;
+  amplitudes = nullptr;
+  time_steps = nullptr;
+  points = nullptr;
+  capacity = 0;
+}
+
+ExcitationMap::~ExcitationMap() {
+  if (amplitudes != nullptr) {
+    mem_free(amplitudes);
+    mem_free(time_steps);
+    mem_free(points);
+  }
+}
+
+void ExcitationMap::Reset(const WindowSize &window, const WindowSize &region,
+                          uint batch) {
+  this->window = window;
+  this->region = region;
+  this->batch = batch;
+  region_size = GetRegionSize(region, batch);
+  if (region_size > capacity) {
+    if (amplitudes != nullptr) {
+      mem_free(amplitudes);
+      mem_free(time_steps);
+      mem_free(points);
+    }
+    amplitudes = (float *)mem_allocate(sizeof(float), region_size,
+                                       "excitation_amplitudes");
+    time_steps = (uint *)mem_allocate(sizeof(uint), region_size,
+                                      "excitation_time_steps");
+    points = (uint *)mem_allocate(sizeof(uint), region_size,
+                                  "excitation_points");
+    if (amplitudes == nullptr || time_steps == nullptr || points == nullptr) {
+      cout << "Could not allocate the "
+           << 3 * region_size * sizeof(float) / (1024 * 1024)
+           << " MB of the excitation times" << endl;
+      cout << "Terminating..." << endl;
+      exit(-1);
+    }
+    capacity = region_size;
+  }
+  memset(amplitudes, 0, region_size * sizeof(float));
+  memset(time_steps, 0, region_size * sizeof(uint));
+  step_starts.clear();
+}
+
+void ExcitationMap::Add(const float *frame, uint time_step) {
+  size_t row = (size_t)region.window_nx * batch;
+  int rows = region.window_ny * region.window_nz;
+#pragma omp parallel for schedule(static)
+  for (int r = 0; r < rows; r++) {
+    uint iy = r / region.window_nz;
+    uint iz = r % region.window_nz;
+    size_t y = region.window_start.y + iy;
+    size_t z = region.window_start.z + iz;
+    const float *values =
+        frame +
+        ((y * window.window_nz + z) * window.window_nx +
+         region.window_start.x) *
+            batch;
+    float *amplitude = amplitudes + r * row;
+    uint *excitation = time_steps + r * row;
+    for (size_t x = 0; x < row; x++) {
+      if (fabsf(values[x]) > fabsf(amplitude[x])) {
+        amplitude[x] = values[x];
+        excitation[x] = time_step;
+      }
+    }
+  }
+}
+
+void ExcitationMap::Finish(uint time_steps, bool normalized) {
+  // The points whose source wavefield stayed zero are never sampled.
+  step_starts.assign(time_steps + 2, 0);
+  float largest = 0;
+  for (size_t p = 0; p < region_size; p++) {
+    if (amplitudes[p] != 0) {
+      step_starts[this->time_steps[p] + 2]++;
+      largest = max(largest, fabsf(amplitudes[p]));
+    }
+  }
+  for (uint t = 2; t < time_steps + 2; t++) {
+    step_starts[t] += step_starts[t - 1];
+  }
+  for (size_t p = 0; p < region_size; p++) {
+    if (amplitudes[p] != 0) {
+      points[step_starts[this->time_steps[p] + 1]++] = p;
+    }
+  }
+  if (normalized) {
+    // The samples are divided by the amplitude, damped by the floor where it
+    // is small.
+    float floor = EXCITATION_FLOOR * largest;
+    float damping = floor * floor;
+#pragma omp parallel for schedule(static)
+    for (size_t p = 0; p < region_size; p++) {
+      float amplitude = amplitudes[p];
+      amplitudes[p] = amplitude / (amplitude * amplitude + damping);
+    }
+  }
+}
+
+void ExcitationMap::Sample(const float *frame, uint time_step,
+                           const GridSize &grid, float *image) const {
+  if (time_step + 1 >= step_starts.size()) {
+    return;
+  }
+  size_t start = step_starts[time_step];
+  size_t end = step_starts[time_step + 1];
+  size_t row = (size_t)region.window_nx * batch;
+  // The points of a time-step are distinct, so are their image points.
+#pragma omp parallel for schedule(static) if (end - start > 4096)
+  for (size_t i = start; i < end; i++) {
+    size_t point = points[i];
+    size_t r = point / row;
+    size_t x = point % row;
+    size_t y = region.window_start.y + r / region.window_nz;
+    size_t z = region.window_start.z + r % region.window_nz;
+    size_t frame_offset =
+        ((y * window.window_nz + z) * window.window_nx +
+         region.window_start.x) *
+            batch +
+        x;
+    size_t image_offset =
+        (((window.window_start.y + y) * grid.nz + window.window_start.z + z) *
+             grid.nx +
+         window.window_start.x + region.window_start.x) *
+            batch +
+        x;
+    image[image_offset] += frame[frame_offset] * amplitudes[point];
+  }
+}
+
+size_t ExcitationMap::GetBytes() const {
+  return region_size * (sizeof(float) + sizeof(uint));
+}
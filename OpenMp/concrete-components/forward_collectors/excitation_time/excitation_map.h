@@ -0,0 +1,93 @@
+#ifndef ACOUSTIC2ND_RTM_EXCITATION_MAP_H
+#define ACOUSTIC2ND_RTM_EXCITATION_MAP_H
+
+#include <skeleton/base/datatypes.h>
+
+#include <cstddef>
+#include <vector>
+
+// The amplitude, relative to the largest one, below which the source
+// normalization of the image is damped rather than amplifying the noise.
+#define EXCITATION_FLOOR 0.01f
+
+/*!
+ * The excitation time of each point of the imaging region of a window : the
+ * time-step of the largest absolute value of the source wavefield at it, with
+ * that value, tracked as the frames of the forward propagation are computed.
+ * The value weights the samples of the backward frames, keeping the polarity
+ * of the cross correlation.
+ *
+ * Once complete, the points are sorted by their excitation time, so the
+ * backward frame of a time-step is only sampled at the points excited at it.
+ * The points are numbered like the packed region snapshots, the shots of a
+ * batch being interleaved innermost.
+ */
+class ExcitationMap {
+private:
+  WindowSize window;
+  WindowSize region;
+  uint batch;
+  size_t region_size;
+  // The value of the largest amplitude of each point, replaced by the weight
+  // of its samples once complete.
+  float *amplitudes;
+  // The excitation time-step of each point.
+  uint *time_steps;
+  // The points excited at each time-step, the ones of time-step t being from
+  // step_starts[t] to step_starts[t + 1].
+  uint *points;
+  size_t capacity;
+  std::vector<size_t> step_starts;
+
+public:
+  ExcitationMap();
+  /*!
+   * Clears the excitation times, allocating them for the given layout if
+   * needed.
+   * @param window
+   * The window of the frames.
+   * @param region
+   * The region of the window the excitation times are tracked in.
+   */
+  void Reset(const WindowSize &window, const WindowSize &region, uint batch);
+  /*!
+   * Updates the excitation times with the region of a frame of the window at
+   * the given time-step.
+   */
+  void Add(const float *frame, uint time_step);
+  /*!
+   * Sorts the points by excitation time, to be called after the last frame.
+   * @param time_steps
+   * The number of time-steps, all the added ones being below it.
+   * @param normalized
+   * Whether the samples are divided by the excitation amplitude, damped below
+   * EXCITATION_FLOOR of the largest one, instead of being multiplied by it.
+   */
+  void Finish(uint time_steps, bool normalized);
+  /*!
+   * Adds the values of a frame of the window at the points excited at the
+   * given time-step to the image of the grid, the shots of a batch being
+   * interleaved innermost in it.
+   */
+  void Sample(const float *frame, uint time_step, const GridSize &grid,
+              float *image) const;
+  /*!
+   * @return
+   * The bytes of the excitation times and amplitudes.
+   */
+  size_t GetBytes() const;
+  ~ExcitationMap();
+};
+
+/*!
+ * The forward grid of the excitation time collectors : the excitation times of
+ * the forward propagation, and the time-step of the forward frame each
+ * backward one is imaged with, in place of the frame itself.
+ */
+class ExcitationGrid : public GridBox {
+public:
+  ExcitationMap *map;
+  uint time_step;
+};
+
+#endif // ACOUSTIC2ND_RTM_EXCITATION_MAP_H
@@ -5,6 +5,7 @@
 #ifndef ACOUSTIC2ND_RTM_FILE_HANDLER_H
 #define ACOUSTIC2ND_RTM_FILE_HANDLER_H
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
@@ -13,5 +14,7 @@
 
 void bin_file_save(const char *fname, const float *data, const size_t size);
 void bin_file_load(const char *fname, float *data, const size_t size);
+void bin_file_save(const char *fname, const uint16_t *data, const size_t size);
+void bin_file_load(const char *fname, uint16_t *data, const size_t size);
 
 #endif // ACOUSTIC2ND_RTM_FILE_HANDLER_H
@@ -0,0 +1,205 @@
+#include "frequency_slices.h"
+
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_region.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <xmmintrin.h>
+
+// The flush to zero and denormals are zero bits of the MXCSR register.
+#define FLUSH_DENORMALS 0x8040
+
+using namespace std;
+
+float GetFrequencyStep(uint &frequency_count, float max_frequency,
+                       float source_frequency, float dt, uint nt,
+                       uint imaging_step) {
+  if (max_frequency <= 0) {
+    max_frequency = 3 * source_frequency;
+  }
+  max_frequency = min(max_frequency, 1.0f / (2 * imaging_step * dt));
+  if (frequency_count == 0) {
+    // The correlation of the sampled frequencies repeats every inverse of
+    // their spacing in time, which the duration of the shot leaves out.
+    frequency_count = max(1, (int)ceil(max_frequency * nt * dt));
+  }
+  return max_frequency / frequency_count;
+}
+
+FrequencySlices::FrequencySlices() {
+  slices = nullptr;
+  capacity = 0;
+  window = {{0, 0, 0}, 0, 0, 0};
+  region = window;
+  batch = 1;
+  region_size = 0;
+  frequency_count = 0;
+  frequency_step = 0;
+  dt = 0;
+  frames = nullptr;
+  frame_count = 0;
+}
+
+FrequencySlices::~FrequencySlices() {
+  if (slices != nullptr) {
+    mem_free(slices);
+    mem_free(frames);
+  }
+}
+
+void FrequencySlices::Reset(const WindowSize &window, const WindowSize &region,
+                            uint batch, uint frequency_count,
+                            float frequency_step, float dt) {
+  this->window = window;
+  this->region = region;
+  this->batch = batch;
+  this->frequency_count = frequency_count;
+  this->frequency_step = frequency_step;
+  this->dt = dt;
+  region_size = GetRegionSize(region, batch);
+  size_t size = 2 * frequency_count * region_size;
+  if (size > capacity) {
+    if (slices != nullptr) {
+      mem_free(slices);
+      mem_free(frames);
+    }
+    slices = (float *)mem_allocate(sizeof(float), size, "frequency_slices");
+    frames = (float *)mem_allocate(
+        sizeof(float), FREQUENCY_FRAMES * region_size, "frequency_frames");
+    if (slices == nullptr || frames == nullptr) {
+      cout << "Could not allocate the " << size * sizeof(float) / (1024 * 1024)
+           << " MB of the frequency slices" << endl;
+      cout << "Terminating..." << endl;
+      exit(-1);
+    }
+    capacity = size;
+  }
+  memset(slices, 0, size * sizeof(float));
+  frame_count = 0;
+}
+
+void FrequencySlices::Reset(const FrequencySlices &layout) {
+  Reset(layout.window, layout.region, layout.batch, layout.frequency_count,
+        layout.frequency_step, layout.dt);
+}
+
+float *FrequencySlices::GetReal(uint frequency) const {
+  return slices + 2 * frequency * region_size;
+}
+
+float *FrequencySlices::GetImaginary(uint frequency) const {
+  return slices + (2 * frequency + 1) * region_size;
+}
+
+void FrequencySlices::Add(const float *frame, uint time_step) {
+  PackRegion(frame, window, region, batch,
+             frames + frame_count * region_size);
+  frame_time_steps[frame_count] = time_step;
+  frame_count++;
+  if (frame_count == FREQUENCY_FRAMES) {
+    Flush();
+  }
+}
+
+void FrequencySlices::Flush() {
+  if (frame_count == 0) {
+    return;
+  }
+  // The phases are computed in double, the time-steps reaching thousands of
+  // periods of the frequencies.
+  vector<float> cosines(frequency_count * frame_count);
+  vector<float> sines(frequency_count * frame_count);
+  for (uint f = 0; f < frequency_count; f++) {
+    for (uint i = 0; i < frame_count; i++) {
+      double phase = 2 * M_PI * (f + 1) * frequency_step *
+                     frame_time_steps[i] * dt;
+      cosines[f * frame_count + i] = cos(phase);
+      sines[f * frame_count + i] = sin(phase);
+    }
+  }
+  // A row of a slice stays in the cache while all the frames are added to it,
+  // four at a time.
+  size_t row = (size_t)region.window_nx * batch;
+  int rows = region.window_ny * region.window_nz;
+  uint count = frame_count;
+#pragma omp parallel
+  {
+    // The tails of the waves are denormal numbers, slowing the products down
+    // by far for no difference in the slices.
+    unsigned int csr = _mm_getcsr();
+    _mm_setcsr(csr | FLUSH_DENORMALS);
+#pragma omp for schedule(static)
+    for (int r = 0; r < rows; r++) {
+      for (uint f = 0; f < frequency_count; f++) {
+        float *real = GetReal(f) + r * row;
+        float *imaginary = GetImaginary(f) + r * row;
+        const float *c = &cosines[f * count];
+        const float *s = &sines[f * count];
+        uint i = 0;
+        for (; i + 4 <= count; i += 4) {
+          const float *v0 = frames + i * region_size + r * row;
+          const float *v1 = v0 + region_size;
+          const float *v2 = v1 + region_size;
+          const float *v3 = v2 + region_size;
+          float c0 = c[i], c1 = c[i + 1], c2 = c[i + 2], c3 = c[i + 3];
+          float s0 = s[i], s1 = s[i + 1], s2 = s[i + 2], s3 = s[i + 3];
+#pragma ivdep
+          for (size_t x = 0; x < row; x++) {
+            real[x] += v0[x] * c0 + v1[x] * c1 + v2[x] * c2 + v3[x] * c3;
+            imaginary[x] -= v0[x] * s0 + v1[x] * s1 + v2[x] * s2 + v3[x] * s3;
+          }
+        }
+        for (; i < count; i++) {
+          const float *v = frames + i * region_size + r * row;
+          float c0 = c[i], s0 = s[i];
+#pragma ivdep
+          for (size_t x = 0; x < row; x++) {
+            real[x] += v[x] * c0;
+            imaginary[x] -= v[x] * s0;
+          }
+        }
+      }
+    }
+    _mm_setcsr(csr);
+  }
+  frame_count = 0;
+}
+
+void FrequencySlices::Correlate(const FrequencySlices &other, float scale,
+                                const GridSize &grid, float *image) const {
+  size_t row = (size_t)region.window_nx * batch;
+  int rows = region.window_ny * region.window_nz;
+  size_t x_start = window.window_start.x + region.window_start.x;
+#pragma omp parallel for schedule(static)
+  for (int r = 0; r < rows; r++) {
+    size_t y = window.window_start.y + region.window_start.y +
+               r / region.window_nz;
+    size_t z = window.window_start.z + region.window_start.z +
+               r % region.window_nz;
+    float *output =
+        image + ((y * grid.nz + z) * grid.nx + x_start) * batch;
+    for (uint f = 0; f < frequency_count; f++) {
+      const float *real = GetReal(f) + r * row;
+      const float *imaginary = GetImaginary(f) + r * row;
+      const float *other_real = other.GetReal(f) + r * row;
+      const float *other_imaginary = other.GetImaginary(f) + r * row;
+#pragma ivdep
+      for (size_t x = 0; x < row; x++) {
+        output[x] += scale * (real[x] * other_real[x] +
+                              imaginary[x] * other_imaginary[x]);
+      }
+    }
+  }
+}
+
+uint FrequencySlices::GetFrequencyCount() const { return frequency_count; }
+
+float FrequencySlices::GetFrequencyStep() const { return frequency_step; }
+
+size_t FrequencySlices::GetBytes() const {
+  return 2 * frequency_count * region_size * sizeof(float);
+}
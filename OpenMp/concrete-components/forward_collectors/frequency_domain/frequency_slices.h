@@ -0,0 +1,125 @@
+#ifndef ACOUSTIC2ND_RTM_FREQUENCY_SLICES_H
+#define ACOUSTIC2ND_RTM_FREQUENCY_SLICES_H
+
+#include <skeleton/base/datatypes.h>
+
+#include <cstddef>
+
+// The frames added to the slices at once : each slice is read and written once
+// for all of them rather than for each frame.
+#define FREQUENCY_FRAMES 16
+
+/*!
+ * The frequency slices of a wavefield over the imaging region of a window,
+ * accumulated by a running discrete Fourier transform as its frames are
+ * computed : the slice of a frequency f sums each frame p(t) multiplied by
+ * exp(-2i * pi * f * t * dt).
+ *
+ * The frequencies are evenly spaced, the first one being the spacing. The
+ * real and imaginary parts of each slice are held one after the other, their
+ * points packed row after row like the region snapshots, the shots of a batch
+ * being interleaved innermost. The added frames are kept till FREQUENCY_FRAMES
+ * of them are added to the slices together.
+ */
+class FrequencySlices {
+private:
+  float *slices;
+  size_t capacity;
+  WindowSize window;
+  WindowSize region;
+  uint batch;
+  size_t region_size;
+  uint frequency_count;
+  float frequency_step;
+  float dt;
+  // The packed regions of the frames not added to the slices yet, with their
+  // time-steps.
+  float *frames;
+  uint frame_time_steps[FREQUENCY_FRAMES];
+  uint frame_count;
+
+  float *GetReal(uint frequency) const;
+  float *GetImaginary(uint frequency) const;
+
+public:
+  FrequencySlices();
+  /*!
+   * Zeroes the slices, allocating them for the given layout if needed.
+   * @param window
+   * The window of the frames.
+   * @param region
+   * The region of the window the slices hold.
+   * @param frequency_count
+   * The number of frequencies.
+   * @param frequency_step
+   * The spacing of the frequencies in Hz.
+   * @param dt
+   * The seconds of a time-step.
+   */
+  void Reset(const WindowSize &window, const WindowSize &region, uint batch,
+             uint frequency_count, float frequency_step, float dt);
+  /*!
+   * Zeroes the slices, with the same layout and frequencies as the given ones.
+   */
+  void Reset(const FrequencySlices &layout);
+  /*!
+   * Adds the region of a frame of the window at the given time-step to all
+   * the slices, once Flush is called or enough frames are added.
+   */
+  void Add(const float *frame, uint time_step);
+  /*!
+   * Adds the frames kept by Add to the slices, to be called after the last
+   * frame.
+   */
+  void Flush();
+  /*!
+   * Adds the zero lag cross correlation of the frames of these slices and of
+   * the other ones to the region of an image of the grid : the sum over the
+   * frequencies of the real part of the product of the slices by the
+   * conjugate of the other ones, multiplied by the scale.
+   * @param other
+   * Slices of the same layout.
+   * @param grid
+   * The size of the grid of the image, the shots of a batch being interleaved
+   * innermost in it.
+   */
+  void Correlate(const FrequencySlices &other, float scale,
+                 const GridSize &grid, float *image) const;
+  uint GetFrequencyCount() const;
+  float GetFrequencyStep() const;
+  /*!
+   * @return
+   * The bytes of the slices.
+   */
+  size_t GetBytes() const;
+  ~FrequencySlices();
+};
+
+/*!
+ * Gets the spacing of the evenly spaced frequencies of the slices.
+ * @param frequency_count
+ * The number of frequencies, 0 for the fewest spaced by at most the inverse
+ * of the duration of the shot, which is set to it. Fewer frequencies mix the
+ * events of the correlation apart by a multiple of the inverse of their
+ * spacing.
+ * @param max_frequency
+ * The highest frequency in Hz, 0 for three times the source frequency,
+ * beyond which a ricker wavelet has almost no energy. It is lowered to the
+ * Nyquist frequency of the time-steps accumulated every imaging step.
+ */
+float GetFrequencyStep(uint &frequency_count, float max_frequency,
+                       float source_frequency, float dt, uint nt,
+                       uint imaging_step);
+
+/*!
+ * The forward grid of the frequency domain collectors : the frequency slices
+ * of the forward propagation, and the time-step of the forward frame each
+ * backward one is correlated with, in place of the frame itself.
+ */
+class FrequencyGrid : public GridBox {
+public:
+  FrequencySlices *slices;
+  uint time_step;
+};
+
+#endif // ACOUSTIC2ND_RTM_FREQUENCY_SLICES_H
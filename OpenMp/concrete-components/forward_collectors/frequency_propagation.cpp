@@ -0,0 +1,125 @@
+#include "frequency_propagation.h"
+
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_region.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+FrequencyPropagation::FrequencyPropagation(uint frequency_count,
+                                           float max_frequency) {
+  this->internal_grid = (FrequencyGrid *)mem_allocate(
+      sizeof(FrequencyGrid), 1, "forward_collector_gridbox");
+  this->internal_grid->pressure_current = nullptr;
+  this->slices = new FrequencySlices();
+  this->internal_grid->slices = this->slices;
+  this->internal_grid->time_step = 0;
+  this->frequency_count = frequency_count;
+  this->max_frequency = max_frequency;
+  time_counter = 0;
+  imaging_step = 1;
+  reported = false;
+}
+
+// The frame fetched at a backward time-step is the one after it, so the
+// accumulated frames follow the time-steps correlated by the engine.
+bool FrequencyPropagation::IsImaged(uint frame) {
+  return frame > 0 && (frame - 1) % imaging_step == 0;
+}
+
+void FrequencyPropagation::ClearFrames() {
+  memset(main_grid->pressure_previous, 0.0f, pressure_size * sizeof(float));
+  memset(main_grid->pressure_current, 0.0f, pressure_size * sizeof(float));
+  memset(main_grid->pressure_next, 0.0f, pressure_size * sizeof(float));
+}
+
+void FrequencyPropagation::FetchForward(void) {
+  // The correlation kernel accumulates the backward frame with the phase of
+  // the forward one.
+  internal_grid->time_step = time_counter;
+  time_counter--;
+}
+
+void FrequencyPropagation::ResetGrid(bool forward_run) {
+  if (forward_run) {
+    // The frames hold all the shots of a batch.
+    uint batch = parameters->shot_batch;
+    pressure_size = main_grid->window_size.window_nx *
+                    main_grid->window_size.window_ny *
+                    main_grid->window_size.window_nz * batch;
+    time_counter = 0;
+    imaging_step = parameters->imaging_step;
+    uint count = frequency_count;
+    float frequency_step = GetFrequencyStep(
+        count, max_frequency, parameters->source_frequency, main_grid->dt,
+        main_grid->nt, imaging_step);
+    WindowSize region = GetImagingRegion(main_grid, parameters);
+    slices->Reset(main_grid->window_size, region, batch, count, frequency_step,
+                  main_grid->dt);
+    if (!reported) {
+      cout << "Forward frequency slices : " << count
+           << " frequencies every " << frequency_step << " Hz in "
+           << slices->GetBytes() / (1024 * 1024) << " MB" << endl;
+      reported = true;
+    }
+    // The frames hold the backward propagation of the previous shot.
+    ClearFrames();
+    internal_grid->nt = main_grid->nt;
+    internal_grid->dt = main_grid->dt;
+    memcpy(&internal_grid->grid_size, &main_grid->grid_size,
+           sizeof(main_grid->grid_size));
+    memcpy(&internal_grid->window_size, &main_grid->window_size,
+           sizeof(main_grid->window_size));
+    memcpy(&internal_grid->cell_dimensions, &main_grid->cell_dimensions,
+           sizeof(main_grid->cell_dimensions));
+    internal_grid->velocity = main_grid->velocity;
+  } else {
+    // The last two frames of the forward propagation aren't followed by
+    // SaveForward calls.
+    if (IsImaged(time_counter)) {
+      slices->Add(main_grid->pressure_previous, time_counter);
+    }
+    if (IsImaged(time_counter + 1)) {
+      slices->Add(main_grid->pressure_current, time_counter + 1);
+    }
+    slices->Flush();
+    // The first fetched frame is the last one of the forward propagation.
+    time_counter++;
+    ClearFrames();
+  }
+}
+
+void FrequencyPropagation::SaveForward() {
+  time_counter++;
+  // The frame before the current one is complete, its source being injected.
+  uint frame = time_counter - 1;
+  if (IsImaged(frame)) {
+    slices->Add(main_grid->pressure_previous, frame);
+  }
+}
+
+FrequencyPropagation::~FrequencyPropagation() {
+  delete slices;
+  mem_free((void *)internal_grid);
+}
+
+void FrequencyPropagation::SetComputationParameters(
+    ComputationParameters *parameters) {
+  this->parameters = parameters;
+}
+
+void FrequencyPropagation::SetGridBox(GridBox *grid_box) {
+  this->main_grid = (AcousticSecondGrid *)(grid_box);
+  if (this->main_grid == nullptr) {
+    std::cout << "Not a compatible gridbox : "
+                 "expected AcousticSecondGrid"
+              << std::endl;
+    exit(-1);
+  }
+}
+
+GridBox *FrequencyPropagation::GetForwardGrid() { return internal_grid; }
+
+bool FrequencyPropagation::SupportsShotBatch() { return true; }
@@ -0,0 +1,55 @@
+#ifndef ACOUSTIC2ND_RTM_FREQUENCY_PROPAGATION_H
+#define ACOUSTIC2ND_RTM_FREQUENCY_PROPAGATION_H
+
+#include <concrete-components/data_units/acoustic_second_grid.h>
+#include <concrete-components/forward_collectors/frequency_domain/frequency_slices.h>
+#include <skeleton/components/forward_collector.h>
+
+/*!
+ * Forward collector storing no forward wavefield : the frequency slices of the
+ * imaging region of the forward propagation are accumulated while it runs,
+ * for the frequency domain correlation kernel to correlate them with the
+ * same frequencies of the backward propagation. Its memory only depends on
+ * the number of frequencies, not on the number of time-steps.
+ */
+class FrequencyPropagation : public ForwardCollector {
+private:
+  AcousticSecondGrid *main_grid;
+  FrequencyGrid *internal_grid;
+  ComputationParameters *parameters;
+  FrequencySlices *slices;
+  // The number of frequencies, 0 to set it from the duration of the shot.
+  uint frequency_count;
+  // The highest frequency in Hz, 0 for three times the source frequency.
+  float max_frequency;
+  uint pressure_size;
+  unsigned int time_counter;
+  // The time-steps between the accumulated frames.
+  uint imaging_step;
+  bool reported;
+
+  bool IsImaged(uint frame);
+  void ClearFrames();
+
+public:
+  /*!
+   * @param frequency_count
+   * The number of frequencies accumulated, 0 for the fewest not mixing the
+   * events of the correlation within the duration of the shot.
+   * @param max_frequency
+   * The highest frequency in Hz, the others being evenly spaced below it, 0
+   * for three times the source frequency. It is lowered to the Nyquist
+   * frequency of the imaged time-steps.
+   */
+  FrequencyPropagation(uint frequency_count, float max_frequency = 0);
+  void FetchForward(void) override;
+  void SaveForward() override;
+  void ResetGrid(bool forward_run) override;
+  void SetComputationParameters(ComputationParameters *parameters) override;
+  void SetGridBox(GridBox *grid_box) override;
+  bool SupportsShotBatch() override;
+  GridBox *GetForwardGrid() override;
+  ~FrequencyPropagation() override;
+};
+
+#endif // ACOUSTIC2ND_RTM_FREQUENCY_PROPAGATION_H
@@ -0,0 +1,263 @@
+#include "half_precision.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+/*!
+ * Conversions between fp32 and the 16 bit storage precisions. The fp16
+ * conversions use the F16C instructions when the cpu supports them, compiled
+ * through the target attribute so the binary runs on any cpu, and the bit
+ * manipulation below otherwise. Both round to the nearest even, so they give
+ * the same values.
+ */
+
+// The conversions work on chunks of this many values, large enough to
+// amortize the scheduling and a multiple of the vector length.
+#define HALF_CHUNK 4096
+
+static inline uint32_t FloatBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static inline float BitsFloat(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline uint16_t FloatToHalf(float value) {
+  uint32_t bits = FloatBits(value);
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t abs = bits & 0x7FFFFFFF;
+  if (abs >= 0x7F800000) {
+    // Infinity, or a quiet nan.
+    return sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 : 0);
+  }
+  if (abs >= 0x477FF000) {
+    // Rounds to a value above the largest fp16(65504).
+    return sign | 0x7C00;
+  }
+  if (abs < 0x38800000) {
+    // Below the smallest normal fp16(2^-14) : a subnormal fp16 in units of
+    // 2^-24, half of the smallest subnormal rounds to the even zero.
+    if (abs <= 0x33000000) {
+      return sign;
+    }
+    uint32_t exponent = abs >> 23;
+    uint32_t mantissa = (abs & 0x7FFFFF) | 0x800000;
+    uint32_t shift = 126 - exponent;
+    uint32_t half = mantissa >> shift;
+    uint32_t remainder = mantissa & ((1u << shift) - 1);
+    uint32_t tie = 1u << (shift - 1);
+    if (remainder > tie || (remainder == tie && (half & 1))) {
+      half++;
+    }
+    return sign | half;
+  }
+  // Normal : rebias the exponent from 127 to 15 and drop 13 mantissa bits, a
+  // carry of the rounding goes to the exponent.
+  uint32_t half = (abs - 0x38000000) >> 13;
+  uint32_t remainder = abs & 0x1FFF;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+    half++;
+  }
+  return sign | half;
+}
+
+static inline float HalfToFloat(uint16_t half) {
+  uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1F;
+  uint32_t mantissa = half & 0x3FF;
+  if (exponent == 0) {
+    // Zero or subnormal, exact in fp32.
+    float value = (float)mantissa * 5.9604644775390625e-8f;
+    return sign ? -value : value;
+  }
+  if (exponent == 31) {
+    return BitsFloat(sign | 0x7F800000 | (mantissa << 13));
+  }
+  return BitsFloat(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+static inline uint16_t FloatToBfloat(float value) {
+  uint32_t bits = FloatBits(value);
+  if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+    // Keep nans quiet, the rounding could turn them to infinity.
+    return (bits >> 16) | 0x40;
+  }
+  return (bits + 0x7FFF + ((bits >> 16) & 1)) >> 16;
+}
+
+static inline float BfloatToFloat(uint16_t bfloat) {
+  return BitsFloat((uint32_t)bfloat << 16);
+}
+
+__attribute__((target("avx,f16c"))) static void
+PackHalfF16C(const float *src, uint16_t *dst, size_t n, float scale) {
+  __m256 scale_vec = _mm256_set1_ps(scale);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 values = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale_vec);
+    _mm_storeu_si128((__m128i *)(dst + i),
+                     _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i < n; i++) {
+    dst[i] = FloatToHalf(src[i] * scale);
+  }
+}
+
+__attribute__((target("avx,f16c"))) static void
+UnpackHalfF16C(const uint16_t *src, float *dst, size_t n, float inv_scale) {
+  __m256 scale_vec = _mm256_set1_ps(inv_scale);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 values =
+        _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src + i)));
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(values, scale_vec));
+  }
+  for (; i < n; i++) {
+    dst[i] = HalfToFloat(src[i]) * inv_scale;
+  }
+}
+
+static bool SupportsF16C() {
+  static bool supported =
+      __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+  return supported;
+}
+
+static void PackChunk(const float *src, uint16_t *dst, size_t n,
+                      STORAGE_PRECISION precision, float scale) {
+  if (precision == STORAGE_BF16) {
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = FloatToBfloat(src[i]);
+    }
+  } else if (SupportsF16C()) {
+    PackHalfF16C(src, dst, n, scale);
+  } else {
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = FloatToHalf(src[i] * scale);
+    }
+  }
+}
+
+static void UnpackChunk(const uint16_t *src, float *dst, size_t n,
+                        STORAGE_PRECISION precision, float scale) {
+  if (precision == STORAGE_BF16) {
+#pragma omp simd
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = BfloatToFloat(src[i]);
+    }
+  } else if (SupportsF16C()) {
+    UnpackHalfF16C(src, dst, n, 1.0f / scale);
+  } else {
+    float inv_scale = 1.0f / scale;
+    for (size_t i = 0; i < n; i++) {
+      dst[i] = HalfToFloat(src[i]) * inv_scale;
+    }
+  }
+}
+
+const char *GetStoragePrecisionName(STORAGE_PRECISION precision) {
+  switch (precision) {
+  case STORAGE_FP16:
+    return "fp16";
+  case STORAGE_BF16:
+    return "bf16";
+  default:
+    return "fp32";
+  }
+}
+
+float GetStorageScale(STORAGE_PRECISION precision, float max_abs) {
+  if (precision != STORAGE_FP16 || max_abs == 0 || !std::isfinite(max_abs)) {
+    return 1.0f;
+  }
+  // Brings the largest value to [2^14, 2^15), below the largest fp16.
+  int shift = 14 - std::ilogb(max_abs);
+  if (shift > 127) {
+    shift = 127;
+  } else if (shift < -126) {
+    shift = -126;
+  }
+  return std::ldexp(1.0f, shift);
+}
+
+float GetMaxAbs(const float *values, size_t n) {
+  float max_abs = 0;
+#pragma omp parallel for simd schedule(static) reduction(max : max_abs)
+  for (size_t i = 0; i < n; i++) {
+    max_abs = std::max(max_abs, std::fabs(values[i]));
+  }
+  return max_abs;
+}
+
+void PackHalf(const float *src, uint16_t *dst, size_t n,
+              STORAGE_PRECISION precision, float scale) {
+  size_t chunks = (n + HALF_CHUNK - 1) / HALF_CHUNK;
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    size_t start = chunk * HALF_CHUNK;
+    size_t count = std::min((size_t)HALF_CHUNK, n - start);
+    PackChunk(src + start, dst + start, count, precision, scale);
+  }
+}
+
+void UnpackHalf(const uint16_t *src, float *dst, size_t n,
+                STORAGE_PRECISION precision, float scale) {
+  size_t chunks = (n + HALF_CHUNK - 1) / HALF_CHUNK;
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    size_t start = chunk * HALF_CHUNK;
+    size_t count = std::min((size_t)HALF_CHUNK, n - start);
+    UnpackChunk(src + start, dst + start, count, precision, scale);
+  }
+}
+
+void PackHalfRow(const float *src, uint16_t *dst, size_t n,
+                 STORAGE_PRECISION precision) {
+  PackChunk(src, dst, n, precision, 1.0f);
+}
+
+void UnpackHalfRow(const uint16_t *src, float *dst, size_t n,
+                   STORAGE_PRECISION precision) {
+  UnpackChunk(src, dst, n, precision, 1.0f);
+}
+
+uint16_t AddHalf(uint16_t value, float amplitude, STORAGE_PRECISION precision) {
+  if (precision == STORAGE_BF16) {
+    return FloatToBfloat(BfloatToFloat(value) + amplitude);
+  }
+  return FloatToHalf(HalfToFloat(value) + amplitude);
+}
+
+void AccumulateHalfError(const float *reference, const uint16_t *packed,
+                         size_t n, STORAGE_PRECISION precision, float scale,
+                         double &error_norm, double &reference_norm,
+                         float &max_error) {
+  size_t chunks = (n + HALF_CHUNK - 1) / HALF_CHUNK;
+  double error_sum = 0;
+  double reference_sum = 0;
+  float error_max = max_error;
+#pragma omp parallel for schedule(static)                                      \
+    reduction(+ : error_sum, reference_sum) reduction(max : error_max)
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    float values[HALF_CHUNK];
+    size_t start = chunk * HALF_CHUNK;
+    size_t count = std::min((size_t)HALF_CHUNK, n - start);
+    UnpackChunk(packed + start, values, count, precision, scale);
+    for (size_t i = 0; i < count; i++) {
+      float error = std::fabs(values[i] - reference[start + i]);
+      error_sum += (double)error * error;
+      reference_sum += (double)reference[start + i] * reference[start + i];
+      error_max = std::max(error_max, error);
+    }
+  }
+  error_norm += error_sum;
+  reference_norm += reference_sum;
+  max_error = error_max;
+}
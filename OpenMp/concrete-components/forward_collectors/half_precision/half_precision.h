@@ -0,0 +1,82 @@
+#ifndef ACOUSTIC2ND_RTM_HALF_PRECISION_H
+#define ACOUSTIC2ND_RTM_HALF_PRECISION_H
+
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * The precision the forward collector stores the saved wavefields in, or the
+ * computation kernel the live ones, the computations are always done in fp32.
+ */
+enum STORAGE_PRECISION { STORAGE_FP32, STORAGE_FP16, STORAGE_BF16 };
+
+/*!
+ * Gets a printable name of the storage precision.
+ */
+const char *GetStoragePrecisionName(STORAGE_PRECISION precision);
+
+/*!
+ * Gets the power of two the values of a frame are multiplied by before being
+ * stored in fp16, so that the largest value of the frame lands near the top of
+ * the fp16 range instead of having the small amplitudes flushed to zero.
+ * @param max_abs
+ * The largest absolute value of the frame.
+ * @return
+ * The scale of fp16, always 1 for bf16 which has the exponent range of fp32.
+ */
+float GetStorageScale(STORAGE_PRECISION precision, float max_abs);
+
+/*!
+ * Gets the largest absolute value of the n values.
+ */
+float GetMaxAbs(const float *values, size_t n);
+
+/*!
+ * Converts n fp32 values multiplied by the scale to the 16 bit precision,
+ * rounding to the nearest even.
+ */
+void PackHalf(const float *src, uint16_t *dst, size_t n,
+              STORAGE_PRECISION precision, float scale);
+
+/*!
+ * Converts n values of the 16 bit precision back to fp32, divided by the scale
+ * they were packed with.
+ */
+void UnpackHalf(const uint16_t *src, float *dst, size_t n,
+                STORAGE_PRECISION precision, float scale);
+
+/*!
+ * Converts n fp32 values to the 16 bit precision like PackHalf with a scale
+ * of 1, in the calling thread, for the callers converting their own share of
+ * a frame.
+ */
+void PackHalfRow(const float *src, uint16_t *dst, size_t n,
+                 STORAGE_PRECISION precision);
+
+/*!
+ * Converts n values of the 16 bit precision back to fp32 like UnpackHalf with
+ * a scale of 1, in the calling thread.
+ */
+void UnpackHalfRow(const uint16_t *src, float *dst, size_t n,
+                   STORAGE_PRECISION precision);
+
+/*!
+ * Adds the amplitude to the 16 bit value, computed in fp32.
+ */
+uint16_t AddHalf(uint16_t value, float amplitude, STORAGE_PRECISION precision);
+
+/*!
+ * Accumulates the error of storing the n fp32 values as the packed ones.
+ * @param error_norm
+ * The sum of the squared errors is added to it.
+ * @param reference_norm
+ * The sum of the squared fp32 values is added to it.
+ * @param max_error
+ * Updated to the largest absolute error.
+ */
+void AccumulateHalfError(const float *reference, const uint16_t *packed,
+                         size_t n, STORAGE_PRECISION precision, float scale,
+                         double &error_norm, double &reference_norm,
+                         float &max_error);
+
+#endif // ACOUSTIC2ND_RTM_HALF_PRECISION_H
@@ -6,7 +6,8 @@
 #include <iostream>
 
 ReverseInjectionPropagation::ReverseInjectionPropagation(
-    ComputationKernel *kernel) {
+    ComputationKernel *kernel, string write_path, size_t memory_budget,
+    BOUNDARY_CODEC codec, double tolerance) {
   this->internal_grid = (AcousticSecondGrid *)mem_allocate(
       sizeof(AcousticSecondGrid), 1, "forward_collector_gridbox");
   this->internal_grid->pressure_current = nullptr;
@@ -14,39 +15,46 @@ ReverseInjectionPropagation::ReverseInjectionPropagation(
   this->computation_kernel->SetGridBox(internal_grid);
   this->size_of_boundaries = 0;
   this->time_step = 0;
-  this->backup_boundaries = nullptr;
+  this->boundary_store =
+      new BoundaryStore(write_path, memory_budget, codec, tolerance);
 }
 
 void ReverseInjectionPropagation::FetchForward(void) {
   this->computation_kernel->Step();
   time_step--;
-  RestoreBoundaries(main_grid, internal_grid, parameters, backup_boundaries,
-                    time_step, size_of_boundaries);
+  RestoreBoundaries(main_grid, internal_grid, parameters,
+                    boundary_store->Fetch(time_step), 0, size_of_boundaries);
 }
 
+bool ReverseInjectionPropagation::IsReconstructed() { return true; }
+
 void ReverseInjectionPropagation::ResetGrid(bool forward_run) {
   unsigned int const grid_size = main_grid->window_size.window_nx *
                                  main_grid->window_size.window_ny *
                                  main_grid->window_size.window_nz;
   float *temp;
-  uint nx = main_grid->window_size.window_nx;
-  uint nz = main_grid->window_size.window_nz;
-  uint ny = main_grid->window_size.window_ny;
   if (!forward_run) {
+    boundary_store->Report();
     if (internal_grid->pressure_current == NULL) {
+      // Allocated once for the full grid so that the frames fit the window of
+      // any shot.
+      uint full_nx = main_grid->grid_size.nx;
+      uint full_nz = main_grid->grid_size.nz;
+      uint full_ny = main_grid->grid_size.ny;
+      unsigned int const full_size = full_nx * full_nz * full_ny;
       internal_grid->pressure_previous = (float *)mem_allocate(
-          sizeof(float), grid_size, "forward_collector_pressure_prev",
+          sizeof(float), full_size, "forward_collector_pressure_prev",
           parameters->half_length, 16);
       internal_grid->pressure_current = (float *)mem_allocate(
-          sizeof(float), grid_size, "forward_collector_pressure_curr",
+          sizeof(float), full_size, "forward_collector_pressure_curr",
           parameters->half_length, 32);
       internal_grid->pressure_next = internal_grid->pressure_previous;
-      this->computation_kernel->FirstTouch(internal_grid->pressure_previous, nx,
-                                           nz, ny);
-      this->computation_kernel->FirstTouch(internal_grid->pressure_current, nx,
-                                           nz, ny);
-      this->computation_kernel->FirstTouch(internal_grid->pressure_next, nx, nz,
-                                           ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_previous,
+                                           full_nx, full_nz, full_ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_current,
+                                           full_nx, full_nz, full_ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_next,
+                                           full_nx, full_nz, full_ny);
     }
     memcpy(internal_grid->pressure_previous, main_grid->pressure_previous,
            grid_size * sizeof(float));
@@ -70,9 +78,6 @@ void ReverseInjectionPropagation::ResetGrid(bool forward_run) {
     // Only use two pointers, prev is same as next.
     internal_grid->pressure_next = internal_grid->pressure_previous;
   } else {
-    if (this->backup_boundaries != nullptr) {
-      mem_free(this->backup_boundaries);
-    }
     time_step = 0;
     uint half_length = this->parameters->half_length;
     uint bound_length = this->parameters->boundary_length;
@@ -89,9 +94,7 @@ void ReverseInjectionPropagation::ResetGrid(bool forward_run) {
     if (nyi != 1) {
       this->size_of_boundaries += nxi * nzi * half_length * 2;
     }
-    this->backup_boundaries = (float *)mem_allocate(
-        sizeof(float), this->size_of_boundaries * (main_grid->nt + 1),
-        "boundary memory");
+    boundary_store->Reset(main_grid->nt + 1, size_of_boundaries);
   }
   memset(main_grid->pressure_previous, 0.0f, grid_size * sizeof(float));
   memset(main_grid->pressure_current, 0.0f, grid_size * sizeof(float));
@@ -99,8 +102,9 @@ void ReverseInjectionPropagation::ResetGrid(bool forward_run) {
 }
 
 void ReverseInjectionPropagation::SaveForward() {
-  SaveBoundaries(main_grid, parameters, backup_boundaries, time_step,
+  SaveBoundaries(main_grid, parameters, boundary_store->GetStep(time_step), 0,
                  size_of_boundaries);
+  boundary_store->Save(time_step);
   time_step++;
 }
 
@@ -110,6 +114,7 @@ ReverseInjectionPropagation::~ReverseInjectionPropagation() {
     mem_free((void *)internal_grid->pressure_current);
   }
   mem_free((void *)internal_grid);
+  delete boundary_store;
   delete computation_kernel;
 }
 
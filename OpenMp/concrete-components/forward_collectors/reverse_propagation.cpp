@@ -8,35 +8,52 @@ ReversePropagation::ReversePropagation(ComputationKernel *kernel) {
   this->internal_grid->pressure_current = nullptr;
   this->computation_kernel = kernel;
   this->computation_kernel->SetGridBox(internal_grid);
+  this->prepared = false;
 }
 
 void ReversePropagation::FetchForward(void) {
+  if (!this->prepared) {
+    this->computation_kernel->PreparePropagation();
+    this->prepared = true;
+  }
   this->computation_kernel->Step();
 }
 
+void ReversePropagation::SkipBackward(uint time_steps) {
+  if (!this->prepared) {
+    this->computation_kernel->PreparePropagation();
+    this->prepared = true;
+  }
+  // The reconstruction advances over the skipped time steps at once too.
+  this->computation_kernel->MultiStep(time_steps);
+}
+
 void ReversePropagation::ResetGrid(bool forward_run) {
   unsigned int const grid_size = main_grid->window_size.window_nx *
                                  main_grid->window_size.window_ny *
                                  main_grid->window_size.window_nz;
   float *temp;
-  uint nx = main_grid->window_size.window_nx;
-  uint nz = main_grid->window_size.window_nz;
-  uint ny = main_grid->window_size.window_ny;
   if (!forward_run) {
     if (internal_grid->pressure_current == NULL) {
+      // Allocated once for the full grid so that the frames fit the window of
+      // any shot.
+      uint full_nx = main_grid->grid_size.nx;
+      uint full_nz = main_grid->grid_size.nz;
+      uint full_ny = main_grid->grid_size.ny;
+      unsigned int const full_size = full_nx * full_nz * full_ny;
       internal_grid->pressure_previous = (float *)mem_allocate(
-          sizeof(float), grid_size, "forward_collector_pressure_prev",
+          sizeof(float), full_size, "forward_collector_pressure_prev",
           parameters->half_length, 16);
       internal_grid->pressure_current = (float *)mem_allocate(
-          sizeof(float), grid_size, "forward_collector_pressure_curr",
+          sizeof(float), full_size, "forward_collector_pressure_curr",
           parameters->half_length, 32);
       internal_grid->pressure_next = internal_grid->pressure_previous;
-      this->computation_kernel->FirstTouch(internal_grid->pressure_previous, nx,
-                                           nz, ny);
-      this->computation_kernel->FirstTouch(internal_grid->pressure_current, nx,
-                                           nz, ny);
-      this->computation_kernel->FirstTouch(internal_grid->pressure_next, nx, nz,
-                                           ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_previous,
+                                           full_nx, full_nz, full_ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_current,
+                                           full_nx, full_nz, full_ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_next,
+                                           full_nx, full_nz, full_ny);
     }
     memcpy(internal_grid->pressure_previous, main_grid->pressure_previous,
            grid_size * sizeof(float));
@@ -59,6 +76,7 @@ void ReversePropagation::ResetGrid(bool forward_run) {
     internal_grid->pressure_current = temp;
     // Only use two pointers, prev is same as next.
     internal_grid->pressure_next = internal_grid->pressure_previous;
+    this->prepared = false;
   }
   memset(main_grid->pressure_previous, 0.0f, grid_size * sizeof(float));
   memset(main_grid->pressure_current, 0.0f, grid_size * sizeof(float));
@@ -67,6 +85,10 @@ void ReversePropagation::ResetGrid(bool forward_run) {
 
 void ReversePropagation::SaveForward() {}
 
+bool ReversePropagation::IsSaveRequired(uint time_step) { return false; }
+
+bool ReversePropagation::IsReconstructed() { return true; }
+
 ReversePropagation::~ReversePropagation() {
   if (internal_grid->pressure_current != NULL) {
     mem_free((void *)internal_grid->pressure_previous);
@@ -93,3 +115,8 @@ void ReversePropagation::SetGridBox(GridBox *grid_box) {
 }
 
 GridBox *ReversePropagation::GetForwardGrid() { return internal_grid; }
+
+bool ReversePropagation::SupportsNarrowWavefields() {
+  // The frames are copied as they are and only read by the kernel.
+  return this->computation_kernel->SupportsNarrowWavefields();
+}
@@ -14,15 +14,22 @@ private:
   AcousticSecondGrid *internal_grid;
   ComputationParameters *parameters;
   ComputationKernel *computation_kernel;
+  // Whether the kernel was prepared for the backward propagation, done by the
+  // first fetch as the model is adjusted for it after the reset.
+  bool prepared;
 
 public:
   ReversePropagation(ComputationKernel *kernel);
   void FetchForward(void) override;
+  void SkipBackward(uint time_steps) override;
   void SaveForward() override;
+  bool IsSaveRequired(uint time_step) override;
+  bool IsReconstructed() override;
   void ResetGrid(bool forward_run) override;
   void SetComputationParameters(ComputationParameters *parameters) override;
   void SetGridBox(GridBox *grid_box) override;
   GridBox *GetForwardGrid() override;
+  bool SupportsNarrowWavefields() override;
   ~ReversePropagation() override;
 };
 #endif
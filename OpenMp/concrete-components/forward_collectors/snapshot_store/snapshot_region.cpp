@@ -0,0 +1,82 @@
+#include "snapshot_region.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Sets the start and size of the region along an axis of the window : the
+// correlation skips the halos of the window and the stacking skips the halos
+// and the boundary layers of the grid.
+static void SetRegionAxis(int grid_n, int window_start, int window_n,
+                          int half_length, int offset, uint &start,
+                          uint &size) {
+  int first = max(half_length, offset - window_start);
+  int end = min(window_n - half_length, grid_n - offset - window_start);
+  start = first;
+  size = max(end - first, 1);
+}
+
+WindowSize GetImagingRegion(GridBox *grid_box,
+                            ComputationParameters *parameters) {
+  WindowSize *window = &grid_box->window_size;
+  GridSize *grid = &grid_box->grid_size;
+  int half_length = parameters->half_length;
+  int offset = half_length + parameters->boundary_length;
+  WindowSize region;
+  SetRegionAxis(grid->nx, window->window_start.x, window->window_nx,
+                half_length, offset, region.window_start.x, region.window_nx);
+  SetRegionAxis(grid->nz, window->window_start.z, window->window_nz,
+                half_length, offset, region.window_start.z, region.window_nz);
+  if (window->window_ny > 1) {
+    SetRegionAxis(grid->ny, window->window_start.y, window->window_ny,
+                  half_length, offset, region.window_start.y,
+                  region.window_ny);
+  } else {
+    region.window_start.y = 0;
+    region.window_ny = 1;
+  }
+  return region;
+}
+
+size_t GetRegionSize(const WindowSize &region, uint batch) {
+  return (size_t)region.window_nx * region.window_nz * region.window_ny *
+         batch;
+}
+
+// Gets the offset of the first point of a row of the region in the frame.
+static size_t GetRowOffset(const WindowSize &window, const WindowSize &region,
+                           uint batch, uint iy, uint iz) {
+  size_t y = region.window_start.y + iy;
+  size_t z = region.window_start.z + iz;
+  return ((y * window.window_nz + z) * window.window_nx +
+          region.window_start.x) *
+         batch;
+}
+
+void PackRegion(const float *frame, const WindowSize &window,
+                const WindowSize &region, uint batch, float *packed) {
+  size_t row = (size_t)region.window_nx * batch;
+  int rows = region.window_ny * region.window_nz;
+#pragma omp parallel for schedule(static)
+  for (int r = 0; r < rows; r++) {
+    uint iy = r / region.window_nz;
+    uint iz = r % region.window_nz;
+    memcpy(packed + r * row,
+           frame + GetRowOffset(window, region, batch, iy, iz),
+           row * sizeof(float));
+  }
+}
+
+void UnpackRegion(const float *packed, const WindowSize &window,
+                  const WindowSize &region, uint batch, float *frame) {
+  size_t row = (size_t)region.window_nx * batch;
+  int rows = region.window_ny * region.window_nz;
+#pragma omp parallel for schedule(static)
+  for (int r = 0; r < rows; r++) {
+    uint iy = r / region.window_nz;
+    uint iz = r % region.window_nz;
+    memcpy(frame + GetRowOffset(window, region, batch, iy, iz),
+           packed + r * row, row * sizeof(float));
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef ACOUSTIC2ND_RTM_SNAPSHOT_REGION_H
+#define ACOUSTIC2ND_RTM_SNAPSHOT_REGION_H
+
+#include <skeleton/base/datatypes.h>
+
+#include <cstddef>
+
+/*!
+ * Gets the imaging region of the window of a grid : the points correlated by
+ * the imaging condition that are stacked in the image, leaving out the halos
+ * and the boundary layers of the model.
+ * @return
+ * The region, its start being in points of the window.
+ */
+WindowSize GetImagingRegion(GridBox *grid_box,
+                            ComputationParameters *parameters);
+
+/*!
+ * @return
+ * The number of values of the region, of all the shots of a batch.
+ */
+size_t GetRegionSize(const WindowSize &region, uint batch);
+
+/*!
+ * Copies the points of the region of a frame of the window to the packed
+ * values, row after row. The shots of a batch are interleaved innermost in
+ * both.
+ */
+void PackRegion(const float *frame, const WindowSize &window,
+                const WindowSize &region, uint batch, float *packed);
+
+/*!
+ * Copies the packed values back to the region of a frame of the window, the
+ * points out of it being left as they are.
+ */
+void UnpackRegion(const float *packed, const WindowSize &window,
+                  const WindowSize &region, uint batch, float *frame);
+
+#endif // ACOUSTIC2ND_RTM_SNAPSHOT_REGION_H
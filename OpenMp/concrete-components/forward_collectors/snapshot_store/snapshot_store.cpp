@@ -0,0 +1,528 @@
+#include "snapshot_store.h"
+
+#include <concrete-components/forward_collectors/file_handler/file_handler.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+// Reallocates a buffer of the store when it is too small, or frees it when it
+// isn't needed, zeroing the new buffers.
+static void *ReserveBuffer(void *buffer, size_t &capacity, size_t bytes,
+                           bool exact, string name) {
+  if (buffer != nullptr && (bytes > capacity || bytes == 0 || exact)) {
+    mem_free(buffer);
+    buffer = nullptr;
+    capacity = 0;
+  }
+  if (buffer == nullptr && bytes > 0) {
+    // Allocated as floats to have the frames aligned as the ones of the grid.
+    buffer = mem_allocate(sizeof(float),
+                          (bytes + sizeof(float) - 1) / sizeof(float), name);
+    if (buffer == nullptr) {
+      cout << "Could not allocate the " << bytes / (1024 * 1024)
+           << " MB of " << name << " within the memory budget" << endl;
+      cout << "Terminating..." << endl;
+      exit(-1);
+    }
+    memset(buffer, 0, bytes);
+    capacity = bytes;
+  }
+  return buffer;
+}
+
+// Accumulates the error of the n decoded values against the reference ones,
+// as AccumulateHalfError does for the 16 bit precisions.
+static void AccumulateError(const float *reference, const float *decoded,
+                            size_t n, double &error_norm,
+                            double &reference_norm, float &max_error) {
+  double error_sum = 0;
+  double reference_sum = 0;
+  float error_max = max_error;
+#pragma omp parallel for schedule(static)                                      \
+    reduction(+ : error_sum, reference_sum) reduction(max : error_max)
+  for (size_t i = 0; i < n; i++) {
+    float error = fabs(decoded[i] - reference[i]);
+    error_sum += (double)error * error;
+    reference_sum += (double)reference[i] * reference[i];
+    error_max = max(error_max, error);
+  }
+  error_norm += error_sum;
+  reference_norm += reference_sum;
+  max_error = error_max;
+}
+
+// The bytes a buffer of the store holds once reserved.
+static size_t GetKeptBytes(size_t bytes, size_t capacity) {
+  if (bytes == 0) {
+    return 0;
+  }
+  return max(bytes, capacity);
+}
+
+const char *GetSnapshotCodecName(SNAPSHOT_CODEC codec) {
+  switch (codec) {
+  case SNAPSHOT_ZFP:
+    return "zfp";
+  case SNAPSHOT_BFP:
+    return "bfp";
+  default:
+    return "none";
+  }
+}
+
+SnapshotStore::SnapshotStore(string write_path,
+                             const SnapshotOptions &options)
+    : chunk_io(SPILL_CHUNKS) {
+  this->write_path = write_path;
+  this->memory_budget = options.memory_budget;
+  // Storing all the snapshots in 16 bits takes over the compressed tier.
+  this->precision = options.compressed_tier;
+  if (options.precision != STORAGE_FP32) {
+    this->precision = options.precision;
+  }
+  this->fixed_rate = nullptr;
+  if (options.zfp_rate > 0) {
+    this->fixed_rate = new zfp::FixedRateCodec(options.zfp_rate);
+    this->precision = STORAGE_FP32;
+  }
+  this->packing = this->precision != STORAGE_FP32 || fixed_rate != nullptr;
+  this->spill = options.spill;
+  this->codec = options.codec;
+  this->tolerance = options.tolerance;
+  this->zfp_parallel = options.zfp_parallel;
+  this->zfp_is_relative = options.zfp_is_relative;
+  // Without a memory budget the codec takes all the snapshots, the budget
+  // keeping the ones it holds raw.
+  this->compress_all = options.precision != STORAGE_FP32 ||
+                       options.zfp_rate > 0 ||
+                       (codec != SNAPSHOT_RAW && memory_budget == 0);
+  this->precision_report = options.precision_report;
+  this->window = {{0, 0, 0}, 0, 0, 0};
+  this->snapshot_size = 0;
+  this->snapshots = 0;
+  this->disk_end = 0;
+  this->raw_start = 0;
+  this->chunk_nt = 0;
+  this->disk_chunks = 0;
+  this->packed_bytes = 0;
+  this->raw_frames = nullptr;
+  this->compressed_frames = nullptr;
+  this->working_frames = nullptr;
+  this->disk_ring = nullptr;
+  this->raw_capacity = 0;
+  this->compressed_capacity = 0;
+  this->working_capacity = 0;
+  this->ring_capacity = 0;
+  for (int i = 0; i < SPILL_CHUNKS; i++) {
+    resident_chunk[i] = -1;
+  }
+}
+
+SnapshotStore::~SnapshotStore() {
+  chunk_io.WaitAll();
+  ReserveBuffer(raw_frames, raw_capacity, 0, true, "");
+  ReserveBuffer(compressed_frames, compressed_capacity, 0, true, "");
+  ReserveBuffer(working_frames, working_capacity, 0, true, "");
+  ReserveBuffer(disk_ring, ring_capacity, 0, true, "");
+  delete fixed_rate;
+}
+
+void SnapshotStore::Reset(uint snapshots, size_t snapshot_size,
+                          const WindowSize &window, bool clear) {
+  // The chunks of the previous shot may still be written.
+  chunk_io.WaitAll();
+  uint previous_disk_end = this->disk_end;
+  uint previous_raw_start = this->raw_start;
+  uint previous_snapshots = this->snapshots;
+  this->snapshots = snapshots;
+  this->snapshot_size = snapshot_size;
+  this->window = window;
+  packed_bytes = snapshot_size * sizeof(uint16_t);
+  if (fixed_rate != nullptr) {
+    packed_bytes = fixed_rate->GetSize(window.window_nx, window.window_ny,
+                                       GetRowCount());
+  }
+  size_t budget =
+      GetStoreBudget(memory_budget, raw_capacity + compressed_capacity +
+                                        working_capacity + ring_capacity);
+  PlaceTiers(budget);
+  if (codec != SNAPSHOT_RAW && disk_end > 0) {
+    archive.Open(write_path + "/forward_pressure.zfp");
+  }
+  size_t frame_bytes = snapshot_size * sizeof(float);
+  size_t raw_bytes = (snapshots - raw_start) * frame_bytes;
+  size_t compressed_bytes = (size_t)(raw_start - disk_end) * packed_bytes;
+  size_t working_bytes = 0;
+  if (packing && raw_start > 0) {
+    working_bytes = 4 * frame_bytes;
+  }
+  size_t ring_bytes = 0;
+  if (disk_end > 0) {
+    ring_bytes = SPILL_CHUNKS * chunk_nt * GetDiskSnapshotBytes();
+  }
+  // The buffers kept from the previous shots are reallocated to their sizes
+  // when keeping them would go over the budget.
+  size_t kept_bytes = GetKeptBytes(raw_bytes, raw_capacity) +
+                      GetKeptBytes(compressed_bytes, compressed_capacity) +
+                      GetKeptBytes(working_bytes, working_capacity) +
+                      GetKeptBytes(ring_bytes, ring_capacity);
+  bool exact = kept_bytes > budget;
+  if (clear) {
+    // Zeroing the frames computed in place is done by reallocating them.
+    exact = true;
+  }
+  raw_frames = (float *)ReserveBuffer(raw_frames, raw_capacity, raw_bytes,
+                                      exact, "raw_snapshots");
+  compressed_frames = (char *)ReserveBuffer(
+      compressed_frames, compressed_capacity, compressed_bytes, exact,
+      "compressed_snapshots");
+  working_frames = (float *)ReserveBuffer(working_frames, working_capacity,
+                                          working_bytes, exact,
+                                          "working_snapshots");
+  disk_ring = ReserveBuffer(disk_ring, ring_capacity, ring_bytes, exact,
+                            "spilled_snapshots");
+  if (scales.size() < snapshots) {
+    scales.resize(snapshots);
+  }
+  // The first chunk is filled by the forward propagation from the start.
+  for (int i = 0; i < SPILL_CHUNKS; i++) {
+    resident_chunk[i] = -1;
+  }
+  report_error = 0;
+  report_reference = 0;
+  report_max_error = 0;
+  if (raw_start > 0 &&
+      (disk_end != previous_disk_end || raw_start != previous_raw_start ||
+       snapshots != previous_snapshots)) {
+    cout << "Forward wavefields : " << snapshots - raw_start
+         << " raw in memory, ";
+    if (packing) {
+      cout << raw_start - disk_end << " in " << GetPackingName()
+           << " in memory, ";
+    }
+    cout << disk_end << " on the disk";
+    if (disk_end > 0) {
+      cout << " in chunks of " << chunk_nt;
+    }
+    cout << " (memory budget of " << budget / (1024 * 1024) << " MB)" << endl;
+  }
+}
+
+void SnapshotStore::PlaceTiers(size_t budget) {
+  size_t frame_bytes = snapshot_size * sizeof(float);
+  uint raw = 0;
+  uint compressed = 0;
+  chunk_nt = 0;
+  if (!compress_all && snapshots * frame_bytes <= budget) {
+    raw = snapshots;
+  } else {
+    // The frames the compressed snapshots are computed in and unpacked to.
+    size_t working = packing ? 4 * frame_bytes : 0;
+    if (!spill && (!packing || working + snapshots * packed_bytes > budget)) {
+      size_t needed = working + snapshots * packed_bytes;
+      if (!packing) {
+        needed = snapshots * frame_bytes;
+      }
+      cout << "The forward wavefields need " << needed / (1024 * 1024)
+           << " MB of memory, over the memory budget of "
+           << budget / (1024 * 1024) << " MB" << endl;
+      cout << "Terminating..." << endl;
+      exit(-1);
+    }
+    if (packing && working + snapshots * packed_bytes <= budget) {
+      compressed = snapshots;
+      if (!compress_all) {
+        raw = (budget - working - snapshots * packed_bytes) /
+              (frame_bytes - packed_bytes);
+        compressed -= raw;
+      }
+    } else {
+      // An eighth of the budget goes to the chunks of the disk tier in
+      // memory, the frames of a time-step and the ones around it are in at
+      // most two chunks while another one is written.
+      size_t disk_bytes = GetDiskSnapshotBytes();
+      chunk_nt = max((size_t)2, budget / (8 * SPILL_CHUNKS * disk_bytes));
+      if (compress_all && !packing) {
+        chunk_nt = min(chunk_nt, (uint)ENCODED_CHUNK_NT);
+      }
+      size_t ring = SPILL_CHUNKS * chunk_nt * disk_bytes;
+      if (ring + working > budget) {
+        cout << "The memory budget of " << budget / (1024 * 1024)
+             << " MB can't hold the chunks of the forward wavefields" << endl;
+        cout << "Terminating..." << endl;
+        exit(-1);
+      }
+      size_t left = budget - ring - working;
+      if (packing) {
+        compressed = min((size_t)snapshots, left / packed_bytes);
+      } else if (!compress_all) {
+        raw = min((size_t)snapshots, left / frame_bytes);
+      }
+    }
+  }
+  raw_start = snapshots - raw;
+  disk_end = raw_start - compressed;
+  if (disk_end == 0) {
+    chunk_nt = 0;
+    disk_chunks = 0;
+  } else {
+    disk_chunks = (disk_end + chunk_nt - 1) / chunk_nt;
+  }
+}
+
+bool SnapshotStore::IsPacked(uint time_step) {
+  if (time_step >= raw_start) {
+    return false;
+  }
+  return time_step >= disk_end || packing;
+}
+
+size_t SnapshotStore::GetDiskSnapshotBytes() {
+  if (packing) {
+    return packed_bytes;
+  }
+  return snapshot_size * sizeof(float);
+}
+
+// The codec type of the compression library the archive is given.
+unsigned int SnapshotStore::GetCodecType() {
+  if (codec == SNAPSHOT_BFP) {
+    return BFP_CODEC;
+  }
+  // The zfp codec types 1 and 2 are serial and parallel.
+  return zfp_parallel ? 2 : 1;
+}
+
+char *SnapshotStore::GetRingSlot(uint time_step) {
+  return (char *)disk_ring +
+         (time_step % (SPILL_CHUNKS * chunk_nt)) * GetDiskSnapshotBytes();
+}
+
+float *SnapshotStore::GetFrame(uint time_step) {
+  if (time_step >= raw_start) {
+    return raw_frames + (time_step - raw_start) * snapshot_size;
+  }
+  if (IsPacked(time_step)) {
+    return working_frames + (time_step % 3) * snapshot_size;
+  }
+  // The frame starts a chunk, in a buffer whose chunk must have been written.
+  uint chunk = time_step / chunk_nt;
+  uint buffer = chunk % SPILL_CHUNKS;
+  if (resident_chunk[buffer] != (int)chunk) {
+    chunk_io.Wait(buffer);
+    resident_chunk[buffer] = chunk;
+  }
+  return (float *)GetRingSlot(time_step);
+}
+
+void SnapshotStore::Save(uint time_step) {
+  if (time_step >= raw_start) {
+    return;
+  }
+  if (time_step >= disk_end) {
+    Pack(time_step, compressed_frames + (time_step - disk_end) * packed_bytes);
+    return;
+  }
+  uint chunk = time_step / chunk_nt;
+  if (IsPacked(time_step)) {
+    uint buffer = chunk % SPILL_CHUNKS;
+    if (resident_chunk[buffer] != (int)chunk) {
+      chunk_io.Wait(buffer);
+      resident_chunk[buffer] = chunk;
+    }
+    Pack(time_step, GetRingSlot(time_step));
+  }
+  // The chunks left in memory at the end of the forward propagation are the
+  // first ones fetched, so they aren't written, unless all the snapshots go
+  // through the codec.
+  bool encode_all = compress_all && !packing;
+  bool chunk_end = time_step % chunk_nt == chunk_nt - 1 ||
+                   (encode_all && time_step == disk_end - 1);
+  if (chunk_end && (encode_all || chunk + SPILL_CHUNKS < disk_chunks)) {
+    SpillChunk(chunk);
+    if (encode_all) {
+      // Read back from the disk when fetched, as the chunks before it.
+      resident_chunk[chunk % SPILL_CHUNKS] = -1;
+    }
+  }
+}
+
+float *SnapshotStore::Fetch(uint time_step) {
+  if (time_step >= raw_start) {
+    return raw_frames + (time_step - raw_start) * snapshot_size;
+  }
+  float *frame = working_frames + 3 * snapshot_size;
+  const char *packed;
+  if (time_step >= disk_end) {
+    packed = compressed_frames + (time_step - disk_end) * packed_bytes;
+  } else {
+    FetchChunk(time_step / chunk_nt);
+    if (!IsPacked(time_step)) {
+      return (float *)GetRingSlot(time_step);
+    }
+    packed = GetRingSlot(time_step);
+  }
+  Unpack(time_step, packed, frame);
+  return frame;
+}
+
+int SnapshotStore::GetRowCount() {
+  // The rows of all the shots of a batch follow each other.
+  return snapshot_size / ((size_t)window.window_nx * window.window_ny);
+}
+
+void SnapshotStore::Pack(uint time_step, char *slot) {
+  float *frame = working_frames + (time_step % 3) * snapshot_size;
+  if (fixed_rate != nullptr) {
+    fixed_rate->Compress(frame, window.window_nx, window.window_ny,
+                         GetRowCount(), slot);
+    if (precision_report) {
+      // The snapshot is decoded to the frame of the fetches, unused during
+      // the forward propagation.
+      float *decoded = working_frames + 3 * snapshot_size;
+      Unpack(time_step, slot, decoded);
+      AccumulateError(frame, decoded, snapshot_size, report_error,
+                      report_reference, report_max_error);
+    }
+    return;
+  }
+  float scale = 1.0f;
+  if (precision == STORAGE_FP16) {
+    scale = GetStorageScale(precision, GetMaxAbs(frame, snapshot_size));
+  }
+  scales[time_step] = scale;
+  PackHalf(frame, (uint16_t *)slot, snapshot_size, precision, scale);
+  if (precision_report) {
+    AccumulateHalfError(frame, (const uint16_t *)slot, snapshot_size,
+                        precision, scale, report_error, report_reference,
+                        report_max_error);
+  }
+}
+
+void SnapshotStore::Unpack(uint time_step, const char *slot, float *frame) {
+  if (fixed_rate != nullptr) {
+    fixed_rate->Decompress(frame, window.window_nx, window.window_ny,
+                           GetRowCount(), slot);
+    return;
+  }
+  UnpackHalf((const uint16_t *)slot, frame, snapshot_size, precision,
+             scales[time_step]);
+}
+
+string SnapshotStore::GetPackingName() {
+  if (fixed_rate != nullptr) {
+    return "zfp fixed rate";
+  }
+  return GetStoragePrecisionName(precision);
+}
+
+void SnapshotStore::Report() {
+  uint packed = packing ? raw_start : 0;
+  if (!precision_report || packed == 0) {
+    return;
+  }
+  double relative_error = 0;
+  if (report_reference > 0) {
+    relative_error = sqrt(report_error / report_reference);
+  }
+  cout << endl
+       << "Forward wavefields stored in " << GetPackingName() << " ("
+       << packed << " of " << snapshots << " frames)" << endl;
+  cout << "\tRelative L2 error of the stored wavefields : " << relative_error
+       << endl;
+  cout << "\tMaximum absolute error of the stored wavefields : "
+       << report_max_error << endl;
+}
+
+void SnapshotStore::SpillChunk(uint chunk) {
+  uint buffer = chunk % SPILL_CHUNKS;
+  string path = this->write_path + "/temp_" + to_string(chunk);
+  size_t size = chunk_nt * snapshot_size;
+  char *data = GetRingSlot(chunk * chunk_nt);
+  if (packing) {
+    uint16_t *values = (uint16_t *)data;
+    size = chunk_nt * packed_bytes / sizeof(uint16_t);
+    chunk_io.Start(buffer, [path, values, size]() {
+      bin_file_save(path.c_str(), values, size);
+    });
+  } else if (codec != SNAPSHOT_RAW) {
+    float *values = (float *)data;
+    WindowSize window = this->window;
+    // The last chunk may end before the disk tier does.
+    uint first = chunk * chunk_nt;
+    uint frames = min(chunk_nt, disk_end - first);
+    size_t frame_size = snapshot_size;
+    unsigned int type = GetCodecType();
+    chunk_io.Start(buffer, [this, values, window, first, frames, frame_size,
+                          type]() {
+      for (uint it = 0; it < frames; it++) {
+        this->archive.Append(values + it * frame_size, window.window_nx,
+                             window.window_ny, window.window_nz,
+                             (double)this->tolerance, type,
+                             first + it, this->zfp_is_relative);
+      }
+    });
+  } else {
+    float *values = (float *)data;
+    chunk_io.Start(buffer, [path, values, size]() {
+      bin_file_save(path.c_str(), values, size);
+    });
+  }
+}
+
+void SnapshotStore::LoadChunk(uint chunk) {
+  uint buffer = chunk % SPILL_CHUNKS;
+  string path = this->write_path + "/temp_" + to_string(chunk);
+  size_t size = chunk_nt * snapshot_size;
+  char *data = GetRingSlot(chunk * chunk_nt);
+  resident_chunk[buffer] = chunk;
+  if (packing) {
+    uint16_t *values = (uint16_t *)data;
+    size = chunk_nt * packed_bytes / sizeof(uint16_t);
+    chunk_io.Start(buffer, [path, values, size]() {
+      bin_file_load(path.c_str(), values, size);
+    });
+  } else if (codec != SNAPSHOT_RAW) {
+    float *values = (float *)data;
+    WindowSize window = this->window;
+    // Only the snapshots of the disk tier were written.
+    uint first = chunk * chunk_nt;
+    uint frames = min(chunk_nt, disk_end - first);
+    size_t frame_size = snapshot_size;
+    unsigned int type = GetCodecType();
+    chunk_io.Start(buffer, [this, values, window, first, frames, frame_size,
+                          type]() {
+      for (uint it = 0; it < frames; it++) {
+        this->archive.Read(values + it * frame_size, window.window_nx,
+                           window.window_ny, window.window_nz,
+                           (double)this->tolerance, type,
+                           first + it, this->zfp_is_relative);
+      }
+    });
+  } else {
+    float *values = (float *)data;
+    chunk_io.Start(buffer, [path, values, size]() {
+      bin_file_load(path.c_str(), values, size);
+    });
+  }
+}
+
+void SnapshotStore::FetchChunk(uint chunk) {
+  uint buffer = chunk % SPILL_CHUNKS;
+  if (resident_chunk[buffer] != (int)chunk) {
+    LoadChunk(chunk);
+  }
+  chunk_io.Wait(buffer);
+  // The chunks before it are read in the other buffers, whose chunks were
+  // already fetched, while this one is used.
+  for (uint i = 1; i < SPILL_CHUNKS && i <= chunk; i++) {
+    uint previous = chunk - i;
+    if (resident_chunk[previous % SPILL_CHUNKS] != (int)previous) {
+      LoadChunk(previous);
+    }
+  }
+}
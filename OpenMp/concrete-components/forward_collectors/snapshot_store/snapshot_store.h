@@ -0,0 +1,198 @@
+#ifndef ACOUSTIC2ND_RTM_SNAPSHOT_STORE_H
+#define ACOUSTIC2ND_RTM_SNAPSHOT_STORE_H
+
+#include <archive.h>
+#include <fixed_rate.h>
+#include <concrete-components/forward_collectors/chunk_io/chunk_io.h>
+#include <concrete-components/forward_collectors/half_precision/half_precision.h>
+#include <skeleton/base/datatypes.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The chunks of the snapshots on the disk kept in memory, so that a chunk is
+// written to or read from the disk in the background while the others are
+// used.
+#define SPILL_CHUNKS 2
+// The time-steps of a chunk when all the snapshots go through zfp, the chunks
+// in memory being raw.
+#define ENCODED_CHUNK_NT 16
+
+/*!
+ * The codec the snapshots of the disk tier go through : none keeps them raw,
+ * zfp and bfp compress them to a single archive file.
+ */
+enum SNAPSHOT_CODEC { SNAPSHOT_RAW, SNAPSHOT_ZFP, SNAPSHOT_BFP };
+
+/*!
+ * Gets a printable name of the snapshot codec.
+ */
+const char *GetSnapshotCodecName(SNAPSHOT_CODEC codec);
+
+/*!
+ * The configuration of the snapshots of the forward wavefields, as given to
+ * the two propagation collectors.
+ */
+struct SnapshotOptions {
+  // The bytes of memory the snapshots may use, 0 for the memory available
+  // when a shot starts.
+  size_t memory_budget = 0;
+  // The 16 bit precision all the snapshots are compressed to, fp32 for none.
+  STORAGE_PRECISION precision = STORAGE_FP32;
+  // The 16 bit precision of the snapshots the memory can't hold raw, before
+  // going to the disk, fp32 to send them to the disk directly.
+  STORAGE_PRECISION compressed_tier = STORAGE_FP32;
+  // The bits per value of all the snapshots, compressed in memory by the fixed
+  // rate mode of zfp in place of the 16 bit precisions, 0 for none.
+  double zfp_rate = 0;
+  // The codec of the snapshots on the disk. Without a memory budget all the
+  // snapshots go through it, the budget keeping the ones it holds raw.
+  SNAPSHOT_CODEC codec = SNAPSHOT_RAW;
+  // The error tolerance of the codec, absolute unless zfp_is_relative.
+  float tolerance = 0.01f;
+  // Whether zfp compresses a snapshot with all the threads.
+  bool zfp_parallel = true;
+  bool zfp_is_relative = false;
+  // Whether to print the error of the compressed snapshots of each shot.
+  bool precision_report = false;
+  // Whether the snapshots the memory budget can't hold go to the disk, the
+  // migration stops when they don't fit otherwise.
+  bool spill = true;
+  // Whether only the imaging region of the forward wavefields is stored,
+  // without the halos and the boundary layers.
+  bool interior = false;
+};
+
+/*!
+ * Stores the snapshots of the forward wavefields of a shot within a memory
+ * budget. The backward propagation reads them from the last time-step to the
+ * first, so they are placed in three tiers by time-step : the last ones raw in
+ * memory, the ones before them compressed in memory and the first ones on the
+ * disk, written and read back in chunks in the background.
+ *
+ * The snapshots of the raw tier and the uncompressed disk tier are computed in
+ * place, the others in working frames packed once they are complete, in 16
+ * bits or by the fixed rate mode of zfp.
+ */
+class SnapshotStore {
+private:
+  std::string write_path;
+  // The bytes of memory the snapshots may use, 0 for the available memory.
+  size_t memory_budget;
+  // The 16 bit precision of the compressed snapshots, fp32 for none.
+  STORAGE_PRECISION precision;
+  // The codec of the compressed snapshots when they go through the fixed rate
+  // mode of zfp instead of the 16 bit precision, nullptr otherwise.
+  zfp::FixedRateCodec *fixed_rate;
+  // Whether the snapshots are compressed, by either of them.
+  bool packing;
+  // Whether the snapshots the memory can't hold may go to the disk.
+  bool spill;
+  // Whether all the snapshots are compressed, not only the ones the memory
+  // can't hold raw, the ones going through the codec all being on the disk.
+  bool compress_all;
+  bool precision_report;
+  // The codec of the snapshots on the disk, with its parameters.
+  SNAPSHOT_CODEC codec;
+  float tolerance;
+  bool zfp_parallel;
+  bool zfp_is_relative;
+  // The single file the snapshots compressed by the codec are appended to.
+  zfp::WavefieldArchive archive;
+
+  WindowSize window;
+  size_t snapshot_size;
+  uint snapshots;
+  // The tiers by time-step : [0, disk_end) on the disk, [disk_end, raw_start)
+  // compressed in memory and [raw_start, snapshots) raw in memory.
+  uint disk_end;
+  uint raw_start;
+  // The time-steps of a chunk of the disk tier, and the chunks of that tier.
+  uint chunk_nt;
+  uint disk_chunks;
+  // The bytes of a compressed snapshot.
+  size_t packed_bytes;
+
+  float *raw_frames;
+  char *compressed_frames;
+  // The frames the compressed snapshots are computed in, followed by the one
+  // they are unpacked to.
+  float *working_frames;
+  // The chunks of the disk tier held in memory, packed if compressed.
+  void *disk_ring;
+  size_t raw_capacity;
+  size_t compressed_capacity;
+  size_t working_capacity;
+  size_t ring_capacity;
+  std::vector<float> scales;
+
+  double report_error;
+  double report_reference;
+  float report_max_error;
+
+  // The background reads and writes of the chunks.
+  ChunkIO chunk_io;
+  // The chunk held by each buffer of the ring, -1 if none.
+  int resident_chunk[SPILL_CHUNKS];
+
+  bool IsPacked(uint time_step);
+  size_t GetDiskSnapshotBytes();
+  unsigned int GetCodecType();
+  void PlaceTiers(size_t budget);
+  char *GetRingSlot(uint time_step);
+  void Pack(uint time_step, char *slot);
+  void Unpack(uint time_step, const char *slot, float *frame);
+  int GetRowCount();
+  std::string GetPackingName();
+  void SpillChunk(uint chunk);
+  void LoadChunk(uint chunk);
+  void FetchChunk(uint chunk);
+
+public:
+  /*!
+   * @param write_path
+   * The directory of the snapshots spilled to the disk.
+   * @param options
+   * The memory budget, the compression and the codec of the snapshots.
+   */
+  SnapshotStore(std::string write_path, const SnapshotOptions &options);
+  /*!
+   * Places the snapshots of a shot in the tiers, waiting for the disk
+   * operations of the previous shot.
+   * @param snapshots
+   * The number of snapshots of the shot, saved by increasing time-step.
+   * @param snapshot_size
+   * The number of values of a snapshot.
+   * @param window
+   * The window of the snapshots.
+   * @param clear
+   * Whether the frames computed in place must be zeroed, their halos keeping
+   * the values of a previous shot otherwise.
+   */
+  void Reset(uint snapshots, size_t snapshot_size, const WindowSize &window,
+             bool clear);
+  /*!
+   * @return
+   * The frame the snapshot of the time-step is computed in, until it is
+   * saved. The frames of the three time-steps up to it are valid together.
+   */
+  float *GetFrame(uint time_step);
+  /*!
+   * Stores the snapshot of the time-step, computed in its frame.
+   */
+  void Save(uint time_step);
+  /*!
+   * @return
+   * The snapshot of the time-step, the snapshots being fetched from the last
+   * time-step backwards. It is valid until the next fetch.
+   */
+  float *Fetch(uint time_step);
+  /*!
+   * Prints the error of the compressed snapshots of the shot, when asked for.
+   */
+  void Report();
+  ~SnapshotStore();
+};
+
+#endif // ACOUSTIC2ND_RTM_SNAPSHOT_STORE_H
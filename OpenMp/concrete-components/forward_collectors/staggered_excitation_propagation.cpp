@@ -0,0 +1,152 @@
+#include "staggered_excitation_propagation.h"
+
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_region.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+StaggeredExcitationPropagation::StaggeredExcitationPropagation(
+    bool normalized) {
+  this->internal_grid = (ExcitationGrid *)mem_allocate(
+      sizeof(ExcitationGrid), 1, "forward_collector_gridbox");
+  this->internal_grid->pressure_current = nullptr;
+  this->map = new ExcitationMap();
+  this->internal_grid->map = this->map;
+  this->internal_grid->time_step = 0;
+  this->normalized = normalized;
+  time_counter = 0;
+  imaging_step = 1;
+  reported = false;
+  temp_curr = nullptr;
+  temp_next = nullptr;
+  staged_frame = nullptr;
+  staged_capacity = 0;
+  staged_time_step = -1;
+}
+
+// The frame fetched at a backward time-step is its own one.
+bool StaggeredExcitationPropagation::IsImaged(uint frame) {
+  return frame % imaging_step == 0;
+}
+
+void StaggeredExcitationPropagation::AddStagedFrame() {
+  if (staged_time_step >= 0) {
+    map->Add(staged_frame, staged_time_step);
+    staged_time_step = -1;
+  }
+}
+
+void StaggeredExcitationPropagation::ClearFrames() {
+  main_grid->pressure_current = temp_curr;
+  main_grid->pressure_next = temp_next;
+  memset(temp_curr, 0.0f, pressure_size * sizeof(float));
+  memset(temp_next, 0.0f, pressure_size * sizeof(float));
+  memset(main_grid->particle_velocity_x_current, 0.0f,
+         pressure_size * sizeof(float));
+  memset(main_grid->particle_velocity_z_current, 0.0f,
+         pressure_size * sizeof(float));
+  if (main_grid->window_size.window_ny > 1) {
+    memset(main_grid->particle_velocity_y_current, 0.0f,
+           pressure_size * sizeof(float));
+  }
+}
+
+void StaggeredExcitationPropagation::FetchForward(void) {
+  // The correlation kernel samples the backward frame at the points excited
+  // by the forward one.
+  internal_grid->time_step = time_counter;
+  time_counter--;
+}
+
+void StaggeredExcitationPropagation::ResetGrid(bool forward_run) {
+  if (forward_run) {
+    pressure_size = main_grid->window_size.window_nx *
+                    main_grid->window_size.window_ny *
+                    main_grid->window_size.window_nz;
+    time_counter = 0;
+    imaging_step = parameters->imaging_step;
+    WindowSize region = GetImagingRegion(main_grid, parameters);
+    map->Reset(main_grid->window_size, region, 1);
+    if (!reported) {
+      cout << "Forward excitation times : " << map->GetBytes() / (1024 * 1024)
+           << " MB" << endl;
+      reported = true;
+    }
+    if (pressure_size > staged_capacity) {
+      if (staged_frame != nullptr) {
+        mem_free(staged_frame);
+      }
+      staged_frame = (float *)mem_allocate(sizeof(float), pressure_size,
+                                           "staged_frame");
+      staged_capacity = pressure_size;
+    }
+    staged_time_step = -1;
+    temp_curr = main_grid->pressure_current;
+    temp_next = main_grid->pressure_next;
+    // The frames hold the backward propagation of the previous shot.
+    ClearFrames();
+    internal_grid->nt = main_grid->nt;
+    internal_grid->dt = main_grid->dt;
+    memcpy(&internal_grid->grid_size, &main_grid->grid_size,
+           sizeof(main_grid->grid_size));
+    memcpy(&internal_grid->window_size, &main_grid->window_size,
+           sizeof(main_grid->window_size));
+    memcpy(&internal_grid->cell_dimensions, &main_grid->cell_dimensions,
+           sizeof(main_grid->cell_dimensions));
+    internal_grid->velocity = main_grid->velocity;
+  } else {
+    // The last frame of the forward propagation isn't followed by a
+    // SaveForward call, it is the first one fetched.
+    AddStagedFrame();
+    if (IsImaged(time_counter)) {
+      map->Add(main_grid->pressure_current, time_counter);
+    }
+    map->Finish(main_grid->nt + 1, normalized);
+    ClearFrames();
+  }
+}
+
+void StaggeredExcitationPropagation::SaveForward() {
+  time_counter++;
+  AddStagedFrame();
+  main_grid->pressure_current = temp_curr;
+  main_grid->pressure_next = temp_next;
+  // The frame of the grid is the one of the previous time-step, its source
+  // is injected after this call.
+  uint frame = time_counter - 1;
+  if (IsImaged(frame)) {
+    memcpy(staged_frame, temp_curr, pressure_size * sizeof(float));
+    main_grid->pressure_current = staged_frame;
+    staged_time_step = frame;
+  }
+}
+
+StaggeredExcitationPropagation::~StaggeredExcitationPropagation() {
+  delete map;
+  if (staged_frame != nullptr) {
+    mem_free(staged_frame);
+  }
+  mem_free((void *)internal_grid);
+}
+
+void StaggeredExcitationPropagation::SetComputationParameters(
+    ComputationParameters *parameters) {
+  this->parameters = parameters;
+}
+
+void StaggeredExcitationPropagation::SetGridBox(GridBox *grid_box) {
+  this->main_grid = (StaggeredGrid *)(grid_box);
+  if (this->main_grid == nullptr) {
+    std::cout << "Not a compatible gridbox : "
+                 "expected StaggeredGrid"
+              << std::endl;
+    exit(-1);
+  }
+}
+
+GridBox *StaggeredExcitationPropagation::GetForwardGrid() {
+  return internal_grid;
+}
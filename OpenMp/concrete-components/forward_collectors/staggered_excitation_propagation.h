@@ -0,0 +1,49 @@
+#ifndef ACOUSTIC2ND_RTM_STAGGERED_EXCITATION_PROPAGATION_H
+#define ACOUSTIC2ND_RTM_STAGGERED_EXCITATION_PROPAGATION_H
+
+#include <concrete-components/data_units/staggered_grid.h>
+#include <concrete-components/forward_collectors/excitation_time/excitation_map.h>
+#include <skeleton/components/forward_collector.h>
+
+/*!
+ * The excitation time forward collector of the staggered grid, see
+ * ExcitationPropagation.
+ */
+class StaggeredExcitationPropagation : public ForwardCollector {
+private:
+  StaggeredGrid *main_grid;
+  ExcitationGrid *internal_grid;
+  ComputationParameters *parameters;
+  ExcitationMap *map;
+  // Whether the image is normalized by the excitation amplitudes.
+  bool normalized;
+  uint pressure_size;
+  unsigned int time_counter;
+  // The time-steps between the tracked frames.
+  uint imaging_step;
+  bool reported;
+  float *temp_curr;
+  float *temp_next;
+  // The frame of the grid is updated in place, so an imaged frame is copied
+  // to the staged frame the step is computed out of, to be tracked once its
+  // source is injected.
+  float *staged_frame;
+  uint staged_capacity;
+  int staged_time_step;
+
+  bool IsImaged(uint frame);
+  void AddStagedFrame();
+  void ClearFrames();
+
+public:
+  explicit StaggeredExcitationPropagation(bool normalized = false);
+  void FetchForward(void) override;
+  void SaveForward() override;
+  void ResetGrid(bool forward_run) override;
+  void SetComputationParameters(ComputationParameters *parameters) override;
+  void SetGridBox(GridBox *grid_box) override;
+  GridBox *GetForwardGrid() override;
+  ~StaggeredExcitationPropagation() override;
+};
+
+#endif // ACOUSTIC2ND_RTM_STAGGERED_EXCITATION_PROPAGATION_H
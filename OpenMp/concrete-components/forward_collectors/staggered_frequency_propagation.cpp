@@ -0,0 +1,159 @@
+#include "staggered_frequency_propagation.h"
+
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_region.h>
+#include <skeleton/helpers/memory_allocation/memory_allocator.h>
+
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+StaggeredFrequencyPropagation::StaggeredFrequencyPropagation(
+    uint frequency_count, float max_frequency) {
+  this->internal_grid = (FrequencyGrid *)mem_allocate(
+      sizeof(FrequencyGrid), 1, "forward_collector_gridbox");
+  this->internal_grid->pressure_current = nullptr;
+  this->slices = new FrequencySlices();
+  this->internal_grid->slices = this->slices;
+  this->internal_grid->time_step = 0;
+  this->frequency_count = frequency_count;
+  this->max_frequency = max_frequency;
+  time_counter = 0;
+  imaging_step = 1;
+  reported = false;
+  temp_curr = nullptr;
+  temp_next = nullptr;
+  staged_frame = nullptr;
+  staged_capacity = 0;
+  staged_time_step = -1;
+}
+
+// The frame fetched at a backward time-step is its own one.
+bool StaggeredFrequencyPropagation::IsImaged(uint frame) {
+  return frame % imaging_step == 0;
+}
+
+void StaggeredFrequencyPropagation::AddStagedFrame() {
+  if (staged_time_step >= 0) {
+    slices->Add(staged_frame, staged_time_step);
+    staged_time_step = -1;
+  }
+}
+
+void StaggeredFrequencyPropagation::ClearFrames() {
+  main_grid->pressure_current = temp_curr;
+  main_grid->pressure_next = temp_next;
+  memset(temp_curr, 0.0f, pressure_size * sizeof(float));
+  memset(temp_next, 0.0f, pressure_size * sizeof(float));
+  memset(main_grid->particle_velocity_x_current, 0.0f,
+         pressure_size * sizeof(float));
+  memset(main_grid->particle_velocity_z_current, 0.0f,
+         pressure_size * sizeof(float));
+  if (main_grid->window_size.window_ny > 1) {
+    memset(main_grid->particle_velocity_y_current, 0.0f,
+           pressure_size * sizeof(float));
+  }
+}
+
+void StaggeredFrequencyPropagation::FetchForward(void) {
+  // The correlation kernel accumulates the backward frame with the phase of
+  // the forward one.
+  internal_grid->time_step = time_counter;
+  time_counter--;
+}
+
+void StaggeredFrequencyPropagation::ResetGrid(bool forward_run) {
+  if (forward_run) {
+    pressure_size = main_grid->window_size.window_nx *
+                    main_grid->window_size.window_ny *
+                    main_grid->window_size.window_nz;
+    time_counter = 0;
+    imaging_step = parameters->imaging_step;
+    uint count = frequency_count;
+    float frequency_step = GetFrequencyStep(
+        count, max_frequency, parameters->source_frequency, main_grid->dt,
+        main_grid->nt, imaging_step);
+    WindowSize region = GetImagingRegion(main_grid, parameters);
+    slices->Reset(main_grid->window_size, region, 1, count, frequency_step,
+                  main_grid->dt);
+    if (!reported) {
+      cout << "Forward frequency slices : " << count
+           << " frequencies every " << frequency_step << " Hz in "
+           << slices->GetBytes() / (1024 * 1024) << " MB" << endl;
+      reported = true;
+    }
+    if (pressure_size > staged_capacity) {
+      if (staged_frame != nullptr) {
+        mem_free(staged_frame);
+      }
+      staged_frame = (float *)mem_allocate(sizeof(float), pressure_size,
+                                           "staged_frame");
+      staged_capacity = pressure_size;
+    }
+    staged_time_step = -1;
+    temp_curr = main_grid->pressure_current;
+    temp_next = main_grid->pressure_next;
+    // The frames hold the backward propagation of the previous shot.
+    ClearFrames();
+    internal_grid->nt = main_grid->nt;
+    internal_grid->dt = main_grid->dt;
+    memcpy(&internal_grid->grid_size, &main_grid->grid_size,
+           sizeof(main_grid->grid_size));
+    memcpy(&internal_grid->window_size, &main_grid->window_size,
+           sizeof(main_grid->window_size));
+    memcpy(&internal_grid->cell_dimensions, &main_grid->cell_dimensions,
+           sizeof(main_grid->cell_dimensions));
+    internal_grid->velocity = main_grid->velocity;
+  } else {
+    // The last frame of the forward propagation isn't followed by a
+    // SaveForward call, it is the first one fetched.
+    AddStagedFrame();
+    if (IsImaged(time_counter)) {
+      slices->Add(main_grid->pressure_current, time_counter);
+    }
+    slices->Flush();
+    ClearFrames();
+  }
+}
+
+void StaggeredFrequencyPropagation::SaveForward() {
+  time_counter++;
+  AddStagedFrame();
+  main_grid->pressure_current = temp_curr;
+  main_grid->pressure_next = temp_next;
+  // The frame of the grid is the one of the previous time-step, its source
+  // is injected after this call.
+  uint frame = time_counter - 1;
+  if (IsImaged(frame)) {
+    memcpy(staged_frame, temp_curr, pressure_size * sizeof(float));
+    main_grid->pressure_current = staged_frame;
+    staged_time_step = frame;
+  }
+}
+
+StaggeredFrequencyPropagation::~StaggeredFrequencyPropagation() {
+  delete slices;
+  if (staged_frame != nullptr) {
+    mem_free(staged_frame);
+  }
+  mem_free((void *)internal_grid);
+}
+
+void StaggeredFrequencyPropagation::SetComputationParameters(
+    ComputationParameters *parameters) {
+  this->parameters = parameters;
+}
+
+void StaggeredFrequencyPropagation::SetGridBox(GridBox *grid_box) {
+  this->main_grid = (StaggeredGrid *)(grid_box);
+  if (this->main_grid == nullptr) {
+    std::cout << "Not a compatible gridbox : "
+                 "expected StaggeredGrid"
+              << std::endl;
+    exit(-1);
+  }
+}
+
+GridBox *StaggeredFrequencyPropagation::GetForwardGrid() {
+  return internal_grid;
+}
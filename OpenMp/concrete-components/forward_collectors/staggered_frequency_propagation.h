@@ -0,0 +1,51 @@
+#ifndef ACOUSTIC2ND_RTM_STAGGERED_FREQUENCY_PROPAGATION_H
+#define ACOUSTIC2ND_RTM_STAGGERED_FREQUENCY_PROPAGATION_H
+
+#include <concrete-components/data_units/staggered_grid.h>
+#include <concrete-components/forward_collectors/frequency_domain/frequency_slices.h>
+#include <skeleton/components/forward_collector.h>
+
+/*!
+ * The frequency domain forward collector of the staggered grid, see
+ * FrequencyPropagation.
+ */
+class StaggeredFrequencyPropagation : public ForwardCollector {
+private:
+  StaggeredGrid *main_grid;
+  FrequencyGrid *internal_grid;
+  ComputationParameters *parameters;
+  FrequencySlices *slices;
+  // The number of frequencies, 0 to set it from the duration of the shot.
+  uint frequency_count;
+  // The highest frequency in Hz, 0 for three times the source frequency.
+  float max_frequency;
+  uint pressure_size;
+  unsigned int time_counter;
+  // The time-steps between the accumulated frames.
+  uint imaging_step;
+  bool reported;
+  float *temp_curr;
+  float *temp_next;
+  // The frame of the grid is updated in place, so an imaged frame is copied
+  // to the staged frame the step is computed out of, to be accumulated once
+  // its source is injected.
+  float *staged_frame;
+  uint staged_capacity;
+  int staged_time_step;
+
+  bool IsImaged(uint frame);
+  void AddStagedFrame();
+  void ClearFrames();
+
+public:
+  StaggeredFrequencyPropagation(uint frequency_count, float max_frequency = 0);
+  void FetchForward(void) override;
+  void SaveForward() override;
+  void ResetGrid(bool forward_run) override;
+  void SetComputationParameters(ComputationParameters *parameters) override;
+  void SetGridBox(GridBox *grid_box) override;
+  GridBox *GetForwardGrid() override;
+  ~StaggeredFrequencyPropagation() override;
+};
+
+#endif // ACOUSTIC2ND_RTM_STAGGERED_FREQUENCY_PROPAGATION_H
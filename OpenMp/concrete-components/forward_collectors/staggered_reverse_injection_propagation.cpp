@@ -6,7 +6,8 @@
 #include <iostream>
 
 StaggeredReverseInjectionPropagation::StaggeredReverseInjectionPropagation(
-    ComputationKernel *kernel) {
+    ComputationKernel *kernel, string write_path, size_t memory_budget,
+    BOUNDARY_CODEC codec, double tolerance) {
   this->internal_grid = (StaggeredGrid *)mem_allocate(
       sizeof(StaggeredGrid), 1, "forward_collector_gridbox");
   this->internal_grid->pressure_current = nullptr;
@@ -14,15 +15,19 @@ StaggeredReverseInjectionPropagation::StaggeredReverseInjectionPropagation(
   this->computation_kernel->SetGridBox(internal_grid);
   this->size_of_boundaries = 0;
   this->time_step = 0;
-  this->backup_boundaries = nullptr;
+  this->boundary_store =
+      new BoundaryStore(write_path, memory_budget, codec, tolerance);
 }
 
 void StaggeredReverseInjectionPropagation::FetchForward(void) {
   this->computation_kernel->Step();
   time_step--;
-  RestoreBoundaries(main_grid, internal_grid, parameters, backup_boundaries,
-                    time_step, size_of_boundaries);
+  RestoreBoundaries(main_grid, internal_grid, parameters,
+                    boundary_store->Fetch(time_step), 0, size_of_boundaries);
 }
+
+bool StaggeredReverseInjectionPropagation::IsReconstructed() { return true; }
+
 void StaggeredReverseInjectionPropagation::ResetGrid(bool forward_run) {
   unsigned int const grid_size = main_grid->window_size.window_nx *
                                  main_grid->window_size.window_ny *
@@ -32,36 +37,46 @@ void StaggeredReverseInjectionPropagation::ResetGrid(bool forward_run) {
   uint nz = main_grid->window_size.window_nz;
   uint ny = main_grid->window_size.window_ny;
   if (!forward_run) {
+    boundary_store->Report();
     if (internal_grid->pressure_current == NULL) {
+      // Allocated once for the full grid so that the frames fit the window of
+      // any shot.
+      uint full_nx = main_grid->grid_size.nx;
+      uint full_nz = main_grid->grid_size.nz;
+      uint full_ny = main_grid->grid_size.ny;
+      unsigned int const full_size = full_nx * full_nz * full_ny;
       internal_grid->pressure_current = (float *)mem_allocate(
-          sizeof(float), grid_size, "forward_collector_pressure_curr",
+          sizeof(float), full_size, "forward_collector_pressure_curr",
           parameters->half_length, 16);
       internal_grid->pressure_next = internal_grid->pressure_current;
       internal_grid->particle_velocity_x_current =
-          (float *)mem_allocate(sizeof(float), grid_size,
+          (float *)mem_allocate(sizeof(float), full_size,
                                 "forward_collector_particle_velocity_x_current",
                                 parameters->half_length, 32);
       internal_grid->particle_velocity_z_current =
-          (float *)mem_allocate(sizeof(float), grid_size,
+          (float *)mem_allocate(sizeof(float), full_size,
                                 "forward_collector_particle_velocity_z_current",
                                 parameters->half_length, 48);
       if (ny > 1) {
         internal_grid->particle_velocity_y_current = (float *)mem_allocate(
-            sizeof(float), grid_size,
+            sizeof(float), full_size,
             "forward_collector_particle_velocity_y_current",
             parameters->half_length, 64);
       }
-      this->computation_kernel->FirstTouch(internal_grid->pressure_current, nx,
-                                           nz, ny);
-      this->computation_kernel->FirstTouch(internal_grid->pressure_next, nx, nz,
-                                           ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_current,
+                                           full_nx, full_nz, full_ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_next,
+                                           full_nx, full_nz, full_ny);
       this->computation_kernel->FirstTouch(
-          internal_grid->particle_velocity_x_current, nx, nz, ny);
+          internal_grid->particle_velocity_x_current, full_nx, full_nz,
+          full_ny);
       this->computation_kernel->FirstTouch(
-          internal_grid->particle_velocity_z_current, nx, nz, ny);
+          internal_grid->particle_velocity_z_current, full_nx, full_nz,
+          full_ny);
       if (ny > 1) {
         this->computation_kernel->FirstTouch(
-            internal_grid->particle_velocity_y_current, nx, nz, ny);
+            internal_grid->particle_velocity_y_current, full_nx, full_nz,
+            full_ny);
       }
     }
     memcpy(internal_grid->pressure_current, main_grid->pressure_current,
@@ -91,9 +106,6 @@ void StaggeredReverseInjectionPropagation::ResetGrid(bool forward_run) {
     internal_grid->pressure_next = internal_grid->pressure_current;
     internal_grid->pressure_current = temp;
   } else {
-    if (this->backup_boundaries != nullptr) {
-      mem_free(this->backup_boundaries);
-    }
     time_step = 0;
     uint half_length = this->parameters->half_length;
     uint bound_length = this->parameters->boundary_length;
@@ -110,9 +122,7 @@ void StaggeredReverseInjectionPropagation::ResetGrid(bool forward_run) {
     if (nyi != 1) {
       this->size_of_boundaries += nxi * nzi * half_length * 2;
     }
-    this->backup_boundaries = (float *)mem_allocate(
-        sizeof(float), this->size_of_boundaries * (main_grid->nt + 1),
-        "boundary memory");
+    boundary_store->Reset(main_grid->nt + 1, size_of_boundaries);
   }
   memset(main_grid->pressure_current, 0.0f, grid_size * sizeof(float));
   memset(main_grid->pressure_next, 0.0f, grid_size * sizeof(float));
@@ -127,8 +137,9 @@ void StaggeredReverseInjectionPropagation::ResetGrid(bool forward_run) {
 }
 
 void StaggeredReverseInjectionPropagation::SaveForward() {
-  SaveBoundaries(main_grid, parameters, backup_boundaries, time_step,
+  SaveBoundaries(main_grid, parameters, boundary_store->GetStep(time_step), 0,
                  size_of_boundaries);
+  boundary_store->Save(time_step);
   time_step++;
 }
 
@@ -137,6 +148,7 @@ StaggeredReverseInjectionPropagation::~StaggeredReverseInjectionPropagation() {
     mem_free((void *)internal_grid->pressure_current);
   }
   mem_free((void *)internal_grid);
+  delete boundary_store;
   delete computation_kernel;
 }
 
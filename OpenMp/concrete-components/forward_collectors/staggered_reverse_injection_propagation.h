@@ -6,6 +6,7 @@
 #define ACOUSTIC2ND_RTM_STAGGERED_REVERSE_INJECTION_PROPAGATION_H
 #include <concrete-components/data_units/staggered_grid.h>
 #include <concrete-components/forward_collectors/boundary_saver/boundary_saver.h>
+#include <concrete-components/forward_collectors/boundary_saver/boundary_store.h>
 #include <cstdlib>
 #include <cstring>
 #include <skeleton/components/computation_kernel.h>
@@ -18,13 +19,28 @@ private:
   StaggeredGrid *internal_grid;
   ComputationParameters *parameters;
   ComputationKernel *computation_kernel;
-  float *backup_boundaries;
+  // The boundaries saved at each time-step of the forward propagation.
+  BoundaryStore *boundary_store;
   uint time_step;
   uint size_of_boundaries;
 
 public:
-  StaggeredReverseInjectionPropagation(ComputationKernel *kernel);
+  /*!
+   * @param write_path
+   * The directory of the boundaries the memory budget can't hold.
+   * @param memory_budget
+   * The bytes of memory the saved boundaries may use, 0 for the available
+   * memory.
+   * @param codec
+   * The codec of the saved boundaries, with the absolute error of bfp.
+   */
+  StaggeredReverseInjectionPropagation(ComputationKernel *kernel,
+                                       string write_path = ".",
+                                       size_t memory_budget = 0,
+                                       BOUNDARY_CODEC codec = BOUNDARY_RAW,
+                                       double tolerance = 1e-6);
   void FetchForward(void) override;
+  bool IsReconstructed() override;
   void SaveForward() override;
   void ResetGrid(bool forward_run) override;
   void SetComputationParameters(ComputationParameters *parameters) override;
@@ -30,36 +30,45 @@ void StaggeredReversePropagation::ResetGrid(bool forward_run) {
   uint ny = main_grid->window_size.window_ny;
   if (!forward_run) {
     if (internal_grid->pressure_current == NULL) {
+      // Allocated once for the full grid so that the frames fit the window of
+      // any shot.
+      uint full_nx = main_grid->grid_size.nx;
+      uint full_nz = main_grid->grid_size.nz;
+      uint full_ny = main_grid->grid_size.ny;
+      unsigned int const full_size = full_nx * full_nz * full_ny;
       internal_grid->pressure_current = (float *)mem_allocate(
-          sizeof(float), grid_size, "forward_collector_pressure_curr",
+          sizeof(float), full_size, "forward_collector_pressure_curr",
           parameters->half_length, 16);
       internal_grid->pressure_next = internal_grid->pressure_current;
       internal_grid->particle_velocity_x_current =
-          (float *)mem_allocate(sizeof(float), grid_size,
+          (float *)mem_allocate(sizeof(float), full_size,
                                 "forward_collector_particle_velocity_x_current",
                                 parameters->half_length, 32);
       internal_grid->particle_velocity_z_current =
-          (float *)mem_allocate(sizeof(float), grid_size,
+          (float *)mem_allocate(sizeof(float), full_size,
                                 "forward_collector_particle_velocity_z_current",
                                 parameters->half_length, 48);
 
       if (ny > 1) {
         internal_grid->particle_velocity_y_current = (float *)mem_allocate(
-            sizeof(float), grid_size,
+            sizeof(float), full_size,
             "forward_collector_particle_velocity_y_current",
             parameters->half_length, 64);
       }
-      this->computation_kernel->FirstTouch(internal_grid->pressure_current, nx,
-                                           nz, ny);
-      this->computation_kernel->FirstTouch(internal_grid->pressure_next, nx, nz,
-                                           ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_current,
+                                           full_nx, full_nz, full_ny);
+      this->computation_kernel->FirstTouch(internal_grid->pressure_next,
+                                           full_nx, full_nz, full_ny);
       this->computation_kernel->FirstTouch(
-          internal_grid->particle_velocity_x_current, nx, nz, ny);
+          internal_grid->particle_velocity_x_current, full_nx, full_nz,
+          full_ny);
       this->computation_kernel->FirstTouch(
-          internal_grid->particle_velocity_z_current, nx, nz, ny);
+          internal_grid->particle_velocity_z_current, full_nx, full_nz,
+          full_ny);
       if (ny > 1) {
         this->computation_kernel->FirstTouch(
-            internal_grid->particle_velocity_y_current, nx, nz, ny);
+            internal_grid->particle_velocity_y_current, full_nx, full_nz,
+            full_ny);
       }
     }
     memcpy(internal_grid->pressure_current, main_grid->pressure_current,
@@ -103,6 +112,10 @@ void StaggeredReversePropagation::ResetGrid(bool forward_run) {
 
 void StaggeredReversePropagation::SaveForward() {}
 
+bool StaggeredReversePropagation::IsSaveRequired(uint time_step) { return false; }
+
+bool StaggeredReversePropagation::IsReconstructed() { return true; }
+
 StaggeredReversePropagation::~StaggeredReversePropagation() {
   if (internal_grid->pressure_current != NULL) {
     mem_free((void *)internal_grid->pressure_current);
@@ -23,6 +23,8 @@ public:
   StaggeredReversePropagation(ComputationKernel *kernel);
   void FetchForward(void) override;
   void SaveForward() override;
+  bool IsSaveRequired(uint time_step) override;
+  bool IsReconstructed() override;
   void ResetGrid(bool forward_run) override;
   void SetComputationParameters(ComputationParameters *parameters) override;
   void SetGridBox(GridBox *grid_box) override;
@@ -1,92 +1,96 @@
 #include "staggered_two_propagation.h"
 
-#include <compress.h>
 #include <iostream>
 #include <sys/stat.h>
 //
 // Created by mirnamoawad on 1/15/20.
 //
 
-StaggeredTwoPropagation::StaggeredTwoPropagation(bool compression,
-                                                 string write_path,
-                                                 float zfp_tolerance,
-                                                 int zfp_parallel,
-                                                 bool zfp_is_relative) {
+StaggeredTwoPropagation::StaggeredTwoPropagation(
+    string write_path, const SnapshotOptions &options) {
   this->internal_grid = (StaggeredGrid *)mem_allocate(
       sizeof(StaggeredGrid), 1, "forward_collector_gridbox");
   this->internal_grid->pressure_current = nullptr;
-  this->forward_pressure = nullptr;
-  mem_fit = false;
+  this->stored_window = {{0, 0, 0}, 0, 0, 0};
   time_counter = 0;
+  imaging_step = 1;
+  saved_slot = -1;
+  copy_frames = false;
+  this->interior = options.interior;
+  this->region_frame = nullptr;
+  this->region_capacity = 0;
   mkdir(write_path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
   this->write_path = write_path + "/two_prop";
   mkdir(this->write_path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-  zfp::setPath(this->write_path);
-  this->compression = compression;
-  this->zfp_tolerance = zfp_tolerance;
-  this->zfp_parallel = zfp_parallel + 1;
-  this->zfp_is_relative = zfp_is_relative;
+  this->compression = options.codec != SNAPSHOT_RAW;
+  this->store = new SnapshotStore(this->write_path, options);
 }
 
 void StaggeredTwoPropagation::SaveForward() {
-  if (mem_fit) {
-    main_grid->pressure_next = main_grid->pressure_current + pressure_size;
-  } else {
-    time_counter++;
-    if ((time_counter + 1) % max_nt == 0) {
-      if (this->compression) {
-        for (int it = 0; it < max_nt; it++) {
-          size_t resultSize;
-          zfp::compression(forward_pressure + it * pressure_size,
-                           main_grid->window_size.window_nx,
-                           main_grid->window_size.window_ny,
-                           main_grid->window_size.window_nz,
-                           (double)this->zfp_tolerance, this->zfp_parallel,
-                           (unsigned int)(time_counter + 1 - max_nt + it),
-                           &resultSize, "forward_pressure",
-                           this->zfp_is_relative);
-        }
-      } else {
-        string s =
-            this->write_path + "/temp_" + to_string(time_counter / max_nt);
-        bin_file_save(s.c_str(), forward_pressure, max_nt * pressure_size);
-      }
+  time_counter++;
+  if (copy_frames) {
+    // The frame of the grid is updated in place, so a stored frame is copied
+    // to the store, or to the region frame, before its source is injected and
+    // the step computed out of it, to be saved at the next time-step.
+    SaveStagedFrame();
+    main_grid->pressure_current = temp_curr;
+    main_grid->pressure_next = temp_next;
+    uint frame = time_counter - 1;
+    if (frame % imaging_step == 0) {
+      saved_slot = frame / imaging_step;
+      float *staged = interior ? region_frame : store->GetFrame(saved_slot);
+      memcpy(staged, temp_curr, pressure_size * sizeof(float));
+      main_grid->pressure_current = staged;
     }
-    main_grid->pressure_current =
-        forward_pressure + ((time_counter) % max_nt) * pressure_size;
-    main_grid->pressure_next =
-        forward_pressure + ((time_counter + 1) % max_nt) * pressure_size;
+    return;
+  }
+  // The current frame is the one of the previous time-step, the one before it
+  // is complete, its source being injected.
+  if (time_counter > 1) {
+    store->Save(time_counter - 2);
+  }
+  main_grid->pressure_current = store->GetFrame(time_counter - 1);
+  main_grid->pressure_next = store->GetFrame(time_counter);
+}
+
+bool StaggeredTwoPropagation::IsSaveRequired(uint time_step) {
+  // The frames computed in place are all stored, the copied ones are staged
+  // by the SaveForward call of the time-step after them and saved by the next
+  // one.
+  if (!copy_frames) {
+    return true;
   }
+  uint frame = time_step - 1;
+  return frame % imaging_step == 0 ||
+         (frame > 0 && (frame - 1) % imaging_step == 0);
+}
+
+void StaggeredTwoPropagation::SkipForward(uint time_steps) {
+  time_counter += time_steps;
+}
+
+void StaggeredTwoPropagation::SaveStagedFrame() {
+  if (saved_slot < 0) {
+    return;
+  }
+  if (interior) {
+    PackRegion(region_frame, main_grid->window_size, region, 1,
+               store->GetFrame(saved_slot));
+  }
+  store->Save(saved_slot);
+  saved_slot = -1;
 }
 
 void StaggeredTwoPropagation::FetchForward(void) {
-  if (mem_fit) {
-    internal_grid->pressure_current =
-        internal_grid->pressure_current - pressure_size;
-  } else {
-    if ((time_counter + 1) % max_nt == 0) {
-      if (this->compression) {
-        for (int it = 0; it < max_nt; it++) {
-          size_t resultSize;
-          zfp::decompression(&forward_pressure[it * pressure_size],
-                             main_grid->window_size.window_nx,
-                             main_grid->window_size.window_ny,
-                             main_grid->window_size.window_nz,
-                             (double)this->zfp_tolerance, this->zfp_parallel,
-                             (unsigned int)(time_counter + 1 - max_nt + it),
-                             &resultSize, "forward_pressure",
-                             this->zfp_is_relative);
-        }
-      } else {
-        string s =
-            this->write_path + "/temp_" + to_string(time_counter / max_nt);
-        bin_file_load(s.c_str(), forward_pressure, max_nt * pressure_size);
-      }
+  if (time_counter % imaging_step == 0) {
+    float *snapshot = store->Fetch(time_counter / imaging_step);
+    if (interior) {
+      UnpackRegion(snapshot, main_grid->window_size, region, 1, region_frame);
+      snapshot = region_frame;
     }
-    internal_grid->pressure_current =
-        forward_pressure + ((time_counter) % max_nt) * pressure_size;
-    time_counter--;
+    internal_grid->pressure_current = snapshot;
   }
+  time_counter--;
 }
 
 void StaggeredTwoPropagation::ResetGrid(bool forward_run) {
@@ -95,30 +99,47 @@ void StaggeredTwoPropagation::ResetGrid(bool forward_run) {
                     main_grid->window_size.window_ny *
                     main_grid->window_size.window_nz;
     time_counter = 0;
-    if (forward_pressure == nullptr) {
-      // Add one for empty timeframe at the start of the simulation(The first
-      // previous) since SaveForward is called before each step.
-      max_nt = main_grid->nt + 1;
-      forward_pressure = (float *)mem_allocate(
-          (sizeof(float)), max_nt * pressure_size, "forward_pressure");
-      if (forward_pressure != nullptr) {
-        mem_fit = true;
-      } else {
-        mem_fit = false;
-        while (forward_pressure == nullptr) {
-          max_nt = max_nt / 2;
-          forward_pressure = (float *)mem_allocate(
-              (sizeof(float)), max_nt * pressure_size, "forward_pressure");
-        }
-      }
-    }
+    // The halos of the frames aren't written by the propagation, so the
+    // frames of a previous shot with a different window would leave their
+    // values in them.
+    WindowSize *window = &main_grid->window_size;
+    bool window_changed = stored_window.window_nx != 0 &&
+                          (window->window_nx != stored_window.window_nx ||
+                           window->window_nz != stored_window.window_nz ||
+                           window->window_ny != stored_window.window_ny);
+    stored_window = *window;
+    imaging_step = parameters->imaging_step;
+    copy_frames = imaging_step > 1 || interior;
     temp_curr = main_grid->pressure_current;
     temp_next = main_grid->pressure_next;
-    memset(forward_pressure, 0.0f, pressure_size * sizeof(float));
-    memset(forward_pressure + pressure_size, 0.0f,
-           pressure_size * sizeof(float));
-    main_grid->pressure_current = forward_pressure;
-    main_grid->pressure_next = forward_pressure + pressure_size;
+    if (copy_frames) {
+      // Only one frame of each imaging step is stored, copied from the frames
+      // of the grid once computed. They hold the backward propagation of the
+      // previous shot.
+      size_t snapshot_size = pressure_size;
+      WindowSize snapshot_window = *window;
+      if (interior) {
+        // The snapshots only hold the imaging region, packed from the region
+        // frame.
+        region = GetImagingRegion(main_grid, parameters);
+        snapshot_size = GetRegionSize(region, 1);
+        snapshot_window = region;
+        ReserveRegionFrame();
+      }
+      store->Reset((main_grid->nt - 1) / imaging_step + 1, snapshot_size,
+                   snapshot_window, window_changed);
+      memset(temp_curr, 0.0f, pressure_size * sizeof(float));
+      memset(temp_next, 0.0f, pressure_size * sizeof(float));
+      saved_slot = -1;
+    } else {
+      // The frame of each time-step, starting from the empty one the first
+      // step is computed from.
+      store->Reset(main_grid->nt, pressure_size, *window, window_changed);
+      memset(store->GetFrame(0), 0.0f, pressure_size * sizeof(float));
+      memset(store->GetFrame(1), 0.0f, pressure_size * sizeof(float));
+      main_grid->pressure_current = store->GetFrame(0);
+      main_grid->pressure_next = store->GetFrame(1);
+    }
     internal_grid->nt = main_grid->nt;
     internal_grid->dt = main_grid->dt;
     memcpy(&internal_grid->grid_size, &main_grid->grid_size,
@@ -129,6 +150,26 @@ void StaggeredTwoPropagation::ResetGrid(bool forward_run) {
            sizeof(main_grid->cell_dimensions));
     internal_grid->velocity = main_grid->velocity;
   } else {
+    // The last two frames of the forward propagation aren't followed by
+    // SaveForward calls, the last one being the first fetched.
+    if (copy_frames) {
+      SaveStagedFrame();
+      if (time_counter % imaging_step == 0) {
+        saved_slot = time_counter / imaging_step;
+        float *staged = interior ? region_frame : store->GetFrame(saved_slot);
+        memcpy(staged, main_grid->pressure_current,
+               pressure_size * sizeof(float));
+        SaveStagedFrame();
+      }
+      if (interior) {
+        // The fetched snapshots are unpacked to the region frame, whose other
+        // points stay zero.
+        memset(region_frame, 0.0f, pressure_size * sizeof(float));
+      }
+    } else {
+      store->Save(time_counter - 1);
+      store->Save(time_counter);
+    }
     memset(temp_curr, 0.0f, pressure_size * sizeof(float));
     memset(temp_next, 0.0f, pressure_size * sizeof(float));
     memset(main_grid->particle_velocity_x_current, 0.0f,
@@ -139,22 +180,26 @@ void StaggeredTwoPropagation::ResetGrid(bool forward_run) {
       memset(main_grid->particle_velocity_y_current, 0.0f,
              pressure_size * sizeof(float));
     }
-    if (!mem_fit) {
-      time_counter++;
-      internal_grid->pressure_current = main_grid->pressure_current;
-    } else {
-      // Pressure size will be minimized in FetchForward call at first step.
-      internal_grid->pressure_current =
-          main_grid->pressure_current + pressure_size;
-    }
     main_grid->pressure_current = temp_curr;
     main_grid->pressure_next = temp_next;
   }
 }
 
+void StaggeredTwoPropagation::ReserveRegionFrame() {
+  if (pressure_size > region_capacity) {
+    if (region_frame != nullptr) {
+      mem_free(region_frame);
+    }
+    region_frame = (float *)mem_allocate(sizeof(float), pressure_size,
+                                         "region_snapshot");
+    region_capacity = pressure_size;
+  }
+}
+
 StaggeredTwoPropagation::~StaggeredTwoPropagation() {
-  if (forward_pressure != NULL) {
-    mem_free((void *)forward_pressure);
+  delete store;
+  if (region_frame != nullptr) {
+    mem_free(region_frame);
   }
   mem_free((void *)internal_grid);
 }
@@ -1,92 +1,116 @@
 #include "two_propagation.h"
-#include <compress.h>
 #include <iostream>
 #include <sys/stat.h>
 
-TwoPropagation::TwoPropagation(bool compression, string write_path,
-                               float zfp_tolerance, int zfp_parallel,
-                               bool zfp_is_relative) {
+TwoPropagation::TwoPropagation(string write_path,
+                               const SnapshotOptions &options) {
   this->internal_grid = (AcousticSecondGrid *)mem_allocate(
       sizeof(AcousticSecondGrid), 1, "forward_collector_gridbox");
   this->internal_grid->pressure_current = nullptr;
-  this->forward_pressure = nullptr;
-  mem_fit = false;
   time_counter = 0;
+  imaging_step = 1;
+  copy_frames = false;
+  this->interior = options.interior;
+  this->region_frame = nullptr;
+  this->region_capacity = 0;
   mkdir(write_path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
   this->write_path = write_path + "/two_prop";
   mkdir(this->write_path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-  zfp::setPath(this->write_path);
-  this->compression = compression;
-  this->zfp_tolerance = zfp_tolerance;
-  this->zfp_parallel = zfp_parallel + 1;
-  this->zfp_is_relative = zfp_is_relative;
+  this->compression = options.codec != SNAPSHOT_RAW;
+  this->stored_window = {{0, 0, 0}, 0, 0, 0};
+  this->store = new SnapshotStore(this->write_path, options);
 }
+
+// The frame fetched at a backward time-step is the one after it, so the
+// stored frames follow the time-steps correlated by the engine.
+bool TwoPropagation::IsStored(uint frame) {
+  return frame > 0 && (frame - 1) % imaging_step == 0;
+}
+
+uint TwoPropagation::GetSlot(uint frame) {
+  return copy_frames ? (frame - 1) / imaging_step : frame;
+}
+
+void TwoPropagation::StoreFrame(uint frame, float *pressure) {
+  if (IsStored(frame)) {
+    uint slot = GetSlot(frame);
+    if (interior) {
+      PackRegion(pressure, main_grid->window_size, region,
+                 parameters->shot_batch, store->GetFrame(slot));
+    } else {
+      memcpy(store->GetFrame(slot), pressure, pressure_size * sizeof(float));
+    }
+    store->Save(slot);
+  }
+}
+
 void TwoPropagation::FetchForward(void) {
-  if (mem_fit) {
-    internal_grid->pressure_current =
-        internal_grid->pressure_current - pressure_size;
-  } else {
-    if ((time_counter + 1) % max_nt == 0) {
-      if (this->compression) {
-        for (int it = 0; it < max_nt; it++) {
-          size_t resultSize;
-          zfp::decompression(&forward_pressure[it * pressure_size],
-                             main_grid->window_size.window_nx,
-                             main_grid->window_size.window_ny,
-                             main_grid->window_size.window_nz,
-                             (double)this->zfp_tolerance, this->zfp_parallel,
-                             (unsigned int)(time_counter + 1 - max_nt + it),
-                             &resultSize, "forward_pressure",
-                             this->zfp_is_relative);
-        }
-      } else {
-        string s =
-            this->write_path + "/temp_" + to_string(time_counter / max_nt);
-        bin_file_load(s.c_str(), forward_pressure, max_nt * pressure_size);
-      }
+  if (!copy_frames) {
+    internal_grid->pressure_current = store->Fetch(time_counter);
+  } else if (IsStored(time_counter)) {
+    float *snapshot = store->Fetch(GetSlot(time_counter));
+    if (interior) {
+      UnpackRegion(snapshot, main_grid->window_size, region,
+                   parameters->shot_batch, region_frame);
+      snapshot = region_frame;
     }
-    internal_grid->pressure_current =
-        forward_pressure + ((time_counter) % max_nt) * pressure_size;
-    time_counter--;
+    internal_grid->pressure_current = snapshot;
   }
+  time_counter--;
 }
 
 void TwoPropagation::ResetGrid(bool forward_run) {
   if (forward_run) {
+    // The frames hold all the shots of a batch.
     pressure_size = main_grid->window_size.window_nx *
                     main_grid->window_size.window_ny *
-                    main_grid->window_size.window_nz;
+                    main_grid->window_size.window_nz * parameters->shot_batch;
     time_counter = 0;
-    if (forward_pressure == nullptr) {
-      // Add one for empty timeframe at the start of the simulation(The first
-      // previous) since SaveForward is called before each step.
-      max_nt = main_grid->nt + 1;
-      forward_pressure = (float *)mem_allocate(
-          (sizeof(float)), max_nt * pressure_size, "forward_pressure");
-      if (forward_pressure != nullptr) {
-        mem_fit = true;
-      } else {
-        mem_fit = false;
-        while (forward_pressure == nullptr) {
-          max_nt = max_nt / 2;
-          forward_pressure = (float *)mem_allocate(
-              (sizeof(float)), max_nt * pressure_size, "forward_pressure");
-        }
-      }
-    }
+    // The halos of the frames aren't written by the propagation, so the
+    // frames of a previous shot with a different window would leave their
+    // values in them.
+    WindowSize *window = &main_grid->window_size;
+    bool window_changed = stored_window.window_nx != 0 &&
+                          (window->window_nx != stored_window.window_nx ||
+                           window->window_nz != stored_window.window_nz ||
+                           window->window_ny != stored_window.window_ny);
+    stored_window = *window;
+    imaging_step = parameters->imaging_step;
+    copy_frames = imaging_step > 1 || interior;
     temp_prev = main_grid->pressure_previous;
     temp_curr = main_grid->pressure_current;
     temp_next = main_grid->pressure_next;
-    memset(forward_pressure, 0.0f, pressure_size * sizeof(float));
-    memset(forward_pressure + pressure_size, 0.0f,
-           pressure_size * sizeof(float));
-    memset(forward_pressure + 2 * pressure_size, 0.0f,
-           pressure_size * sizeof(float));
-    main_grid->pressure_previous = forward_pressure;
-    main_grid->pressure_current = forward_pressure + pressure_size;
-    // Save forward is called before the kernel in the engine.
-    // When called will advance pressure next to the right point.
-    main_grid->pressure_next = forward_pressure + pressure_size;
+    if (copy_frames) {
+      // Only one frame of each imaging step is stored, copied from the frames
+      // of the grid once computed. They hold the backward propagation of the
+      // previous shot.
+      size_t snapshot_size = pressure_size;
+      WindowSize snapshot_window = *window;
+      if (interior) {
+        // The snapshots only hold the imaging region, the fetched ones are
+        // unpacked to a frame whose other points stay zero.
+        region = GetImagingRegion(main_grid, parameters);
+        snapshot_size = GetRegionSize(region, parameters->shot_batch);
+        snapshot_window = region;
+        ReserveRegionFrame();
+      }
+      store->Reset(main_grid->nt / imaging_step + 1, snapshot_size,
+                   snapshot_window, window_changed);
+      memset(temp_prev, 0.0f, pressure_size * sizeof(float));
+      memset(temp_curr, 0.0f, pressure_size * sizeof(float));
+      memset(temp_next, 0.0f, pressure_size * sizeof(float));
+    } else {
+      // Add one for empty timeframe at the start of the simulation(The first
+      // previous) since SaveForward is called before each step.
+      store->Reset(main_grid->nt + 1, pressure_size, *window, window_changed);
+      memset(store->GetFrame(0), 0.0f, pressure_size * sizeof(float));
+      memset(store->GetFrame(1), 0.0f, pressure_size * sizeof(float));
+      main_grid->pressure_previous = store->GetFrame(0);
+      main_grid->pressure_current = store->GetFrame(1);
+      // Save forward is called before the kernel in the engine.
+      // When called will advance pressure next to the right point.
+      main_grid->pressure_next = store->GetFrame(1);
+    }
     internal_grid->nt = main_grid->nt;
     internal_grid->dt = main_grid->dt;
     memcpy(&internal_grid->grid_size, &main_grid->grid_size,
@@ -97,56 +121,70 @@ void TwoPropagation::ResetGrid(bool forward_run) {
            sizeof(main_grid->cell_dimensions));
     internal_grid->velocity = main_grid->velocity;
   } else {
-    memset(temp_prev, 0.0f, pressure_size * sizeof(float));
-    memset(temp_curr, 0.0f, pressure_size * sizeof(float));
-    if (!mem_fit) {
-      time_counter++;
-      internal_grid->pressure_current = main_grid->pressure_current;
+    // The last two frames of the forward propagation aren't followed by
+    // SaveForward calls.
+    if (copy_frames) {
+      StoreFrame(time_counter, main_grid->pressure_previous);
+      StoreFrame(time_counter + 1, main_grid->pressure_current);
+      // The kernel may have exchanged the frames of the grid with its own
+      // while advancing several time-steps at once.
+      temp_prev = main_grid->pressure_previous;
+      temp_curr = main_grid->pressure_current;
+      temp_next = main_grid->pressure_next;
     } else {
-      // Pressure size will be minimized in FetchForward call at first step.
-      internal_grid->pressure_current =
-          main_grid->pressure_current + pressure_size;
+      store->Save(time_counter);
+      store->Save(time_counter + 1);
     }
+    store->Report();
+    // The first fetched frame is the last one of the forward propagation.
+    time_counter++;
+    memset(temp_prev, 0.0f, pressure_size * sizeof(float));
+    memset(temp_curr, 0.0f, pressure_size * sizeof(float));
     main_grid->pressure_previous = temp_prev;
     main_grid->pressure_current = temp_curr;
     main_grid->pressure_next = temp_next;
   }
 }
+
 void TwoPropagation::SaveForward() {
-  if (mem_fit) {
-    main_grid->pressure_next = main_grid->pressure_current + pressure_size;
-  } else {
-    time_counter++;
-    if ((time_counter + 1) % max_nt == 0) {
-      if (this->compression) {
-        for (int it = 0; it < max_nt; it++) {
-          size_t resultSize;
-          zfp::compression(forward_pressure + it * pressure_size,
-                           main_grid->window_size.window_nx,
-                           main_grid->window_size.window_ny,
-                           main_grid->window_size.window_nz,
-                           (double)this->zfp_tolerance, this->zfp_parallel,
-                           (unsigned int)(time_counter + 1 - max_nt + it),
-                           &resultSize, "forward_pressure",
-                           this->zfp_is_relative);
-        }
-      } else {
-        string s =
-            this->write_path + "/temp_" + to_string(time_counter / max_nt);
-        bin_file_save(s.c_str(), forward_pressure, max_nt * pressure_size);
-      }
+  time_counter++;
+  // The frame before the current one is complete, its source being injected.
+  if (copy_frames) {
+    StoreFrame(time_counter - 1, main_grid->pressure_previous);
+    return;
+  }
+  store->Save(time_counter - 1);
+  main_grid->pressure_previous = store->GetFrame(time_counter - 1);
+  main_grid->pressure_current = store->GetFrame(time_counter);
+  main_grid->pressure_next = store->GetFrame(time_counter + 1);
+}
+
+bool TwoPropagation::IsSaveRequired(uint time_step) {
+  // The frames computed in place are all stored, the copied ones are stored
+  // by the SaveForward call of the time-step after them.
+  return !copy_frames || IsStored(time_step - 1);
+}
+
+void TwoPropagation::SkipForward(uint time_steps) {
+  time_counter += time_steps;
+}
+
+void TwoPropagation::ReserveRegionFrame() {
+  if (pressure_size > region_capacity) {
+    if (region_frame != nullptr) {
+      mem_free(region_frame);
     }
-    main_grid->pressure_previous =
-        forward_pressure + ((time_counter - 1) % max_nt) * pressure_size;
-    main_grid->pressure_current =
-        forward_pressure + ((time_counter) % max_nt) * pressure_size;
-    main_grid->pressure_next =
-        forward_pressure + ((time_counter + 1) % max_nt) * pressure_size;
+    region_frame = (float *)mem_allocate(sizeof(float), pressure_size,
+                                           "region_snapshot");
+    region_capacity = pressure_size;
   }
+  memset(region_frame, 0.0f, pressure_size * sizeof(float));
 }
+
 TwoPropagation::~TwoPropagation() {
-  if (forward_pressure != NULL) {
-    mem_free((void *)forward_pressure);
+  delete store;
+  if (region_frame != nullptr) {
+    mem_free(region_frame);
   }
   mem_free((void *)internal_grid);
 }
@@ -167,3 +205,8 @@ void TwoPropagation::SetGridBox(GridBox *grid_box) {
 }
 
 GridBox *TwoPropagation::GetForwardGrid() { return internal_grid; }
+
+bool TwoPropagation::SupportsShotBatch() {
+  // The compression works on frames of a single shot.
+  return !this->compression;
+}
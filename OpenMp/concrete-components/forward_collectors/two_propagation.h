@@ -2,7 +2,9 @@
 #define ACOUSTIC2ND_RTM_TWO_PROPAGATION_H
 
 #include <concrete-components/data_units/acoustic_second_grid.h>
-#include <concrete-components/forward_collectors/file_handler/file_handler.h>
+#include <concrete-components/forward_collectors/half_precision/half_precision.h>
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_region.h>
+#include <concrete-components/forward_collectors/snapshot_store/snapshot_store.h>
 #include <skeleton/components/computation_kernel.h>
 #include <skeleton/components/forward_collector.h>
 #include <skeleton/helpers/memory_allocation/memory_allocator.h>
@@ -18,29 +20,54 @@ private:
   AcousticSecondGrid *main_grid;
   AcousticSecondGrid *internal_grid;
   ComputationParameters *parameters;
-  float *forward_pressure;
+  // The snapshots of the forward wavefields, the forward propagation runs in
+  // the frames it gives for each time-step.
+  SnapshotStore *store;
   float *temp_prev;
   float *temp_curr;
   float *temp_next;
   uint pressure_size;
-  bool mem_fit;
-  unsigned long long max_nt;
+  // The window of the frames last held by the store.
+  WindowSize stored_window;
   unsigned int time_counter;
+  // The time-steps between the stored frames.
+  uint imaging_step;
+  // Whether the snapshots only hold the imaging region of the window.
+  bool interior;
+  WindowSize region;
+  // The frame the snapshots of the imaging region are unpacked to.
+  float *region_frame;
+  size_t region_capacity;
+  // Whether the forward propagation runs in the frames of the grid, the
+  // stored frames being copied to the store, as needed by an imaging step
+  // above 1 or the imaging region.
+  bool copy_frames;
   string write_path;
   bool compression;
-  float zfp_tolerance;
-  int zfp_parallel;
-  bool zfp_is_relative;
+
+  bool IsStored(uint frame);
+  uint GetSlot(uint frame);
+  void StoreFrame(uint frame, float *pressure);
+  void ReserveRegionFrame();
 
 public:
-  TwoPropagation(bool compression, string write_path,
-                 float zfp_tolerance = 0.01f, int zfp_parallel = 1,
-                 bool zfp_is_relative = false);
+  /*!
+   * @param write_path
+   * The directory the snapshots spilled to the disk are written in.
+   * @param options
+   * The memory budget, the compression and the codec of the snapshots of the
+   * forward wavefields.
+   */
+  TwoPropagation(string write_path,
+                 const SnapshotOptions &options = SnapshotOptions());
   void FetchForward(void) override;
   void SaveForward() override;
+  bool IsSaveRequired(uint time_step) override;
+  void SkipForward(uint time_steps) override;
   void ResetGrid(bool forward_run) override;
   void SetComputationParameters(ComputationParameters *parameters) override;
   void SetGridBox(GridBox *grid_box) override;
+  bool SupportsShotBatch() override;
   GridBox *GetForwardGrid() override;
   ~TwoPropagation() override;
 };
@@ -78,7 +78,7 @@ HomogenousModelHandler ::ReadModel(vector<string> filenames,
   }
   // Loop on vector v and insert nx,ny,nz,dx,dy,dz in val[0]
   // velocity, start and end of each layer in val[1];
-  // start and end of window in val[2]
+  // start and end of window in val[2], unused as the engine sets the window
   for (int i = 0; i < v.size(); i++) {
     stringstream ss(v[i]);
     string item;
@@ -115,22 +115,14 @@ HomogenousModelHandler ::ReadModel(vector<string> filenames,
   // Calculate Model Size
   unsigned int model_size = nx * nz * ny;
 
-  // if there is no window then window size equals full model size
-#ifndef WINDOW_MODEL
+  // The window starts as the full model, the engine moves it to each shot
+  // when the shot window is used.
   grid->window_size.window_start.x = 0;
   grid->window_size.window_start.z = 0;
   grid->window_size.window_start.y = 0;
   grid->window_size.window_nx = nx;
   grid->window_size.window_nz = nz;
   grid->window_size.window_ny = ny;
-#else
-  grid->window_size.window_start.x = val[2][0];
-  grid->window_size.window_start.z = val[2][1];
-  grid->window_size.window_start.y = val[2][2];
-  grid->window_size.window_nx = val[2][3];
-  grid->window_size.window_nz = val[2][4];
-  grid->window_size.window_ny = val[2][5];
-#endif
 
   // Allocation and Zeroing the velocity model
   float *velocity = (float *)mem_allocate(sizeof(float), model_size, "velocity",
@@ -161,32 +153,38 @@ HomogenousModelHandler ::ReadModel(vector<string> filenames,
   return grid;
 }
 
-void HomogenousModelHandler ::PreprocessModel(
+void HomogenousModelHandler::AllocateFrames(
     ComputationKernel *computational_kernel) {
   int nx = grid_box->window_size.window_nx;
   int nz = grid_box->window_size.window_nz;
   int ny = grid_box->window_size.window_ny;
 
-  unsigned int model_size = nx * nz * ny;
+  // The window is still the full model here, so the frames are large enough
+  // for the window of any shot.
+  // A batch of shots is interleaved innermost, so the frames are aligned at
+  // their start instead of after the half length padding.
+  int batch = parameters->shot_batch;
+  int padding = batch > 1 ? 0 : parameters->half_length;
+  unsigned int model_size = nx * nz * ny * batch;
   // allocating and zeroing prev, curr, and next pressure
   float *curr = (float *)mem_allocate(sizeof(float), model_size, "curr",
-                                      parameters->half_length, 32);
+                                      padding, 32);
   grid_box->pressure_current = curr;
-  computational_kernel->FirstTouch(curr, nx, nz, ny);
+  computational_kernel->FirstTouch(curr, nx * batch, nz, ny);
   memset(curr, 0, sizeof(float) * model_size);
 
   if (is_staggered) {
     StaggeredGrid *grid_box = (StaggeredGrid *)this->grid_box;
     float *particle_vel_x =
         (float *)mem_allocate(sizeof(float), model_size, "particle_vel_x",
-                              parameters->half_length, 16);
+                              padding, 16);
     grid_box->particle_velocity_x_current = particle_vel_x;
     computational_kernel->FirstTouch(particle_vel_x, nx, nz, ny);
     memset(particle_vel_x, 0, sizeof(float) * model_size);
 
     float *particle_vel_z =
         (float *)mem_allocate(sizeof(float), model_size, "particle_vel_z",
-                              parameters->half_length, 48);
+                              padding, 48);
     grid_box->particle_velocity_z_current = particle_vel_z;
     computational_kernel->FirstTouch(particle_vel_x, nx, nz, ny);
     memset(particle_vel_x, 0, sizeof(float) * model_size);
@@ -194,7 +192,7 @@ void HomogenousModelHandler ::PreprocessModel(
     if (ny > 1) {
       float *particle_vel_y =
           (float *)mem_allocate(sizeof(float), model_size, "particle_vel_y",
-                                parameters->half_length, 64);
+                                padding, 64);
       grid_box->particle_velocity_y_current = particle_vel_y;
       computational_kernel->FirstTouch(particle_vel_y, nx, nz, ny);
       memset(particle_vel_y, 0, sizeof(float) * model_size);
@@ -202,26 +200,32 @@ void HomogenousModelHandler ::PreprocessModel(
 
     float *next = grid_box->pressure_current;
     grid_box->pressure_next = next;
-    computational_kernel->FirstTouch(next, nx, nz, ny);
+    computational_kernel->FirstTouch(next, nx * batch, nz, ny);
     memset(next, 0, sizeof(float) * model_size);
   } else {
     AcousticSecondGrid *grid_box = (AcousticSecondGrid *)this->grid_box;
     float *prev = (float *)mem_allocate(sizeof(float), model_size, "prev",
-                                        parameters->half_length, 16);
+                                        padding, 16);
     grid_box->pressure_previous = prev;
-    computational_kernel->FirstTouch(prev, nx, nz, ny);
+    computational_kernel->FirstTouch(prev, nx * batch, nz, ny);
     memset(prev, 0, sizeof(float) * model_size);
 
     float *next = prev;
     grid_box->pressure_next = next;
-    computational_kernel->FirstTouch(next, nx, nz, ny);
+    computational_kernel->FirstTouch(next, nx * batch, nz, ny);
     memset(next, 0, sizeof(float) * model_size);
   }
+}
+
+void HomogenousModelHandler ::PreprocessModel(
+    ComputationKernel *computational_kernel) {
+  this->AllocateFrames(computational_kernel);
   float dt = grid_box->dt;
   float dt2 = grid_box->dt * grid_box->dt;
   float *velocity_values = grid_box->velocity;
   int full_nx = grid_box->grid_size.nx;
   int full_nx_nz = grid_box->grid_size.nx * grid_box->grid_size.nz;
+  float max_velocity = 0;
   if (is_staggered) {
     StaggeredGrid *grid_box = (StaggeredGrid *)this->grid_box;
     float *density_values = grid_box->density;
@@ -229,11 +233,12 @@ void HomogenousModelHandler ::PreprocessModel(
 // of the wave equation.
 #pragma omp parallel default(shared)
     {
-#pragma omp for schedule(static) collapse(3)
+#pragma omp for schedule(static) collapse(3) reduction(max : max_velocity)
       for (int y = 0; y < grid_box->grid_size.ny; ++y) {
         for (int z = 0; z < grid_box->grid_size.nz; ++z) {
           for (int x = 0; x < grid_box->grid_size.nx; ++x) {
             float value = velocity_values[y * full_nx_nz + z * full_nx + x];
+            max_velocity = fmax(max_velocity, value);
             int offset = y * full_nx_nz + z * full_nx + x;
             velocity_values[offset] =
                 value * value * dt * density_values[offset];
@@ -249,11 +254,12 @@ void HomogenousModelHandler ::PreprocessModel(
 // wave equation.
 #pragma omp parallel default(shared)
     {
-#pragma omp for schedule(static) collapse(3)
+#pragma omp for schedule(static) collapse(3) reduction(max : max_velocity)
       for (int y = 0; y < grid_box->grid_size.ny; ++y) {
         for (int z = 0; z < grid_box->grid_size.nz; ++z) {
           for (int x = 0; x < grid_box->grid_size.nx; ++x) {
             float value = velocity_values[y * full_nx_nz + z * full_nx + x];
+            max_velocity = fmax(max_velocity, value);
             velocity_values[y * full_nx_nz + z * full_nx + x] =
                 value * value * dt2;
           }
@@ -261,6 +267,49 @@ void HomogenousModelHandler ::PreprocessModel(
       }
     }
   }
+  this->max_velocity = max_velocity;
+}
+
+GridBox *HomogenousModelHandler::CloneModel(GridBox *grid_box,
+    ComputationKernel *computational_kernel, bool share) {
+  GridBox *grid;
+  if (is_staggered) {
+    grid = (GridBox *)mem_allocate(sizeof(StaggeredGrid), 1, "StaggeredGrid");
+    memcpy(grid, grid_box, sizeof(StaggeredGrid));
+  } else {
+    grid = (GridBox *)mem_allocate(sizeof(AcousticSecondGrid), 1, "GridBox");
+    memcpy(grid, grid_box, sizeof(AcousticSecondGrid));
+  }
+  int nx = grid->grid_size.nx;
+  int nz = grid->grid_size.nz;
+  int ny = grid->grid_size.ny;
+  unsigned int model_size = nx * nz * ny;
+  grid->window_size.window_start = {0, 0, 0};
+  grid->window_size.window_nx = nx;
+  grid->window_size.window_nz = nz;
+  grid->window_size.window_ny = ny;
+  // The model is already pre-processed, only copied if the boundary manager
+  // modifies it during the shots.
+  if (!share) {
+    float *velocity = (float *)mem_allocate(sizeof(float), model_size,
+                                            "velocity", parameters->half_length,
+                                            0);
+    computational_kernel->FirstTouch(velocity, nx, nz, ny);
+    memcpy(velocity, grid_box->velocity, sizeof(float) * model_size);
+    grid->velocity = velocity;
+    if (is_staggered) {
+      float *density = (float *)mem_allocate(sizeof(float), model_size,
+                                             "density", parameters->half_length,
+                                             0);
+      computational_kernel->FirstTouch(density, nx, nz, ny);
+      memcpy(density, ((StaggeredGrid *)grid_box)->density,
+             sizeof(float) * model_size);
+      ((StaggeredGrid *)grid)->density = density;
+    }
+  }
+  this->grid_box = grid;
+  this->AllocateFrames(computational_kernel);
+  return grid;
 }
 
 void HomogenousModelHandler ::GetSuitableDt(float dx, float dz, float dy,
@@ -304,7 +353,12 @@ void HomogenousModelHandler::SetGridBox(GridBox *grid_box) {
 }
 
 HomogenousModelHandler::HomogenousModelHandler(bool staggered) {
+  this->max_velocity = 0;
   this->is_staggered = staggered;
 }
 
 HomogenousModelHandler ::~HomogenousModelHandler() = default;
+
+float HomogenousModelHandler::GetMaxVelocity() { return this->max_velocity; }
+
+bool HomogenousModelHandler::SupportsShotBatch() { return true; }
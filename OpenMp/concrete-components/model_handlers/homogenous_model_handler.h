@@ -28,16 +28,27 @@ public:
 
   void PreprocessModel(ComputationKernel *computational_kernel) override;
 
+  GridBox *CloneModel(GridBox *grid_box,
+                      ComputationKernel *computational_kernel,
+                      bool share) override;
+
   void SetComputationParameters(ComputationParameters *parameters) override;
 
   void SetGridBox(GridBox *grid_box) override;
 
+  bool SupportsShotBatch() override;
+
+  float GetMaxVelocity() override;
+
   HomogenousModelHandler(bool is_staggered);
 
 private:
   ComputationParameters *parameters;
   GridBox *grid_box;
   bool is_staggered;
+  float max_velocity;
+  // Allocates the frames of the GridBox for the size of its window.
+  void AllocateFrames(ComputationKernel *computational_kernel);
   static void GetSuitableDt(float dx, float dz, float dy, float *dt,
                             float *coeff, int max, int half_length,
                             float dt_relax);
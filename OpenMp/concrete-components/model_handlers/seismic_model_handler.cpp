@@ -8,8 +8,7 @@
 #include <seismic-io-framework/datatypes.h>
 
 SeismicModelHandler::SeismicModelHandler(bool is_staggered) {
-  sio = new SeIO();
-  IO = new SEGYIOManager();
+  this->max_velocity = 0;
   this->is_staggered = is_staggered;
 }
 
@@ -44,33 +43,38 @@ void SeismicModelHandler ::GetSuitableDt(int ny, float dx, float dz, float dy,
   *dt = ((sqrtf(a1 / a2)) * distanceM) / max * dt_relax;
 }
 
-void SeismicModelHandler ::PreprocessModel(
+void SeismicModelHandler::AllocateFrames(
     ComputationKernel *computational_kernel) {
-
   int nx = grid_box->window_size.window_nx;
   int nz = grid_box->window_size.window_nz;
   int ny = grid_box->window_size.window_ny;
 
-  unsigned int model_size = nx * nz * ny;
+  // The window is still the full model here, so the frames are large enough
+  // for the window of any shot.
+  // A batch of shots is interleaved innermost, so the frames are aligned at
+  // their start instead of after the half length padding.
+  int batch = parameters->shot_batch;
+  int padding = batch > 1 ? 0 : parameters->half_length;
+  unsigned int model_size = nx * nz * ny * batch;
   // allocating and zeroing prev, curr, and next pressure
   float *curr = (float *)mem_allocate(sizeof(float), model_size, "curr",
-                                      parameters->half_length, 32);
+                                      padding, 32);
   grid_box->pressure_current = curr;
-  computational_kernel->FirstTouch(curr, nx, nz, ny);
+  computational_kernel->FirstTouch(curr, nx * batch, nz, ny);
   memset(curr, 0, sizeof(float) * model_size);
 
   if (is_staggered) {
     StaggeredGrid *grid_box = (StaggeredGrid *)this->grid_box;
     float *particle_vel_x =
         (float *)mem_allocate(sizeof(float), model_size, "particle_vel_x",
-                              parameters->half_length, 16);
+                              padding, 16);
     grid_box->particle_velocity_x_current = particle_vel_x;
     computational_kernel->FirstTouch(particle_vel_x, nx, nz, ny);
     memset(particle_vel_x, 0, sizeof(float) * model_size);
 
     float *particle_vel_z =
         (float *)mem_allocate(sizeof(float), model_size, "particle_vel_z",
-                              parameters->half_length, 48);
+                              padding, 48);
     grid_box->particle_velocity_z_current = particle_vel_z;
     computational_kernel->FirstTouch(particle_vel_x, nx, nz, ny);
     memset(particle_vel_x, 0, sizeof(float) * model_size);
@@ -78,7 +82,7 @@ void SeismicModelHandler ::PreprocessModel(
     if (ny > 1) {
       float *particle_vel_y =
           (float *)mem_allocate(sizeof(float), model_size, "particle_vel_y",
-                                parameters->half_length, 64);
+                                padding, 64);
       grid_box->particle_velocity_y_current = particle_vel_y;
       computational_kernel->FirstTouch(particle_vel_y, nx, nz, ny);
       memset(particle_vel_y, 0, sizeof(float) * model_size);
@@ -86,26 +90,33 @@ void SeismicModelHandler ::PreprocessModel(
 
     float *next = grid_box->pressure_current;
     grid_box->pressure_next = next;
-    computational_kernel->FirstTouch(next, nx, nz, ny);
+    computational_kernel->FirstTouch(next, nx * batch, nz, ny);
     memset(next, 0, sizeof(float) * model_size);
   } else {
     AcousticSecondGrid *grid_box = (AcousticSecondGrid *)this->grid_box;
     float *prev = (float *)mem_allocate(sizeof(float), model_size, "prev",
-                                        parameters->half_length, 16);
+                                        padding, 16);
     grid_box->pressure_previous = prev;
-    computational_kernel->FirstTouch(prev, nx, nz, ny);
+    computational_kernel->FirstTouch(prev, nx * batch, nz, ny);
     memset(prev, 0, sizeof(float) * model_size);
 
     float *next = prev;
     grid_box->pressure_next = next;
-    computational_kernel->FirstTouch(next, nx, nz, ny);
+    computational_kernel->FirstTouch(next, nx * batch, nz, ny);
     memset(next, 0, sizeof(float) * model_size);
   }
+}
+
+void SeismicModelHandler ::PreprocessModel(
+    ComputationKernel *computational_kernel) {
+
+  this->AllocateFrames(computational_kernel);
   float dt = grid_box->dt;
   float dt2 = grid_box->dt * grid_box->dt;
   float *velocity_values = grid_box->velocity;
   int full_nx = grid_box->grid_size.nx;
   int full_nx_nz = grid_box->grid_size.nx * grid_box->grid_size.nz;
+  float max_velocity = 0;
   if (is_staggered) {
     StaggeredGrid *grid_box = (StaggeredGrid *)this->grid_box;
     float *density_values = grid_box->density;
@@ -113,11 +124,12 @@ void SeismicModelHandler ::PreprocessModel(
     // component of the wave equation.
 #pragma omp parallel default(shared)
     {
-#pragma omp for schedule(static) collapse(3)
+#pragma omp for schedule(static) collapse(3) reduction(max : max_velocity)
       for (int y = 0; y < grid_box->grid_size.ny; ++y) {
         for (int z = 0; z < grid_box->grid_size.nz; ++z) {
           for (int x = 0; x < grid_box->grid_size.nx; ++x) {
             float value = velocity_values[y * full_nx_nz + z * full_nx + x];
+            max_velocity = fmax(max_velocity, value);
             int offset = y * full_nx_nz + z * full_nx + x;
             velocity_values[offset] =
                 value * value * dt * density_values[offset];
@@ -133,11 +145,12 @@ void SeismicModelHandler ::PreprocessModel(
     // the wave equation.
 #pragma omp parallel default(shared)
     {
-#pragma omp for schedule(static) collapse(3)
+#pragma omp for schedule(static) collapse(3) reduction(max : max_velocity)
       for (int y = 0; y < grid_box->grid_size.ny; ++y) {
         for (int z = 0; z < grid_box->grid_size.nz; ++z) {
           for (int x = 0; x < grid_box->grid_size.nx; ++x) {
             float value = velocity_values[y * full_nx_nz + z * full_nx + x];
+            max_velocity = fmax(max_velocity, value);
             velocity_values[y * full_nx_nz + z * full_nx + x] =
                 value * value * dt2;
           }
@@ -145,6 +158,49 @@ void SeismicModelHandler ::PreprocessModel(
       }
     }
   }
+  this->max_velocity = max_velocity;
+}
+
+GridBox *SeismicModelHandler::CloneModel(GridBox *grid_box,
+    ComputationKernel *computational_kernel, bool share) {
+  GridBox *grid;
+  if (is_staggered) {
+    grid = (GridBox *)mem_allocate(sizeof(StaggeredGrid), 1, "StaggeredGrid");
+    memcpy(grid, grid_box, sizeof(StaggeredGrid));
+  } else {
+    grid = (GridBox *)mem_allocate(sizeof(AcousticSecondGrid), 1, "GridBox");
+    memcpy(grid, grid_box, sizeof(AcousticSecondGrid));
+  }
+  int nx = grid->grid_size.nx;
+  int nz = grid->grid_size.nz;
+  int ny = grid->grid_size.ny;
+  unsigned int model_size = nx * nz * ny;
+  grid->window_size.window_start = {0, 0, 0};
+  grid->window_size.window_nx = nx;
+  grid->window_size.window_nz = nz;
+  grid->window_size.window_ny = ny;
+  // The model is already pre-processed, only copied if the boundary manager
+  // modifies it during the shots.
+  if (!share) {
+    float *velocity = (float *)mem_allocate(sizeof(float), model_size,
+                                            "velocity", parameters->half_length,
+                                            0);
+    computational_kernel->FirstTouch(velocity, nx, nz, ny);
+    memcpy(velocity, grid_box->velocity, sizeof(float) * model_size);
+    grid->velocity = velocity;
+    if (is_staggered) {
+      float *density = (float *)mem_allocate(sizeof(float), model_size,
+                                             "density", parameters->half_length,
+                                             0);
+      computational_kernel->FirstTouch(density, nx, nz, ny);
+      memcpy(density, ((StaggeredGrid *)grid_box)->density,
+             sizeof(float) * model_size);
+      ((StaggeredGrid *)grid)->density = density;
+    }
+  }
+  this->grid_box = grid;
+  this->AllocateFrames(computational_kernel);
+  return grid;
 }
 
 void SeismicModelHandler::SetComputationParameters(
@@ -162,69 +218,69 @@ SeismicModelHandler::ReadModel(vector<string> filenames,
 
   string file_name = filenames[0];
 
-  IO->ReadVelocityDataFromFile(file_name, "CSR", this->sio);
+  // Each trace of the models is a column of nz samples, the traces going
+  // along x.
+  SegyMappedFile velocity_file;
+  float *velocities = ReadTraces(velocity_file, file_name);
 
   GridBox *grid;
+  SegyMappedFile density_file;
+  float *densities = nullptr;
   if (is_staggered) {
     grid = (GridBox *)mem_allocate(sizeof(StaggeredGrid), 1, "StaggeredGrid");
     string d_file_name = filenames[1];
-    IO->ReadDensityDataFromFile(d_file_name, "CSR", this->sio); // case density
+    densities = ReadTraces(density_file, d_file_name); // case density
   } else {
     grid = (GridBox *)mem_allocate(sizeof(AcousticSecondGrid), 1, "GridBox");
   }
   int nx, ny, nz;
+  uint model_nz = velocity_file.GetSampleCount();
 
-  nx = grid->grid_size.nx = sio->DM.nx + 2 * parameters->boundary_length +
+  nx = grid->grid_size.nx = velocity_file.GetTraceCount() +
+                            2 * parameters->boundary_length +
                             2 * parameters->half_length;
-  nz = grid->grid_size.nz = sio->DM.nz + 2 * parameters->boundary_length +
-                            2 * parameters->half_length;
-
-  if (sio->DM.ny > 1) {
-    ny = grid->grid_size.ny = sio->DM.ny + 2 * parameters->boundary_length +
-                              2 * parameters->half_length;
-  } else {
-    ny = grid->grid_size.ny = 1;
-  }
+  nz = grid->grid_size.nz =
+      model_nz + 2 * parameters->boundary_length + 2 * parameters->half_length;
+  ny = grid->grid_size.ny = 1;
 
   float dx, dy, dz, dt;
 
-  dx = grid->cell_dimensions.dx = sio->DM.dx;
-  dz = grid->cell_dimensions.dz = sio->DM.dz;
-  dy = grid->cell_dimensions.dy = sio->DM.dy;
+  int last = velocity_file.GetTraceCount() - 1;
+  SegyTraceHeader first_trace = velocity_file.GetHeader(0);
+  SegyTraceHeader second_trace = velocity_file.GetHeader(1);
+  SegyTraceHeader last_trace = velocity_file.GetHeader(last);
 
-  int last = sio->Velocity.size() - 1;
+  dx = grid->cell_dimensions.dx =
+      (second_trace.sx() * dBtoscale(second_trace.scalco())) -
+      (first_trace.sx() * dBtoscale(first_trace.scalco()));
+  dz = grid->cell_dimensions.dz =
+      velocity_file.GetBinaryHeader().hdt / (float)1000.0;
+  dy = grid->cell_dimensions.dy = 1.0;
 
-  grid->reference_point.x =
-      sio->Velocity.at(0).TraceMetaData.source_location_x <
-              sio->Velocity.at(last).TraceMetaData.source_location_x
-          ? sio->Velocity.at(0).TraceMetaData.source_location_x
-          : sio->Velocity.at(last).TraceMetaData.source_location_x;
+  grid->reference_point.x = first_trace.sx() < last_trace.sx()
+                                ? first_trace.sx()
+                                : last_trace.sx();
 
-  grid->reference_point.z =
-      sio->Velocity.at(0).TraceMetaData.source_location_z <
-              sio->Velocity.at(last).TraceMetaData.source_location_z
-          ? sio->Velocity.at(0).TraceMetaData.source_location_z
-          : sio->Velocity.at(last).TraceMetaData.source_location_z;
+  // The traces carry no depth of their sources.
+  grid->reference_point.z = 0;
 
-  grid->reference_point.y =
-      sio->Velocity.at(0).TraceMetaData.source_location_y <
-              sio->Velocity.at(last).TraceMetaData.source_location_y
-          ? sio->Velocity.at(0).TraceMetaData.source_location_y
-          : sio->Velocity.at(last).TraceMetaData.source_location_y;
+  grid->reference_point.y = first_trace.sy() < last_trace.sy()
+                                ? first_trace.sy()
+                                : last_trace.sy();
 
   cout << "refrence x " << grid->reference_point.x << "refrence z "
        << grid->reference_point.z << "refrence y " << grid->reference_point.y
        << endl;
   unsigned int model_size = nx * nz * ny;
 
-#ifndef WINDOW_MODEL
+  // The window starts as the full model, the engine moves it to each shot
+  // when the shot window is used.
   grid->window_size.window_start.x = 0;
   grid->window_size.window_start.z = 0;
   grid->window_size.window_start.y = 0;
   grid->window_size.window_nx = nx;
   grid->window_size.window_nz = nz;
   grid->window_size.window_ny = ny;
-#endif
 
   float *velocity = (float *)mem_allocate(sizeof(float), model_size, "velocity",
                                           parameters->half_length, 0);
@@ -240,7 +296,7 @@ SeismicModelHandler::ReadModel(vector<string> filenames,
     for (unsigned int i = offset; i < nx - offset; i++) {
       for (unsigned int j = offset; j < nz - offset; j++) {
         float temp_velocity = velocity[k * nx * nz + j * nx + i] =
-            sio->Velocity.at(i - offset).TraceData[j - offset];
+            velocities[(size_t)(i - offset) * model_nz + j - offset];
         if (temp_velocity > max) {
           max = temp_velocity;
         }
@@ -260,7 +316,7 @@ SeismicModelHandler::ReadModel(vector<string> filenames,
       for (unsigned int i = offset; i < nx - offset; i++) {
         for (unsigned int j = offset; j < nz - offset; j++) {
           density[k * nx * nz + j * nx + i] =
-              sio->Density.at(i - offset).TraceData[j - offset];
+              densities[(size_t)(i - offset) * model_nz + j - offset];
         }
       }
     }
@@ -272,9 +328,30 @@ SeismicModelHandler::ReadModel(vector<string> filenames,
   GetSuitableDt(ny, dx, dz, dy, &grid->dt,
                 parameters->second_derivative_fd_coeff, max,
                 parameters->half_length, parameters->dt_relax);
-  free(sio);
-  free(IO);
+  mem_free(velocities);
+  if (densities != nullptr) {
+    mem_free(densities);
+  }
   return grid;
 }
 
+float *SeismicModelHandler::ReadTraces(SegyMappedFile &file,
+                                       string file_name) {
+  if (!file.Open(file_name)) {
+    cout << "Could not map the model file " << file_name << endl;
+    cout << "Terminating..." << endl;
+    exit(0);
+  }
+  size_t trace_count = file.GetTraceCount();
+  float *samples = (float *)mem_allocate(
+      sizeof(float), trace_count * file.GetSampleCount(), "model_samples");
+  vector<pair<size_t, size_t>> ranges(1, make_pair(0, trace_count));
+  file.ReadSamples(ranges, samples);
+  return samples;
+}
+
 SeismicModelHandler ::~SeismicModelHandler() = default;
+
+float SeismicModelHandler::GetMaxVelocity() { return this->max_velocity; }
+
+bool SeismicModelHandler::SupportsShotBatch() { return true; }
@@ -2,8 +2,8 @@
 // Created by ingy on 1/26/20.
 //
 
-#include <IO/io_manager.h>
 #include <Segy/segy_io_manager.h>
+#include <Segy/segy_mapped_file.h>
 #include <concrete-components/data_units/acoustic_second_grid.h>
 #include <datatypes.h>
 #include <skeleton/components/computation_kernel.h>
@@ -25,16 +25,27 @@ public:
 
   void PreprocessModel(ComputationKernel *computational_kernel) override;
 
+  GridBox *CloneModel(GridBox *grid_box,
+                      ComputationKernel *computational_kernel,
+                      bool share) override;
+
   void SetComputationParameters(ComputationParameters *parameters) override;
 
   void SetGridBox(GridBox *grid_box) override;
 
+  bool SupportsShotBatch() override;
+
+  float GetMaxVelocity() override;
+
 private:
-  IOManager *IO;
-  SeIO *sio;
   ComputationParameters *parameters;
   GridBox *grid_box;
   bool is_staggered;
+  float max_velocity;
+  // Maps a model file and converts all its traces, one after the other.
+  static float *ReadTraces(SegyMappedFile &file, string file_name);
+  // Allocates the frames of the GridBox for the size of its window.
+  void AllocateFrames(ComputationKernel *computational_kernel);
   static void GetSuitableDt(int ny, float dx, float dz, float dy, float *dt,
                             float *coeff, int max, int half_length,
                             float dt_relax);
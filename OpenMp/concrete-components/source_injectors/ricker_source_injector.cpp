@@ -7,23 +7,39 @@
  * https://tel.archives-ouvertes.fr/tel-00954506v2/document .
  */
 void RickerSourceInjector::ApplySource(uint time_step) {
-  float dt = grid->dt;
-  float freq = parameters->source_frequency;
+  if (time_step < this->GetCutOffTimestep()) {
+    float *pressure = grid->pressure_current;
+    pressure[this->GetSourceOffset()] += this->GetAmplitude(time_step);
+  }
+}
+
+InjectionList *RickerSourceInjector::GetInjection(uint time_step) {
+  this->injection.num_points = 0;
+  if (time_step < this->GetCutOffTimestep()) {
+    this->injection_offset = this->GetSourceOffset();
+    this->injection_amplitude = this->GetAmplitude(time_step);
+    this->injection.num_points = 1;
+    this->injection.offsets = &this->injection_offset;
+    this->injection.amplitudes = &this->injection_amplitude;
+  }
+  return &this->injection;
+}
+
+uint RickerSourceInjector::GetSourceOffset() {
   int x = source_point->x;
   int y = source_point->y;
   int z = source_point->z;
   int nx = grid->window_size.window_nx;
-  int ny = grid->window_size.window_ny;
   int nz = grid->window_size.window_nz;
-  if (time_step < this->GetCutOffTimestep()) {
-    float temp = M_PI * M_PI * freq * freq *
-                 (((time_step - 1) * dt) - 1 / freq) *
-                 (((time_step - 1) * dt) - 1 / freq);
-    float ricker = (2 * temp - 1) * exp(-temp);
-    int location = y * nx * nz + z * nx + x;
-    float *pressure = grid->pressure_current;
-    pressure[location] += ricker;
-  }
+  return y * nx * nz + z * nx + x;
+}
+
+float RickerSourceInjector::GetAmplitude(uint time_step) {
+  float dt = grid->dt;
+  float freq = parameters->source_frequency;
+  float temp = M_PI * M_PI * freq * freq * (((time_step - 1) * dt) - 1 / freq) *
+               (((time_step - 1) * dt) - 1 / freq);
+  return (2 * temp - 1) * exp(-temp);
 }
 
 uint RickerSourceInjector::GetCutOffTimestep() {
@@ -58,3 +74,7 @@ void RickerSourceInjector::SetSourcePoint(Point3D *source_point) {
 }
 
 RickerSourceInjector::~RickerSourceInjector() = default;
+
+bool RickerSourceInjector::SupportsShotBatch() { return true; }
+
+bool RickerSourceInjector::SupportsNarrowWavefields() { return true; }
@@ -14,18 +14,35 @@ private:
   Point3D *source_point;
   AcousticSecondGrid *grid;
   AcousticOmpComputationParameters *parameters;
+  // The single point injection returned by GetInjection.
+  uint injection_offset;
+  float injection_amplitude;
+  InjectionList injection;
+
+  /*!
+   * Computes the offset of the source point in the window and the value of the
+   * ricker wavelet at the given time step.
+   */
+  uint GetSourceOffset();
+  float GetAmplitude(uint time_step);
 
 public:
   ~RickerSourceInjector() override;
 
   void ApplySource(uint time_step) override;
 
+  InjectionList *GetInjection(uint time_step) override;
+
   uint GetCutOffTimestep() override;
 
   void SetComputationParameters(ComputationParameters *parameters) override;
 
   void SetGridBox(GridBox *grid_box) override;
 
+  bool SupportsShotBatch() override;
+
+  bool SupportsNarrowWavefields() override;
+
   void SetSourcePoint(Point3D *source_point) override;
 };
 #endif // ACOUSTIC2ND_RTM_RICKER_SOURCE_INJECTOR_H
@@ -28,10 +28,12 @@ Point3D BinaryTraceManager::DeLocalizePoint(Point3D point, bool is_2D,
                                             uint half_length,
                                             uint bound_length) {
   Point3D copy;
-  copy.x = point.x + half_length + bound_length;
-  copy.z = point.z + half_length + bound_length;
+  // The points are given in the model, the grids only hold the window.
+  WindowSize *window = &grid->window_size;
+  copy.x = point.x + half_length + bound_length - window->window_start.x;
+  copy.z = point.z + half_length + bound_length - window->window_start.z;
   if (!is_2D) {
-    copy.y = point.y + half_length + bound_length;
+    copy.y = point.y + half_length + bound_length - window->window_start.y;
   } else {
     copy.y = point.y;
   }
@@ -158,29 +160,42 @@ void BinaryTraceManager::PreprocessShot(uint cut_off_timestep) {
           delete[] travel_times;
       }
   */
+  // The receivers are now in the window, build their injection.
+  IPoint3D start = {(int)r_start.x, (int)r_start.z, (int)r_start.y};
+  IPoint3D end = {(int)r_end.x, (int)r_end.z, (int)r_end.y};
+  IPoint3D increment = {(int)r_inc.x, (int)r_inc.z, (int)r_inc.y};
+  this->receiver_injection.SetReceivers(start, end, increment, wnx,
+                                        grid->window_size.window_nz);
 }
 
 void BinaryTraceManager::ApplyTraces(uint time_step) {
-  int x_inc = r_inc.x == 0 ? 1 : r_inc.x;
-  int y_inc = r_inc.y == 0 ? 1 : r_inc.y;
-  int z_inc = r_inc.z == 0 ? 1 : r_inc.z;
-  int trace_size = traces->trace_size_per_timestep;
-  int wnx = grid->window_size.window_nx;
-  int wnz_wnx = grid->window_size.window_nz * wnx;
-  int index = 0;
+  // The receivers are added through their injection list, in parallel.
+  AddInjection(this->GetInjection(time_step), grid->pressure_current);
+}
+
+InjectionList *BinaryTraceManager::GetInjection(uint time_step) {
   float current_time = (time_step - 1) * grid->dt;
   uint trace_step = uint(current_time / traces->sample_dt);
   trace_step = min(trace_step, traces->sample_nt - 1);
-  for (int iz = r_start.z; iz < r_end.z; iz += z_inc) {
-    for (int iy = r_start.y; iy < r_end.y; iy += y_inc) {
-      for (int ix = r_start.x; ix < r_end.x; ix += x_inc) {
-        int offset = iy * wnz_wnx + iz * wnx + ix;
-        grid->pressure_current[offset] +=
-            traces->traces[(trace_step)*trace_size + index];
-        index++;
-      }
-    }
-  }
+  return this->receiver_injection.GetInjection(
+      traces->traces + trace_step * traces->trace_size_per_timestep);
+}
+
+bool BinaryTraceManager::GetReceiverBox(ActiveBox *box) {
+  return this->receiver_injection.GetBox(box);
+}
+
+bool BinaryTraceManager::GetShotBox(ActiveBox *box) {
+  // The points are still in the model, shift them to the full grid.
+  uint offset = parameters->half_length + parameters->boundary_length;
+  uint offset_y = grid->grid_size.ny == 1 ? 0 : offset;
+  box->start.x = min(source_point.x, r_start.x) + offset;
+  box->start.z = min(source_point.z, r_start.z) + offset;
+  box->start.y = min(source_point.y, r_start.y) + offset_y;
+  box->end.x = max(source_point.x + 1, r_end.x) + offset;
+  box->end.z = max(source_point.z + 1, r_end.z) + offset;
+  box->end.y = max(source_point.y + 1, r_end.y) + offset_y;
+  return true;
 }
 
 Traces *BinaryTraceManager::GetTraces() { return traces; }
@@ -210,3 +225,7 @@ vector<uint> BinaryTraceManager::GetWorkingShots(vector<string> filenames, uint
     }
     return all_shots;
 }
+
+bool BinaryTraceManager::SupportsShotBatch() { return true; }
+
+bool BinaryTraceManager::SupportsNarrowWavefields() { return true; }
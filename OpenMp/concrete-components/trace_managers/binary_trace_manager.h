@@ -7,6 +7,7 @@
 
 #include <concrete-components/data_units/acoustic_openmp_computation_parameters.h>
 #include <concrete-components/data_units/acoustic_second_grid.h>
+#include <concrete-components/trace_managers/receiver_injection.h>
 #include <skeleton/components/trace_manager.h>
 
 #include <fstream>
@@ -24,6 +25,7 @@ class BinaryTraceManager : public TraceManager {
   GridBox *grid;
   AcousticOmpComputationParameters *parameters;
   Point3D source_point;
+  ReceiverInjection receiver_injection;
   Point3D DeLocalizePoint(Point3D point, bool is_2D, uint half_length,
                           uint bound_length);
 
@@ -33,9 +35,15 @@ public:
   void ReadShot(vector<string> filenames, uint shot_number, string sort_key) override;
   void PreprocessShot(uint cut_off_timestep) override;
   void ApplyTraces(uint time_step) override;
+  InjectionList *GetInjection(uint time_step) override;
+  bool GetReceiverBox(ActiveBox *box) override;
+  bool GetShotBox(ActiveBox *box) override;
   Traces *GetTraces() override;
   void SetComputationParameters(ComputationParameters *parameters) override;
   void SetGridBox(GridBox *grid_box) override;
+  bool SupportsShotBatch() override;
+
+  bool SupportsNarrowWavefields() override;
   Point3D *GetSourcePoint() override;
 
   vector<uint> GetWorkingShots(vector<string> filenames, uint min_shot, uint max_shot, string type) override;
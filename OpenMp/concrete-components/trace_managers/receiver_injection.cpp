@@ -0,0 +1,92 @@
+#include "receiver_injection.h"
+#include <algorithm>
+
+using namespace std;
+
+ReceiverInjection::ReceiverInjection() {
+  this->ordered = true;
+  this->injection.num_points = 0;
+  this->injection.offsets = nullptr;
+  this->injection.amplitudes = nullptr;
+  this->box = {{0, 0, 0}, {0, 0, 0}};
+}
+
+void ReceiverInjection::SetReceivers(IPoint3D start, IPoint3D end,
+                                     IPoint3D increment, uint wnx, uint wnz) {
+  int x_inc = increment.x == 0 ? 1 : increment.x;
+  int y_inc = increment.y == 0 ? 1 : increment.y;
+  int z_inc = increment.z == 0 ? 1 : increment.z;
+  // Same order as the receivers of a time step in the traces.
+  vector<pair<uint, uint>> receivers;
+  uint index = 0;
+  for (int iz = start.z; iz < end.z; iz += z_inc) {
+    for (int iy = start.y; iy < end.y; iy += y_inc) {
+      for (int ix = start.x; ix < end.x; ix += x_inc) {
+        receivers.emplace_back(iy * wnz * wnx + iz * wnx + ix, index);
+        if (index == 0) {
+          this->box.start = {(uint)ix, (uint)iz, (uint)iy};
+          this->box.end = this->box.start;
+        }
+        this->box.start.x = min(this->box.start.x, (uint)ix);
+        this->box.start.z = min(this->box.start.z, (uint)iz);
+        this->box.start.y = min(this->box.start.y, (uint)iy);
+        this->box.end.x = max(this->box.end.x, (uint)ix + 1);
+        this->box.end.z = max(this->box.end.z, (uint)iz + 1);
+        this->box.end.y = max(this->box.end.y, (uint)iy + 1);
+        index++;
+      }
+    }
+  }
+  stable_sort(receivers.begin(), receivers.end(),
+              [](const pair<uint, uint> &a, const pair<uint, uint> &b) {
+                return a.first < b.first;
+              });
+  this->offsets.resize(receivers.size());
+  this->indices.resize(receivers.size());
+  this->ordered = true;
+  for (uint i = 0; i < receivers.size(); i++) {
+    this->offsets[i] = receivers[i].first;
+    this->indices[i] = receivers[i].second;
+    if (receivers[i].second != i) {
+      this->ordered = false;
+    }
+  }
+  this->amplitudes.resize(this->ordered ? 0 : receivers.size());
+  this->injection.num_points = receivers.size();
+  this->injection.offsets = this->offsets.data();
+}
+
+InjectionList *ReceiverInjection::GetInjection(const float *trace_values) {
+  if (this->ordered) {
+    // The traces can be used as they are.
+    this->injection.amplitudes = trace_values;
+  } else {
+    int num_points = this->injection.num_points;
+    float *values = this->amplitudes.data();
+    const uint *receiver_indices = this->indices.data();
+#pragma omp parallel for if (num_points > 4096)
+    for (int i = 0; i < num_points; i++) {
+      values[i] = trace_values[receiver_indices[i]];
+    }
+    this->injection.amplitudes = values;
+  }
+  return &this->injection;
+}
+
+bool ReceiverInjection::GetBox(ActiveBox *box) {
+  if (this->injection.num_points == 0) {
+    return false;
+  }
+  *box = this->box;
+  return true;
+}
+
+void AddInjection(const InjectionList *injection, float *frame) {
+  int num_points = injection->num_points;
+  const uint *offsets = injection->offsets;
+  const float *amplitudes = injection->amplitudes;
+#pragma omp parallel for if (num_points > 4096)
+  for (int i = 0; i < num_points; i++) {
+    frame[offsets[i]] += amplitudes[i];
+  }
+}
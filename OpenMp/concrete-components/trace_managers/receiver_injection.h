@@ -0,0 +1,72 @@
+#ifndef ACOUSTIC2ND_RTM_RECEIVER_INJECTION_H
+#define ACOUSTIC2ND_RTM_RECEIVER_INJECTION_H
+
+#include <skeleton/base/datatypes.h>
+#include <vector>
+
+/*!
+ * Builds the injection lists of the traces of a shot for the computation
+ * kernel, from the receivers laid out the way the trace managers read them.
+ */
+class ReceiverInjection {
+private:
+  // The offsets of the receivers in the window, sorted.
+  std::vector<uint> offsets;
+  // The index in the traces of a time step of each of the sorted receivers.
+  std::vector<uint> indices;
+  std::vector<float> amplitudes;
+  // Whether the sorted receivers are in the same order as in the traces.
+  bool ordered;
+  InjectionList injection;
+  // The box enclosing the receivers, in the window.
+  ActiveBox box;
+
+public:
+  ReceiverInjection();
+
+  /*!
+   * Sets the receivers of the shot, should be called each time the receivers
+   * or the window change.
+   * @param start
+   * The first receiver, in the window.
+   * @param end
+   * The end of the receivers(exclusive), in the window.
+   * @param increment
+   * The step between the receivers, 0 being treated as 1.
+   * @param wnx
+   * The window size in x.
+   * @param wnz
+   * The window size in z.
+   */
+  void SetReceivers(IPoint3D start, IPoint3D end, IPoint3D increment,
+                    uint wnx, uint wnz);
+
+  /*!
+   * @param trace_values
+   * The values of all the receivers at the injected time step, in the order
+   * of the traces.
+   * @return
+   * The injection list of the given values, valid till the next call.
+   */
+  InjectionList *GetInjection(const float *trace_values);
+
+  /*!
+   * @param box
+   * Set to the box enclosing the receivers, in the window.
+   * @return
+   * False if there are no receivers.
+   */
+  bool GetBox(ActiveBox *box);
+};
+
+/*!
+ * Adds the amplitudes of an injection list to a frame, in parallel over its
+ * points as the receivers never share an offset.
+ * @param injection
+ * The injection list to add.
+ * @param frame
+ * The float frame of the window to add it to.
+ */
+void AddInjection(const InjectionList *injection, float *frame);
+
+#endif // ACOUSTIC2ND_RTM_RECEIVER_INJECTION_H
@@ -14,7 +14,6 @@ SeismicTraceManager::SeismicTraceManager() {
   traces = new Traces();
   traces->traces = nullptr;
   this->trace_file = nullptr;
-  sio = nullptr;
   IO = new SEGYIOManager();
 }
 
@@ -33,10 +32,12 @@ Point3D SeismicTraceManager::SDeLocalizePoint(Point3D point, bool is_2D,
                                               uint half_length,
                                               uint bound_length) {
   Point3D copy;
-  copy.x = point.x + half_length + bound_length;
-  copy.z = point.z + half_length + bound_length;
+  // The points are given in the model, the grids only hold the window.
+  WindowSize *window = &grid->window_size;
+  copy.x = point.x + half_length + bound_length - window->window_start.x;
+  copy.z = point.z + half_length + bound_length - window->window_start.z;
   if (!is_2D) {
-    copy.y = point.y + half_length + bound_length;
+    copy.y = point.y + half_length + bound_length - window->window_start.y;
   } else {
     copy.y = point.y;
   }
@@ -47,10 +48,12 @@ IPoint3D SeismicTraceManager::DeLocalizePointS(IPoint3D point, bool is_2D,
                                                uint half_length,
                                                uint bound_length) {
   IPoint3D copy;
-  copy.x = point.x + half_length + bound_length;
-  copy.z = point.z + half_length + bound_length;
+  // The points are given in the model, the grids only hold the window.
+  WindowSize *window = &grid->window_size;
+  copy.x = point.x + half_length + bound_length - window->window_start.x;
+  copy.z = point.z + half_length + bound_length - window->window_start.z;
   if (!is_2D) {
-    copy.y = point.y + half_length + bound_length;
+    copy.y = point.y + half_length + bound_length - window->window_start.y;
   } else {
     copy.y = point.y;
   }
@@ -82,25 +85,44 @@ void SeismicTraceManager::ReadShot(vector<string> filenames, uint shot_number, s
     std::cout << "Reading trace: " << file_name << " for shot ID " << shot_number
               << std::endl;
   }
-  sio = new SeIO();
-  IO->ReadSelectiveDataFromFile(file_name, sort_key, sio, shot_number);
+  // The traces of the shot are converted straight from the mapped file, at
+  // their ranges in the index of the file.
+  if (mapped_file.GetFileName() != file_name &&
+      !mapped_file.Open(file_name)) {
+    std::cout << "Could not map the trace file " << file_name << std::endl;
+    std::cout << "Terminating..." << std::endl;
+    exit(0);
+  }
+  vector<pair<size_t, size_t>> ranges =
+      IO->GetIndex(file_name, sort_key)->GetRanges(shot_number);
+  vector<SegyTraceHeader> headers;
+  for (auto &range : ranges) {
+    for (size_t i = 0; i < range.second; i++) {
+      headers.push_back(mapped_file.GetHeader(range.first + i));
+    }
+  }
+  float *samples = (float *)mem_allocate(
+      sizeof(float), headers.size() * mapped_file.GetSampleCount(),
+      "shot_samples");
+  mapped_file.ReadSamples(ranges, samples);
+  // The traces carry no depth of the source and receivers.
+  const int depth = 0;
 
-  float scale = abs(sio->Atraces.at(0).TraceMetaData.scalar) * 1.0;
+  float scale = abs(headers.at(0).scalco()) * 1.0;
 
   // cout << "you are ere " << endl;
-  this->source_point.x = (sio->Atraces.at(0).TraceMetaData.source_location_x) /
-                         (grid->cell_dimensions.dx * scale);
-  this->source_point.z = (sio->Atraces.at(0).TraceMetaData.source_location_z) /
-                         (grid->cell_dimensions.dz * scale);
-  this->source_point.y = (sio->Atraces.at(0).TraceMetaData.source_location_y) /
-                         (grid->cell_dimensions.dy * scale);
+  this->source_point.x =
+      headers.at(0).sx() / (grid->cell_dimensions.dx * scale);
+  this->source_point.z = depth / (grid->cell_dimensions.dz * scale);
+  this->source_point.y =
+      headers.at(0).sy() / (grid->cell_dimensions.dy * scale);
 
-  traces->sample_dt = sio->DM.dt;
+  traces->sample_dt = mapped_file.GetBinaryHeader().hdt / (float)1000000;
 
   this->absolute_shot_num++;
 
-  int sample_nt = sio->DM.nt;
-  int total_rec_num = sio->Atraces.size();
+  int sample_nt = mapped_file.GetSampleCount();
+  int total_rec_num = headers.size();
 
   //cout << "sample nt " << sample_nt << endl;
 
@@ -112,38 +134,26 @@ void SeismicTraceManager::ReadShot(vector<string> filenames, uint shot_number, s
   IPoint3D last;
   IPoint3D second;
 
-  first.x = (sio->Atraces.at(0).TraceMetaData.receiver_location_x -
-             (int)grid->reference_point.x) /
+  first.x = (headers.at(0).gx() - (int)grid->reference_point.x) /
             (grid->cell_dimensions.dx * scale);
-  first.y = (sio->Atraces.at(0).TraceMetaData.receiver_location_y -
-             (int)grid->reference_point.y) /
+  first.y = (headers.at(0).gy() - (int)grid->reference_point.y) /
             (grid->cell_dimensions.dy * scale);
-  first.z = (sio->Atraces.at(0).TraceMetaData.receiver_location_z -
-             (int)grid->reference_point.z) /
+  first.z = (depth - (int)grid->reference_point.z) /
             (grid->cell_dimensions.dz * scale);
 
-  second.x = (sio->Atraces.at(1).TraceMetaData.receiver_location_x -
-              (int)grid->reference_point.x) /
+  second.x = (headers.at(1).gx() - (int)grid->reference_point.x) /
              (grid->cell_dimensions.dx * scale);
-  second.y = (sio->Atraces.at(1).TraceMetaData.receiver_location_y -
-              (int)grid->reference_point.y) /
+  second.y = (headers.at(1).gy() - (int)grid->reference_point.y) /
              (grid->cell_dimensions.dy * scale);
-  second.z = (sio->Atraces.at(1).TraceMetaData.receiver_location_z -
-              (int)grid->reference_point.z) /
+  second.z = (depth - (int)grid->reference_point.z) /
              (grid->cell_dimensions.dz * scale);
 
-  last.x =
-      (sio->Atraces.at(total_rec_num - 1).TraceMetaData.receiver_location_x -
-       (int)grid->reference_point.x) /
-      (grid->cell_dimensions.dx * scale);
-  last.y =
-      (sio->Atraces.at(total_rec_num - 1).TraceMetaData.receiver_location_y -
-       (int)grid->reference_point.y) /
-      (grid->cell_dimensions.dy * scale);
-  last.z =
-      (sio->Atraces.at(total_rec_num - 1).TraceMetaData.receiver_location_z -
-       (int)grid->reference_point.z) /
-      (grid->cell_dimensions.dz * scale);
+  last.x = (headers.at(total_rec_num - 1).gx() - (int)grid->reference_point.x) /
+           (grid->cell_dimensions.dx * scale);
+  last.y = (headers.at(total_rec_num - 1).gy() - (int)grid->reference_point.y) /
+           (grid->cell_dimensions.dy * scale);
+  last.z = (depth - (int)grid->reference_point.z) /
+           (grid->cell_dimensions.dz * scale);
 
   // setting the start and the end of the x locations of the receivers
 
@@ -287,7 +297,7 @@ void SeismicTraceManager::ReadShot(vector<string> filenames, uint shot_number, s
 
           index++;
 
-          value = sio->Atraces.at(iy * num_rec_x + ix).TraceData[t];
+          value = samples[(size_t)(iy * num_rec_x + ix) * sample_nt + t];
 
           traces->traces[t * num_elements_per_time_step + index] = value;
         }
@@ -303,22 +313,18 @@ void SeismicTraceManager::ReadShot(vector<string> filenames, uint shot_number, s
 
   total_time = sample_nt * traces->sample_dt;
 
-  r_start.x = (sio->Atraces.at(rec_start_y * num_rec_x + rec_start_x)
-                   .TraceMetaData.receiver_location_x -
+  r_start.x = (headers.at(rec_start_y * num_rec_x + rec_start_x).gx() -
                (int)grid->reference_point.x) /
               (grid->cell_dimensions.dx * scale);
-  r_start.y = (sio->Atraces.at(rec_start_y * num_rec_x + rec_start_x)
-                   .TraceMetaData.receiver_location_y -
+  r_start.y = (headers.at(rec_start_y * num_rec_x + rec_start_x).gy() -
                (int)grid->reference_point.y) /
               (grid->cell_dimensions.dy * scale);
   r_start.z = rec_start_z;
 
-  r_end.x = (sio->Atraces.at((rec_end_y - 1) * num_rec_x + rec_end_x - 1)
-                 .TraceMetaData.receiver_location_x -
+  r_end.x = (headers.at((rec_end_y - 1) * num_rec_x + rec_end_x - 1).gx() -
              (int)grid->reference_point.x) /
             (grid->cell_dimensions.dx * scale);
-  r_end.y = (sio->Atraces.at((rec_end_y - 1) * num_rec_x + rec_end_x - 1)
-                 .TraceMetaData.receiver_location_y -
+  r_end.y = (headers.at((rec_end_y - 1) * num_rec_x + rec_end_x - 1).gy() -
              (int)grid->reference_point.y) /
             (grid->cell_dimensions.dy * scale);
   r_end.z = rec_end_z;
@@ -326,7 +332,7 @@ void SeismicTraceManager::ReadShot(vector<string> filenames, uint shot_number, s
   if (r_end.y == 0) {
     r_end.y = 1;
   }
-  delete sio;
+  mem_free(samples);
 }
 void SeismicTraceManager::PreprocessShot(uint cut_off_timestep) {
   bool is_2D = grid->grid_size.ny == 1;
@@ -394,31 +400,40 @@ void SeismicTraceManager::PreprocessShot(uint cut_off_timestep) {
   //
   //        delete[] travel_times;
   //    }
+  // The receivers are now in the window, build their injection.
+  this->receiver_injection.SetReceivers(r_start, r_end, r_inc, wnx,
+                                        grid->window_size.window_nz);
 }
 
 void SeismicTraceManager::ApplyTraces(uint time_step) {
-  int x_inc = r_inc.x == 0 ? 1 : r_inc.x;
-  int y_inc = r_inc.y == 0 ? 1 : r_inc.y;
-  int z_inc = r_inc.z == 0 ? 1 : r_inc.z;
-  int trace_size = traces->trace_size_per_timestep;
-  int wnx = grid->window_size.window_nx;
-  int wnz_wnx = grid->window_size.window_nz * wnx;
-  int index = 0;
-  float current_time = (time_step - 1) * grid->dt;
+  // The receivers are added through their injection list, in parallel.
+  AddInjection(this->GetInjection(time_step), grid->pressure_current);
+}
 
+InjectionList *SeismicTraceManager::GetInjection(uint time_step) {
+  float current_time = (time_step - 1) * grid->dt;
   uint trace_step = uint(current_time / traces->sample_dt);
   trace_step = min(trace_step, traces->sample_nt - 1);
+  return this->receiver_injection.GetInjection(
+      traces->traces + trace_step * traces->trace_size_per_timestep);
+}
 
-  for (int iz = r_start.z; iz < r_end.z; iz += z_inc) {
-    for (int iy = r_start.y; iy < r_end.y; iy += y_inc) {
-      for (int ix = r_start.x; ix < r_end.x; ix += x_inc) {
-        int offset = iy * wnz_wnx + iz * wnx + ix;
-        grid->pressure_current[offset] +=
-            traces->traces[(trace_step)*trace_size + index];
-        index++;
-      }
-    }
-  }
+bool SeismicTraceManager::GetReceiverBox(ActiveBox *box) {
+  return this->receiver_injection.GetBox(box);
+}
+
+bool SeismicTraceManager::GetShotBox(ActiveBox *box) {
+  // The points are still in the model, shift them to the full grid. The end
+  // receivers are included.
+  int offset = parameters->half_length + parameters->boundary_length;
+  int offset_y = grid->grid_size.ny == 1 ? 0 : offset;
+  box->start.x = max(0, min((int)source_point.x, r_start.x)) + offset;
+  box->start.z = max(0, min((int)source_point.z, r_start.z)) + offset;
+  box->start.y = max(0, min((int)source_point.y, r_start.y)) + offset_y;
+  box->end.x = max((int)source_point.x, r_end.x) + 1 + offset;
+  box->end.z = max((int)source_point.z, r_end.z) + 1 + offset;
+  box->end.y = max((int)source_point.y, r_end.y) + 1 + offset_y;
+  return true;
 }
 
 Traces *SeismicTraceManager::GetTraces() { return traces; }
@@ -450,4 +465,8 @@ vector<uint> SeismicTraceManager::GetWorkingShots(vector<string> filenames, uint
         }
     }
     return all_shots;
-}
\ No newline at end of file
+}
+
+bool SeismicTraceManager::SupportsShotBatch() { return true; }
+
+bool SeismicTraceManager::SupportsNarrowWavefields() { return true; }
@@ -6,8 +6,10 @@
 #define ACOUSTIC2ND_RTM_SEISMIC_TRACE_MANAGER_H
 #include <IO/io_manager.h>
 #include <Segy/segy_io_manager.h>
+#include <Segy/segy_mapped_file.h>
 #include <concrete-components/data_units/acoustic_openmp_computation_parameters.h>
 #include <concrete-components/data_units/acoustic_second_grid.h>
+#include <concrete-components/trace_managers/receiver_injection.h>
 #include <datatypes.h>
 #include <fstream>
 #include <skeleton/components/trace_manager.h>
@@ -24,6 +26,7 @@ class SeismicTraceManager : public TraceManager {
   GridBox *grid;
   AcousticOmpComputationParameters *parameters;
   Point3D source_point;
+  ReceiverInjection receiver_injection;
 
   Point3D SDeLocalizePoint(Point3D point, bool is_2D, uint half_length,
                            uint bound_length);
@@ -40,9 +43,15 @@ public:
   void ReadShot(vector<string> filenames, uint shot_number, string sort_key) override;
   void PreprocessShot(uint cut_off_timestep) override;
   void ApplyTraces(uint time_step) override;
+  InjectionList *GetInjection(uint time_step) override;
+  bool GetReceiverBox(ActiveBox *box) override;
+  bool GetShotBox(ActiveBox *box) override;
   Traces *GetTraces() override;
   void SetComputationParameters(ComputationParameters *parameters) override;
   void SetGridBox(GridBox *grid_box) override;
+  bool SupportsShotBatch() override;
+
+  bool SupportsNarrowWavefields() override;
   Point3D *GetSourcePoint() override;
   vector<uint> GetWorkingShots(vector<string> filenames, uint min_shot, uint max_shot, string type) override;
 
@@ -50,8 +59,9 @@ public:
   // uint bound_length);
 
 private:
-  IOManager *IO;
-  SeIO *sio;
+  SEGYIOManager *IO;
+  // The trace file of the last shot read, kept mapped for the next shots.
+  SegyMappedFile mapped_file;
   unordered_map<uint, string> shot_to_file_mapping;
 };
 
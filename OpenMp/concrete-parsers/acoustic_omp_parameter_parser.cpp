@@ -2,6 +2,7 @@
 // Created by amr on 12/12/2019.
 //
 
+#include <concrete-components/computation_kernels/simd/simd_stencil.h>
 #include <concrete-components/data_units/acoustic_openmp_computation_parameters.h>
 #include <fstream>
 #include <iostream>
@@ -21,6 +22,50 @@ void PrintParameters(AcousticOmpComputationParameters *parameters) {
   cout << "\tblock factor in x-direction : " << parameters->block_x << endl;
   cout << "\tblock factor in z-direction : " << parameters->block_z << endl;
   cout << "\tblock factor in y-direction : " << parameters->block_y << endl;
+  cout << "\ttemporal block factor : " << parameters->temporal_block << endl;
+  cout << "\tstencil instruction set : " << GetSimdIsaName(parameters->simd_isa)
+       << endl;
+  if (parameters->autotune) {
+    cout << "\tblock factors autotuning cache : " << parameters->autotune_cache
+         << endl;
+    cout << "\tblock factors autotuning covers the plain stencil only, "
+            "without the fused injection and imaging, the temporal blocking "
+            "or the narrow wavefields"
+         << endl;
+  }
+  if (parameters->narrow_wavefields) {
+    cout << "\twavefields precision : "
+         << GetStoragePrecisionName(parameters->wavefield_precision) << endl;
+    cout << "\twavefields precision only applies to the three propagation "
+            "with random or no boundaries and the fused correlation, the "
+            "frames keep their fp32 allocation"
+         << endl;
+  }
+  if (parameters->active_region) {
+    cout << "\tactive region margin : " << parameters->active_region_margin
+         << endl;
+  }
+  if (parameters->shot_window) {
+    cout << "\tshot window aperture in x-direction : "
+         << parameters->window_aperture_x << endl;
+    cout << "\tshot window aperture in y-direction : "
+         << parameters->window_aperture_y << endl;
+  }
+  if (parameters->concurrent_shots > 1) {
+    cout << "\t# of concurrent shots : " << parameters->concurrent_shots
+         << endl;
+  }
+  if (parameters->shot_batch > 1) {
+    cout << "\t# of shots per batch : " << parameters->shot_batch << endl;
+  }
+  if (parameters->shot_prefetch > 0) {
+    cout << "\t# of shots read ahead : " << parameters->shot_prefetch << endl;
+  }
+  if (parameters->imaging_step == 0) {
+    cout << "\timaging step : auto" << endl;
+  } else if (parameters->imaging_step > 1) {
+    cout << "\timaging step : " << parameters->imaging_step << endl;
+  }
   cout << endl;
 }
 
@@ -33,6 +78,20 @@ ComputationParameters *ParseParameterFile(string &file_name) {
   cout << "Parsing acoustic OpenMP computation properties..." << endl;
   string temp_line;
   int boundary_length = -1, block_x = -1, block_z = -1, block_y = -1,order = -1;
+  int temporal_block = 1;
+  SIMD_ISA simd_isa = ISA_AUTO;
+  bool autotune = false;
+  string autotune_cache;
+  bool active_region = false;
+  int active_region_margin = 10;
+  bool shot_window = false;
+  int window_aperture_x = 0;
+  int window_aperture_y = 0;
+  int concurrent_shots = 1;
+  int shot_batch = 1;
+  int shot_prefetch = 0;
+  int imaging_step = 1;
+  STORAGE_PRECISION wavefield_precision = STORAGE_FP32;
     int n_threads;
 #pragma omp parallel
     {
@@ -126,6 +185,137 @@ ComputationParameters *ParseParameterFile(string &file_name) {
       } else {
         block_y = value;
       }
+    } else if (key == "temporal-block") {
+      int value = stoi(value_s);
+      if (value <= 0) {
+        cout << "Invalid value entered for temporal block factor : must be "
+                "positive..."
+             << endl;
+      } else {
+        temporal_block = value;
+      }
+    } else if (key == "simd") {
+      if (value_s == "auto") {
+        simd_isa = ISA_AUTO;
+      } else if (value_s == "avx512") {
+        simd_isa = ISA_AVX512;
+      } else if (value_s == "avx2") {
+        simd_isa = ISA_AVX2;
+      } else if (value_s == "scalar") {
+        simd_isa = ISA_SCALAR;
+      } else {
+        cout << "Invalid value entered for stencil instruction set : must be "
+                "auto, avx512, avx2 or scalar..."
+             << endl;
+      }
+    } else if (key == "autotune") {
+      if (value_s == "yes") {
+        autotune = true;
+      } else if (value_s == "no") {
+        autotune = false;
+      } else {
+        cout << "Invalid value entered for autotune : must be yes or no..."
+             << endl;
+      }
+    } else if (key == "autotune-cache") {
+      autotune_cache = value_s;
+    } else if (key == "active-region") {
+      if (value_s == "yes") {
+        active_region = true;
+      } else if (value_s == "no") {
+        active_region = false;
+      } else {
+        cout << "Invalid value entered for active region : must be yes or "
+                "no..."
+             << endl;
+      }
+    } else if (key == "active-region-margin") {
+      int value = stoi(value_s);
+      if (value < 0) {
+        cout << "Invalid value entered for active region margin : must be "
+                "positive or zero..."
+             << endl;
+      } else {
+        active_region_margin = value;
+      }
+    } else if (key == "shot-window") {
+      if (value_s == "yes") {
+        shot_window = true;
+      } else if (value_s == "no") {
+        shot_window = false;
+      } else {
+        cout << "Invalid value entered for shot window : must be yes or no..."
+             << endl;
+      }
+    } else if (key == "window-aperture-x") {
+      int value = stoi(value_s);
+      if (value < 0) {
+        cout << "Invalid value entered for window aperture in x-direction : "
+                "must be positive or zero..."
+             << endl;
+      } else {
+        window_aperture_x = value;
+      }
+    } else if (key == "window-aperture-y") {
+      int value = stoi(value_s);
+      if (value < 0) {
+        cout << "Invalid value entered for window aperture in y-direction : "
+                "must be positive or zero..."
+             << endl;
+      } else {
+        window_aperture_y = value;
+      }
+    } else if (key == "concurrent-shots") {
+      int value = stoi(value_s);
+      if (value <= 0) {
+        cout << "Invalid value entered for concurrent shots : must be "
+                "positive..."
+             << endl;
+      } else {
+        concurrent_shots = value;
+      }
+    } else if (key == "shot-batch") {
+      int value = stoi(value_s);
+      if (value <= 0) {
+        cout << "Invalid value entered for shot batch : must be positive..."
+             << endl;
+      } else {
+        shot_batch = value;
+      }
+    } else if (key == "shot-prefetch") {
+      int value = stoi(value_s);
+      if (value < 0) {
+        cout << "Invalid value entered for shot prefetch : must be positive "
+                "or zero..."
+             << endl;
+      } else {
+        shot_prefetch = value;
+      }
+    } else if (key == "imaging-step") {
+      if (value_s == "auto") {
+        imaging_step = 0;
+      } else {
+        int value = stoi(value_s);
+        if (value <= 0) {
+          cout << "Invalid value entered for imaging step : must be positive "
+                  "or auto..."
+               << endl;
+        } else {
+          imaging_step = value;
+        }
+      }
+    } else if (key == "wavefield-precision") {
+      if (value_s == "fp32") {
+        wavefield_precision = STORAGE_FP32;
+      } else if (value_s == "fp16") {
+        wavefield_precision = STORAGE_FP16;
+      } else if (value_s == "bf16") {
+        wavefield_precision = STORAGE_BF16;
+      } else {
+        cout << "Invalid value entered for wavefield precision : must be "
+                "fp32, fp16 or bf16..."
+             << endl;
+      }
     }
   }
   if (order == -1) {
@@ -149,6 +339,38 @@ ComputationParameters *ParseParameterFile(string &file_name) {
          << endl;
     dt_relax = 0.4;
   }
+  if (concurrent_shots > n_threads) {
+    cout << "Concurrent shots can't exceed the # of threads, using "
+         << n_threads << " concurrent shots" << endl;
+    concurrent_shots = n_threads;
+  }
+  if (shot_batch > 1 && concurrent_shots > 1) {
+    cout << "Concurrent shots aren't supported with shot batching, migrating "
+            "one batch at a time"
+         << endl;
+    concurrent_shots = 1;
+  }
+  if (shot_prefetch > 0 && (concurrent_shots > 1 || shot_batch > 1)) {
+    cout << "Shot prefetching isn't supported with concurrent shots or shot "
+            "batching, reading each shot when it is migrated"
+         << endl;
+    shot_prefetch = 0;
+  }
+  // The engine and the kernel fall back to single time steps otherwise.
+  if (temporal_block > 1 &&
+      (shot_batch > 1 || wavefield_precision != STORAGE_FP32)) {
+    cout << "Notice : temporal-block has no effect with shot batching or "
+            "narrow wavefields"
+         << endl;
+  } else if (temporal_block > 1) {
+    cout << "Notice : temporal-block only advances the forward time steps "
+            "whose wavefields aren't saved by the forward collector (three, "
+            "or two with imaging-step above 1 or interior-only) and the "
+            "backward time steps that aren't imaged (imaging-step above 1), "
+            "with the random, sponge or no boundaries, it has no effect with "
+            "cpml"
+         << endl;
+  }
   if (block_x == -1) {
     cout << "No valid value provided for key 'block-x'..." << endl;
     cout << "Using default blocking factor in x-direction of 560" << endl;
@@ -172,6 +394,23 @@ ComputationParameters *ParseParameterFile(string &file_name) {
   parameters->block_x = block_x;
   parameters->block_z = block_z;
   parameters->block_y = block_y;
+  parameters->temporal_block = temporal_block;
+  parameters->simd_isa = simd_isa;
+  parameters->autotune = autotune;
+  parameters->active_region = active_region;
+  parameters->active_region_margin = active_region_margin;
+  parameters->shot_window = shot_window;
+  parameters->window_aperture_x = window_aperture_x;
+  parameters->window_aperture_y = window_aperture_y;
+  parameters->concurrent_shots = concurrent_shots;
+  parameters->shot_batch = shot_batch;
+  parameters->shot_prefetch = shot_prefetch;
+  parameters->imaging_step = imaging_step;
+  parameters->wavefield_precision = wavefield_precision;
+  parameters->narrow_wavefields = wavefield_precision != STORAGE_FP32;
+  if (!autotune_cache.empty()) {
+    parameters->autotune_cache = autotune_cache;
+  }
   PrintParameters(parameters);
   omp_set_num_threads(parameters->n_threads);
   return parameters;
@@ -4,21 +4,66 @@
 
 #include "correlation_kernel_parser.h"
 
+// The frequency domain correlation kernel only works with the forward
+// collector of the same name.
+static CorrelationKernel *parse_frequency_domain(ConfigMap &map) {
+  if (map["forward-collector"] != "frequency-domain") {
+    cout << "The frequency-domain correlation kernel needs the "
+            "frequency-domain forward collector"
+         << endl;
+    cout << "Terminating..." << endl;
+    exit(0);
+  }
+  cout << "Using the frequency domain cross-correlation as correlation "
+          "kernel..."
+       << endl;
+  return new FrequencyCorrelationKernel();
+}
+
+// The excitation time correlation kernel only works with the forward
+// collector of the same name.
+static CorrelationKernel *parse_excitation_time(ConfigMap &map) {
+  if (map["forward-collector"] != "excitation-time") {
+    cout << "The excitation-time correlation kernel needs the "
+            "excitation-time forward collector"
+         << endl;
+    cout << "Terminating..." << endl;
+    exit(0);
+  }
+  cout << "Using the excitation time imaging condition as correlation "
+          "kernel..."
+       << endl;
+  return new ExcitationCorrelationKernel();
+}
+
 CorrelationKernel *
 parse_correlation_kernel_acoustic_iso_openmp_second(ConfigMap map) {
   CorrelationKernel *correlation_kernel = nullptr;
   if (map.find("correlation-kernel") == map.end()) {
     cout << "No entry for correlation-kernel key : supported values [ "
-            "cross-correlation ]"
+            "cross-correlation | frequency-domain | excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
   } else if (map["correlation-kernel"] == "cross-correlation") {
-    correlation_kernel = new CrossCorrelationKernel();
+    bool fused = false;
+    if (map.find("correlation-kernel.fused") != map.end()) {
+      if (map["correlation-kernel.fused"] == "yes") {
+        fused = true;
+        cout << "Fusing the correlation into the backward propagation. To "
+                "disable it set <correlation-kernel.fused=no>"
+             << endl;
+      }
+    }
+    correlation_kernel = new CrossCorrelationKernel(fused);
     cout << "Using Cross-Correlation as correlation kernel..." << endl;
+  } else if (map["correlation-kernel"] == "frequency-domain") {
+    correlation_kernel = parse_frequency_domain(map);
+  } else if (map["correlation-kernel"] == "excitation-time") {
+    correlation_kernel = parse_excitation_time(map);
   } else {
     cout << "Invalid value for correlation-kernel key : supported values [ "
-            "cross-correlation ]"
+            "cross-correlation | frequency-domain | excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
@@ -31,16 +76,20 @@ parse_correlation_kernel_acoustic_iso_openmp_first(ConfigMap map) {
   CorrelationKernel *correlation_kernel = nullptr;
   if (map.find("correlation-kernel") == map.end()) {
     cout << "No entry for correlation-kernel key : supported values [ "
-            "cross-correlation ]"
+            "cross-correlation | frequency-domain | excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
   } else if (map["correlation-kernel"] == "cross-correlation") {
     correlation_kernel = new CrossCorrelationKernel();
     cout << "Using Cross-Correlation as correlation kernel..." << endl;
+  } else if (map["correlation-kernel"] == "frequency-domain") {
+    correlation_kernel = parse_frequency_domain(map);
+  } else if (map["correlation-kernel"] == "excitation-time") {
+    correlation_kernel = parse_excitation_time(map);
   } else {
     cout << "Invalid value for correlation-kernel key : supported values [ "
-            "cross-correlation ]"
+            "cross-correlation | frequency-domain | excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
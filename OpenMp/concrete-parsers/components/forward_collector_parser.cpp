@@ -2,6 +2,243 @@
 // Created by amr on 25/01/2020.
 //
 #include "forward_collector_parser.h"
+#include "boundary_manager_parser.h"
+
+// The memory budget of the forward wavefields, or of the saved boundaries, in
+// bytes, 0 for the available memory.
+static size_t parse_memory_budget(ConfigMap &map) {
+  size_t memory_budget = 0;
+  if (map.find("forward-collector.memory-budget") != map.end()) {
+    int value = stoi(map["forward-collector.memory-budget"]);
+    if (value < 1) {
+      cout << "Invalid value for forward-collector.memory-budget key : it "
+              "should be a positive number of MB"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+    memory_budget = (size_t)value * 1024 * 1024;
+    cout << "\tMemory budget of the forward wavefields : " << value << " MB"
+         << endl;
+  }
+  return memory_budget;
+}
+
+// The precision of the forward wavefields of the two propagation the memory
+// budget can't hold in fp32.
+static STORAGE_PRECISION parse_compressed_tier(ConfigMap &map) {
+  STORAGE_PRECISION compressed_tier = STORAGE_FP32;
+  if (map.find("forward-collector.compressed-tier") != map.end()) {
+    string value = map["forward-collector.compressed-tier"];
+    if (value == "none") {
+      compressed_tier = STORAGE_FP32;
+    } else if (value == "fp16") {
+      compressed_tier = STORAGE_FP16;
+    } else if (value == "bf16") {
+      compressed_tier = STORAGE_BF16;
+    } else {
+      cout << "Invalid value for forward-collector.compressed-tier key : "
+              "supported values [ none | fp16 | bf16 ]"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+  }
+  return compressed_tier;
+}
+
+// The bits per value of the forward wavefields compressed in memory by the
+// fixed rate mode of zfp.
+static double parse_zfp_rate(ConfigMap &map) {
+  double zfp_rate = 8;
+  if (map.find("forward-collector.zfp-rate") != map.end()) {
+    zfp_rate = stod(map["forward-collector.zfp-rate"]);
+    if (zfp_rate <= 0 || zfp_rate > 32) {
+      cout << "Invalid value for forward-collector.zfp-rate key : it should be "
+              "a number of bits per value in ]0, 32]"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+  }
+  if (!zfp::FixedRateCodec::IsAvailable()) {
+    cout << "Notice : zfp isn't part of the build, storing the forward "
+            "wavefields out of the memory in fp16 instead"
+         << endl;
+    return 0;
+  }
+  cout << "\tZFP fixed rate : " << zfp_rate << " bits per value" << endl;
+  return zfp_rate;
+}
+
+// The codec of the two propagation with compression.
+static SNAPSHOT_CODEC parse_compression_codec(ConfigMap &map) {
+  string codec = "zfp";
+  if (map.find("forward-collector.codec") != map.end()) {
+    codec = map["forward-collector.codec"];
+    if (codec != "zfp" && codec != "bfp") {
+      cout << "Invalid value for forward-collector.codec key : supported "
+              "values [ zfp | bfp ]"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+  }
+  if (codec == "zfp" && !zfp::isZFPAvailable()) {
+    cout << "Notice : zfp isn't part of the build, using the built in bfp "
+            "codec instead"
+         << endl;
+    codec = "bfp";
+  }
+  cout << "\tCompression codec : " << codec << endl;
+  if (codec == "bfp") {
+    return SNAPSHOT_BFP;
+  }
+  return SNAPSHOT_ZFP;
+}
+
+// Whether the two propagation only stores the imaging region of the forward
+// wavefields.
+static bool parse_interior(ConfigMap &map) {
+  bool interior = false;
+  if (map.find("forward-collector.interior-only") != map.end()) {
+    string value = map["forward-collector.interior-only"];
+    if (value != "yes" && value != "no") {
+      cout << "Invalid value for forward-collector.interior-only key : "
+              "supported values [ yes | no ]"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+    interior = value == "yes";
+  }
+  if (interior) {
+    cout << "\tStoring the imaging region of the forward wavefields only"
+         << endl;
+  }
+  return interior;
+}
+
+// The codec of the boundaries saved by the boundary saving, with the absolute
+// error of bfp.
+static BOUNDARY_CODEC parse_boundary_codec(ConfigMap &map, double &tolerance) {
+  BOUNDARY_CODEC codec = BOUNDARY_RAW;
+  if (map.find("forward-collector.boundary-codec") != map.end()) {
+    string value = map["forward-collector.boundary-codec"];
+    if (value == "none") {
+      codec = BOUNDARY_RAW;
+    } else if (value == "fp16") {
+      codec = BOUNDARY_FP16;
+    } else if (value == "bfp") {
+      codec = BOUNDARY_BFP;
+    } else {
+      cout << "Invalid value for forward-collector.boundary-codec key : "
+              "supported values [ none | fp16 | bfp ]"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+  }
+  tolerance = 1e-6;
+  if (map.find("forward-collector.boundary-tolerance") != map.end()) {
+    tolerance = stod(map["forward-collector.boundary-tolerance"]);
+    if (tolerance <= 0) {
+      cout << "Invalid value for forward-collector.boundary-tolerance key : "
+              "it should be a positive error"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+  }
+  if (codec != BOUNDARY_RAW) {
+    cout << "\tStoring the boundaries in " << GetBoundaryCodecName(codec);
+    if (codec == BOUNDARY_BFP) {
+      cout << " with a tolerance of " << tolerance;
+    }
+    cout << endl;
+  }
+  return codec;
+}
+
+// The number of frequencies of the frequency domain collector, 0 to set it
+// from the duration of the shot, with its highest frequency in Hz, 0 for the
+// default one. It only works with the
+// correlation kernel of the same name.
+static uint parse_frequencies(ConfigMap &map, float &max_frequency) {
+  if (map["correlation-kernel"] != "frequency-domain") {
+    cout << "The frequency-domain forward collector needs the "
+            "frequency-domain correlation kernel"
+         << endl;
+    cout << "Terminating..." << endl;
+    exit(0);
+  }
+  uint frequency_count = 0;
+  if (map.find("forward-collector.frequencies") != map.end() &&
+      map["forward-collector.frequencies"] != "auto") {
+    int value = stoi(map["forward-collector.frequencies"]);
+    if (value < 1) {
+      cout << "Invalid value for forward-collector.frequencies key : it "
+              "should be auto or a positive number of frequencies"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+    frequency_count = value;
+  }
+  max_frequency = 0;
+  if (map.find("forward-collector.max-frequency") != map.end()) {
+    max_frequency = stof(map["forward-collector.max-frequency"]);
+    if (max_frequency <= 0) {
+      cout << "Invalid value for forward-collector.max-frequency key : it "
+              "should be a positive frequency in Hz"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+  }
+  cout << "\tAccumulating ";
+  if (frequency_count > 0) {
+    cout << frequency_count;
+  } else {
+    cout << "enough";
+  }
+  cout << " frequencies up to ";
+  if (max_frequency > 0) {
+    cout << max_frequency << " Hz" << endl;
+  } else {
+    cout << "three times the source frequency" << endl;
+  }
+  return frequency_count;
+}
+
+// Whether the excitation time collector normalizes the image by the
+// excitation amplitudes. It only works with the correlation kernel of the
+// same name.
+static bool parse_excitation_amplitude(ConfigMap &map) {
+  if (map["correlation-kernel"] != "excitation-time") {
+    cout << "The excitation-time forward collector needs the "
+            "excitation-time correlation kernel"
+         << endl;
+    cout << "Terminating..." << endl;
+    exit(0);
+  }
+  bool normalized = false;
+  if (map.find("forward-collector.excitation-amplitude") != map.end()) {
+    string value = map["forward-collector.excitation-amplitude"];
+    if (value != "yes" && value != "no") {
+      cout << "Invalid value for forward-collector.excitation-amplitude key : "
+              "supported values [ yes | no ]"
+           << endl;
+      cout << "Terminating..." << endl;
+      exit(0);
+    }
+    normalized = value == "yes";
+  }
+  if (normalized) {
+    cout << "\tNormalizing the image by the excitation amplitudes" << endl;
+  }
+  return normalized;
+}
 
 ForwardCollector *
 parse_forward_collector_acoustic_iso_openmp_second(ConfigMap map,
@@ -9,13 +246,49 @@ parse_forward_collector_acoustic_iso_openmp_second(ConfigMap map,
   ForwardCollector *forward_collector = nullptr;
   if (map.find("forward-collector") == map.end()) {
     cout << "No entry for forward-collector key : supported values [ two | "
-            "three | two-compression | optimal-checkpointing ]"
+            "three | two-compression | two-memory-compression | "
+            "optimal-checkpointing | boundary-saving | frequency-domain | "
+            "excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
   } else if (map["forward-collector"] == "two") {
-    forward_collector = new TwoPropagation(false, write_path);
+    STORAGE_PRECISION precision = STORAGE_FP32;
+    bool precision_report = false;
+    if (map.find("forward-collector.precision") != map.end()) {
+      string value = map["forward-collector.precision"];
+      if (value == "fp32") {
+        precision = STORAGE_FP32;
+      } else if (value == "fp16") {
+        precision = STORAGE_FP16;
+      } else if (value == "bf16") {
+        precision = STORAGE_BF16;
+      } else {
+        cout << "Invalid value for forward-collector.precision key : "
+                "supported values [ fp32 | fp16 | bf16 ]"
+             << endl;
+        cout << "Terminating..." << endl;
+        exit(0);
+      }
+    }
+    if (map.find("forward-collector.precision-report") != map.end()) {
+      precision_report = map["forward-collector.precision-report"] == "yes";
+    }
     cout << "Using two propagation mechanism..." << endl;
+    SnapshotOptions options;
+    options.precision = precision;
+    options.precision_report = precision_report;
+    options.memory_budget = parse_memory_budget(map);
+    options.compressed_tier = parse_compressed_tier(map);
+    options.interior = parse_interior(map);
+    forward_collector = new TwoPropagation(write_path, options);
+    if (precision != STORAGE_FP32) {
+      cout << "\tStoring the forward wavefields in "
+           << GetStoragePrecisionName(precision) << endl;
+    } else if (options.compressed_tier != STORAGE_FP32) {
+      cout << "\tStoring the forward wavefields out of the memory budget in "
+           << GetStoragePrecisionName(options.compressed_tier) << endl;
+    }
   } else if (map["forward-collector"] == "three") {
     forward_collector =
         new ReversePropagation(new SecondOrderComputationKernel());
@@ -54,19 +327,87 @@ parse_forward_collector_acoustic_iso_openmp_second(ConfigMap map,
       }
       zfp_is_relative = relative == 1;
     }
-    forward_collector = new TwoPropagation(true, write_path, zfp_tolerance,
-                                           zfp_parallel, zfp_is_relative);
     cout << "Using two propagation with compression mechanism..." << endl;
+    SnapshotOptions options;
+    options.codec = parse_compression_codec(map);
+    options.tolerance = zfp_tolerance;
+    options.zfp_parallel = zfp_parallel == 1;
+    options.zfp_is_relative = zfp_is_relative;
+    options.memory_budget = parse_memory_budget(map);
+    options.interior = parse_interior(map);
+    forward_collector = new TwoPropagation(write_path, options);
+    if (options.memory_budget != 0) {
+      cout << "\tCompressing the forward wavefields the memory budget can't "
+              "hold"
+           << endl;
+    }
     cout << "\tZFP tolerance : " << zfp_tolerance << endl;
-    cout << "\tZFP parallel use : " << zfp_parallel << endl;
+    if (options.codec == SNAPSHOT_ZFP) {
+      cout << "\tZFP parallel use : " << zfp_parallel << endl;
+    }
     cout << "\tZFP use relative error : " << zfp_is_relative << endl;
+  } else if (map["forward-collector"] == "two-memory-compression") {
+    bool precision_report = false;
+    if (map.find("forward-collector.precision-report") != map.end()) {
+      precision_report = map["forward-collector.precision-report"] == "yes";
+    }
+    cout << "Using two propagation with in memory compression mechanism..."
+         << endl;
+    SnapshotOptions options;
+    options.precision_report = precision_report;
+    options.memory_budget = parse_memory_budget(map);
+    options.zfp_rate = parse_zfp_rate(map);
+    // Without zfp the wavefields the memory can't hold in fp32 are stored in
+    // fp16.
+    options.compressed_tier =
+        options.zfp_rate > 0 ? STORAGE_FP32 : STORAGE_FP16;
+    // The wavefields are only compressed in memory.
+    options.spill = false;
+    options.interior = parse_interior(map);
+    forward_collector = new TwoPropagation(write_path, options);
   } else if (map["forward-collector"] == "optimal-checkpointing") {
-    forward_collector =
-        new ReverseInjectionPropagation(new SecondOrderComputationKernel());
+    uint checkpoints = 20;
+    if (map.find("forward-collector.checkpoints") != map.end()) {
+      int value = stoi(map["forward-collector.checkpoints"]);
+      if (value < 1) {
+        cout << "Invalid value for forward-collector.checkpoints key : it "
+                "should be a positive number of checkpoints"
+             << endl;
+        cout << "Terminating..." << endl;
+        exit(0);
+      }
+      checkpoints = value;
+    }
+    cout << "Using optimal checkpointing mechanism..." << endl;
+    cout << "\tMaximum number of checkpoints : " << checkpoints << endl;
+    cout << "\tRecomputing the forward propagation with its own boundary :"
+         << endl;
+    forward_collector = new CheckpointPropagation(
+        new SecondOrderComputationKernel(),
+        parse_boundary_manager_acoustic_iso_openmp_second(map), checkpoints);
+  } else if (map["forward-collector"] == "boundary-saving") {
     cout << "Using three propagation with boundary saving mechanism..." << endl;
+    size_t memory_budget = parse_memory_budget(map);
+    double tolerance;
+    BOUNDARY_CODEC codec = parse_boundary_codec(map, tolerance);
+    forward_collector = new ReverseInjectionPropagation(
+        new SecondOrderComputationKernel(), write_path, memory_budget, codec,
+        tolerance);
+  } else if (map["forward-collector"] == "frequency-domain") {
+    cout << "Using frequency domain mechanism..." << endl;
+    float max_frequency;
+    uint frequency_count = parse_frequencies(map, max_frequency);
+    forward_collector =
+        new FrequencyPropagation(frequency_count, max_frequency);
+  } else if (map["forward-collector"] == "excitation-time") {
+    cout << "Using excitation time mechanism..." << endl;
+    bool normalized = parse_excitation_amplitude(map);
+    forward_collector = new ExcitationPropagation(normalized);
   } else {
     cout << "Invalid value for forward-collector key : supported values [ two "
-            "| three | two-compression | optimal-checkpointing ]"
+            "| three | two-compression | two-memory-compression | "
+            "optimal-checkpointing | boundary-saving | frequency-domain | "
+            "excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
@@ -80,13 +421,23 @@ parse_forward_collector_acoustic_iso_openmp_first(ConfigMap map,
   ForwardCollector *forward_collector = nullptr;
   if (map.find("forward-collector") == map.end()) {
     cout << "No entry for forward-collector key : supported values [ two | "
-            "three | two-compression | optimal-checkpointing ]"
+            "three | two-compression | two-memory-compression | "
+            "optimal-checkpointing | boundary-saving | frequency-domain | "
+            "excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
   } else if (map["forward-collector"] == "two") {
-    forward_collector = new StaggeredTwoPropagation(false, write_path);
     cout << "Using two propagation mechanism..." << endl;
+    SnapshotOptions options;
+    options.memory_budget = parse_memory_budget(map);
+    options.compressed_tier = parse_compressed_tier(map);
+    options.interior = parse_interior(map);
+    forward_collector = new StaggeredTwoPropagation(write_path, options);
+    if (options.compressed_tier != STORAGE_FP32) {
+      cout << "\tStoring the forward wavefields out of the memory budget in "
+           << GetStoragePrecisionName(options.compressed_tier) << endl;
+    }
   } else if (map["forward-collector"] == "three") {
     forward_collector =
         new StaggeredReversePropagation(new StaggeredComputationKernel(false));
@@ -125,19 +476,68 @@ parse_forward_collector_acoustic_iso_openmp_first(ConfigMap map,
       }
       zfp_is_relative = relative == 1;
     }
-    forward_collector = new StaggeredTwoPropagation(
-        true, write_path, zfp_tolerance, zfp_parallel, zfp_is_relative);
     cout << "Using two propagation with compression mechanism..." << endl;
+    SnapshotOptions options;
+    options.codec = parse_compression_codec(map);
+    options.tolerance = zfp_tolerance;
+    options.zfp_parallel = zfp_parallel == 1;
+    options.zfp_is_relative = zfp_is_relative;
+    options.memory_budget = parse_memory_budget(map);
+    options.interior = parse_interior(map);
+    forward_collector = new StaggeredTwoPropagation(write_path, options);
+    if (options.memory_budget != 0) {
+      cout << "\tCompressing the forward wavefields the memory budget can't "
+              "hold"
+           << endl;
+    }
     cout << "\tZFP tolerance : " << zfp_tolerance << endl;
-    cout << "\tZFP parallel use : " << zfp_parallel << endl;
+    if (options.codec == SNAPSHOT_ZFP) {
+      cout << "\tZFP parallel use : " << zfp_parallel << endl;
+    }
     cout << "\tZFP use relative error : " << zfp_is_relative << endl;
-  } else if (map["forward-collector"] == "optimal-checkpointing") {
-    forward_collector = new StaggeredReverseInjectionPropagation(
-        new StaggeredComputationKernel(false));
+  } else if (map["forward-collector"] == "two-memory-compression") {
+    cout << "Using two propagation with in memory compression mechanism..."
+         << endl;
+    SnapshotOptions options;
+    options.memory_budget = parse_memory_budget(map);
+    options.zfp_rate = parse_zfp_rate(map);
+    // Without zfp the wavefields the memory can't hold in fp32 are stored in
+    // fp16.
+    options.compressed_tier =
+        options.zfp_rate > 0 ? STORAGE_FP32 : STORAGE_FP16;
+    // The wavefields are only compressed in memory.
+    options.spill = false;
+    options.interior = parse_interior(map);
+    forward_collector = new StaggeredTwoPropagation(write_path, options);
+  } else if (map["forward-collector"] == "optimal-checkpointing" ||
+             map["forward-collector"] == "boundary-saving") {
+    if (map["forward-collector"] == "optimal-checkpointing") {
+      cout << "Optimal checkpointing not supported by the first order, using "
+              "boundary saving instead"
+           << endl;
+    }
     cout << "Using three propagation with boundary saving mechanism..." << endl;
+    size_t memory_budget = parse_memory_budget(map);
+    double tolerance;
+    BOUNDARY_CODEC codec = parse_boundary_codec(map, tolerance);
+    forward_collector = new StaggeredReverseInjectionPropagation(
+        new StaggeredComputationKernel(false), write_path, memory_budget, codec,
+        tolerance);
+  } else if (map["forward-collector"] == "frequency-domain") {
+    cout << "Using frequency domain mechanism..." << endl;
+    float max_frequency;
+    uint frequency_count = parse_frequencies(map, max_frequency);
+    forward_collector =
+        new StaggeredFrequencyPropagation(frequency_count, max_frequency);
+  } else if (map["forward-collector"] == "excitation-time") {
+    cout << "Using excitation time mechanism..." << endl;
+    bool normalized = parse_excitation_amplitude(map);
+    forward_collector = new StaggeredExcitationPropagation(normalized);
   } else {
     cout << "Invalid value for forward-collector key : supported values [ two "
-            "| three | two-compression | optimal-checkpointing ]"
+            "| three | two-compression | two-memory-compression | "
+            "optimal-checkpointing | boundary-saving | frequency-domain | "
+            "excitation-time ]"
          << endl;
     cout << "Terminating..." << endl;
     exit(0);
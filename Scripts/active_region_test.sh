@@ -0,0 +1,30 @@
+#!/bin/bash
+# Checks that restricting the time steps to the active region of the shot
+# doesn't change the image, with the collectors storing and reconstructing the
+# forward wavefields.
+# Usage : active_region_test.sh <acoustic_engine> <acoustic_modeller> <compare_binary>
+if [[ $# -ne 3 ]] ; then
+    echo 'Usage : active_region_test.sh <acoustic_engine> <acoustic_modeller> <compare_binary>'
+    exit 1
+fi
+engine=$1
+modeller=$2
+compare=$3
+#The maximum relative L2 error between the images.
+tolerance=1e-5
+source "$(dirname "$0")/test_workload.sh" "$modeller"
+
+failed=0
+for collector in three two;do
+	sed "s/^forward-collector=.*/forward-collector=$collector/" "$run/rtm_configuration.txt" > "$run/$collector.txt"
+	cp "$run/computation_parameters.txt" "$run/$collector-active.txt"
+	echo "active-region=yes" >> "$run/$collector-active.txt"
+	for parameters in computation_parameters $collector-active;do
+		$engine -p "$run/$parameters.txt" -s "$run/$collector.txt" \
+		        -c "$run/callback_configuration.txt" -w "$run/$parameters-$collector" > "$run/$parameters-$collector.log" || exit 1
+	done
+	echo "Active region with the $collector propagation :"
+	$compare "$run/computation_parameters-$collector/raw_binary/migration.bin" \
+	         "$run/$collector-active-$collector/raw_binary/migration.bin" $tolerance || failed=1
+done
+exit $failed
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Sourced by the migration tests : sets up a shorter shot of the homogeneous
+# workload, only writing the migration, in a temporary directory removed on
+# exit, then models its traces.
+# Usage : source test_workload.sh <acoustic_modeller>
+# Sets : run, the directory of the workload.
+cd "$(dirname "${BASH_SOURCE[0]}")/.." || exit 1
+run=$(mktemp -d)
+trap 'rm -rf "$run"' EXIT
+
+workload=./workloads/homogeneous_model
+cp $workload/computation_parameters.txt $workload/rtm_configuration.txt \
+   $workload/modelling_configuration.txt $workload/modelling.txt "$run"
+echo "./data/big_velocity.csv" > "$run/models.txt"
+printf "none\nnone\n$run/shot.trace\n" > "$run/traces.txt"
+sed -i "s/simulation_time=.*/simulation_time=0.8/" "$run/modelling.txt"
+sed -i "s#^trace-file=.*#trace-file=$run/shot.trace#; s#^modelling-configuration-file=.*#modelling-configuration-file=$run/modelling.txt#; s#^models-list=.*#models-list=$run/models.txt#" "$run/modelling_configuration.txt"
+sed -i "s#^traces-list=.*#traces-list=$run/traces.txt#; s#^models-list=.*#models-list=$run/models.txt#" "$run/rtm_configuration.txt"
+cat > "$run/callback_configuration.txt" << EOT
+enable-binary=yes
+write_migration=yes
+binary.show_each=200
+EOT
+
+$1 -p "$run/computation_parameters.txt" -s "$run/modelling_configuration.txt" \
+   -c "$run/callback_configuration.txt" -w "$run/modelling" > "$run/modelling.log" || exit 1
@@ -0,0 +1,31 @@
+#!/bin/bash
+# Checks that the image of the wavefields propagated in fp16 and bf16 stays
+# close to the fp32 one.
+# Usage : wavefield_precision_test.sh <acoustic_engine> <acoustic_modeller> <compare_binary>
+if [[ $# -ne 3 ]] ; then
+    echo 'Usage : wavefield_precision_test.sh <acoustic_engine> <acoustic_modeller> <compare_binary>'
+    exit 1
+fi
+engine=$1
+modeller=$2
+compare=$3
+source "$(dirname "$0")/test_workload.sh" "$modeller"
+
+#The narrow wavefields need the imaging fused in the computation kernel.
+sed -i "s/^forward-collector=.*/forward-collector=three/; s/^correlation-kernel=.*/correlation-kernel=cross-correlation\ncorrelation-kernel.fused=yes/" "$run/rtm_configuration.txt"
+failed=0
+for precision in fp32 fp16 bf16;do
+	cp "$run/computation_parameters.txt" "$run/$precision.txt"
+	echo "wavefield-precision=$precision" >> "$run/$precision.txt"
+	$engine -p "$run/$precision.txt" -s "$run/rtm_configuration.txt" \
+	        -c "$run/callback_configuration.txt" -w "$run/$precision" > "$run/$precision.log" || exit 1
+done
+#The maximum relative L2 error of each precision, a few units of its rounding.
+for test in fp16:5e-3 bf16:3e-2;do
+	precision=${test%:*}
+	grep -q "Narrow wavefields not supported" "$run/$precision.log" && { echo "$precision wavefields not used"; failed=1; }
+	echo "Wavefields in $precision :"
+	$compare "$run/fp32/raw_binary/migration.bin" \
+	         "$run/$precision/raw_binary/migration.bin" ${test#*:} || failed=1
+done
+exit $failed
@@ -20,10 +20,24 @@ int main(int argc, char *argv[]) {
   parse_args_engine(parameter_file, configuration_file, callback_file,
                     write_path, argc, argv, message.c_str());
   ComputationParameters *p = ParseParameterFile(parameter_file);
-  EngineConfiguration *rtm_configuration =
-      parse_rtm_configuration(configuration_file, write_path);
+  vector<EngineConfiguration *> rtm_configurations;
+  rtm_configurations.push_back(
+      parse_rtm_configuration(configuration_file, write_path));
+  // The other shots migrated at the same time write their temporary files in
+  // their own directories, the other shots of a batch only use the trace
+  // manager and source injector of their configuration, like the shots read
+  // ahead.
+  uint shots_at_once =
+      max(max(p->concurrent_shots, p->shot_batch), p->shot_prefetch + 1);
+  string shot_path = p->shot_batch > 1      ? "/batch_shot_"
+                     : p->shot_prefetch > 0 ? "/prefetch_shot_"
+                                            : "/concurrent_shot_";
+  for (uint i = 1; i < shots_at_once; i++) {
+    rtm_configurations.push_back(parse_rtm_configuration(
+        configuration_file, write_path + shot_path + to_string(i)));
+  }
   CallbackCollection *cbs = parse_callbacks(callback_file, write_path);
-  RTMEngine engine(rtm_configuration, p, cbs);
+  RTMEngine engine(rtm_configurations, p, cbs);
   MigrationData *mig;
   cout << "Detecting available shots for processing..." << std::endl;
   Timer *timer = Timer::getInstance();
@@ -36,7 +50,8 @@ int main(int argc, char *argv[]) {
   }
   cout << "Valid shots detected to process : " << possible_shots.size() << std::endl;
   mig = engine.Migrate(possible_shots);
-  float *filtered_migration = new float[mig->nx * mig->nz * mig->ny];
+  // The filter doesn't write the borders of the image.
+  float *filtered_migration = new float[mig->nx * mig->nz * mig->ny]();
   timer->start_timer("Engine::FilterMigration");
   filter_stacked_correlation(mig->stacked_correlation, filtered_migration,
           mig->nx, mig->nz, mig->ny,
@@ -50,7 +65,9 @@ int main(int argc, char *argv[]) {
   cout <<endl<<"Timings of the application are: "<<endl;
   cout <<"------------------------------"<<endl;
   timer->export_to_file(write_path + "/timing_results.txt",1);
-  delete rtm_configuration;
+  for (EngineConfiguration *rtm_configuration : rtm_configurations) {
+    delete rtm_configuration;
+  }
   delete cbs;
   delete p;
   return 0;
@@ -61,6 +61,32 @@ typedef struct {
   float total_time;
 } ModellingConfiguration;
 
+// The points of the window a source or the traces add values to at a time step.
+typedef struct {
+  // The number of injected points.
+  uint num_points;
+  // The offsets of the points in the window, sorted in ascending order.
+  const uint *offsets;
+  // The values to add to each of the points.
+  const float *amplitudes;
+} InjectionList;
+
+// A box of the window, from the start point inclusive to the end point
+// exclusive.
+typedef struct {
+  Point3D start;
+  Point3D end;
+} ActiveBox;
+
+typedef struct {
+  // The frame to correlate with, in the same window as the computed frame.
+  const float *source;
+  // The image accumulating the correlation, of the full grid size.
+  float *image;
+  // The region of the window to correlate, nullptr for the whole window.
+  const ActiveBox *region;
+} FusedImaging;
+
 // Structure containing the available traces information.
 typedef struct {
   float *traces;
@@ -116,6 +142,42 @@ public:
   float *first_derivative_staggered_fd_coeff;
   // is the stability condition safety /relaxation factor
   float dt_relax;
+  // the maximum number of time steps the engine asks the computation kernel
+  // to advance at once (temporal blocking), 1 disables it.
+  uint temporal_block;
+  // whether the engine restricts the computations of each time step to the
+  // box around the source/receivers that the waves could have reached.
+  bool active_region;
+  // the number of grid points the active box is grown by on top of the
+  // distance traveled at the maximum velocity.
+  uint active_region_margin;
+  // whether each shot only propagates in a window of the model around its
+  // source and receivers instead of the whole model.
+  bool shot_window;
+  // the number of grid points the window of each shot extends beyond its
+  // source and receivers in the x and y directions, the boundary is added on
+  // top of it.
+  uint window_aperture_x;
+  uint window_aperture_y;
+  // the number of shots migrated at the same time, each by its own engine
+  // configuration on its share of the threads, 1 migrates them one by one.
+  uint concurrent_shots;
+  // the number of shots propagated together in lockstep, their wavefields are
+  // interleaved in the frames with the shots innermost, 1 propagates them one
+  // by one.
+  uint shot_batch;
+  // the number of shots read and preprocessed ahead by a helper thread while
+  // the current shot propagates, 0 reads each shot when it is migrated.
+  uint shot_prefetch;
+  // the number of time steps between the forward wavefields stored and
+  // correlated with the backward ones, 1 images every time step and 0 derives
+  // it from the source frequency and dt once the model is read.
+  uint imaging_step;
+  // whether the frames of the wavefields hold 16 bit values instead of
+  // floats, only accessed through the computation kernel which computes in
+  // fp32 : the components must support it, see
+  // Component::SupportsNarrowWavefields.
+  bool narrow_wavefields;
 
   // the constructor of the class, it takes as input the half_length
   explicit ComputationParameters(HALF_LENGTH hl) {
@@ -124,6 +186,17 @@ public:
     boundary_length = 20;
     half_length = hl;
     dt_relax = 0.4;
+    temporal_block = 1;
+    active_region = false;
+    active_region_margin = 10;
+    shot_window = false;
+    window_aperture_x = 0;
+    window_aperture_y = 0;
+    concurrent_shots = 1;
+    shot_batch = 1;
+    shot_prefetch = 0;
+    imaging_step = 1;
+    narrow_wavefields = false;
     // array of floats of size hl+1 only contains the zero and positive (x>0 )
     // coefficients and not all coefficients
     second_derivative_fd_coeff = new float[hl + 1];
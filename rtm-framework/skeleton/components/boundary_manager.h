@@ -46,6 +46,51 @@ public:
    * backward propagation of each shot.
    */
   virtual void AdjustModelForBackward() = 0;
+  /*!
+   * Whether ApplyBoundary modifies the wavefields. Boundary managers that only
+   * act on the model (eg: random boundaries) return false, allowing the
+   * computation kernels to advance several time-steps without calling it.
+   */
+  virtual bool AltersWavefield() { return true; }
+  /*!
+   * Whether ApplyBoundary only scales each point of the current frame by a
+   * factor fixed for the window (eg: the sponge), that the computation kernels
+   * advancing several time-steps at once can apply themselves, see GetDamping.
+   */
+  virtual bool DampsWavefield() { return false; }
+  /*!
+   * Fills the given frame of the window with the factor ApplyBoundary scales
+   * each of its points by, only called if DampsWavefield returns true.
+   */
+  virtual void GetDamping(float *damping) {}
+  /*!
+   * Whether ReExtendModel or AdjustModelForBackward modify the model of a shot
+   * using the whole grid (eg: the top layer). If not, the model is only read
+   * during the shots, so that the shots migrated at the same time can share it.
+   */
+  virtual bool AltersModel() { return true; }
+  /*!
+   * Restricts ApplyBoundary to the given box of the window, outside of which
+   * the wavefields are zero. The box should stay valid till the next call,
+   * nullptr for the whole window.
+   */
+  virtual void SetActiveBox(const ActiveBox *box) {}
+  /*!
+   * The number of floats of the state carried by ApplyBoundary from a
+   * time-step to the next (eg: the auxiliary variables of the CPML), zero if
+   * it only depends on the current frames.
+   */
+  virtual uint GetStateSize() { return 0; }
+  /*!
+   * Copies the state carried between the time-steps to the given array of
+   * GetStateSize floats, so that the propagation can be resumed from it.
+   */
+  virtual void SaveState(float *state) {}
+  /*!
+   * Resumes from a state given by SaveState of a boundary manager of the same
+   * type and window.
+   */
+  virtual void RestoreState(const float *state) {}
 };
 
 #endif // RTM_FRAMEWORK_BOUNDARY_MANAGER_H
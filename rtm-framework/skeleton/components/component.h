@@ -27,6 +27,23 @@ public:
    * The designated grid box to run operations on.
    */
   virtual void SetGridBox(GridBox *grid_box) = 0;
+
+  /*!
+   * Whether the component handles frames holding several shots interleaved
+   * with the shots innermost, as set by the shot_batch parameter.
+   * @return
+   * True if the component supports shot batching, false by default.
+   */
+  virtual bool SupportsShotBatch() { return false; }
+
+  /*!
+   * Whether the component handles frames holding 16 bit wavefields, as set by
+   * the narrow_wavefields parameter : it must not access the frames itself,
+   * only through the computation kernel.
+   * @return
+   * True if the component supports narrow wavefields, false by default.
+   */
+  virtual bool SupportsNarrowWavefields() { return false; }
 };
 
 #endif // RTM_FRAMEWORK_COMPONENT_H
@@ -33,6 +33,82 @@ public:
    */
   virtual void Step() = 0;
 
+  /*!
+   * Advances the wave equation by the given number of time-steps. This is
+   * equivalent to calling Step() time_steps times with nothing applied to the
+   * wavefields in between but the injections given by SetInjection, which
+   * allows kernels supporting temporal blocking to advance each of their tiles
+   * several time-steps while it is in cache.
+   * @param time_steps
+   * The number of time-steps to advance.
+   */
+  virtual void MultiStep(uint time_steps) {
+    for (uint t = 0; t < time_steps; t++) {
+      this->Step();
+    }
+  }
+
+  /*!
+   * @return
+   * True if the kernel can apply an injection list while computing the
+   * time-step, see SetInjection.
+   */
+  virtual bool SupportsInjection() { return false; }
+
+  /*!
+   * Sets the injection to be applied by the next call to Step() : the
+   * amplitudes are added to the current frame by the threads of the step,
+   * before it is read by the stencil, instead of in a separate serial pass.
+   * The injection is only used by that single step. Before MultiStep(), it is
+   * called once for each of the time-steps, in order.
+   * @param injection
+   * The injection of the time-step being computed, copied by the kernel.
+   */
+  virtual void SetInjection(InjectionList *injection) {}
+
+  /*!
+   * @return
+   * True if the kernel can apply the cross correlation imaging condition while
+   * computing the time-step, see SetImaging.
+   */
+  virtual bool SupportsImaging() { return false; }
+
+  /*!
+   * Sets the imaging to be done by the next call to Step() : the product of the
+   * source frame and of the newly computed frame is added to the image as
+   * soon as each block of the frame is computed, before the boundary
+   * conditions are applied. The imaging is only used by that single step.
+   * @param imaging
+   * The frames of the imaging, they should stay valid till the step is done.
+   */
+  virtual void SetImaging(FusedImaging *imaging) {}
+
+  /*!
+   * @return
+   * True if the kernel can restrict its time-steps to a box of the window, see
+   * SetActiveBox.
+   */
+  virtual bool SupportsActiveBox() { return false; }
+
+  /*!
+   * Restricts the following time-steps to the given box of the window : the
+   * points outside of it are taken as zero. The kernel keeps them zero in the
+   * frames it computes up to the reach of the stencil around the box, so the
+   * box may grow by up to the half length of the stencil each time-step.
+   * @param box
+   * The box to compute, it should stay valid till the next call. nullptr for
+   * the whole window.
+   */
+  virtual void SetActiveBox(const ActiveBox *box) {}
+
+  /*!
+   * Prepares the kernel for a propagation on the current model, called once
+   * the model is set for it and before its first step : the kernels keeping
+   * their own copy of the velocity, like the one of the narrow wavefields,
+   * refresh it.
+   */
+  virtual void PreparePropagation() {}
+
   /*!
    * Set kernel boundary manager to be used and called internally.
    * @param boundary_manager
@@ -39,6 +39,23 @@ public:
    * interest is the current one.
    */
   virtual void Correlate(GridBox *in_1) = 0;
+  /*!
+   * Whether the correlation should be fused into the backward propagation :
+   * if the computation kernel supports it, the engine then has the kernel
+   * accumulate the product of the frames into GetShotCorrelation() while
+   * computing them, instead of calling Correlate.
+   * @return
+   * True if the correlation is a cross correlation that can be fused.
+   */
+  virtual bool IsFused() { return false; }
+
+  /*!
+   * Restricts Correlate to the given box of the window, outside of which one
+   * of the frames is zero. The box should stay valid till the next call,
+   * nullptr for the whole window.
+   */
+  virtual void SetActiveBox(const ActiveBox *box) {}
+
   /*!
    * @return
    * The pointer to the array that should contain the results of the correlation
@@ -51,6 +68,18 @@ public:
    * correlation of the frames of all shots.
    */
   virtual float *GetStackedShotCorrelation() = 0;
+  /*!
+   * Stacks the stacked correlation of another correlation kernel of the same
+   * grid into the stacked correlation, to reduce the results of the shots
+   * migrated at the same time.
+   * @param correlation
+   * The correlation kernel to stack the result of.
+   * @return
+   * False if not supported.
+   */
+  virtual bool StackCorrelation(CorrelationKernel *correlation) {
+    return false;
+  }
   /*!
    * @return
    * The pointer to the array that should contain the final results and details
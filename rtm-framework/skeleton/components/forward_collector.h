@@ -5,7 +5,9 @@
 #ifndef RTM_FRAMEWORK_FORWARD_COLLECTOR_H
 #define RTM_FRAMEWORK_FORWARD_COLLECTOR_H
 
+#include "boundary_manager.h"
 #include "component.h"
+#include "source_injector.h"
 #include <skeleton/base/datatypes.h>
 
 /*!
@@ -39,6 +41,44 @@ public:
    */
   virtual void SaveForward() = 0;
 
+  /*!
+   * Whether SaveForward needs to be called before the given time step of the
+   * forward propagation. Collectors that don't store the forward wavefield
+   * (eg: 3 propagation) return false, allowing the engine to advance several
+   * time steps at once.
+   * @param time_step
+   * The time step of the forward propagation.
+   */
+  virtual bool IsSaveRequired(uint time_step) { return true; }
+
+  /*!
+   * Called in place of the SaveForward calls the engine skipped, after
+   * advancing over the time steps IsSaveRequired returned false for.
+   * @param time_steps
+   * The number of skipped SaveForward calls.
+   */
+  virtual void SkipForward(uint time_steps) {}
+  /*!
+   * Called in place of the FetchForward calls of the time steps the backward
+   * propagation advanced over at once, none of which is imaged. They are
+   * fetched one by one by default.
+   * @param time_steps
+   * The number of skipped FetchForward calls.
+   */
+  virtual void SkipBackward(uint time_steps) {
+    for (uint t = 0; t < time_steps; t++) {
+      this->FetchForward();
+    }
+  }
+
+  /*!
+   * Whether the forward wavefields given to the backward propagation are
+   * reconstructed backward in time(eg: 3 propagation) rather than saved during
+   * the forward propagation. The reconstructed wavefields also hold the
+   * reconstruction noise, so they aren't bounded by the forward wavefront.
+   */
+  virtual bool IsReconstructed() { return false; }
+
   /*!
    * Resets the grid pressures or allocates new frames for the backward
    * propagation. It should either free or keep track of the old frames. it is
@@ -59,6 +99,14 @@ public:
    * calculated using fetch forward. this function is called on each time step.
    */
   virtual GridBox *GetForwardGrid() = 0;
+
+  /*!
+   * Gives the boundary manager and the source injector of the forward
+   * propagation, for the collectors recomputing parts of it. Called once after
+   * the initialization.
+   */
+  virtual void SetForwardComponents(BoundaryManager *boundary_manager,
+                                    SourceInjector *source_injector) {}
 };
 /*!example for the 3 propagation:
  * 1-Reset grid:
@@ -48,6 +48,33 @@ public:
    * The computation kernel to be used for first touch.
    */
   virtual void PreprocessModel(ComputationKernel *kernel) = 0;
+
+  /*!
+   * Gets the maximum velocity of the model in m/s, valid after PreprocessModel.
+   * @return
+   * The maximum velocity, 0 if not supported.
+   */
+  virtual float GetMaxVelocity() { return 0; }
+
+  /*!
+   * Creates a new GridBox with the model of a GridBox already pre-processed
+   * by another model handler, and its own frames allocated like in
+   * PreprocessModel, so that another shot can be migrated at the same time.
+   * The maximum velocity is the one of the other model handler.
+   * @param grid_box
+   * The pre-processed GridBox to take the model from.
+   * @param kernel
+   * The computation kernel to be used for first touch.
+   * @param share
+   * Whether the model arrays are shared with the given GridBox, they are
+   * copied otherwise.
+   * @return
+   * The new GridBox, nullptr if not supported.
+   */
+  virtual GridBox *CloneModel(GridBox *grid_box, ComputationKernel *kernel,
+                              bool share) {
+    return nullptr;
+  }
 };
 
 #endif // RTM_FRAMEWORK_MODEL_HANDLER_H
@@ -39,6 +39,18 @@ public:
    */
   virtual void ApplySource(uint time_step) = 0;
 
+  /*!
+   * Gets the source injection of the given time step as an injection list, so
+   * that the computation kernel can apply it instead of ApplySource.
+   * @param time_step
+   * The time step corresponding to the frame to inject, 1-based like in
+   * ApplySource.
+   * @return
+   * The injection list, valid till the next call. nullptr if not supported,
+   * the engine then uses ApplySource.
+   */
+  virtual InjectionList *GetInjection(uint time_step) { return nullptr; }
+
   /*!
    * Function to get the timestep that the source injection would stop after.
    * @return
@@ -61,6 +61,38 @@ public:
    */
   virtual void ApplyTraces(uint time_step) = 0;
 
+  /*!
+   * Gets the traces of the given time step as an injection list, so that the
+   * computation kernel can apply them instead of ApplyTraces.
+   * @param time_step
+   * The time step corresponding to the frame to inject, like in ApplyTraces.
+   * @return
+   * The injection list, valid till the next call. nullptr if not supported,
+   * the engine then uses ApplyTraces.
+   */
+  virtual InjectionList *GetInjection(uint time_step) { return nullptr; }
+
+  /*!
+   * Gets the box of the window enclosing all the receivers of the shot, valid
+   * after PreprocessShot.
+   * @param box
+   * Set to the box of the receivers.
+   * @return
+   * False if not supported.
+   */
+  virtual bool GetReceiverBox(ActiveBox *box) { return false; }
+
+  /*!
+   * Gets the box of the full grid enclosing the source and all the receivers
+   * of the shot, valid after ReadShot and before PreprocessShot so that the
+   * window of the shot can be set from it.
+   * @param box
+   * Set to the box of the shot, boundaries included in the coordinates.
+   * @return
+   * False if not supported, the shot then uses the whole grid.
+   */
+  virtual bool GetShotBox(ActiveBox *box) { return false; }
+
   /*!
   * Getter to the property containing the shot location source point
   * of the current read traces. This value should be set in the ReadShot
@@ -95,6 +95,13 @@ ModellingEngine::ModellingEngine(ModellingEngineConfiguration *configuration,
 GridBox *ModellingEngine::Initialize() {
   // start the timer and give it the name of function (Engine::Initialize)
   this->timer->start_timer("Engine::Initialize");
+  // The traces are written from the float frames.
+  if (this->parameters->narrow_wavefields) {
+    cout << "Narrow wavefields are only used by the migration, modelling in "
+            "fp32"
+         << endl;
+    this->parameters->narrow_wavefields = false;
+  }
 
   // set the ComputationParameters with the parameters given to the constructor
   // for all needed functions.
@@ -1,10 +1,18 @@
 //
 // Created by amrnasr on 20/10/2019.
 //
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
+#include <mutex>
+#include <omp.h>
+#include <queue>
 #include <skeleton/engine/rtm_engine.h>
 #include <skeleton/helpers/memory_allocation/memory_allocator.h>
+#include <thread>
 
 using namespace std;
 
@@ -25,6 +33,8 @@ RTMEngine::RTMEngine(EngineConfiguration *configuration,
   this->parameters = parameters;
   this->callbacks = new CallbackCollection();
   this->timer = Timer::getInstance();
+  this->active_velocity = 0;
+  this->show_progress = true;
 }
 
 RTMEngine::RTMEngine(EngineConfiguration *configuration,
@@ -34,6 +44,16 @@ RTMEngine::RTMEngine(EngineConfiguration *configuration,
   this->parameters = parameters;
   this->callbacks = cbs;
   this->timer = Timer::getInstance();
+  this->active_velocity = 0;
+  this->show_progress = true;
+}
+
+RTMEngine::RTMEngine(vector<EngineConfiguration *> configurations,
+                     ComputationParameters *parameters,
+                     CallbackCollection *cbs)
+    : RTMEngine(configurations[0], parameters, cbs) {
+  this->shot_configurations.assign(configurations.begin() + 1,
+                                   configurations.end());
 }
 
 vector<uint> RTMEngine::GetValidShots() {
@@ -46,81 +66,448 @@ MigrationData *RTMEngine::Migrate(vector<uint> shot_ids) {
 #ifndef NDEBUG
   this->callbacks->BeforeInitialization(parameters);
 #endif
+  // The frames are allocated for the batch by the initialization.
+  if (this->parameters->shot_batch > 1 && !this->SupportsShotBatch()) {
+    cout << "Shot batching not supported by the components, migrating the "
+            "shots one by one"
+         << endl;
+    this->parameters->shot_batch = 1;
+  }
+  if (this->parameters->narrow_wavefields) {
+    vector<string> blockers = this->GetNarrowWavefieldsBlockers();
+    if (!blockers.empty()) {
+      cout << "Narrow wavefields not supported by the";
+      for (uint i = 0; i < blockers.size(); i++) {
+        cout << (i == 0 ? " " : ", ") << blockers[i];
+      }
+      cout << ", propagating the wavefields in fp32" << endl;
+      cout << "\tThey need the three forward collector, random or no "
+              "boundaries and correlation-kernel.fused=yes, without shot "
+              "batching"
+           << endl;
+      this->parameters->narrow_wavefields = false;
+    }
+  }
   GridBox *grid_box = this->Initialize();
 
 #ifndef NDEBUG
   this->callbacks->AfterInitialization(grid_box);
 #endif
-  this->configuration->computation_kernel->SetBoundaryManager(
-      this->configuration->boundary_manager);
+  this->active_velocity = 0;
+  if (this->parameters->active_region) {
+    if (this->configuration->computation_kernel->SupportsActiveBox() &&
+        this->configuration->model_handler->GetMaxVelocity() > 0) {
+      this->active_velocity =
+          this->configuration->model_handler->GetMaxVelocity();
+      cout << "Restricting the time-steps to the active region of the shots"
+           << endl;
+    } else {
+      cout << "Active region not supported by the components, computing the "
+              "whole window"
+           << endl;
+    }
+  }
   cout << "Gridbox->dt : " << grid_box->dt << endl;
   cout << "Gridbox->nx : " << grid_box->grid_size.nx << endl;
   cout << "Gridbox->nz : " << grid_box->grid_size.nz << endl;
-  uint shot_num = 0;
-  for (uint shot_id : shot_ids) {
-    shot_num++;
-	  printf("Shot %d/%d\n",
-			  shot_num,
-			  shot_ids.size());
-	  this->configuration->correlation_kernel->ResetShotCorrelation();
-	  this->configuration->trace_manager->ReadShot(
-        this->configuration->trace_files, shot_id, this->configuration->sort_key);
+  this->SetImagingStep(grid_box);
+  if (this->parameters->shot_batch > 1) {
+    this->MigrateBatches(grid_box, shot_ids);
+  } else if (this->parameters->shot_prefetch > 0 && shot_ids.size() > 1) {
+    this->MigratePrefetched(grid_box, shot_ids);
+  } else if (this->parameters->concurrent_shots < 2 || shot_ids.size() < 2) {
+    // The configurations of the other shots of a batch that isn't supported
+    // are left unused.
+    uint shot_num = 0;
+    for (uint shot_id : shot_ids) {
+      shot_num++;
+      printf("Shot %d/%d\n", shot_num, shot_ids.size());
+      this->MigrateShot(grid_box, shot_id);
+    }
+  } else {
+    this->MigrateConcurrently(grid_box, shot_ids);
+  }
 #ifndef NDEBUG
-    this->callbacks->BeforeShotPreprocessing(
-        this->configuration->trace_manager->GetTraces());
+  this->callbacks->AfterMigration(
+      this->configuration->correlation_kernel->GetStackedShotCorrelation(),
+      grid_box);
 #endif
-    this->configuration->trace_manager->PreprocessShot(
-        this->configuration->source_injector->GetCutOffTimestep());
+
+  this->timer->stop_timer("Engine::Migration");
+
+  MigrationData *migration =
+      this->configuration->correlation_kernel->GetMigrationData();
+
+  mem_free((void *)grid_box);
+
+  return migration;
+}
+
+void RTMEngine::MigrateShot(GridBox *grid_box, uint shot_id) {
+  this->configuration->correlation_kernel->ResetShotCorrelation();
+  this->configuration->trace_manager->ReadShot(
+      this->configuration->trace_files, shot_id, this->configuration->sort_key);
+  this->SetShotWindow(grid_box, this->configuration->trace_manager);
+#ifndef NDEBUG
+  this->callbacks->BeforeShotPreprocessing(
+      this->configuration->trace_manager->GetTraces());
+#endif
+  this->configuration->trace_manager->PreprocessShot(
+      this->configuration->source_injector->GetCutOffTimestep());
 // grid_box->nt=5000;
 #ifndef NDEBUG
-    this->callbacks->AfterShotPreprocessing(
-        this->configuration->trace_manager->GetTraces());
+  this->callbacks->AfterShotPreprocessing(
+      this->configuration->trace_manager->GetTraces());
 #endif
-    this->configuration->source_injector->SetSourcePoint(
-        this->configuration->trace_manager->GetSourcePoint());
-    this->configuration->boundary_manager->ReExtendModel();
-    this->configuration->forward_collector->ResetGrid(true);
+  this->PropagateShot(grid_box);
+}
+
+void RTMEngine::PropagateShot(GridBox *grid_box) {
+  this->configuration->source_injector->SetSourcePoint(
+      this->configuration->trace_manager->GetSourcePoint());
+  this->configuration->boundary_manager->ReExtendModel();
+  this->configuration->forward_collector->ResetGrid(true);
 
 #ifndef NDEBUG
-    this->callbacks->BeforeForwardPropagation(grid_box);
+  this->callbacks->BeforeForwardPropagation(grid_box);
 #endif
-    this->Forward(grid_box);
-    this->configuration->forward_collector->ResetGrid(false);
-    this->configuration->boundary_manager->AdjustModelForBackward();
+  this->Forward(grid_box);
+  this->configuration->forward_collector->ResetGrid(false);
+  this->configuration->boundary_manager->AdjustModelForBackward();
 #ifndef NDEBUG
-    this->callbacks->BeforeBackwardPropagation(grid_box);
+  this->callbacks->BeforeBackwardPropagation(grid_box);
 #endif
-    this->Backward(grid_box);
+  this->Backward(grid_box);
 #ifndef NDEBUG
-    this->callbacks->BeforeShotStacking(
-        this->configuration->correlation_kernel->GetShotCorrelation(),
-        grid_box);
+  this->callbacks->BeforeShotStacking(
+      this->configuration->correlation_kernel->GetShotCorrelation(), grid_box);
 #endif
-    this->configuration->correlation_kernel->Stack();
+  this->configuration->correlation_kernel->Stack();
 
 #ifndef NDEBUG
-    this->callbacks->AfterShotStacking(
-        this->configuration->correlation_kernel->GetStackedShotCorrelation(),
-        grid_box);
-#endif
-  }
-#ifndef NDEBUG
-  this->callbacks->AfterMigration(
+  this->callbacks->AfterShotStacking(
       this->configuration->correlation_kernel->GetStackedShotCorrelation(),
       grid_box);
 #endif
+}
 
-  this->timer->stop_timer("Engine::Migration");
+void RTMEngine::MigratePrefetched(GridBox *grid_box,
+                                  const vector<uint> &shot_ids) {
+  uint depth = this->shot_configurations.size();
+  uint cut_off = this->configuration->source_injector->GetCutOffTimestep();
+  // The shots read ahead set the number of time-steps and the window of
+  // their own copy of the grid box, copied to this one when handed over.
+  vector<GridBox> grids(depth, *grid_box);
+  // The slots free to read a shot into, and the ones holding the shots read
+  // in their order.
+  queue<uint> free_slots, read_slots;
+  for (uint i = 0; i < depth; i++) {
+    EngineConfiguration *config = this->shot_configurations[i];
+    config->trace_manager->SetComputationParameters(this->parameters);
+    // The trace managers find the files of the shots while listing them.
+    config->trace_manager->GetWorkingShots(config->trace_files,
+                                           config->sort_min, config->sort_max,
+                                           config->sort_key);
+    free_slots.push(i);
+  }
+  mutex slots_mutex;
+  condition_variable slots_changed;
+  cout << "Reading up to " << depth << " shots ahead" << endl;
+  thread reader([&]() {
+    // The reading only takes one thread from the propagation.
+    omp_set_num_threads(1);
+    for (uint shot_id : shot_ids) {
+      uint slot;
+      {
+        unique_lock<mutex> lock(slots_mutex);
+        slots_changed.wait(lock, [&]() { return !free_slots.empty(); });
+        slot = free_slots.front();
+        free_slots.pop();
+      }
+      EngineConfiguration *config = this->shot_configurations[slot];
+      config->trace_manager->SetGridBox(&grids[slot]);
+      config->trace_manager->ReadShot(config->trace_files, shot_id,
+                                      config->sort_key);
+      this->SetShotWindow(&grids[slot], config->trace_manager);
+      config->trace_manager->PreprocessShot(cut_off);
+      {
+        lock_guard<mutex> lock(slots_mutex);
+        read_slots.push(slot);
+      }
+      slots_changed.notify_all();
+    }
+  });
+  for (uint shot = 0; shot < shot_ids.size(); shot++) {
+    printf("Shot %d/%d\n", shot + 1, shot_ids.size());
+    uint slot;
+    {
+      unique_lock<mutex> lock(slots_mutex);
+      slots_changed.wait(lock, [&]() { return !read_slots.empty(); });
+      slot = read_slots.front();
+      read_slots.pop();
+    }
+    // The trace manager of the shot read takes the place of the one of the
+    // previous shot, which is given the slot to read the next shots.
+    swap(this->configuration->trace_manager,
+         this->shot_configurations[slot]->trace_manager);
+    grid_box->nt = grids[slot].nt;
+    grid_box->window_size = grids[slot].window_size;
+    this->configuration->trace_manager->SetGridBox(grid_box);
+    {
+      lock_guard<mutex> lock(slots_mutex);
+      free_slots.push(slot);
+    }
+    slots_changed.notify_all();
+    this->configuration->correlation_kernel->ResetShotCorrelation();
+    this->PropagateShot(grid_box);
+  }
+  reader.join();
+}
 
-  MigrationData *migration =
-      this->configuration->correlation_kernel->GetMigrationData();
+void RTMEngine::MigrateConcurrently(GridBox *grid_box,
+                                    const vector<uint> &shot_ids) {
+  uint engines_count = min(this->shot_configurations.size() + 1,
+                           shot_ids.size());
+  int threads = omp_get_max_threads();
+  int engine_threads = max(1, threads / (int)engines_count);
+  // The shots only read the model if it has no window and no boundary that
+  // is changed for each shot.
+  bool share = !this->parameters->shot_window &&
+               !this->configuration->boundary_manager->AltersModel();
+  cout << "Migrating " << engines_count << " shots at the same time on "
+       << engine_threads << " threads each, "
+       << (share ? "sharing the model" : "each with its own copy of the model")
+       << endl;
+  // The other engines are initialized one after the other, with the threads
+  // they migrate with so that the memory is touched by them.
+  vector<RTMEngine *> engines = {this};
+  vector<GridBox *> grids = {grid_box};
+  omp_set_num_threads(engine_threads);
+  for (uint i = 1; i < engines_count; i++) {
+    auto *engine =
+        new RTMEngine(this->shot_configurations[i - 1], this->parameters);
+    engine->active_velocity = this->active_velocity;
+    engine->show_progress = false;
+    grids.push_back(engine->Initialize(grid_box, share));
+    engines.push_back(engine);
+  }
+  this->show_progress = false;
+  atomic<uint> next_shot(0);
+  mutex print_mutex;
+  vector<thread> workers;
+  for (uint i = 0; i < engines_count; i++) {
+    workers.emplace_back([&, i]() {
+      omp_set_num_threads(engine_threads);
+      for (uint shot = next_shot++; shot < shot_ids.size();
+           shot = next_shot++) {
+        {
+          lock_guard<mutex> lock(print_mutex);
+          printf("Shot %d/%d\n", shot + 1, shot_ids.size());
+        }
+        engines[i]->MigrateShot(grids[i], shot_ids[shot]);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  omp_set_num_threads(threads);
+  this->show_progress = true;
+  for (uint i = 1; i < engines_count; i++) {
+    if (!this->configuration->correlation_kernel->StackCorrelation(
+            engines[i]->configuration->correlation_kernel)) {
+      cout << "The correlation kernel doesn't support stacking the results "
+              "of the concurrent shots..."
+           << endl;
+      exit(-1);
+    }
+    mem_free((void *)grids[i]);
+    delete engines[i];
+  }
+}
 
-  mem_free((void *)grid_box);
+bool RTMEngine::SupportsShotBatch() {
+  // The batched shots share the grid, so none of them may have a window.
+  uint batch = this->parameters->shot_batch;
+  if (this->parameters->shot_window ||
+      this->shot_configurations.size() + 1 < batch) {
+    return false;
+  }
+  EngineConfiguration *config = this->configuration;
+  vector<Component *> components = {
+      config->trace_manager,     config->boundary_manager,
+      config->computation_kernel, config->correlation_kernel,
+      config->forward_collector, config->model_handler,
+      config->source_injector};
+  for (uint i = 1; i < batch; i++) {
+    components.push_back(this->shot_configurations[i - 1]->trace_manager);
+    components.push_back(this->shot_configurations[i - 1]->source_injector);
+  }
+  for (Component *component : components) {
+    if (!component->SupportsShotBatch()) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  return migration;
+vector<string> RTMEngine::GetNarrowWavefieldsBlockers() {
+  // The batched shots are propagated in fp32, the model handler only
+  // allocates the frames.
+  if (this->parameters->shot_batch > 1) {
+    return {"shot batching"};
+  }
+  vector<EngineConfiguration *> configurations = {this->configuration};
+  configurations.insert(configurations.end(),
+                        this->shot_configurations.begin(),
+                        this->shot_configurations.end());
+  vector<string> blockers;
+  for (EngineConfiguration *config : configurations) {
+    vector<pair<string, Component *>> components = {
+        {"trace manager", config->trace_manager},
+        {"boundary manager", config->boundary_manager},
+        {"computation kernel", config->computation_kernel},
+        {"correlation kernel", config->correlation_kernel},
+        {"forward collector", config->forward_collector},
+        {"source injector", config->source_injector}};
+    for (auto &component : components) {
+      if (!component.second->SupportsNarrowWavefields() &&
+          find(blockers.begin(), blockers.end(), component.first) ==
+              blockers.end()) {
+        blockers.push_back(component.first);
+      }
+    }
+  }
+  return blockers;
 }
 
-GridBox *RTMEngine::Initialize() {
+void RTMEngine::MigrateBatches(GridBox *grid_box,
+                               const vector<uint> &shot_ids) {
+  uint batch = this->parameters->shot_batch;
+  CorrelationKernel *correlation = this->configuration->correlation_kernel;
+  ForwardCollector *collector = this->configuration->forward_collector;
+  BoundaryManager *boundary_manager = this->configuration->boundary_manager;
+  vector<EngineConfiguration *> lanes = {this->configuration};
+  for (uint i = 1; i < batch; i++) {
+    EngineConfiguration *lane = this->shot_configurations[i - 1];
+    lane->trace_manager->SetComputationParameters(this->parameters);
+    lane->source_injector->SetComputationParameters(this->parameters);
+    lane->trace_manager->SetGridBox(grid_box);
+    lane->source_injector->SetGridBox(grid_box);
+    lanes.push_back(lane);
+  }
+  cout << "Propagating " << batch << " shots at the same time" << endl;
+  vector<uint> lane_nt(batch);
+  for (uint first = 0; first < shot_ids.size(); first += batch) {
+    uint count = min((size_t)batch, shot_ids.size() - first);
+    printf("Shots %d-%d/%d\n", first + 1, first + count, shot_ids.size());
+    correlation->ResetShotCorrelation();
+    // The shots are read one after the other, each setting the number of
+    // time-steps of the grid, which propagates for the longest of them.
+    uint nt = 0;
+    for (uint lane = 0; lane < batch; lane++) {
+      lane_nt[lane] = 0;
+      if (lane >= count) {
+        continue;
+      }
+      EngineConfiguration *config = lanes[lane];
+      config->trace_manager->ReadShot(config->trace_files,
+                                      shot_ids[first + lane],
+                                      config->sort_key);
+      config->trace_manager->PreprocessShot(
+          config->source_injector->GetCutOffTimestep());
+      config->source_injector->SetSourcePoint(
+          config->trace_manager->GetSourcePoint());
+      lane_nt[lane] = grid_box->nt;
+      nt = max(nt, grid_box->nt);
+    }
+    grid_box->nt = nt;
+    boundary_manager->ReExtendModel();
+    collector->ResetGrid(true);
+    this->ForwardBatch(grid_box, lanes, lane_nt);
+    collector->ResetGrid(false);
+    boundary_manager->AdjustModelForBackward();
+    this->BackwardBatch(grid_box, lanes, lane_nt);
+    correlation->Stack();
+  }
+}
+
+/*!
+ * Adds the points of the injection of a shot to its lane of a frame holding
+ * the interleaved shots of a batch.
+ */
+void InjectLane(float *frame, const InjectionList *injection, uint lane,
+                uint batch) {
+  if (injection == nullptr) {
+    return;
+  }
+  for (uint i = 0; i < injection->num_points; i++) {
+    frame[(size_t)injection->offsets[i] * batch + lane] +=
+        injection->amplitudes[i];
+  }
+}
+
+void RTMEngine::ForwardBatch(GridBox *grid_box,
+                             const vector<EngineConfiguration *> &lanes,
+                             const vector<uint> &lane_nt) {
+  this->timer->start_timer("Engine::Forward");
+  int onePercent = grid_box->nt / 100 + 1;
+  uint batch = lane_nt.size();
+  for (uint t = 1; t < grid_box->nt; t++) {
+    this->configuration->forward_collector->SaveForward();
+    for (uint lane = 0; lane < batch; lane++) {
+      if (t < lane_nt[lane]) {
+        InjectLane(grid_box->pressure_current,
+                   lanes[lane]->source_injector->GetInjection(t), lane, batch);
+      }
+    }
+    this->configuration->computation_kernel->Step();
+    if (this->show_progress && (t / onePercent) != ((t + 1) / onePercent)) {
+      printProgress(((float)t + 1) / grid_box->nt, "Forward Propagation");
+    }
+  }
+  if (this->show_progress) {
+    printProgress(1, "Forward Propagation");
+    cout << " ... Done" << endl;
+  }
+  this->timer->stop_timer("Engine::Forward");
+}
+
+void RTMEngine::BackwardBatch(GridBox *grid_box,
+                              const vector<EngineConfiguration *> &lanes,
+                              const vector<uint> &lane_nt) {
+  this->timer->start_timer("Engine::Backward");
+  int onePercent = grid_box->nt / 100 + 1;
+  uint batch = lane_nt.size();
+  ForwardCollector *collector = this->configuration->forward_collector;
+  for (uint t = grid_box->nt - 1; t > 0; t--) {
+    // The backward waves of the shorter shots start once their time-steps
+    // are reached.
+    for (uint lane = 0; lane < batch; lane++) {
+      if (t < lane_nt[lane]) {
+        InjectLane(grid_box->pressure_current,
+                   lanes[lane]->trace_manager->GetInjection(t), lane, batch);
+      }
+    }
+    this->configuration->computation_kernel->Step();
+    collector->FetchForward();
+    if (t % this->parameters->imaging_step == 0) {
+      this->configuration->correlation_kernel->Correlate(
+          collector->GetForwardGrid());
+    }
+    if (this->show_progress && (t % onePercent) == 0) {
+      printProgress(((float)(grid_box->nt - t)) / grid_box->nt,
+                    "Backward Propagation");
+    }
+  }
+  if (this->show_progress) {
+    printProgress(1, "Backward Propagation");
+    cout << " ... Done" << endl;
+  }
+  this->timer->stop_timer("Engine::Backward");
+}
+
+GridBox *RTMEngine::Initialize(GridBox *model, bool share) {
   this->timer->start_timer("Engine::Initialization");
   this->configuration->trace_manager->SetComputationParameters(parameters);
   this->configuration->boundary_manager->SetComputationParameters(parameters);
@@ -129,9 +516,17 @@ GridBox *RTMEngine::Initialize() {
   this->configuration->forward_collector->SetComputationParameters(parameters);
   this->configuration->model_handler->SetComputationParameters(parameters);
   this->configuration->source_injector->SetComputationParameters(parameters);
-  GridBox *grid = this->configuration->model_handler->ReadModel(
-      this->configuration->model_files,
-      this->configuration->computation_kernel);
+  GridBox *grid = nullptr;
+  if (model != nullptr) {
+    grid = this->configuration->model_handler->CloneModel(
+        model, this->configuration->computation_kernel, share);
+  }
+  bool read = grid == nullptr;
+  if (read) {
+    grid = this->configuration->model_handler->ReadModel(
+        this->configuration->model_files,
+        this->configuration->computation_kernel);
+  }
   this->configuration->trace_manager->SetGridBox(grid);
   this->configuration->boundary_manager->SetGridBox(grid);
   this->configuration->computation_kernel->SetGridBox(grid);
@@ -139,55 +534,290 @@ GridBox *RTMEngine::Initialize() {
   this->configuration->forward_collector->SetGridBox(grid);
   this->configuration->model_handler->SetGridBox(grid);
   this->configuration->source_injector->SetGridBox(grid);
-  this->configuration->model_handler->PreprocessModel(
-      this->configuration->computation_kernel);
+  if (read) {
+    this->configuration->model_handler->PreprocessModel(
+        this->configuration->computation_kernel);
+  }
   this->configuration->boundary_manager->ExtendModel();
+  this->configuration->computation_kernel->SetBoundaryManager(
+      this->configuration->boundary_manager);
+  this->configuration->forward_collector->SetForwardComponents(
+      this->configuration->boundary_manager,
+      this->configuration->source_injector);
   this->timer->stop_timer("Engine::Initialization");
 
   return grid;
 }
 
+void RTMEngine::SetShotWindow(GridBox *grid_box,
+                              TraceManager *trace_manager) {
+  WindowSize *window = &grid_box->window_size;
+  uint nx = grid_box->grid_size.nx;
+  uint nz = grid_box->grid_size.nz;
+  uint ny = grid_box->grid_size.ny;
+  window->window_start = {0, 0, 0};
+  window->window_nx = nx;
+  window->window_nz = nz;
+  window->window_ny = ny;
+  ActiveBox shot;
+  if (!this->parameters->shot_window ||
+      !trace_manager->GetShotBox(&shot)) {
+    return;
+  }
+  // The boundary of the window replaces the model beyond the aperture.
+  uint padding =
+      this->parameters->half_length + this->parameters->boundary_length;
+  uint grow_x = this->parameters->window_aperture_x + padding;
+  window->window_start.x = shot.start.x > grow_x ? shot.start.x - grow_x : 0;
+  window->window_nx = min(shot.end.x + grow_x, nx) - window->window_start.x;
+  if (ny > 1) {
+    uint grow_y = this->parameters->window_aperture_y + padding;
+    window->window_start.y = shot.start.y > grow_y ? shot.start.y - grow_y : 0;
+    window->window_ny = min(shot.end.y + grow_y, ny) - window->window_start.y;
+  }
+  cout << "Shot window : x [" << window->window_start.x << ", "
+       << window->window_start.x + window->window_nx << ")";
+  if (ny > 1) {
+    cout << " y [" << window->window_start.y << ", "
+         << window->window_start.y + window->window_ny << ")";
+  }
+  cout << " of the " << nx << " x " << ny << " grid" << endl;
+}
+
+void RTMEngine::SetImagingStep(GridBox *grid_box) {
+  if (this->parameters->imaging_step == 0) {
+    float period = 1.0f / (6 * this->parameters->source_frequency);
+    this->parameters->imaging_step = max(1, (int)(period / grid_box->dt));
+  }
+  if (this->parameters->imaging_step > 1) {
+    cout << "Imaging every " << this->parameters->imaging_step
+         << " time-steps" << endl;
+  }
+}
+
+bool RTMEngine::GetActiveBox(GridBox *grid_box, const ActiveBox &seed,
+                             uint time_steps, ActiveBox *box) {
+  float distance = this->active_velocity * grid_box->dt * time_steps;
+  uint margin = this->parameters->active_region_margin;
+  uint wnx = grid_box->window_size.window_nx;
+  uint wnz = grid_box->window_size.window_nz;
+  uint wny = grid_box->window_size.window_ny;
+  uint grow_x = ceil(distance / grid_box->cell_dimensions.dx) + margin;
+  uint grow_z = ceil(distance / grid_box->cell_dimensions.dz) + margin;
+  box->start.x = seed.start.x > grow_x ? seed.start.x - grow_x : 0;
+  box->start.z = seed.start.z > grow_z ? seed.start.z - grow_z : 0;
+  box->end.x = min(seed.end.x + grow_x, wnx);
+  box->end.z = min(seed.end.z + grow_z, wnz);
+  box->start.y = 0;
+  box->end.y = 1;
+  if (grid_box->grid_size.ny > 1) {
+    uint grow_y = ceil(distance / grid_box->cell_dimensions.dy) + margin;
+    box->start.y = seed.start.y > grow_y ? seed.start.y - grow_y : 0;
+    box->end.y = min(seed.end.y + grow_y, wny);
+  }
+  return box->start.x > 0 || box->start.z > 0 || box->start.y > 0 ||
+         box->end.x < wnx || box->end.z < wnz || box->end.y < wny;
+}
+
 void RTMEngine::Forward(GridBox *grid_box) {
   this->timer->start_timer("Engine::Forward");
   int onePercent = grid_box->nt / 100 + 1;
-  for (uint t = 1; t < grid_box->nt; t++) {
+  uint cut_off = this->configuration->source_injector->GetCutOffTimestep();
+  ComputationKernel *kernel = this->configuration->computation_kernel;
+  BoundaryManager *boundary_manager = this->configuration->boundary_manager;
+  // The waves start from the source point.
+  Point3D *source = this->configuration->trace_manager->GetSourcePoint();
+  ActiveBox source_box = {*source, {source->x + 1, source->z + 1,
+                                    source->y + 1}};
+  ActiveBox active_box;
+  bool restricted = this->active_velocity > 0;
+  // The narrow wavefields are only accessed through the kernel.
+  bool narrow = this->parameters->narrow_wavefields;
+  kernel->PreparePropagation();
+  for (uint t = 1; t < grid_box->nt;) {
     this->configuration->forward_collector->SaveForward();
-    this->configuration->source_injector->ApplySource(t);
-    this->configuration->computation_kernel->Step();
+    // The source is injected by the threads of the kernel's step if
+    // supported.
+    InjectionList *injection =
+        kernel->SupportsInjection()
+            ? this->configuration->source_injector->GetInjection(t)
+            : nullptr;
+    if (injection != nullptr) {
+      kernel->SetInjection(injection);
+    } else {
+      this->configuration->source_injector->ApplySource(t);
+    }
+    // Restrict the next time step to the region the waves could have reached,
+    // till it covers the whole window.
+    if (restricted) {
+      restricted = this->GetActiveBox(grid_box, source_box, t + 1, &active_box);
+      kernel->SetActiveBox(restricted ? &active_box : nullptr);
+      boundary_manager->SetActiveBox(restricted ? &active_box : nullptr);
+    }
+    // Advance several time steps at once as long as the steps in between need
+    // no saving of the forward wavefield, and no source injection unless the
+    // kernel takes the injection of each of them.
+    uint steps = 1;
+    while (!restricted && steps < this->parameters->temporal_block &&
+           t + steps < grid_box->nt &&
+           (injection != nullptr || t + steps >= cut_off) &&
+           !this->configuration->forward_collector->IsSaveRequired(t + steps)) {
+      if (injection != nullptr) {
+        kernel->SetInjection(
+            this->configuration->source_injector->GetInjection(t + steps));
+      }
+      steps++;
+    }
+    if (steps > 1) {
+      kernel->MultiStep(steps);
+      this->configuration->forward_collector->SkipForward(steps - 1);
+    } else {
+      kernel->Step();
+    }
+    t += steps;
 #ifndef NDEBUG
-    this->callbacks->AfterForwardStep(grid_box, t);
+    // The callbacks read the frames as floats. The time steps advanced at once
+    // have no frames of their own, so only the last one is given to them.
+    if (!narrow) {
+      this->callbacks->AfterForwardStep(grid_box, t - 1);
+    }
 #endif
-    if((t % onePercent) == 0)
+    if(this->show_progress && ((t - steps) / onePercent) != (t / onePercent))
     {
     	printProgress(((float)t) / grid_box->nt, "Forward Propagation");
     }
   }
-  printProgress(1, "Forward Propagation");
-  cout << " ... Done" << endl;
+  kernel->SetActiveBox(nullptr);
+  boundary_manager->SetActiveBox(nullptr);
+  if (this->show_progress) {
+    printProgress(1, "Forward Propagation");
+    cout << " ... Done" << endl;
+  }
   this->timer->stop_timer("Engine::Forward");
 }
 
 void RTMEngine::Backward(GridBox *grid_box) {
   this->timer->start_timer("Engine::Backward");
   int onePercent = grid_box->nt / 100 + 1;
-  for (uint t = grid_box->nt - 1; t > 0; t--) {
-    this->configuration->trace_manager->ApplyTraces(t);
-    this->configuration->computation_kernel->Step();
-    this->configuration->forward_collector->FetchForward();
+  ComputationKernel *kernel = this->configuration->computation_kernel;
+  CorrelationKernel *correlation = this->configuration->correlation_kernel;
+  ForwardCollector *collector = this->configuration->forward_collector;
+  // The fused imaging needs the forward frame before the backward step.
+  bool fused = correlation->IsFused() && kernel->SupportsImaging();
+  FusedImaging imaging;
+  imaging.region = nullptr;
+  // The forward wavefields are only stored and correlated every imaging step.
+  uint imaging_step = this->parameters->imaging_step;
+  BoundaryManager *boundary_manager = this->configuration->boundary_manager;
+  // The backward waves start from the receivers, the forward ones from the
+  // source.
+  Point3D *source = this->configuration->trace_manager->GetSourcePoint();
+  ActiveBox source_box = {*source, {source->x + 1, source->z + 1,
+                                    source->y + 1}};
+  ActiveBox receiver_box;
+  ActiveBox active_box, forward_box, image_box;
+  bool reconstructed = collector->IsReconstructed();
+  bool restricted =
+      this->active_velocity > 0 &&
+      this->configuration->trace_manager->GetReceiverBox(&receiver_box);
+  // The narrow wavefields are only accessed through the kernel.
+  bool narrow = this->parameters->narrow_wavefields;
+  kernel->PreparePropagation();
+  for (uint t = grid_box->nt - 1; t > 0;) {
+    // The traces are injected by the threads of the kernel's step if
+    // supported.
+    InjectionList *injection =
+        kernel->SupportsInjection()
+            ? this->configuration->trace_manager->GetInjection(t)
+            : nullptr;
+    if (injection != nullptr) {
+      kernel->SetInjection(injection);
+    } else {
+      this->configuration->trace_manager->ApplyTraces(t);
+    }
+    // The backward waves are restricted like the forward ones, the imaging
+    // to where both the forward and the backward waves could be.
+    if (restricted) {
+      restricted = this->GetActiveBox(grid_box, receiver_box,
+                                      grid_box->nt - t + 1, &active_box);
+      kernel->SetActiveBox(restricted ? &active_box : nullptr);
+      boundary_manager->SetActiveBox(restricted ? &active_box : nullptr);
+    }
+    const ActiveBox *region = nullptr;
+    if (this->active_velocity > 0) {
+      // The forward wavefields reconstructed backward in time aren't bounded
+      // by the forward wavefront, so they are imaged wherever the backward
+      // waves are.
+      bool forward_restricted =
+          !reconstructed &&
+          this->GetActiveBox(grid_box, source_box, t + 1, &forward_box);
+      if (restricted || forward_restricted) {
+        image_box = restricted ? active_box : forward_box;
+        if (restricted && forward_restricted) {
+          image_box.start.x = max(active_box.start.x, forward_box.start.x);
+          image_box.start.z = max(active_box.start.z, forward_box.start.z);
+          image_box.start.y = max(active_box.start.y, forward_box.start.y);
+          image_box.end.x = min(active_box.end.x, forward_box.end.x);
+          image_box.end.z = min(active_box.end.z, forward_box.end.z);
+          image_box.end.y = min(active_box.end.y, forward_box.end.y);
+        }
+        region = &image_box;
+      }
+      correlation->SetActiveBox(region);
+    }
+    bool imaged = t % imaging_step == 0;
+    // Advance several time steps at once over the ones that aren't imaged,
+    // the kernel taking the traces of each of them.
+    uint steps = 1;
+    if (!imaged && injection != nullptr) {
+      while (!restricted && steps < this->parameters->temporal_block &&
+             t - steps > 0 && (t - steps) % imaging_step != 0) {
+        kernel->SetInjection(
+            this->configuration->trace_manager->GetInjection(t - steps));
+        steps++;
+      }
+    }
+    if (steps > 1) {
+      kernel->MultiStep(steps);
+      collector->SkipBackward(steps);
+    } else {
+      if (fused) {
+        collector->FetchForward();
+        if (imaged) {
+          imaging.source = collector->GetForwardGrid()->pressure_current;
+          imaging.image = correlation->GetShotCorrelation();
+          imaging.region = region;
+          kernel->SetImaging(&imaging);
+        }
+      }
+      kernel->Step();
+      if (!fused) {
+        collector->FetchForward();
+      }
+    }
+    t -= steps;
 #ifndef NDEBUG
-    this->callbacks->AfterFetchStep(
-        this->configuration->forward_collector->GetForwardGrid(), t);
-    this->callbacks->AfterBackwardStep(grid_box, t);
+    // The time steps advanced at once have no frames of their own, so only
+    // the last one is given to the callbacks.
+    if (!narrow) {
+      this->callbacks->AfterFetchStep(collector->GetForwardGrid(), t + 1);
+      this->callbacks->AfterBackwardStep(grid_box, t + 1);
+    }
 #endif
-    this->configuration->correlation_kernel->Correlate(
-    		this->configuration->forward_collector->GetForwardGrid());
-    if((t % onePercent) == 0)
+    if (!fused && imaged) {
+      correlation->Correlate(collector->GetForwardGrid());
+    }
+    if(this->show_progress && ((t + steps) / onePercent) != (t / onePercent))
     {
     	printProgress(((float)(grid_box->nt - t)) / grid_box->nt, "Backward Propagation");
     }
   }
-  printProgress(1, "Backward Propagation");
-
-  cout << " ... Done" << endl;
+  kernel->SetActiveBox(nullptr);
+  boundary_manager->SetActiveBox(nullptr);
+  correlation->SetActiveBox(nullptr);
+  if (this->show_progress) {
+    printProgress(1, "Backward Propagation");
+    cout << " ... Done" << endl;
+  }
   this->timer->stop_timer("Engine::Backward");
 }
@@ -9,6 +9,7 @@
 #include <skeleton/base/migration_data.h>
 #include <skeleton/helpers/callbacks/callback_collection.h>
 #include <skeleton/helpers/timer/timer.hpp>
+#include <string>
 #include <vector>
 
 /*!
@@ -23,6 +24,12 @@ private:
    * process.
    */
   EngineConfiguration *configuration;
+  /*!
+   * The configurations of the other shots migrated at the same time, each
+   * used by its own engine, of the other shots of a batch, or of the shots
+   * read ahead.
+   */
+  vector<EngineConfiguration *> shot_configurations;
   /*!
    * Callback collection to be called when not in release mode.
    */
@@ -35,6 +42,113 @@ private:
    * The timer to use.
    */
   Timer *timer;
+  /*!
+   * The maximum velocity of the model if the time-steps are restricted to the
+   * active region of each shot, 0 otherwise.
+   */
+  float active_velocity;
+  /*!
+   * Whether the progress of the propagations is printed, it isn't when
+   * several shots are migrated at the same time.
+   */
+  bool show_progress;
+  /*!
+   * Migrates a single shot and stacks it into the stacked correlation.
+   */
+  void MigrateShot(GridBox *grid_box, uint shot_id);
+  /*!
+   * Propagates the shot already read and preprocessed by the trace manager,
+   * and stacks it into the stacked correlation.
+   */
+  void PropagateShot(GridBox *grid_box);
+  /*!
+   * Migrates the shots one by one while a helper thread reads and preprocesses
+   * the next ones, up to one for each of the configurations of the shots read
+   * ahead. Each shot is read by the trace manager of a free configuration into
+   * its own copy of the grid box, and handed over by swapping that trace
+   * manager with the one of this configuration. The shot preprocessing
+   * callbacks aren't called for the shots read ahead.
+   */
+  void MigratePrefetched(GridBox *grid_box, const vector<uint> &shot_ids);
+  /*!
+   * Migrates the shots by several engines at the same time, one for each
+   * configuration, on an equal share of the threads. The shots are handed out
+   * one at a time to the engine that is done first, and the results of the
+   * engines are stacked into the stacked correlation of this one at the end.
+   * The model is shared by the engines if the shots don't modify it.
+   */
+  void MigrateConcurrently(GridBox *grid_box, const vector<uint> &shot_ids);
+  /*!
+   * Whether the components of the configurations support propagating the
+   * shots in batches, with a configuration for each shot of a batch.
+   */
+  bool SupportsShotBatch();
+  /*!
+   * Gets what keeps the configurations from using the narrow wavefields : each
+   * of their components must leave the frames to the computation kernel.
+   * @return
+   * The kinds of the components that don't support them, or shot batching,
+   * empty if they are supported.
+   */
+  vector<string> GetNarrowWavefieldsBlockers();
+  /*!
+   * Migrates the shots in batches of the shot batch parameter, propagated
+   * together in the interleaved frames of the grid. Each shot of a batch is
+   * read and injected by the trace manager and source injector of its own
+   * configuration, the first one by this one. The callbacks aren't called for
+   * the batched shots.
+   */
+  void MigrateBatches(GridBox *grid_box, const vector<uint> &shot_ids);
+  /*!
+   * Applies the forward propagation of a batch of shots.
+   * @param lanes
+   * The configurations of the shots of the batch.
+   * @param lane_nt
+   * The number of time-steps of each shot, 0 for the lanes without a shot.
+   */
+  void ForwardBatch(GridBox *grid_box,
+                    const vector<EngineConfiguration *> &lanes,
+                    const vector<uint> &lane_nt);
+  /*!
+   * Applies the backward propagation of a batch of shots.
+   * @param lanes
+   * The configurations of the shots of the batch.
+   * @param lane_nt
+   * The number of time-steps of each shot, 0 for the lanes without a shot.
+   */
+  void BackwardBatch(GridBox *grid_box,
+                     const vector<EngineConfiguration *> &lanes,
+                     const vector<uint> &lane_nt);
+  /*!
+   * Sets the window of the grid for the shot just read by the trace manager :
+   * the box of its source and receivers grown by the aperture of the
+   * parameters and the boundary in the x and y directions, with the full
+   * depth. The whole grid is used if the shot window is disabled or not
+   * supported by the trace manager.
+   */
+  void SetShotWindow(GridBox *grid_box, TraceManager *trace_manager);
+  /*!
+   * Derives the imaging step from the source frequency and dt when asked to
+   * by the parameters. The ricker wavelet has no significant energy above
+   * three times its frequency, so the product of the forward and backward
+   * wavefields is below six times it and summing one time-step of each period
+   * of that frequency keeps the zero lag of their correlation.
+   */
+  void SetImagingStep(GridBox *grid_box);
+  /*!
+   * Gets the box the waves emitted from the seed box could have reached.
+   * @param seed
+   * The box the waves started from.
+   * @param time_steps
+   * The number of time-steps the waves traveled.
+   * @param box
+   * Set to the seed box grown by the distance traveled at the maximum velocity
+   * and the margin of the parameters, clamped to the window.
+   * @return
+   * False if the box covers the whole window.
+   */
+  bool GetActiveBox(GridBox *grid_box, const ActiveBox &seed, uint time_steps,
+                    ActiveBox *box);
   /*!
    * Applies the forward propagation using the different components provided in
    * the configuration.
@@ -47,8 +161,13 @@ private:
   void Backward(GridBox *grid_box);
   /*!
    * Initializes our domain model.
+   * @param model
+   * If not nullptr, the model is cloned from this pre-processed GridBox instead
+   * of being read, when supported by the model handler.
+   * @param share
+   * Whether the cloned model is shared with the given GridBox.
    */
-  GridBox *Initialize();
+  GridBox *Initialize(GridBox *model = nullptr, bool share = false);
 
 public:
   /*!
@@ -75,6 +194,20 @@ public:
    */
   RTMEngine(EngineConfiguration *configuration,
             ComputationParameters *parameters, CallbackCollection *cbs);
+  /*!
+   * Constructor for the RTM engine migrating several shots at the same time.
+   * @param configurations
+   * The engine configurations, one for each shot migrated at the same time.
+   * The first one is used like the configuration of the other constructors.
+   * @param parameters
+   * The computation parameters that will control the simulations settings like
+   * boundary length, order of numerical solution.
+   * @param cbs
+   * The callback collection to be called throughout the execution if in debug
+   * mode, only for the shots migrated by the first configuration.
+   */
+  RTMEngine(vector<EngineConfiguration *> configurations,
+            ComputationParameters *parameters, CallbackCollection *cbs);
   /*!
    * The migration function that will apply the reverse time migration process
    * and produce the results needed.
@@ -5,7 +5,10 @@
 #include "memory_allocator.h"
 
 #include <cstdlib>
+#include <fstream>
+#include <mutex>
 #include <skeleton/helpers/memory_tracking/include/memory_tracker.h>
+#include <unistd.h>
 #include <unordered_map>
 
 #define MASK_ALLOC_OFFSET(x) (x)
@@ -15,6 +18,9 @@
  * and its values will also be pointer to void and is called base_pointers
  */
 static unordered_map<void *, void *> base_pointers;
+// guards base_pointers, the shots migrated at the same time allocate from
+// different threads.
+static mutex base_pointers_mutex;
 
 void *mem_allocate(const unsigned long long size_of_type,
                    const unsigned long long number_of_elements, string name) {
@@ -24,7 +30,8 @@ void *mem_allocate(const unsigned long long size_of_type,
 void *mem_allocate(const unsigned long long size_of_type,
                    const unsigned long long number_of_elements, string name,
                    uint half_length_padding) {
-  return mem_allocate(size_of_type, number_of_elements, name, 0, 0);
+  return mem_allocate(size_of_type, number_of_elements, name,
+                      half_length_padding, 0);
 }
 
 void *mem_allocate(const unsigned long long size_of_type,
@@ -41,10 +48,16 @@ void *mem_allocate(const unsigned long long size_of_type,
    * and MASK_ALLOC_OFFSET(0)=0 and number of elements =6 so now we have for
    * each array number of floats reserved equals (6+16) =22 floats which equals
    * 1 cache line of size 64(16float) and extra 6 floats
+   * posix_memalign is used as malloc only guarantees 16 bytes alignment, which
+   * isn't enough for the vector loads of the kernels.
    */
-  void *ptr_base =
-      malloc(size_of_type * (number_of_elements + 16 +
-                             MASK_ALLOC_OFFSET(masking_allocation_factor)));
+  void *ptr_base = nullptr;
+  if (posix_memalign(&ptr_base, CACHELINE_BYTES,
+                     size_of_type *
+                         (number_of_elements + 16 +
+                          MASK_ALLOC_OFFSET(masking_allocation_factor))) != 0) {
+    ptr_base = nullptr;
+  }
 #else
   /*!if the intel compiler is  defined
    * this function is used to ensure the alignment of float variables
@@ -95,7 +108,10 @@ void *mem_allocate(const unsigned long long size_of_type,
    * starts alignment at the inner domain and the value is ptr_base which is
    * aligned and start alignment at the half_length_padding
    */
-  base_pointers[ptr] = ptr_base;
+  {
+    lock_guard<mutex> lock(base_pointers_mutex);
+    base_pointers[ptr] = ptr_base;
+  }
 
   // return the ptr: aligned pointer that start alignment at the inner domain
   // which is the key of the global unordered map base_pointers
@@ -111,7 +127,12 @@ void mem_free(void *ptr) {
   // that ptr_base points to
   // and make org_ptr point to the same address so now ptr_base and org_ptr
   // points to the same address
-  void *org_ptr = base_pointers[ptr];
+  void *org_ptr;
+  {
+    lock_guard<mutex> lock(base_pointers_mutex);
+    org_ptr = base_pointers[ptr];
+    base_pointers.erase(ptr);
+  }
 
 #ifndef __INTEL_COMPILER
   // if the intel compiler is not defined free the org_ptr
@@ -122,3 +143,16 @@ void mem_free(void *ptr) {
   _mm_free(org_ptr);
 #endif
 }
+
+size_t mem_available() {
+  ifstream meminfo("/proc/meminfo");
+  string key;
+  size_t value;
+  string unit;
+  while (meminfo >> key >> value >> unit) {
+    if (key == "MemAvailable:") {
+      return value * 1024;
+    }
+  }
+  return (size_t)sysconf(_SC_AVPHYS_PAGES) * (size_t)sysconf(_SC_PAGESIZE);
+}
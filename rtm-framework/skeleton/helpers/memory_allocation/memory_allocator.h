@@ -72,5 +72,12 @@ void *mem_allocate(const unsigned long long size_of_type,
  * The aligned void pointer to be freed.
  */
 void mem_free(void *ptr);
+/*!
+ * Gets the memory the process can still allocate.
+ * @return
+ * The kernel estimate in bytes of the memory that can be allocated without
+ * swapping.
+ */
+size_t mem_available();
 
 #endif // RTM_FRAMEWORK_MEMORY_ALLOCATOR_H
@@ -86,8 +86,9 @@ Data *DataObj_init() {
 }
 
 void Timer::_start_timer(std::string function_name, int line) {
-  std::unordered_map<std::string, double>::iterator it_running =
-      Running_Times.find(function_name);
+  std::lock_guard<std::mutex> lock(timer_mutex);
+  auto key = std::make_pair(std::this_thread::get_id(), function_name);
+  auto it_running = Running_Times.find(key);
   std::unordered_map<std::string, Data *>::iterator it =
       Timing_dict.find(function_name);
 
@@ -108,15 +109,16 @@ void Timer::_start_timer(std::string function_name, int line) {
   double start = start_time.tv_usec + start_time.tv_sec * 1000000;
   start /= 1000000;
 #endif
-  Running_Times[function_name] = start;
+  Running_Times[key] = start;
   Timing_dict[function_name]->lineNums.push_back(line);
 }
 
 void Timer::_start_timer_for_kernel(std::string function_name, double size,
                                     int arrays, bool single,
                                     int num_of_operations) {
-  std::unordered_map<std::string, double>::iterator it_running =
-      Running_Times.find(function_name);
+  std::lock_guard<std::mutex> lock(timer_mutex);
+  auto key = std::make_pair(std::this_thread::get_id(), function_name);
+  auto it_running = Running_Times.find(key);
   std::unordered_map<std::string, Data *>::iterator it =
       Timing_dict.find(function_name);
   if (it_running != Running_Times.end()) {
@@ -136,7 +138,7 @@ void Timer::_start_timer_for_kernel(std::string function_name, double size,
   double start = start_time.tv_usec + start_time.tv_sec * 1000000;
   start /= 1000000;
 #endif
-  Running_Times[function_name] = start;
+  Running_Times[key] = start;
   // Timing_dict[function_name]->lineNums.push_back(line);
   Timing_dict[function_name]->size_of_grid = size;
   Timing_dict[function_name]->num_of_arrays = arrays;
@@ -152,16 +154,18 @@ void Timer::_start_timer_for_kernel(std::string function_name, double size,
 }
 
 void Timer::stop_timer(std::string function_name) {
+  std::lock_guard<std::mutex> lock(timer_mutex);
   std::unordered_map<std::string, Data *>::iterator it =
       Timing_dict.find(function_name);
-  std::unordered_map<std::string, double>::iterator it_running =
-      Running_Times.find(function_name);
+  auto it_running =
+      Running_Times.find(std::make_pair(std::this_thread::get_id(),
+                                        function_name));
 
   if (it_running == Running_Times.end()) {
     std::cerr << "Timer didn't start..." << std::endl;
     exit(1);
   }
-  double start = Running_Times[function_name];
+  double start = it_running->second;
 #ifdef _OPENMP
   double end = omp_get_wtime();
 #else
@@ -182,7 +186,7 @@ void Timer::stop_timer(std::string function_name) {
 }
 
 int Timer::active_timers(int i = 0) {
-
+  std::lock_guard<std::mutex> lock(timer_mutex);
   if (i == 1) {
     std::cout << "Active Timers: " << std::endl;
     for (auto element : Running_Times) {
@@ -195,9 +199,10 @@ int Timer::active_timers(int i = 0) {
       end /= 1000000;
 #endif
       double duration = end - element.second;
-      std::cout << "Function Name: " << element.first << ", Started "
+      std::cout << "Function Name: " << element.first.second << ", Started "
                 << duration << " seconds ago at line "
-                << Timing_dict[element.first]->lineNums.back() << std::endl;
+                << Timing_dict[element.first.second]->lineNums.back()
+                << std::endl;
     }
   }
   return Running_Times.size();
@@ -287,7 +292,7 @@ std::string get_funcData(Data *dataObj) {
 }
 
 std::string Timer::get_report() {
-
+  std::lock_guard<std::mutex> lock(timer_mutex);
   std::ostringstream os;
 
   for (auto entry : Timing_dict) {
@@ -2,7 +2,9 @@
 #define TIMER_HPP
 #include "limits.h"
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 #include <iostream>
@@ -49,7 +51,12 @@ private:
     // string as a key and vector as value to store the run times of the function 
 	std::unordered_map<std::string, Data* > Timing_dict;
 	
-	std::unordered_map<std::string, double > Running_Times;
+	// start times of the running timers, by thread so that the shots migrated
+	// at the same time can time the same functions
+	std::map<std::pair<std::thread::id, std::string>, double > Running_Times;
+
+	// guards the maps, the timer is used from several threads
+	std::mutex timer_mutex;
 
 	// Map structure to hold the data of each process using the rank of that process
 	std::map<int, std::map<std::string, Data*>> process_data;
@@ -0,0 +1,315 @@
+// Measures the throughput of the SEG-Y conversions of each instruction set
+// supported by the cpu, and of the scalar routines of segy_helpers and
+// swapbyte they replace, on a block of values.
+//
+// usage : bench_convert [verify]
+// verify compares the bits given by the conversions of each instruction set
+// with the ones of the scalar routines instead, for all the 4, 2 and 1 byte
+// values, and exits with 1 if any of them differs.
+#include "segy_convert.h"
+#include "segy_helpers.h"
+#include "suheaders.h"
+#include "swapbyte.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace std;
+using namespace suconvert;
+
+// The runs each throughput is measured on.
+#define BENCH_RUNS 10
+// The values of the benchmarked block, and of each block of the verification.
+#define BLOCK_VALUES (1 << 24)
+// The trace headers of the benchmarked and verified blocks.
+#define HEADER_COUNT 100000
+
+// The byte order argument of the scalar routines, 0 on little endian
+// machines, as in SUSegy.
+static const int endian = htons(1) == 1 ? 1 : 0;
+
+// The seconds of a run of the operation, the best of BENCH_RUNS.
+static double TimeRuns(const function<void()> &operation) {
+  double best = 0;
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    auto start = chrono::steady_clock::now();
+    operation();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    if (run == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+// The instruction sets supported by the cpu.
+static vector<ConvertIsa> GetIsas() {
+  vector<ConvertIsa> isas;
+  for (int isa = CONVERT_SCALAR; isa <= DetectIsa(); isa++) {
+    isas.push_back((ConvertIsa)isa);
+  }
+  return isas;
+}
+
+// The random bits of the benchmarked blocks.
+static uint32_t NextRandom(uint32_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 17;
+  *state ^= *state << 5;
+  return *state;
+}
+
+// Swaps the trace headers with the scalar routine, each of SEGY_HDRBYTES at
+// their stride.
+static void SwapHeadersReference(unsigned char *headers, size_t count,
+                                 size_t stride) {
+  for (size_t h = 0; h < count; h++) {
+    for (int key = 0; key < SEGY_NKEYS; key++) {
+      swaphval((segy *)(headers + h * stride), key);
+    }
+  }
+}
+
+static void PrintResult(const char *conversion, const char *implementation,
+                        double bytes, double time) {
+  printf("%-14s %-8s %10.2f\n", conversion, implementation,
+         bytes / time / 1e9);
+}
+
+static void Bench() {
+  size_t n = BLOCK_VALUES;
+  vector<uint32_t> block(n);
+  vector<uint32_t> result(n);
+  uint32_t state = 1;
+  for (size_t i = 0; i < n; i++) {
+    // IBM floats with a fraction, which ibm_to_float needs to return.
+    block[i] = NextRandom(&state) | 0x00100000;
+  }
+  float *to = (float *)result.data();
+  printf("%-14s %-8s %10s\n", "conversion", "routine", "GB/s read");
+  struct Case {
+    const char *name;
+    double bytes;
+    function<void()> reference;
+    function<void()> conversion;
+  };
+  vector<Case> cases = {
+      {"ibm to float", n * 4.0,
+       [&]() { ibm_to_float((int *)block.data(), (int *)to, n, endian); },
+       [&]() { IbmToFloat(block.data(), to, n); }},
+      {"float to ibm", n * 4.0,
+       [&]() { ieee2ibm(result.data(), block.data(), n); },
+       [&]() { FloatToIbm((float *)block.data(), result.data(), n); }},
+      {"int4 to float", n * 4.0,
+       [&]() {
+         for (size_t i = 0; i < n; i++) {
+           to[i] = (float)(int)ntohl(block[i]);
+         }
+       },
+       [&]() { Int4ToFloat(block.data(), to, n); }},
+      {"int2 to float", n * 2.0,
+       [&]() { short_to_float((short *)block.data(), to, n, endian); },
+       [&]() { Int2ToFloat(block.data(), to, n); }},
+      {"int1 to float", n * 1.0,
+       [&]() { integer1_to_float((signed char *)block.data(), to, n); },
+       [&]() { Int1ToFloat(block.data(), to, n); }},
+      {"swap 4 bytes", n * 4.0,
+       [&]() {
+         for (size_t i = 0; i < n; i++) {
+           swap_float_4(to + i);
+         }
+       },
+       [&]() { SwapBytes4(to, to, n); }},
+      {"swap 2 bytes", n * 4.0,
+       [&]() {
+         for (size_t i = 0; i < 2 * n; i++) {
+           swap_short_2((short *)to + i);
+         }
+       },
+       [&]() { SwapBytes2(to, to, 2 * n); }},
+      {"trace headers", HEADER_COUNT * (double)SEGY_HDRBYTES,
+       [&]() {
+         SwapHeadersReference((unsigned char *)to, HEADER_COUNT,
+                              SEGY_HDRBYTES);
+       },
+       [&]() { SwapTraceHeaders(to, HEADER_COUNT, SEGY_HDRBYTES); }},
+  };
+  vector<ConvertIsa> isas = GetIsas();
+  for (Case &bench : cases) {
+    PrintResult(bench.name, "su", bench.bytes, TimeRuns(bench.reference));
+    for (ConvertIsa isa : isas) {
+      SetIsa(isa);
+      PrintResult(bench.name, GetIsaName(isa), bench.bytes,
+                  TimeRuns(bench.conversion));
+    }
+  }
+  SetIsa(DetectIsa());
+}
+
+// A conversion of n values, from and to the given blocks.
+typedef function<void(const void *from, void *to, size_t n)> Conversion;
+
+// The conversions which differ from the scalar routine.
+static int failures = 0;
+
+// Compares the bytes given by the selected instruction set to the ones of
+// the scalar routine, printing the first difference.
+static void Compare(const char *conversion, const char *mode,
+                    const void *expected, const void *result, size_t size) {
+  if (memcmp(expected, result, size) == 0) {
+    return;
+  }
+  const unsigned char *e = (const unsigned char *)expected;
+  const unsigned char *r = (const unsigned char *)result;
+  size_t first = 0;
+  while (e[first] == r[first]) {
+    first++;
+  }
+  printf("%s %s differs with %s at byte %zu of the block\n", conversion,
+         mode, GetIsaName(GetIsa()), first);
+  failures++;
+}
+
+// Converts the input with each instruction set, in place too if the
+// conversion allows it, and compares the results to the expected bytes.
+static void Verify(const char *name, const Conversion &convert,
+                   const void *input, size_t input_size,
+                   const void *expected, size_t expected_size, size_t n,
+                   bool in_place, vector<unsigned char> &result) {
+  result.resize(max(input_size, expected_size));
+  for (ConvertIsa isa : GetIsas()) {
+    SetIsa(isa);
+    convert(input, result.data(), n);
+    Compare(name, "", expected, result.data(), expected_size);
+    if (in_place) {
+      memcpy(result.data(), input, input_size);
+      convert(result.data(), result.data(), n);
+      Compare(name, "in place", expected, result.data(), expected_size);
+    }
+  }
+  SetIsa(DetectIsa());
+}
+
+// Verifies the 4 byte conversions on all the 2^32 values, a block at a time.
+static void Verify4Bytes() {
+  size_t n = BLOCK_VALUES;
+  size_t size = n * 4;
+  vector<uint32_t> input(n);
+  vector<uint32_t> ibm(n);
+  vector<uint32_t> expected(n);
+  vector<unsigned char> result;
+  for (uint64_t start = 0; start < (1ull << 32); start += n) {
+    for (size_t i = 0; i < n; i++) {
+      uint32_t value = (uint32_t)(start + i);
+      input[i] = value;
+      // ibm_to_float never returns for the values with a zero fraction
+      // besides zero, which IbmToFloat converts to zero.
+      ibm[i] = htonl(value & 0x00ffffff ? value : 0);
+    }
+    ibm_to_float((int *)ibm.data(), (int *)expected.data(), n, endian);
+    Verify("ibm to float",
+           [](const void *from, void *to, size_t count) {
+             IbmToFloat(from, (float *)to, count);
+           },
+           ibm.data(), size, expected.data(), size, n, true, result);
+    ieee2ibm(expected.data(), input.data(), n);
+    Verify("float to ibm",
+           [](const void *from, void *to, size_t count) {
+             FloatToIbm((const float *)from, to, count);
+           },
+           input.data(), size, expected.data(), size, n, true, result);
+    float *integers = (float *)expected.data();
+    for (size_t i = 0; i < n; i++) {
+      integers[i] = (float)(int)ntohl(input[i]);
+    }
+    Verify("int4 to float",
+           [](const void *from, void *to, size_t count) {
+             Int4ToFloat(from, (float *)to, count);
+           },
+           input.data(), size, expected.data(), size, n, true, result);
+    memcpy(expected.data(), input.data(), size);
+    for (size_t i = 0; i < n; i++) {
+      swap_float_4((float *)expected.data() + i);
+    }
+    Verify("swap 4 bytes", SwapBytes4, input.data(), size, expected.data(),
+           size, n, true, result);
+  }
+}
+
+// Verifies the 2 and 1 byte conversions on all their values.
+static void VerifySmallValues() {
+  size_t n = 1 << 16;
+  vector<short> input(n);
+  vector<short> swapped(n);
+  vector<float> expected(n);
+  vector<unsigned char> result;
+  for (size_t i = 0; i < n; i++) {
+    input[i] = (short)i;
+  }
+  // short_to_float swaps its input in place.
+  swapped = input;
+  short_to_float(swapped.data(), expected.data(), n, endian);
+  Verify("int2 to float",
+         [](const void *from, void *to, size_t count) {
+           Int2ToFloat(from, (float *)to, count);
+         },
+         input.data(), n * 2, expected.data(), n * 4, n, false, result);
+  Verify("swap 2 bytes", SwapBytes2, input.data(), n * 2, swapped.data(),
+         n * 2, n, true, result);
+  signed char bytes[256];
+  for (int i = 0; i < 256; i++) {
+    bytes[i] = (signed char)i;
+  }
+  integer1_to_float(bytes, expected.data(), 256);
+  Verify("int1 to float",
+         [](const void *from, void *to, size_t count) {
+           Int1ToFloat(from, (float *)to, count);
+         },
+         bytes, 256, expected.data(), 256 * 4, 256, false, result);
+}
+
+// Verifies the swap of random trace headers, at the stride of the headers
+// alone and of traces of a few samples, which must be kept.
+static void VerifyHeaders() {
+  uint32_t state = 1;
+  vector<unsigned char> result;
+  for (size_t stride : {(size_t)SEGY_HDRBYTES, (size_t)SEGY_HDRBYTES + 100}) {
+    size_t size = HEADER_COUNT * stride;
+    vector<unsigned char> input(size);
+    for (size_t i = 0; i < size; i++) {
+      input[i] = NextRandom(&state);
+    }
+    vector<unsigned char> expected = input;
+    SwapHeadersReference(expected.data(), HEADER_COUNT, stride);
+    Verify("trace headers",
+           [stride](const void *from, void *to, size_t count) {
+             if (to != from) {
+               memcpy(to, from, count * stride);
+             }
+             SwapTraceHeaders(to, count, stride);
+           },
+           input.data(), size, expected.data(), size, HEADER_COUNT, true,
+           result);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  printf("Detected instruction set : %s\n", GetIsaName(DetectIsa()));
+  if (argc > 1 && strcmp(argv[1], "verify") == 0) {
+    VerifySmallValues();
+    VerifyHeaders();
+    Verify4Bytes();
+    if (failures > 0) {
+      printf("%d conversions differ from the scalar routines\n", failures);
+      return 1;
+    }
+    printf("All the conversions match the scalar routines\n");
+    return 0;
+  }
+  Bench();
+  return 0;
+}
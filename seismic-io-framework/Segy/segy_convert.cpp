@@ -0,0 +1,302 @@
+#include "segy_convert.h"
+#include "suheaders.h"
+
+#include <cstdint>
+#include <cstring>
+#include <endian.h>
+#include <immintrin.h>
+
+namespace suconvert {
+
+// The values of the blocks may only be aligned to their size in the files.
+typedef uint32_t Bytes4 __attribute__((aligned(1), may_alias));
+typedef uint16_t Bytes2 __attribute__((aligned(1), may_alias));
+
+/////////////////////////////////////////////////////////////////////////////
+//////////////////////////////// Elements ///////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+// The conversions of single values, written with selects instead of branches
+// so the loops over them are vectorized.
+
+struct IbmToFloatElement {
+  typedef Bytes4 From;
+  typedef Bytes4 To;
+  static inline uint32_t Apply(uint32_t value) {
+    uint32_t ibm = be32toh(value);
+    // The fraction is converted exactly, which normalizes it, and its
+    // exponent is moved from base 16 offset 64 to base 2 offset 127 with the
+    // radix point before the 24 bits of the fraction.
+    uint32_t fraction = ibm & 0x00ffffff;
+    float normalized = (float)(int32_t)fraction;
+    uint32_t bits;
+    memcpy(&bits, &normalized, sizeof(bits));
+    int32_t exponent =
+        (int32_t)(bits >> 23) + (int32_t)((ibm >> 22) & 0x1fc) - 280;
+    uint32_t sign = ibm & 0x80000000;
+    uint32_t result = sign | ((uint32_t)exponent << 23) | (bits & 0x007fffff);
+    // The overflows are clamped to the largest float and the underflows
+    // flushed to zero, as by ibm_to_float.
+    result = exponent > 254 ? sign | 0x7f7fffff : result;
+    return exponent <= 0 || fraction == 0 ? 0 : result;
+  }
+};
+
+struct FloatToIbmElement {
+  typedef Bytes4 From;
+  typedef Bytes4 To;
+  static inline uint32_t Apply(uint32_t bits) {
+    // The steps of ieee2ibm, with the renormalization of the denormals
+    // unrolled : their fraction is at least 2^7 after the shift, so 6 steps
+    // of 4 bits bring it to 2^28.
+    uint32_t sign = bits >> 31;
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t fraction = bits << 9;
+    uint32_t digits = exponent > 0 ? (fraction >> 1) | 0x80000000 : fraction;
+    uint32_t biased = exponent + 130;
+    digits >>= -biased & 3;
+    biased = (biased + 3) >> 2;
+    for (int step = 0; step < 6; step++) {
+      uint32_t shift = digits != 0 && digits < 0x10000000 ? 1 : 0;
+      digits <<= shift * 4;
+      biased -= shift;
+    }
+    uint32_t result = (digits >> 8) | (biased << 24) | (sign << 31);
+    result = exponent == 0 && fraction == 0 ? sign << 31 : result;
+    // Infinities and NaNs are mapped to the largest IBM float.
+    result = exponent == 255 ? 0x7fffffff | (sign << 31) : result;
+    return htobe32(result);
+  }
+};
+
+struct Int4ToFloatElement {
+  typedef Bytes4 From;
+  typedef float To;
+  static inline float Apply(uint32_t value) {
+    return (float)(int32_t)be32toh(value);
+  }
+};
+
+struct Int2ToFloatElement {
+  typedef Bytes2 From;
+  typedef float To;
+  static inline float Apply(uint16_t value) {
+    return (float)(int16_t)be16toh(value);
+  }
+};
+
+struct Int1ToFloatElement {
+  typedef int8_t From;
+  typedef float To;
+  static inline float Apply(int8_t value) { return (float)value; }
+};
+
+struct Swap4Element {
+  typedef Bytes4 From;
+  typedef Bytes4 To;
+  static inline uint32_t Apply(uint32_t value) {
+    return __builtin_bswap32(value);
+  }
+};
+
+struct Swap2Element {
+  typedef Bytes2 From;
+  typedef Bytes2 To;
+  static inline uint16_t Apply(uint16_t value) {
+    return __builtin_bswap16(value);
+  }
+};
+
+// Converts a block of values, inlined in the functions of each instruction
+// set. Every value is read before it is written, so the block may be
+// converted in place when both have the same size.
+template <class Element>
+__attribute__((always_inline)) inline void ConvertBlock(const void *from,
+                                                        void *to, size_t n) {
+  const typename Element::From *source = (const typename Element::From *)from;
+  typename Element::To *destination = (typename Element::To *)to;
+#pragma omp simd
+  for (size_t i = 0; i < n; i++) {
+    destination[i] = Element::Apply(source[i]);
+  }
+}
+
+typedef void (*BlockFunction)(const void *from, void *to, size_t n);
+
+template <class Element>
+void ConvertScalar(const void *from, void *to, size_t n) {
+  ConvertBlock<Element>(from, to, n);
+}
+
+template <class Element>
+__attribute__((target("avx2"))) void ConvertAvx2(const void *from, void *to,
+                                                 size_t n) {
+  ConvertBlock<Element>(from, to, n);
+}
+
+template <class Element>
+__attribute__((target("avx512f,avx512bw"))) void
+ConvertAvx512(const void *from, void *to, size_t n) {
+  ConvertBlock<Element>(from, to, n);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////// Trace headers /////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+// The source byte of each byte of a swapped trace header, built from the keys
+// of hdr. The fields are aligned to their size, so none of them crosses the
+// 16 bytes chunks swapped by a byte shuffle each.
+struct HeaderPermutation {
+  unsigned char bytes[SEGY_HDRBYTES];
+  HeaderPermutation() {
+    for (int i = 0; i < SEGY_HDRBYTES; i++) {
+      bytes[i] = i;
+    }
+    for (int key = 0; key < SEGY_NKEYS; key++) {
+      int size;
+      switch (*hdr[key].type) {
+      case 'h':
+      case 'u':
+        size = 2;
+        break;
+      case 'd':
+        size = 8;
+        break;
+      default:
+        size = 4;
+      }
+      for (int i = 0; i < size; i++) {
+        bytes[hdr[key].offs + i] = hdr[key].offs + size - 1 - i;
+      }
+    }
+  }
+};
+
+static const HeaderPermutation header_permutation;
+
+static void SwapHeadersScalar(void *headers, size_t count, size_t stride) {
+  unsigned char swapped[SEGY_HDRBYTES];
+  for (size_t h = 0; h < count; h++) {
+    unsigned char *header = (unsigned char *)headers + h * stride;
+    for (int i = 0; i < SEGY_HDRBYTES; i++) {
+      swapped[i] = header[header_permutation.bytes[i]];
+    }
+    memcpy(header, swapped, SEGY_HDRBYTES);
+  }
+}
+
+__attribute__((target("avx2"))) static void
+SwapHeadersAvx2(void *headers, size_t count, size_t stride) {
+  const int chunks = SEGY_HDRBYTES / 16;
+  __m128i masks[chunks];
+  for (int c = 0; c < chunks; c++) {
+    char mask[16];
+    for (int i = 0; i < 16; i++) {
+      mask[i] = header_permutation.bytes[c * 16 + i] - c * 16;
+    }
+    masks[c] = _mm_loadu_si128((const __m128i *)mask);
+  }
+  for (size_t h = 0; h < count; h++) {
+    __m128i *header = (__m128i *)((char *)headers + h * stride);
+    for (int c = 0; c < chunks; c++) {
+      _mm_storeu_si128(header + c, _mm_shuffle_epi8(
+                                       _mm_loadu_si128(header + c), masks[c]));
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///////////////////////////////// Dispatch //////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+struct Conversions {
+  BlockFunction ibm_to_float;
+  BlockFunction float_to_ibm;
+  BlockFunction int4_to_float;
+  BlockFunction int2_to_float;
+  BlockFunction int1_to_float;
+  BlockFunction swap4;
+  BlockFunction swap2;
+  void (*swap_headers)(void *headers, size_t count, size_t stride);
+};
+
+#define CONVERSIONS(Convert, swap_headers)                                     \
+  {                                                                            \
+    Convert<IbmToFloatElement>, Convert<FloatToIbmElement>,                    \
+        Convert<Int4ToFloatElement>, Convert<Int2ToFloatElement>,              \
+        Convert<Int1ToFloatElement>, Convert<Swap4Element>,                    \
+        Convert<Swap2Element>, swap_headers                                    \
+  }
+
+// The conversions of each instruction set, in the order of ConvertIsa.
+static const Conversions isa_conversions[] = {
+    CONVERSIONS(ConvertScalar, SwapHeadersScalar),
+    CONVERSIONS(ConvertAvx2, SwapHeadersAvx2),
+    CONVERSIONS(ConvertAvx512, SwapHeadersAvx2)};
+
+static ConvertIsa selected_isa = DetectIsa();
+
+ConvertIsa DetectIsa() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") &&
+      __builtin_cpu_supports("avx512bw")) {
+    return CONVERT_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return CONVERT_AVX2;
+  }
+  return CONVERT_SCALAR;
+}
+
+void SetIsa(ConvertIsa isa) {
+  ConvertIsa supported = DetectIsa();
+  selected_isa = isa > supported ? supported : isa;
+}
+
+ConvertIsa GetIsa() { return selected_isa; }
+
+const char *GetIsaName(ConvertIsa isa) {
+  switch (isa) {
+  case CONVERT_AVX512:
+    return "avx512";
+  case CONVERT_AVX2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+void IbmToFloat(const void *from, float *to, size_t n) {
+  isa_conversions[selected_isa].ibm_to_float(from, to, n);
+}
+
+void FloatToIbm(const float *from, void *to, size_t n) {
+  isa_conversions[selected_isa].float_to_ibm(from, to, n);
+}
+
+void Int4ToFloat(const void *from, float *to, size_t n) {
+  isa_conversions[selected_isa].int4_to_float(from, to, n);
+}
+
+void Int2ToFloat(const void *from, float *to, size_t n) {
+  isa_conversions[selected_isa].int2_to_float(from, to, n);
+}
+
+void Int1ToFloat(const void *from, float *to, size_t n) {
+  isa_conversions[selected_isa].int1_to_float(from, to, n);
+}
+
+void SwapBytes4(const void *from, void *to, size_t n) {
+  isa_conversions[selected_isa].swap4(from, to, n);
+}
+
+void SwapBytes2(const void *from, void *to, size_t n) {
+  isa_conversions[selected_isa].swap2(from, to, n);
+}
+
+void SwapTraceHeaders(void *headers, size_t count, size_t stride) {
+  isa_conversions[selected_isa].swap_headers(headers, count, stride);
+}
+
+} // namespace suconvert
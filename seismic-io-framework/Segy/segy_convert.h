@@ -0,0 +1,95 @@
+#ifndef SEGY_CONVERT_H
+#define SEGY_CONVERT_H
+
+#include <cstddef>
+
+/*!
+ * Conversions of blocks of SEG-Y samples and trace headers between the big
+ * endian formats of the files and the native values of the machine.
+ *
+ * Each conversion is compiled for several instruction sets through the target
+ * attribute, the values being converted without branches so the loops are
+ * vectorized, and the widest one supported by the cpu is selected at runtime.
+ * They give the same bits as the scalar routines of segy_helpers and swapbyte.
+ */
+namespace suconvert {
+
+enum ConvertIsa { CONVERT_SCALAR, CONVERT_AVX2, CONVERT_AVX512 };
+
+/*!
+ * Detects the widest instruction set the conversions support on the running
+ * cpu.
+ */
+ConvertIsa DetectIsa();
+
+/*!
+ * Selects the instruction set of the conversions, the one detected by
+ * default. An instruction set that isn't supported by the cpu falls back to
+ * the widest supported one.
+ */
+void SetIsa(ConvertIsa isa);
+
+ConvertIsa GetIsa();
+
+/*!
+ * Gets a printable name of the instruction set.
+ */
+const char *GetIsaName(ConvertIsa isa);
+
+/*!
+ * Converts n big endian IBM floats to native floats, like ibm_to_float. The
+ * IBM values with a zero fraction, for which ibm_to_float never returns, are
+ * converted to zero. to may be the same as from.
+ */
+void IbmToFloat(const void *from, float *to, size_t n);
+
+/*!
+ * Converts n native floats to big endian IBM floats, like ieee2ibm. to may be
+ * the same as from.
+ */
+void FloatToIbm(const float *from, void *to, size_t n);
+
+/*!
+ * Converts n big endian 4 byte integers to native floats. to may be the same
+ * as from.
+ */
+void Int4ToFloat(const void *from, float *to, size_t n);
+
+/*!
+ * Converts n big endian 2 byte integers to native floats, like
+ * short_to_float. from and to must not overlap.
+ */
+void Int2ToFloat(const void *from, float *to, size_t n);
+
+/*!
+ * Converts n 1 byte integers to native floats, like integer1_to_float. from
+ * and to must not overlap.
+ */
+void Int1ToFloat(const void *from, float *to, size_t n);
+
+/*!
+ * Reverses the bytes of n 4 byte values, like swap_float_4. to may be the
+ * same as from.
+ */
+void SwapBytes4(const void *from, void *to, size_t n);
+
+/*!
+ * Reverses the bytes of n 2 byte values, like swap_short_2. to may be the
+ * same as from.
+ */
+void SwapBytes2(const void *from, void *to, size_t n);
+
+/*!
+ * Reverses the bytes of the fields of count trace headers, like swaphval on
+ * the SEGY_NKEYS keys of each of them. The bytes of the unassigned end of the
+ * headers are kept.
+ * @param headers
+ * The first trace header, in the layout of the segy structure.
+ * @param stride
+ * The bytes from a header to the next one.
+ */
+void SwapTraceHeaders(void *headers, size_t count, size_t stride);
+
+} // namespace suconvert
+
+#endif // SEGY_CONVERT_H
@@ -0,0 +1,194 @@
+#include "segy_index.h"
+#include "susegy.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Identifies the sidecar files, and their layout version.
+#define SEGY_INDEX_MAGIC "SEGYIDX1"
+#define SEGY_INDEX_MAGIC_BYTES 8
+
+SegyIndex::SegyIndex(string file_name, string key_name) {
+  this->file_name = file_name;
+  this->index_name = file_name + "." + key_name + ".idx";
+  // The offsets of fldr and ensemble_number in the trace headers.
+  if (key_name == "CSR") {
+    key_offset = 8;
+  } else if (key_name == "CDP") {
+    key_offset = 20;
+  } else {
+    cout << "Invalid key for ID parsing : " << key_name << std::endl;
+    cout << "Only CSR or CDP are supported as sort type" << std::endl;
+    exit(0);
+  }
+  file_size = 0;
+  modification_seconds = 0;
+  modification_nanoseconds = 0;
+  data_offset = 0;
+  trace_bytes = 0;
+}
+
+bool SegyIndex::Load() {
+  struct stat status;
+  if (stat(file_name.c_str(), &status) != 0) {
+    return false;
+  }
+  file_size = status.st_size;
+  modification_seconds = status.st_mtim.tv_sec;
+  modification_nanoseconds = status.st_mtim.tv_nsec;
+  if (ReadIndex()) {
+    return true;
+  }
+  if (!Build()) {
+    return false;
+  }
+  WriteIndex();
+  return true;
+}
+
+bool SegyIndex::ReadIndex() {
+  ifstream index(index_name.c_str(), ifstream::binary);
+  if (!index.is_open()) {
+    return false;
+  }
+  char magic[SEGY_INDEX_MAGIC_BYTES];
+  size_t size;
+  long seconds;
+  long nanoseconds;
+  uint offset;
+  index.read(magic, SEGY_INDEX_MAGIC_BYTES);
+  index.read((char *)&size, sizeof(size));
+  index.read((char *)&seconds, sizeof(seconds));
+  index.read((char *)&nanoseconds, sizeof(nanoseconds));
+  index.read((char *)&offset, sizeof(offset));
+  if (!index ||
+      memcmp(magic, SEGY_INDEX_MAGIC, SEGY_INDEX_MAGIC_BYTES) != 0 ||
+      size != file_size || seconds != modification_seconds ||
+      nanoseconds != modification_nanoseconds || offset != key_offset) {
+    // The SEG-Y file changed since the index was built.
+    return false;
+  }
+  size_t shot_count;
+  index.read((char *)&data_offset, sizeof(data_offset));
+  index.read((char *)&trace_bytes, sizeof(trace_bytes));
+  index.read((char *)&shot_count, sizeof(shot_count));
+  shots.clear();
+  for (size_t i = 0; i < shot_count && index; i++) {
+    uint shot_id;
+    size_t range_count;
+    index.read((char *)&shot_id, sizeof(shot_id));
+    index.read((char *)&range_count, sizeof(range_count));
+    vector<pair<size_t, size_t>> &ranges = shots[shot_id];
+    ranges.resize(range_count);
+    index.read((char *)ranges.data(),
+               range_count * sizeof(pair<size_t, size_t>));
+  }
+  if (!index) {
+    cout << "Index '" << index_name << "' is truncated, rebuilding it"
+         << endl;
+    shots.clear();
+    return false;
+  }
+  return true;
+}
+
+bool SegyIndex::Build() {
+  int descriptor = open(file_name.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    return false;
+  }
+  SUSegy segy_file;
+  segy_file.ReadBinaryHeader(file_name, false);
+  trace_bytes = segy_file.getNsegy();
+  data_offset = segy_file.getDataOffset();
+  size_t trace_count =
+      file_size > data_offset ? (file_size - data_offset) / trace_bytes : 0;
+  cout << "Indexing the " << trace_count << " traces of " << file_name
+       << endl;
+  // Only the key of each trace header is read, the threads reading
+  // interleaved parts of the file.
+  vector<uint> keys(trace_count);
+  bool complete = true;
+#pragma omp parallel for schedule(static)
+  for (long trace = 0; trace < (long)trace_count; trace++) {
+    uint value;
+    if (pread(descriptor, &value, sizeof(value),
+              data_offset + trace * trace_bytes + key_offset) !=
+        sizeof(value)) {
+      complete = false;
+    }
+    keys[trace] = ntohl(value);
+  }
+  close(descriptor);
+  if (!complete) {
+    return false;
+  }
+  shots.clear();
+  size_t first = 0;
+  for (size_t trace = 1; trace <= trace_count; trace++) {
+    if (trace == trace_count || keys[trace] != keys[first]) {
+      shots[keys[first]].push_back(make_pair(first, trace - first));
+      first = trace;
+    }
+  }
+  return true;
+}
+
+void SegyIndex::WriteIndex() {
+  // The index is written aside then renamed, so a concurrent reader never
+  // sees it partially written.
+  string temporary_name = index_name + "." + to_string(getpid());
+  ofstream index(temporary_name.c_str(), ofstream::binary);
+  if (!index.is_open()) {
+    cout << "Could not write the index '" << index_name
+         << "', it will be rebuilt by the next run" << endl;
+    return;
+  }
+  size_t shot_count = shots.size();
+  index.write(SEGY_INDEX_MAGIC, SEGY_INDEX_MAGIC_BYTES);
+  index.write((char *)&file_size, sizeof(file_size));
+  index.write((char *)&modification_seconds, sizeof(modification_seconds));
+  index.write((char *)&modification_nanoseconds,
+              sizeof(modification_nanoseconds));
+  index.write((char *)&key_offset, sizeof(key_offset));
+  index.write((char *)&data_offset, sizeof(data_offset));
+  index.write((char *)&trace_bytes, sizeof(trace_bytes));
+  index.write((char *)&shot_count, sizeof(shot_count));
+  for (auto &shot : shots) {
+    size_t range_count = shot.second.size();
+    index.write((char *)&shot.first, sizeof(shot.first));
+    index.write((char *)&range_count, sizeof(range_count));
+    index.write((char *)shot.second.data(),
+                range_count * sizeof(pair<size_t, size_t>));
+  }
+  index.close();
+  if (!index || rename(temporary_name.c_str(), index_name.c_str()) != 0) {
+    cout << "Could not write the index '" << index_name
+         << "', it will be rebuilt by the next run" << endl;
+    remove(temporary_name.c_str());
+  }
+}
+
+vector<uint> SegyIndex::GetShots(uint min_threshold,
+                                 uint max_threshold) const {
+  vector<uint> results;
+  for (auto it = shots.lower_bound(min_threshold);
+       it != shots.end() && it->first <= max_threshold; it++) {
+    results.push_back(it->first);
+  }
+  return results;
+}
+
+vector<pair<size_t, size_t>> SegyIndex::GetRanges(uint shot_id) const {
+  auto it = shots.find(shot_id);
+  if (it == shots.end()) {
+    return vector<pair<size_t, size_t>>();
+  }
+  return it->second;
+}
@@ -0,0 +1,68 @@
+#ifndef SEGY_INDEX_H
+#define SEGY_INDEX_H
+
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*!
+ * The index of the shots of a SEG-Y file : the ranges of contiguous traces of
+ * each value of a trace header key, so a shot is read without scanning the
+ * file.
+ *
+ * It is kept in a sidecar file next to the SEG-Y one, reused as long as the
+ * size and modification time of the SEG-Y file are the ones it was built
+ * from, and rebuilt otherwise by reading the key of all the trace headers in
+ * parallel.
+ */
+class SegyIndex {
+private:
+  string file_name;
+  string index_name;
+  // The byte offset of the key in the trace headers.
+  uint key_offset;
+  size_t file_size;
+  long modification_seconds;
+  long modification_nanoseconds;
+  size_t data_offset;
+  size_t trace_bytes;
+  // The ranges of each shot, as their first trace and count, in file order.
+  map<uint, vector<pair<size_t, size_t>>> shots;
+
+  bool ReadIndex();
+  bool Build();
+  void WriteIndex();
+
+public:
+  /*!
+   * @param file_name
+   * The SEG-Y file.
+   * @param key_name
+   * The key of the shots, CSR for the field record number or CDP for the
+   * ensemble number.
+   */
+  SegyIndex(string file_name, string key_name);
+  /*!
+   * Reads the sidecar index, building and writing it if it is missing or
+   * outdated.
+   * @return
+   * False if the SEG-Y file can't be read.
+   */
+  bool Load();
+  /*!
+   * @return
+   * The shots within the thresholds, in increasing order.
+   */
+  vector<uint> GetShots(uint min_threshold, uint max_threshold) const;
+  /*!
+   * @return
+   * The trace ranges of a shot, empty if it isn't in the file.
+   */
+  vector<pair<size_t, size_t>> GetRanges(uint shot_id) const;
+};
+
+#endif // SEGY_INDEX_H
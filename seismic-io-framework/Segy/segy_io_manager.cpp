@@ -2,22 +2,33 @@
 
 SEGYIOManager::SEGYIOManager() {}
 
-SEGYIOManager::~SEGYIOManager() {}
+SEGYIOManager::~SEGYIOManager() {
+  for (auto &index : indices) {
+    delete index.second;
+  }
+}
+
+SegyIndex *SEGYIOManager::GetIndex(string file_name, string key_name) {
+  string name = file_name + "." + key_name;
+  if (indices.find(name) == indices.end()) {
+    SegyIndex *index = new SegyIndex(file_name, key_name);
+    if (!index->Load()) {
+      delete index;
+      index = nullptr;
+    }
+    indices[name] = index;
+  }
+  return indices[name];
+}
 
 vector<uint> SEGYIOManager::GetUniqueOccurences(string file_name, string key_name, uint min_threshold, uint max_threshold) {
-	SUSegy *seg = new SUSegy();
-	vector<SEGYelement> conditions;
-	if (key_name == "CSR") {
-		conditions.push_back(SEGYelement(&segy::fldr));
-	} else if (key_name == "CDP") {
-		conditions.push_back(SEGYelement(&segy::ensemble_number));
-	} else {
-	    cout << "Invalid key for ID parsing : " << key_name << std::endl;
-	    cout << "Only CSR or CDP are supported as sort type" << std::endl;
-	    exit(0);
+	// The shots are listed from the index of the file, built by the first run.
+	SegyIndex *index = GetIndex(file_name, key_name);
+	if (index == nullptr) {
+	    cout << "File '" << file_name << "' could not be opened, will be skipped" << std::endl;
+	    return vector<uint>();
 	}
-	vector<uint> unique_occurences = seg->GetUniqueOccurences(file_name, &conditions, min_threshold, max_threshold);
-	return unique_occurences;
+	return index->GetShots(min_threshold, max_threshold);
 }
 
 // data ypr to diffrentaiate between trace and velocitie/density file
@@ -175,19 +186,13 @@ void SEGYIOManager::ReadSelectiveDataFromFile(string file_name,
 
   SUSegy *seg = new SUSegy();
 
-  //    SeisIO * sei = new SeisIO();
-
-  vector<SEGYelement> conditions;
-  if (sort_type == "CSR") {
-      conditions.push_back(SEGYelement(&segy::fldr, cond));
-  } else if (sort_type == "CDP") {
-      conditions.push_back(SEGYelement(&segy::ensemble_number, cond));
-  } else {
-      cout << "Invalid key for ID parsing : " << sort_type << std::endl;
-      cout << "Only CSR or CDP are supported as sort type" << std::endl;
-      exit(0);
+  // Only the traces of the shot are read, at their ranges in the index.
+  SegyIndex *index = GetIndex(file_name, sort_type);
+  if (index == nullptr) {
+      cout << "ERROR:: file '" << file_name << "' doesn't exit" << endl;
+      exit(EXIT_FAILURE);
   }
-  seg->ReadHeadersAndTraces(file_name, &conditions, suselect::ifequal);
+  seg->ReadTraces(file_name, index->GetRanges(cond));
 
   // cout << "segy values" << seg->bh.hns << endl;
 
@@ -4,6 +4,7 @@
 #include "../IO/io_manager.h"
 #include "../datatypes.h"
 #include "math.h"
+#include "segy_index.h"
 #include "susegy.h"
 
 inline float dBtoscale(float x) {
@@ -13,10 +14,16 @@ inline float dBtoscale(float x) {
 }
 
 class SEGYIOManager : public IOManager {
+private:
+  // The shot indices of the files, by file and key.
+  map<string, SegyIndex *> indices;
 
 public:
   SEGYIOManager();
 
+  // Loads the index of a file on first use, null if the file can't be read.
+  SegyIndex *GetIndex(string file_name, string key_name);
+
   ~SEGYIOManager();
 
   void ReadTracesDataFromFile(string file_name, string sort_type,
@@ -0,0 +1,137 @@
+#include "segy_mapped_file.h"
+#include "segy_convert.h"
+#include "segy_helpers.h"
+#include "susegy.h"
+
+#include <fcntl.h>
+#include <iostream>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SegyMappedFile::SegyMappedFile() {
+  data = nullptr;
+  size = 0;
+  data_offset = 0;
+  trace_bytes = 0;
+  trace_count = 0;
+  memset(&bh, 0, sizeof(bh));
+}
+
+SegyMappedFile::~SegyMappedFile() { Close(); }
+
+bool SegyMappedFile::Open(string file_name) {
+  Close();
+  int descriptor = open(file_name.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    return false;
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+    close(descriptor);
+    return false;
+  }
+  size = status.st_size;
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (mapping == MAP_FAILED) {
+    size = 0;
+    return false;
+  }
+  // The traces are read from start to end.
+  madvise(mapping, size, MADV_SEQUENTIAL);
+  data = (const unsigned char *)mapping;
+  // The binary header decoding is shared with SUSegy.
+  SUSegy segy_file;
+  segy_file.ReadBinaryHeader(file_name, false);
+  memcpy(&bh, &segy_file.bh, sizeof(bh));
+  trace_bytes = segy_file.getNsegy();
+  data_offset = segy_file.getDataOffset();
+  trace_count = size > data_offset ? (size - data_offset) / trace_bytes : 0;
+  this->file_name = file_name;
+  return true;
+}
+
+void SegyMappedFile::Close() {
+  if (data != nullptr) {
+    munmap((void *)data, size);
+    data = nullptr;
+  }
+  size = 0;
+  trace_count = 0;
+  file_name.clear();
+}
+
+string SegyMappedFile::GetFileName() const { return file_name; }
+
+size_t SegyMappedFile::GetTraceCount() const { return trace_count; }
+
+const bhed &SegyMappedFile::GetBinaryHeader() const { return bh; }
+
+uint SegyMappedFile::GetSampleCount() const { return bh.hns; }
+
+SegyTraceHeader SegyMappedFile::GetHeader(size_t trace) const {
+  return SegyTraceHeader(data + data_offset + trace * trace_bytes);
+}
+
+void SegyMappedFile::ConvertSamples(const unsigned char *raw, float *samples,
+                                    short trwf) const {
+  int ns = bh.hns;
+  // The samples are converted from the mapping to their row, by the
+  // conversions of the widest instruction set of the cpu.
+  switch (bh.format) {
+  case 1:
+    suconvert::IbmToFloat(raw, samples, ns);
+    break;
+  case 2:
+    suconvert::Int4ToFloat(raw, samples, ns);
+    break;
+  case 3:
+    suconvert::Int2ToFloat(raw, samples, ns);
+    break;
+  case 5:
+    // The machine is little endian when htons swaps, as in SUSegy.
+    if (htons(1) != 1) {
+      suconvert::SwapBytes4(raw, samples, ns);
+    } else {
+      memcpy(samples, raw, ns * sizeof(float));
+    }
+    break;
+  case 8:
+    suconvert::Int1ToFloat(raw, samples, ns);
+    break;
+  }
+  // The trace weighting of SUSegy.
+  int trcwt = (bh.format == 1 || bh.format == 5) ? 0 : 1;
+  if (trcwt && trwf != 0) {
+    float scale = pow(2.0, -trwf);
+    for (int i = 0; i < ns; ++i) {
+      samples[i] *= scale;
+    }
+  }
+}
+
+void SegyMappedFile::ReadSamples(const vector<pair<size_t, size_t>> &ranges,
+                                 float *matrix) const {
+  size_t ns = bh.hns;
+  vector<size_t> traces;
+  for (auto &range : ranges) {
+    for (size_t i = 0; i < range.second; i++) {
+      size_t trace = range.first + i;
+      if (trace >= trace_count) {
+        cout << "ERROR:: file '" << file_name << "' has no trace " << trace
+             << ", its index may be outdated" << endl;
+        exit(EXIT_FAILURE);
+      }
+      traces.push_back(trace);
+    }
+  }
+#pragma omp parallel for schedule(static)
+  for (long i = 0; i < (long)traces.size(); i++) {
+    const unsigned char *trace =
+        data + data_offset + traces[i] * trace_bytes;
+    ConvertSamples(trace + SEGY_HDRBYTES, matrix + i * ns,
+                   SegyTraceHeader(trace).trwf());
+  }
+}
@@ -0,0 +1,112 @@
+#ifndef SEGY_MAPPED_FILE_H
+#define SEGY_MAPPED_FILE_H
+
+#include "suheaders.h"
+
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*!
+ * A view of a trace header of a mapped SEG-Y file, decoding the fields it is
+ * asked for from the big endian bytes of the file, at their offsets in the
+ * SEG-Y trace header.
+ */
+class SegyTraceHeader {
+private:
+  const unsigned char *bytes;
+
+public:
+  explicit SegyTraceHeader(const unsigned char *bytes) : bytes(bytes) {}
+
+  int GetInt(uint offset) const {
+    uint value;
+    memcpy(&value, bytes + offset, sizeof(value));
+    return (int)ntohl(value);
+  }
+
+  short GetShort(uint offset) const {
+    unsigned short value;
+    memcpy(&value, bytes + offset, sizeof(value));
+    return (short)ntohs(value);
+  }
+
+  int tracl() const { return GetInt(0); }
+  int tracr() const { return GetInt(4); }
+  int fldr() const { return GetInt(8); }
+  int tracf() const { return GetInt(12); }
+  int cdp() const { return GetInt(20); }
+  int cdpt() const { return GetInt(24); }
+  short trid() const { return GetShort(28); }
+  short scalco() const { return GetShort(70); }
+  int sx() const { return GetInt(72); }
+  int sy() const { return GetInt(76); }
+  int gx() const { return GetInt(80); }
+  int gy() const { return GetInt(84); }
+  short trwf() const { return GetShort(168); }
+};
+
+/*!
+ * A SEG-Y file mapped in memory : the trace headers are read in place through
+ * views, and the samples of the traces are converted to native floats
+ * straight into a matrix of the actual number of samples per trace, instead
+ * of going through the fixed size traces of SUSegy.
+ */
+class SegyMappedFile {
+private:
+  string file_name;
+  const unsigned char *data;
+  size_t size;
+  size_t data_offset;
+  size_t trace_bytes;
+  size_t trace_count;
+  bhed bh;
+
+  // Converts the raw samples of a trace in the mapping to the row of ns
+  // native floats.
+  void ConvertSamples(const unsigned char *raw, float *samples,
+                      short trwf) const;
+
+public:
+  SegyMappedFile();
+  /*!
+   * Maps a SEG-Y file, unmapping the previous one.
+   * @return
+   * False if the file can't be mapped.
+   */
+  bool Open(string file_name);
+  void Close();
+  /*!
+   * @return
+   * The name of the mapped file, empty if none is.
+   */
+  string GetFileName() const;
+  size_t GetTraceCount() const;
+  /*!
+   * @return
+   * The binary header, in native byte order.
+   */
+  const bhed &GetBinaryHeader() const;
+  /*!
+   * @return
+   * The number of samples of each trace, from the binary header.
+   */
+  uint GetSampleCount() const;
+  SegyTraceHeader GetHeader(size_t trace) const;
+  /*!
+   * Converts the samples of traces to native floats, the traces being given
+   * as ranges of their first trace and count.
+   * @param matrix
+   * The samples, of the traces one after the other, each being
+   * GetSampleCount() floats.
+   */
+  void ReadSamples(const vector<pair<size_t, size_t>> &ranges,
+                   float *matrix) const;
+  ~SegyMappedFile();
+};
+
+#endif // SEGY_MAPPED_FILE_H
@@ -1,4 +1,5 @@
 #include "susegy.h"
+#include "segy_convert.h"
 #include <set>
 
 namespace suselect {
@@ -69,11 +70,7 @@ vector<uint> SUSegy::GetUniqueOccurences(string filename, vector<SEGYelement> *s
     if (!file) { // error in reading (reaching the end of the file)
       break;
     }
-    tapesegy_to_segy(&tapetrace, &trace); // converts to easily readable format
-                                          // (oblivious to the type int/short)
-    if (endian == 0)
-      for (int i = 0; i < SEGY_NKEYS; ++i)
-        swaphval(&trace, i); // swaps the bytes if the machine is little endian
+    DecodeHeader(&tapetrace, &trace);
     uint unique_value = suselect::GetSelected(&trace, select_element);
     if (unique_value >= min_threshold && unique_value <= max_threshold) {
       unique_ids.insert(unique_value);
@@ -208,59 +205,8 @@ void SUSegy::ReadHeadersAndTraces(
       break;
       cout << "reaching end of the file" << endl;
     }
-    tapesegy_to_segy(&tapetrace, &trace); // converts to easily readable format
-                                          // (oblivious to the type int/short)
-    if (endian == 0)
-      for (int i = 0; i < SEGY_NKEYS; ++i)
-        swaphval(&trace, i); // swaps the bytes if the machine is little endian
-    if (bh.hns != trace.ns)
-      //  dout("warning::the number of samples in the binary header is " <<
-      //  bh.hns << " and in the trace is " << trace.ns);
-      itr++; // increase the number of read traces;
-             /*  if (itr== 1 ){
-                  cout << "trace length is " << trace.ns << endl ;
-         
-                        ofstream file;
-                        file.open("bintracenew", std::ofstream::out);
-                        file.write((char*) &trace.data, trace.ns*4);
-                        file.close();
-         
-                }*/
-    switch (bh.format) {
-    case 1:
-      /* Convert IBM floats to native floats */
-      ibm_to_float((int *)trace.data, (int *)trace.data, bh.hns, endian);
-      break;
-    case 2:
-      /* Convert 4 byte integers to native floats */
-      long_to_float((long *)trace.data, (float *)trace.data, bh.hns, endian);
-      break;
-    case 3:
-      /* Convert 2 byte integers to native floats */
-      short_to_float((short *)trace.data, (float *)trace.data, bh.hns, endian);
-      break;
-    case 5:
-      /* IEEE floats.  Byte swap if necessary. */
-      if (endian == 0)
-        for (int i = 0; i < bh.hns; ++i)
-          swap_float_4(&trace.data[i]);
-      break;
-    case 8:
-      /* Convert 1 byte integers to native floats */
-      integer1_to_float((signed char *)trace.data, (float *)trace.data, bh.hns);
-      break;
-    }
-
-    /* Apply trace weighting. */
-    int trcwt = (bh.format == 1 || bh.format == 5) ? 0 : 1;
-    if (trcwt && trace.trwf != 0) {
-      float scale = pow(2.0, -trace.trwf);
-      for (int i = 0; i < bh.hns; ++i) {
-        trace.data[i] *= scale;
-      }
-    }
-
-    trace.ns = bh.hns;
+    DecodeTrace(&tapetrace, &trace);
+    itr++; // increase the number of read traces;
     shot_ids.insert(trace.fldr);
     //        cout << "trace ensemble number " << trace.fldr << endl;
     if (check_func(
@@ -282,6 +228,84 @@ void SUSegy::ReadHeadersAndTraces(
   //    file0.close();
 }
 
+void SUSegy::DecodeHeader(const tapesegy *tapetrace, segy *trace) {
+  // The fields of both headers are at the same offsets, only their bytes are
+  // swapped if the machine is little endian.
+  memcpy(trace, tapetrace, SEGY_HDRBYTES);
+  if (endian == 0)
+    suconvert::SwapTraceHeaders(trace, 1, sizeof(segy));
+}
+
+void SUSegy::DecodeTrace(tapesegy *tapetrace, segy *trace) {
+  DecodeHeader(tapetrace, trace);
+  // The samples are converted from the tape trace by the conversions of the
+  // widest instruction set of the cpu.
+  switch (bh.format) {
+  case 1:
+    /* Convert IBM floats to native floats */
+    suconvert::IbmToFloat(tapetrace->data, trace->data, bh.hns);
+    break;
+  case 2:
+    /* Convert 4 byte integers to native floats. Format 2 is read as the
+     * 4 byte two's complement integers of the SEG-Y standard, long_to_float
+     * read them as longs, which are 8 bytes on 64 bit machines. */
+    suconvert::Int4ToFloat(tapetrace->data, trace->data, bh.hns);
+    break;
+  case 3:
+    /* Convert 2 byte integers to native floats */
+    suconvert::Int2ToFloat(tapetrace->data, trace->data, bh.hns);
+    break;
+  case 5:
+    /* IEEE floats.  Byte swap if necessary. */
+    if (endian == 0)
+      suconvert::SwapBytes4(tapetrace->data, trace->data, bh.hns);
+    else
+      memcpy(trace->data, tapetrace->data, bh.hns * sizeof(float));
+    break;
+  case 8:
+    /* Convert 1 byte integers to native floats */
+    suconvert::Int1ToFloat(tapetrace->data, trace->data, bh.hns);
+    break;
+  }
+
+  /* Apply trace weighting. */
+  int trcwt = (bh.format == 1 || bh.format == 5) ? 0 : 1;
+  if (trcwt && trace->trwf != 0) {
+    float scale = pow(2.0, -trace->trwf);
+    for (int i = 0; i < bh.hns; ++i) {
+      trace->data[i] *= scale;
+    }
+  }
+
+  trace->ns = bh.hns;
+}
+
+void SUSegy::ReadTraces(string filename,
+                        const vector<pair<size_t, size_t>> &ranges) {
+  if (!file.is_open())
+    ReadBinaryHeader(filename);
+  memset((char *)bh.hunass, 0, 340);
+  size_t data_offset = getDataOffset();
+  tapesegy tapetrace;
+  segy trace;
+  for (auto &range : ranges) {
+    // The traces of a range are contiguous, only the first one is sought.
+    file.seekg(data_offset + range.first * nsegy);
+    for (size_t i = 0; i < range.second; i++) {
+      file.read((char *)&tapetrace, nsegy);
+      if (!file) {
+        cout << "ERROR:: file '" << filename << "' ended before trace "
+             << range.first + i << ", its index may be outdated" << endl;
+        exit(EXIT_FAILURE);
+      }
+      DecodeTrace(&tapetrace, &trace);
+      shot_ids.insert(trace.fldr);
+      traces.push_back(trace);
+    }
+  }
+  file.close();
+}
+
 void SUSegy::WriteHeadersAndTraces(string filename) {
 
   ofstream fileW;
@@ -334,8 +358,8 @@ void SUSegy::WriteHeadersAndTraces(string filename) {
     unsigned short ns = trace->ns;
 
     if (endian == 0) {
-      for (int i = 0; i < SEGY_NKEYS; ++i)
-        swaphval(trace, i); ///< swaps the bytes if the machine is little endian
+      // swaps the bytes if the machine is little endian
+      suconvert::SwapTraceHeaders(trace, 1, sizeof(segy));
     };
     /** Set/check trace header words */
     if (trace->ns != bh.hns && le32toh(trace->ns) != bh.hns) {
@@ -355,10 +379,10 @@ void SUSegy::WriteHeadersAndTraces(string filename) {
       }
     }
 
-    ieee2ibm(trace->data, trace->data, ns);
-
-    /* Convert from longs/shorts to bytes*/
-    segy_to_tapesegy(trace, &tapetr, nsegy);
+    /* Copy the header, laid out as the tape one, and convert the samples to
+     * IBM floats in the tape trace */
+    memcpy(&tapetr, trace, SEGY_HDRBYTES);
+    suconvert::FloatToIbm(trace->data, tapetr.data, ns);
     //        memset(tapetr.unass, 0, 60);
     /* Write the trace to tape */
     // if(itr == 1000) {cout << "value in tapetr "<< *(float*)&tapetr.data[1000]
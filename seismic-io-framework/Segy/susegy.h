@@ -39,6 +39,12 @@ private:
   vector<char *> extendedasciitextheader;
   char binaryheader[BNYBYTES + 1];
 
+  // Converts the header of a trace read from the file to native fields.
+  void DecodeHeader(const tapesegy *tapetrace, segy *trace);
+
+  // Converts a trace read from the file to native headers and floats.
+  void DecodeTrace(tapesegy *tapetrace, segy *trace);
+
 protected:
   ifstream file;
   size_t nsegy;
@@ -68,6 +74,10 @@ public:
       std::cout << "header: \n" << header << std::endl;
   }
   size_t getNsegy() { return nsegy; }
+  // The byte offset of the first trace, after the text and binary headers.
+  size_t getDataOffset() {
+    return EBCBYTES + BNYBYTES + (size_t)nextended * EBCBYTES;
+  }
 
   void Ascii2ebc(unsigned char *s) {
     while (*s) {
@@ -130,6 +140,11 @@ public:
       bool (*check_func)(
           segy *trace,
           vector<SEGYelement> *check_elements)); // reads a segy file
+  void ReadTraces(
+      string filename,
+      const vector<pair<size_t, size_t>> &ranges); // reads the traces of the
+                                                   // ranges, each being its
+                                                   // first trace and count
   void WriteHeadersAndTraces(
       string filename); // writes the segy data into a segy file
   void ReadBinaryHeader(
@@ -0,0 +1,139 @@
+// Checks the SEG-Y conversions of each instruction set supported by the cpu
+// against the scalar routines of segy_helpers on the edge cases of the
+// formats : the IBM floats with a zero fraction, the ones too small for a
+// normal float, the negative values and the 4 byte integers of format 2.
+//
+// usage : convert_test
+// exits with 1 if any of the conversions differs.
+#include "segy_convert.h"
+#include "segy_helpers.h"
+
+#include <arpa/inet.h>
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+using namespace suconvert;
+
+// The values each case is repeated to, not a multiple of the vector widths so
+// both the vector loops and their remainder convert some of them.
+#define CASE_VALUES 67
+
+// The byte order argument of the scalar routines, 0 on little endian
+// machines, as in SUSegy.
+static const int endian = htons(1) == 1 ? 1 : 0;
+
+// The conversions which differ from the scalar routines.
+static int failures = 0;
+
+// Repeats the values of a case to CASE_VALUES values.
+static vector<uint32_t> Repeat(const vector<uint32_t> &values) {
+  vector<uint32_t> repeated(CASE_VALUES);
+  for (size_t i = 0; i < repeated.size(); i++) {
+    repeated[i] = values[i % values.size()];
+  }
+  return repeated;
+}
+
+// Compares the bits converted with each instruction set to the expected ones,
+// printing the first value which differs.
+template <typename Convert>
+static void Check(const char *name, const vector<uint32_t> &input,
+                  const vector<uint32_t> &expected, Convert convert) {
+  vector<uint32_t> result(input.size());
+  for (int isa = CONVERT_SCALAR; isa <= DetectIsa(); isa++) {
+    SetIsa((ConvertIsa)isa);
+    convert(input.data(), result.data(), input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+      if (result[i] != expected[i]) {
+        printf("%s differs with %s for 0x%08x : 0x%08x instead of 0x%08x\n",
+               name, GetIsaName((ConvertIsa)isa), input[i], result[i],
+               expected[i]);
+        failures++;
+        break;
+      }
+    }
+  }
+  SetIsa(DetectIsa());
+}
+
+// Checks IbmToFloat on the given big endian IBM floats against ibm_to_float.
+static void CheckIbm(const char *name, const vector<uint32_t> &values) {
+  vector<uint32_t> input = Repeat(values);
+  for (uint32_t &value : input) {
+    value = htonl(value);
+  }
+  vector<uint32_t> expected(input.size());
+  ibm_to_float((int *)input.data(), (int *)expected.data(), input.size(),
+               endian);
+  Check(name, input, expected,
+        [](const void *from, void *to, size_t n) {
+          IbmToFloat(from, (float *)to, n);
+        });
+}
+
+// Checks FloatToIbm on the given float bits against ieee2ibm.
+static void CheckFloat(const char *name, const vector<uint32_t> &values) {
+  vector<uint32_t> input = Repeat(values);
+  vector<uint32_t> expected(input.size());
+  ieee2ibm(expected.data(), input.data(), input.size());
+  Check(name, input, expected,
+        [](const void *from, void *to, size_t n) {
+          FloatToIbm((const float *)from, to, n);
+        });
+}
+
+int main() {
+  printf("Detected instruction set : %s\n", GetIsaName(DetectIsa()));
+  // ibm_to_float never returns for the IBM floats with a zero fraction
+  // besides zero, IbmToFloat converts all of them to zero.
+  vector<uint32_t> zero_fractions = Repeat(
+      {0x00000000, 0x41000000, 0xc1000000, 0x80000000, 0x7f000000,
+       0xff000000});
+  vector<uint32_t> zeros(zero_fractions.size(), 0);
+  for (uint32_t &value : zero_fractions) {
+    value = htonl(value);
+  }
+  Check("ibm zero fraction", zero_fractions, zeros,
+        [](const void *from, void *to, size_t n) {
+          IbmToFloat(from, (float *)to, n);
+        });
+  // The IBM floats below the smallest normal float, 16^-32, are flushed to
+  // zero, and the ones just above it are kept.
+  CheckIbm("ibm denormal",
+           {0x00000001, 0x00ffffff, 0x80100000, 0x1f100000, 0x20800000,
+            0x20ffffff, 0x21100000, 0xa1100000, 0x21000001, 0x22000001});
+  CheckIbm("ibm sign",
+           {0x41100000, 0xc1100000, 0x42640000, 0xc2640000, 0x7fffffff,
+            0xffffffff, 0xc0800000, 0xbf000001});
+  // The floats which aren't normal : zeros, denormals, infinities and NaNs.
+  CheckFloat("float denormal",
+             {0x00000000, 0x80000000, 0x00000001, 0x807fffff, 0x00400000,
+              0x00800000, 0x80800000});
+  CheckFloat("float sign",
+             {0x3f800000, 0xbf800000, 0x7f7fffff, 0xff7fffff, 0x7f800000,
+              0xff800000, 0x7fc00000, 0xc2c80000});
+  // Format 2 samples are 4 byte two's complement integers, the ones over 2^24
+  // are rounded to the nearest float.
+  vector<uint32_t> integers = Repeat(
+      {0, 1, (uint32_t)-1, 16777217, (uint32_t)-16777217, 0x7fffffff,
+       (uint32_t)INT_MIN, 0x12345678, 0x87654321});
+  vector<uint32_t> integer_floats(integers.size());
+  for (size_t i = 0; i < integers.size(); i++) {
+    float value = (float)(int32_t)integers[i];
+    memcpy(&integer_floats[i], &value, 4);
+    integers[i] = htonl(integers[i]);
+  }
+  Check("format 2 int4", integers, integer_floats,
+        [](const void *from, void *to, size_t n) {
+          Int4ToFloat(from, (float *)to, n);
+        });
+  if (failures > 0) {
+    printf("%d conversions differ from the scalar routines\n", failures);
+    return 1;
+  }
+  printf("All the conversions match the scalar routines\n");
+  return 0;
+}
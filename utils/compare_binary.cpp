@@ -0,0 +1,78 @@
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Compares a binary image(eg. filtered_migration.bin) against a reference one
+ * of the same run, eg. the image of a run storing the forward wavefields in a
+ * reduced precision against the image of the fp32 run.
+ * If a maximum relative L2 error is given, the comparison fails when the error
+ * is above it.
+ */
+bool ReadBinary(vector<float> &values, const string &filename) {
+  ifstream in(filename, ios::binary | ios::ate);
+  if (!in.is_open()) {
+    cout << "Couldn't open file : " << filename << endl;
+    return false;
+  }
+  size_t size = in.tellg();
+  in.seekg(0, ios::beg);
+  values.resize(size / sizeof(float));
+  in.read(reinterpret_cast<char *>(values.data()),
+          values.size() * sizeof(float));
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3 && argc != 4) {
+    printf("Usage : ./compare_binary <reference_file> <file> "
+           "[maximum relative L2 error]\n");
+    return 0;
+  }
+  double max_relative = argc == 4 ? atof(argv[3]) : -1;
+  vector<float> reference, values;
+  if (!ReadBinary(reference, argv[1]) || !ReadBinary(values, argv[2])) {
+    return 1;
+  }
+  if (reference.size() != values.size()) {
+    cout << "Files differ in size : " << reference.size() << " and "
+         << values.size() << " values" << endl;
+    return 1;
+  }
+  double error_norm = 0;
+  double reference_norm = 0;
+  float max_error = 0;
+  float max_reference = 0;
+  for (size_t i = 0; i < reference.size(); i++) {
+    float difference = fabsf(values[i] - reference[i]);
+    error_norm += (double)difference * difference;
+    reference_norm += (double)reference[i] * reference[i];
+    max_error = max(max_error, difference);
+    max_reference = max(max_reference, fabsf(reference[i]));
+  }
+  cout << "Values compared : " << reference.size() << endl;
+  cout << "Maximum absolute error : " << max_error
+       << " (reference maximum : " << max_reference << ")" << endl;
+  if (reference_norm > 0) {
+    double relative = sqrt(error_norm / reference_norm);
+    cout << "Relative L2 error : " << relative << endl;
+    if (error_norm > 0) {
+      cout << "Signal to noise ratio : "
+           << 10 * log10(reference_norm / error_norm) << " dB" << endl;
+    }
+    if (max_relative >= 0 && relative > max_relative) {
+      cout << "Relative L2 error above " << max_relative << endl;
+      return 1;
+    }
+  } else {
+    cout << "Reference is all zeros, L2 error : " << sqrt(error_norm) << endl;
+    if (max_relative >= 0 && error_norm > 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
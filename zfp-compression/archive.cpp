@@ -0,0 +1,344 @@
+#include "archive.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace zfp {
+
+#ifdef ZFP_COMPRESSION
+struct WavefieldArchive::Context {
+  zfp_stream *zfp;
+  zfp_field *field;
+  // The stream the thread compresses its blocks to, over its buffer.
+  bitstream *stream;
+  void *buffer;
+  size_t bufsize;
+  size_t used;
+  // The stream the thread decompresses its blocks from, over the record.
+  bitstream *record_stream;
+};
+#endif
+
+WavefieldArchive::WavefieldArchive() {
+  file = -1;
+  end = 0;
+  allocated = 0;
+  record = nullptr;
+  record_size = 0;
+}
+
+WavefieldArchive::~WavefieldArchive() {
+  Close();
+#ifdef ZFP_COMPRESSION
+  for (Context *context : contexts) {
+    zfp_field_free(context->field);
+    zfp_stream_close(context->zfp);
+    if (context->stream != nullptr) {
+      stream_close(context->stream);
+      free(context->buffer);
+    }
+    if (context->record_stream != nullptr) {
+      stream_close(context->record_stream);
+    }
+    delete context;
+  }
+#endif
+  free(record);
+}
+
+void WavefieldArchive::Open(const std::string &filename) {
+  Close();
+  file = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file < 0) {
+    fprintf(stderr, "could not open the archive %s\n", filename.c_str());
+    exit(EXIT_FAILURE);
+  }
+  end = 0;
+  allocated = 0;
+  index.clear();
+}
+
+void WavefieldArchive::Close() {
+  if (file >= 0) {
+    // The extent past the last wavefield was only preallocated.
+    if (ftruncate(file, end) != 0) {
+      fprintf(stderr, "could not truncate the archive\n");
+    }
+    close(file);
+    file = -1;
+  }
+}
+
+void WavefieldArchive::Write(const void *data, size_t size, size_t offset) {
+  while (offset + size > allocated) {
+    // The file system may not support preallocation, the writes then extend
+    // the file.
+    posix_fallocate(file, allocated, ARCHIVE_EXTENT);
+    allocated += ARCHIVE_EXTENT;
+  }
+  const char *bytes = (const char *)data;
+  while (size > 0) {
+    ssize_t written = pwrite(file, bytes, size, offset);
+    if (written <= 0) {
+      fprintf(stderr, "could not write to the archive\n");
+      exit(EXIT_FAILURE);
+    }
+    bytes += written;
+    offset += written;
+    size -= written;
+  }
+}
+
+// Reads the bytes at the offset of the archive file.
+static void ReadRecord(int file, void *data, size_t size, size_t offset) {
+  char *bytes = (char *)data;
+  while (size > 0) {
+    ssize_t count = pread(file, bytes, size, offset);
+    if (count <= 0) {
+      fprintf(stderr, "could not read from the archive\n");
+      exit(EXIT_FAILURE);
+    }
+    bytes += count;
+    offset += count;
+    size -= count;
+  }
+}
+
+void WavefieldArchive::ReserveRecord(size_t size) {
+  if (size <= record_size) {
+    return;
+  }
+  free(record);
+  // A word of slack, the streams read a word at a time.
+  record = (char *)malloc(size + sizeof(uint64_t));
+  record_size = size;
+#ifdef ZFP_COMPRESSION
+  for (Context *context : contexts) {
+    if (context->record_stream != nullptr) {
+      stream_close(context->record_stream);
+    }
+    context->record_stream = stream_open(record, record_size);
+  }
+#endif
+}
+
+#ifdef ZFP_COMPRESSION
+// The blocks of rows compressed independently, a single one covering the
+// whole wavefield unless the codec is the parallel one.
+static int GetBlockCount(int nz, unsigned int codecType) {
+  if (codecType != 2) {
+    return 1;
+  }
+  return (nz + MINBLOCKSIZE - 1) / MINBLOCKSIZE;
+}
+
+void WavefieldArchive::ReserveContexts(int threads) {
+  while ((int)contexts.size() < threads) {
+    Context *context = new Context;
+    context->zfp = zfp_stream_open(NULL);
+    context->field = zfp_field_alloc();
+    zfp_field_set_type(context->field, zfp_type_float);
+    context->stream = nullptr;
+    context->buffer = nullptr;
+    context->bufsize = 0;
+    context->used = 0;
+    context->record_stream = nullptr;
+    if (record != nullptr) {
+      context->record_stream = stream_open(record, record_size);
+    }
+    contexts.push_back(context);
+  }
+}
+
+void WavefieldArchive::SetAccuracy(Context &context, double tolerance,
+                                   bool zfp_is_relative) {
+  if (zfp_is_relative) { // we are concerned with relative error (precision)
+    zfp_stream_set_precision(context.zfp, tolerance);
+  } else { // we are concerned with absolute error (accuracy)
+    zfp_stream_set_accuracy(context.zfp, tolerance);
+  }
+}
+
+void WavefieldArchive::SetField(Context &context, float *array, int nx,
+                                int ny, int nz, int blocks, int block) {
+  if (blocks == 1) {
+    // To choose between 1d,2d or 3d representation
+    zfp_field_set_pointer(context.field, array);
+    if ((nx > 1) && (ny > 1) && (nz > 1)) {
+      zfp_field_set_size_3d(context.field, nx, ny, nz);
+    } else if ((nx > 1) && (nz > 1)) {
+      zfp_field_set_size_2d(context.field, nx, nz);
+    } else {
+      zfp_field_set_size_1d(context.field, nz);
+    }
+    return;
+  }
+  int rows = (block < (blocks - 1)) ? MINBLOCKSIZE : nz % MINBLOCKSIZE;
+  if (rows == 0) {
+    rows = MINBLOCKSIZE;
+  }
+  if ((nx > 1) && (ny > 1) && (nz > 1)) {
+    zfp_field_set_pointer(context.field,
+                          &array[(size_t)block * MINBLOCKSIZE * ny * nx]);
+    zfp_field_set_size_3d(context.field, nx, ny, rows);
+  } else {
+    zfp_field_set_pointer(context.field,
+                          &array[(size_t)block * MINBLOCKSIZE * nx]);
+    zfp_field_set_size_2d(context.field, nx, rows);
+  }
+}
+
+size_t WavefieldArchive::AppendZFP(float *array, int nx, int ny, int nz,
+                                   double tolerance, unsigned int codecType,
+                                   bool zfp_is_relative) {
+  int blocks = GetBlockCount(nz, codecType);
+  int threads = std::min(blocks, omp_get_max_threads());
+  ReserveContexts(threads);
+  block_sizes.resize(blocks);
+  // Each thread compresses a range of consecutive blocks to its own stream,
+  // so the streams of the threads follow each other in the record.
+#pragma omp parallel num_threads(threads)
+  {
+    int thread = omp_get_thread_num();
+    int first = (long)blocks * thread / threads;
+    int last = (long)blocks * (thread + 1) / threads;
+    Context &context = *contexts[thread];
+    SetAccuracy(context, tolerance, zfp_is_relative);
+    size_t needed = 0;
+    for (int block = first; block < last; block++) {
+      SetField(context, array, nx, ny, nz, blocks, block);
+      needed += zfp_stream_maximum_size(context.zfp, context.field);
+    }
+    if (needed > context.bufsize) {
+      if (context.stream != nullptr) {
+        stream_close(context.stream);
+        free(context.buffer);
+      }
+      context.buffer = malloc(needed);
+      context.bufsize = needed;
+      context.stream = stream_open(context.buffer, context.bufsize);
+    }
+    zfp_stream_set_bit_stream(context.zfp, context.stream);
+    zfp_stream_rewind(context.zfp);
+    // The compressed size is the offset in the stream, each block being
+    // flushed to a word.
+    size_t previous = 0;
+    for (int block = first; block < last; block++) {
+      SetField(context, array, nx, ny, nz, blocks, block);
+      size_t total = zfp_compress(context.zfp, context.field);
+      if (!total) {
+        fprintf(stderr, "compression failed\n");
+      }
+      block_sizes[block] = total - previous;
+      previous = total;
+    }
+    context.used = previous;
+  }
+  size_t header = (1 + blocks) * sizeof(uint64_t);
+  size_t size = header;
+  for (int thread = 0; thread < threads; thread++) {
+    size += contexts[thread]->used;
+  }
+  ReserveRecord(size);
+  uint64_t *fields = (uint64_t *)record;
+  fields[0] = blocks;
+  for (int block = 0; block < blocks; block++) {
+    fields[1 + block] = block_sizes[block];
+  }
+  char *data = record + header;
+  for (int thread = 0; thread < threads; thread++) {
+    memcpy(data, contexts[thread]->buffer, contexts[thread]->used);
+    data += contexts[thread]->used;
+  }
+  Write(record, size, end);
+  return size;
+}
+
+void WavefieldArchive::ReadZFP(float *array, int nx, int ny, int nz,
+                               double tolerance, bool zfp_is_relative) {
+  uint64_t *fields = (uint64_t *)record;
+  int blocks = fields[0];
+  int threads = std::min(blocks, omp_get_max_threads());
+  ReserveContexts(threads);
+  // The blocks are found from their sizes, as bit offsets in the record.
+  block_offsets.resize(blocks);
+  size_t offset = (1 + blocks) * sizeof(uint64_t);
+  for (int block = 0; block < blocks; block++) {
+    block_offsets[block] = offset * CHAR_BIT;
+    offset += fields[1 + block];
+  }
+#pragma omp parallel num_threads(threads)
+  {
+    int thread = omp_get_thread_num();
+    int first = (long)blocks * thread / threads;
+    int last = (long)blocks * (thread + 1) / threads;
+    Context &context = *contexts[thread];
+    SetAccuracy(context, tolerance, zfp_is_relative);
+    zfp_stream_set_bit_stream(context.zfp, context.record_stream);
+    for (int block = first; block < last; block++) {
+      SetField(context, array, nx, ny, nz, blocks, block);
+      stream_rseek(context.record_stream, block_offsets[block]);
+      if (!zfp_decompress(context.zfp, context.field)) {
+        fprintf(stderr, "decompression failed\n");
+      }
+    }
+  }
+}
+#endif
+
+size_t WavefieldArchive::Append(float *array, int nx, int ny, int nz,
+                                double tolerance, unsigned int codecType,
+                                unsigned int curTimestep,
+                                bool zfp_is_relative) {
+  size_t n = (size_t)nx * ny * nz;
+  size_t size = 0;
+  if (codecType == BFP_CODEC) {
+    ReserveRecord(getBFPMaxSize(n));
+    size = compressBFP(array, n, tolerance, zfp_is_relative, record);
+    Write(record, size, end);
+  } else {
+#ifdef ZFP_COMPRESSION
+    size = AppendZFP(array, nx, ny, nz, tolerance, codecType,
+                     zfp_is_relative);
+#else
+    size = n * sizeof(float);
+    Write(array, size, end);
+#endif
+  }
+  if (curTimestep >= index.size()) {
+    index.resize(curTimestep + 1);
+  }
+  index[curTimestep] = {end, size};
+  end += size;
+  return size;
+}
+
+size_t WavefieldArchive::Read(float *array, int nx, int ny, int nz,
+                              double tolerance, unsigned int codecType,
+                              unsigned int curTimestep,
+                              bool zfp_is_relative) {
+  if (curTimestep >= index.size() || index[curTimestep].size == 0) {
+    fprintf(stderr, "the time step %u is not in the archive\n", curTimestep);
+    exit(EXIT_FAILURE);
+  }
+  Record entry = index[curTimestep];
+  size_t n = (size_t)nx * ny * nz;
+  if (codecType == BFP_CODEC) {
+    ReserveRecord(entry.size);
+    ReadRecord(file, record, entry.size, entry.offset);
+    decompressBFP(array, n, record);
+  } else {
+#ifdef ZFP_COMPRESSION
+    ReserveRecord(entry.size);
+    ReadRecord(file, record, entry.size, entry.offset);
+    ReadZFP(array, nx, ny, nz, tolerance, zfp_is_relative);
+#else
+    ReadRecord(file, array, entry.size, entry.offset);
+#endif
+  }
+  return n * sizeof(float);
+}
+} // namespace zfp
@@ -0,0 +1,92 @@
+#ifndef WAVEFIELD_ARCHIVE_H
+#define WAVEFIELD_ARCHIVE_H
+
+#include "compress.h"
+
+#include <string>
+#include <vector>
+
+// The bytes the archive file is extended by when the wavefields reach its end,
+// so that the appends don't grow it a few blocks at a time.
+#define ARCHIVE_EXTENT (64 * 1024 * 1024)
+
+namespace zfp {
+/*!
+ * A single file holding the compressed wavefields of a shot, each time step
+ * appended after the previous one and read back from the offset kept in the
+ * index. The zfp streams and buffers of the threads are kept from one call to
+ * the next, so compressing a wavefield doesn't open a file nor allocate.
+ *
+ * The built in block floating point codec, BFP_CODEC, works with or without
+ * zfp. Without zfp the other codec types store the wavefields uncompressed.
+ */
+class WavefieldArchive {
+public:
+  WavefieldArchive();
+  ~WavefieldArchive();
+  /*!
+   * Opens the archive file, dropping the wavefields it held.
+   */
+  void Open(const std::string &filename);
+  /*!
+   * Compresses the wavefield of the time step and appends it to the archive,
+   * with the codec types of compression.
+   * @return
+   * The bytes it takes in the archive.
+   */
+  size_t Append(float *array, int nx, int ny, int nz, double tolerance,
+                unsigned int codecType, unsigned int curTimestep,
+                bool zfp_is_relative);
+  /*!
+   * Decompresses the wavefield of the time step, appended with the same
+   * parameters.
+   * @return
+   * The bytes of the decompressed wavefield.
+   */
+  size_t Read(float *array, int nx, int ny, int nz, double tolerance,
+              unsigned int codecType, unsigned int curTimestep,
+              bool zfp_is_relative);
+  /*!
+   * Closes the archive file, releasing its unused extent.
+   */
+  void Close();
+
+private:
+  typedef struct {
+    size_t offset;
+    size_t size;
+  } Record;
+
+  // The compression state of a thread, reused by all the calls. It is only
+  // defined with zfp, so that the layout of the archive doesn't depend on it.
+  struct Context;
+
+  std::vector<Context *> contexts;
+  std::vector<size_t> block_sizes;
+  std::vector<size_t> block_offsets;
+  // The record of a time step as stored in the file : its number of blocks,
+  // their sizes and their compressed streams.
+  char *record;
+  size_t record_size;
+
+  void ReserveContexts(int threads);
+  void ReserveRecord(size_t size);
+  void SetField(Context &context, float *array, int nx, int ny, int nz,
+                int blocks, int block);
+  void SetAccuracy(Context &context, double tolerance, bool zfp_is_relative);
+  size_t AppendZFP(float *array, int nx, int ny, int nz, double tolerance,
+                   unsigned int codecType, bool zfp_is_relative);
+  void ReadZFP(float *array, int nx, int ny, int nz, double tolerance,
+               bool zfp_is_relative);
+
+  int file;
+  // The end of the appended wavefields and of the preallocated file.
+  size_t end;
+  size_t allocated;
+  std::vector<Record> index;
+
+  void Write(const void *data, size_t size, size_t offset);
+};
+} // namespace zfp
+
+#endif
@@ -0,0 +1,145 @@
+// Compares the built in block floating point codec with zfp on a wavefield :
+// the compression ratio, the throughput of a core, and of all the cores for
+// the built in codec, and the error of the decompressed values.
+//
+// usage : bench_compress [tolerance] [wavefield nx nz [ny]]
+// The wavefield is a binary file of floats, a ring of a ricker wavelet is
+// generated otherwise.
+#include "bfp.h"
+#include "compress.h"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+// The runs each throughput is measured on.
+#define BENCH_RUNS 20
+
+// The seconds of a run of the operation, the best of BENCH_RUNS.
+static double TimeRuns(const function<void()> &operation) {
+  double best = 0;
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    auto start = chrono::steady_clock::now();
+    operation();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    if (run == 0 || elapsed.count() < best) {
+      best = elapsed.count();
+    }
+  }
+  return best;
+}
+
+static void PrintResult(const char *codec, int threads,
+                        const vector<float> &reference,
+                        const vector<float> &decoded, size_t size,
+                        double encode_time, double decode_time) {
+  double error_sum = 0;
+  double reference_sum = 0;
+  float max_error = 0;
+  for (size_t i = 0; i < reference.size(); i++) {
+    float error = fabs(reference[i] - decoded[i]);
+    error_sum += (double)error * error;
+    reference_sum += (double)reference[i] * reference[i];
+    max_error = max(max_error, error);
+  }
+  double bytes = reference.size() * sizeof(float);
+  printf("%-6s %7d %8.2f %12.2f %12.2f %14.3e %14.3e\n", codec, threads,
+         bytes / size, bytes / encode_time / 1e9, bytes / decode_time / 1e9,
+         max_error, reference_sum > 0 ? sqrt(error_sum / reference_sum) : 0);
+}
+
+static void BenchBFP(const vector<float> &values, double tolerance,
+                     int threads) {
+  omp_set_num_threads(threads);
+  size_t n = values.size();
+  vector<char> buffer(zfp::getBFPMaxSize(n));
+  vector<float> decoded(n);
+  size_t size = 0;
+  double encode_time = TimeRuns([&]() {
+    size = zfp::compressBFP(values.data(), n, tolerance, false, buffer.data());
+  });
+  double decode_time = TimeRuns(
+      [&]() { zfp::decompressBFP(decoded.data(), n, buffer.data()); });
+  PrintResult("bfp", threads, values, decoded, size, encode_time,
+              decode_time);
+}
+
+static void BenchZFP(vector<float> &values, int nx, int ny, int nz,
+                     double tolerance) {
+#ifdef ZFP_COMPRESSION
+  vector<float> decoded(values.size());
+  zfp_field *field = zfp_field_alloc();
+  zfp_field_set_type(field, zfp_type_float);
+  zfp_stream *zfp = zfp_stream_open(NULL);
+  zfp_stream_set_accuracy(zfp, tolerance);
+  if (ny > 1) {
+    zfp_field_set_size_3d(field, nx, ny, nz);
+  } else {
+    zfp_field_set_size_2d(field, nx, nz);
+  }
+  zfp_field_set_pointer(field, values.data());
+  size_t capacity = zfp_stream_maximum_size(zfp, field);
+  vector<char> buffer(capacity);
+  bitstream *stream = stream_open(buffer.data(), capacity);
+  zfp_stream_set_bit_stream(zfp, stream);
+  size_t size = 0;
+  double encode_time = TimeRuns([&]() {
+    zfp_stream_rewind(zfp);
+    size = zfp_compress(zfp, field);
+  });
+  zfp_field_set_pointer(field, decoded.data());
+  double decode_time = TimeRuns([&]() {
+    zfp_stream_rewind(zfp);
+    zfp_decompress(zfp, field);
+  });
+  PrintResult("zfp", 1, values, decoded, size, encode_time, decode_time);
+  stream_close(stream);
+  zfp_stream_close(zfp);
+  zfp_field_free(field);
+#else
+  printf("zfp isn't part of the build\n");
+#endif
+}
+
+int main(int argc, char *argv[]) {
+  double tolerance = argc > 1 ? atof(argv[1]) : 0.01;
+  int nx = 2048;
+  int nz = 2048;
+  int ny = 1;
+  vector<float> values;
+  if (argc > 4) {
+    nx = atoi(argv[3]);
+    nz = atoi(argv[4]);
+    ny = argc > 5 ? atoi(argv[5]) : 1;
+    values.resize((size_t)nx * ny * nz);
+    ifstream file(argv[2], ios::binary);
+    if (!file.read((char *)values.data(), values.size() * sizeof(float))) {
+      printf("could not read %zu values from %s\n", values.size(), argv[2]);
+      return 1;
+    }
+  } else {
+    // A ricker wavelet of a wavelength of 40 points spreading from the
+    // center, decaying with the distance.
+    values.resize((size_t)nx * nz);
+    for (int z = 0; z < nz; z++) {
+      for (int x = 0; x < nx; x++) {
+        float distance = hypotf(x - nx / 2, z - nz / 2);
+        float phase = M_PI * (distance - nx / 4) / 40;
+        values[(size_t)z * nx + x] = (1 - 2 * phase * phase) *
+                                     expf(-phase * phase) /
+                                     sqrtf(1 + distance);
+      }
+    }
+  }
+  printf("Wavefield of %d x %d x %d values, tolerance %g\n", nx, ny, nz,
+         tolerance);
+  printf("%-6s %7s %8s %12s %12s %14s %14s\n", "codec", "threads", "ratio",
+         "encode GB/s", "decode GB/s", "max error", "relative L2");
+  BenchBFP(values, tolerance, 1);
+  BenchBFP(values, tolerance, omp_get_num_procs());
+  BenchZFP(values, nx, ny, nz, tolerance);
+  return 0;
+}
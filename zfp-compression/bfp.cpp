@@ -0,0 +1,295 @@
+#include "bfp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// The blocks a thread compresses together, the integers of a chunk being
+// written after the ones of the chunks before it.
+#define BFP_CHUNK_BLOCKS 256
+
+namespace zfp {
+
+// The bytes of the number of values and of the exponents and bits of the
+// blocks, rounded to a word so that the integers start aligned.
+static size_t GetHeaderSize(size_t blocks) {
+  return (sizeof(uint64_t) + 2 * blocks + 7) / 8 * 8;
+}
+
+size_t getBFPMaxSize(size_t n) {
+  size_t blocks = (n + BFP_BLOCK - 1) / BFP_BLOCK;
+  return GetHeaderSize(blocks) + n * sizeof(int16_t);
+}
+
+// Chooses the exponent and bits of a block from its largest magnitude, its
+// values being below 2^exponent. A block takes the fewest bits whose step,
+// 2^(exponent - bits + 1), is within the tolerance.
+static void SetBlockBits(float max, double tolerance, bool zfp_is_relative,
+                         int8_t &exponent, uint8_t &bits) {
+  int e = 0;
+  frexpf(max, &e);
+  exponent = 0;
+  bits = 0;
+  if (max == 0 || e < -127) {
+    return;
+  }
+  exponent = std::min(e, 127);
+  if (zfp_is_relative) {
+    bits = tolerance <= 8 ? 8 : 16;
+  } else if (ldexp(1.0, exponent) <= tolerance) {
+    bits = 0;
+  } else if (ldexp(1.0, exponent - 7) <= tolerance) {
+    bits = 8;
+  } else {
+    bits = 16;
+  }
+}
+
+// The kernels are compiled for the default instruction set and for avx2, the
+// bodies being inlined in both.
+static inline __attribute__((always_inline)) float
+GetBlockMax(const float *values, int count) {
+  float max = 0;
+#pragma omp simd reduction(max : max)
+  for (int i = 0; i < count; i++) {
+    float value = std::fabs(values[i]);
+    max = value > max ? value : max;
+  }
+  return max;
+}
+
+template <typename T>
+static inline __attribute__((always_inline)) void
+QuantizeBlock(const float *values, int count, float scale, T *integers) {
+  const float limit = (float)((1 << (8 * sizeof(T) - 1)) - 1);
+#pragma omp simd
+  for (int i = 0; i < count; i++) {
+    // Rounded half away from zero by the truncation.
+    float value = values[i] * scale + copysignf(0.5f, values[i]);
+    value = value > limit ? limit : value;
+    value = value < -limit ? -limit : value;
+    integers[i] = (T)(int)value;
+  }
+}
+
+template <typename T>
+static inline __attribute__((always_inline)) void
+DequantizeBlock(const T *integers, int count, float scale, float *values) {
+#pragma omp simd
+  for (int i = 0; i < count; i++) {
+    values[i] = (float)integers[i] * scale;
+  }
+}
+
+static inline __attribute__((always_inline)) size_t
+ScanChunkBody(const float *array, size_t n, size_t first, size_t last,
+              double tolerance, bool zfp_is_relative, int8_t *exponents,
+              uint8_t *bits) {
+  size_t bytes = 0;
+  for (size_t block = first; block < last; block++) {
+    size_t start = block * BFP_BLOCK;
+    int count = std::min((size_t)BFP_BLOCK, n - start);
+    SetBlockBits(GetBlockMax(array + start, count), tolerance,
+                 zfp_is_relative, exponents[block], bits[block]);
+    bytes += count * bits[block] / 8;
+  }
+  return bytes;
+}
+
+static inline __attribute__((always_inline)) void
+CompressChunkBody(const float *array, size_t n, size_t first, size_t last,
+                  const int8_t *exponents, const uint8_t *bits, char *data) {
+  for (size_t block = first; block < last; block++) {
+    size_t start = block * BFP_BLOCK;
+    int count = std::min((size_t)BFP_BLOCK, n - start);
+    float scale = ldexpf(1.0f, bits[block] - 1 - exponents[block]);
+    if (bits[block] == 8) {
+      QuantizeBlock(array + start, count, scale, (int8_t *)data);
+    } else if (bits[block] == 16) {
+      QuantizeBlock(array + start, count, scale, (int16_t *)data);
+    }
+    data += count * bits[block] / 8;
+  }
+}
+
+static inline __attribute__((always_inline)) void
+DecompressChunkBody(float *array, size_t n, size_t first, size_t last,
+                    const int8_t *exponents, const uint8_t *bits,
+                    const char *data) {
+  for (size_t block = first; block < last; block++) {
+    size_t start = block * BFP_BLOCK;
+    int count = std::min((size_t)BFP_BLOCK, n - start);
+    float scale = ldexpf(1.0f, exponents[block] - bits[block] + 1);
+    if (bits[block] == 8) {
+      DequantizeBlock((const int8_t *)data, count, scale, array + start);
+    } else if (bits[block] == 16) {
+      DequantizeBlock((const int16_t *)data, count, scale, array + start);
+    } else {
+      memset(array + start, 0, count * sizeof(float));
+    }
+    data += count * bits[block] / 8;
+  }
+}
+
+static size_t ScanChunk(const float *array, size_t n, size_t first,
+                        size_t last, double tolerance, bool zfp_is_relative,
+                        int8_t *exponents, uint8_t *bits) {
+  return ScanChunkBody(array, n, first, last, tolerance, zfp_is_relative,
+                       exponents, bits);
+}
+
+__attribute__((target("avx2"))) static size_t
+ScanChunkAVX2(const float *array, size_t n, size_t first, size_t last,
+              double tolerance, bool zfp_is_relative, int8_t *exponents,
+              uint8_t *bits) {
+  return ScanChunkBody(array, n, first, last, tolerance, zfp_is_relative,
+                       exponents, bits);
+}
+
+static void CompressChunk(const float *array, size_t n, size_t first,
+                          size_t last, const int8_t *exponents,
+                          const uint8_t *bits, char *data) {
+  CompressChunkBody(array, n, first, last, exponents, bits, data);
+}
+
+__attribute__((target("avx2"))) static void
+CompressChunkAVX2(const float *array, size_t n, size_t first, size_t last,
+                  const int8_t *exponents, const uint8_t *bits, char *data) {
+  CompressChunkBody(array, n, first, last, exponents, bits, data);
+}
+
+static void DecompressChunk(float *array, size_t n, size_t first, size_t last,
+                            const int8_t *exponents, const uint8_t *bits,
+                            const char *data) {
+  DecompressChunkBody(array, n, first, last, exponents, bits, data);
+}
+
+__attribute__((target("avx2"))) static void
+DecompressChunkAVX2(float *array, size_t n, size_t first, size_t last,
+                    const int8_t *exponents, const uint8_t *bits,
+                    const char *data) {
+  DecompressChunkBody(array, n, first, last, exponents, bits, data);
+}
+
+static bool UseAVX2() {
+  static bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+
+// Sums the bytes of the integers of the chunks, held from the second offset,
+// to the offsets of the chunks.
+static void SumOffsets(std::vector<size_t> &offsets) {
+  offsets[0] = 0;
+  for (size_t chunk = 1; chunk < offsets.size(); chunk++) {
+    offsets[chunk] += offsets[chunk - 1];
+  }
+}
+
+size_t compressBFP(const float *array, size_t n, double tolerance,
+                   bool zfp_is_relative, char *buffer) {
+  size_t blocks = (n + BFP_BLOCK - 1) / BFP_BLOCK;
+  size_t chunks = (blocks + BFP_CHUNK_BLOCKS - 1) / BFP_CHUNK_BLOCKS;
+  uint64_t count = n;
+  memcpy(buffer, &count, sizeof(count));
+  int8_t *exponents = (int8_t *)(buffer + sizeof(uint64_t));
+  uint8_t *bits = (uint8_t *)(exponents + blocks);
+  char *data = buffer + GetHeaderSize(blocks);
+  bool avx2 = UseAVX2();
+  std::vector<size_t> offsets(chunks + 1);
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    size_t first = chunk * BFP_CHUNK_BLOCKS;
+    size_t last = std::min(blocks, first + BFP_CHUNK_BLOCKS);
+    if (avx2) {
+      offsets[chunk + 1] = ScanChunkAVX2(array, n, first, last, tolerance,
+                                         zfp_is_relative, exponents, bits);
+    } else {
+      offsets[chunk + 1] = ScanChunk(array, n, first, last, tolerance,
+                                     zfp_is_relative, exponents, bits);
+    }
+  }
+  SumOffsets(offsets);
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    size_t first = chunk * BFP_CHUNK_BLOCKS;
+    size_t last = std::min(blocks, first + BFP_CHUNK_BLOCKS);
+    if (avx2) {
+      CompressChunkAVX2(array, n, first, last, exponents, bits,
+                        data + offsets[chunk]);
+    } else {
+      CompressChunk(array, n, first, last, exponents, bits,
+                    data + offsets[chunk]);
+    }
+  }
+  return GetHeaderSize(blocks) + offsets[chunks];
+}
+
+size_t decompressBFP(float *array, size_t n, const char *buffer) {
+  uint64_t count;
+  memcpy(&count, buffer, sizeof(count));
+  if (count != n) {
+    fprintf(stderr, "the compressed wavefield holds %zu values, not %zu\n",
+            (size_t)count, n);
+    exit(EXIT_FAILURE);
+  }
+  size_t blocks = (n + BFP_BLOCK - 1) / BFP_BLOCK;
+  size_t chunks = (blocks + BFP_CHUNK_BLOCKS - 1) / BFP_CHUNK_BLOCKS;
+  const int8_t *exponents = (const int8_t *)(buffer + sizeof(uint64_t));
+  const uint8_t *bits = (const uint8_t *)(exponents + blocks);
+  const char *data = buffer + GetHeaderSize(blocks);
+  bool avx2 = UseAVX2();
+  // The offsets of the chunks are summed from the bits of their blocks.
+  std::vector<size_t> offsets(chunks + 1);
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    size_t first = chunk * BFP_CHUNK_BLOCKS;
+    size_t last = std::min(blocks, first + BFP_CHUNK_BLOCKS);
+    size_t bytes = 0;
+    for (size_t block = first; block < last; block++) {
+      size_t start = block * BFP_BLOCK;
+      bytes += std::min((size_t)BFP_BLOCK, n - start) * bits[block] / 8;
+    }
+    offsets[chunk + 1] = bytes;
+  }
+  SumOffsets(offsets);
+#pragma omp parallel for schedule(static)
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    size_t first = chunk * BFP_CHUNK_BLOCKS;
+    size_t last = std::min(blocks, first + BFP_CHUNK_BLOCKS);
+    if (avx2) {
+      DecompressChunkAVX2(array, n, first, last, exponents, bits,
+                          data + offsets[chunk]);
+    } else {
+      DecompressChunk(array, n, first, last, exponents, bits,
+                      data + offsets[chunk]);
+    }
+  }
+  return GetHeaderSize(blocks) + offsets[chunks];
+}
+
+size_t applyBFPOperation(float *array, size_t n, double tolerance,
+                         const char *filename, int decompress,
+                         bool zfp_is_relative) {
+  FILE *file = fopen(filename, decompress ? "rb" : "wb");
+  if (file == nullptr) {
+    fprintf(stderr, "could not open %s\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  char *buffer = (char *)malloc(getBFPMaxSize(n));
+  size_t size;
+  if (decompress) {
+    size = fread(buffer, 1, getBFPMaxSize(n), file);
+    decompressBFP(array, n, buffer);
+  } else {
+    size = compressBFP(array, n, tolerance, zfp_is_relative, buffer);
+    fwrite(buffer, 1, size, file);
+  }
+  free(buffer);
+  fclose(file);
+  return size;
+}
+} // namespace zfp
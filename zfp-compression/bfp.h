@@ -0,0 +1,57 @@
+#ifndef BFP_COMPRESS_H
+#define BFP_COMPRESS_H
+
+#include <cstddef>
+
+// The codec type of compression and decompression selecting the block floating
+// point codec, available with or without zfp.
+#define BFP_CODEC 3
+// The values sharing an exponent.
+#define BFP_BLOCK 64
+
+namespace zfp {
+/*!
+ * A block floating point codec built in the library, so that the wavefields
+ * can be compressed without zfp. The values are split in blocks of BFP_BLOCK
+ * consecutive values sharing the exponent of their largest magnitude, and
+ * stored as signed integers of 0, 8 or 16 bits : the bit planes below the
+ * tolerance are dropped, a block under it taking no bits at all.
+ *
+ * A compressed wavefield holds its number of values, the exponent and bits of
+ * each block, followed by the integers of the blocks.
+ */
+
+/*!
+ * @return
+ * The largest size of n values compressed by compressBFP.
+ */
+size_t getBFPMaxSize(size_t n);
+/*!
+ * Compresses the n values to the buffer, of getBFPMaxSize(n) bytes at least.
+ * @param tolerance
+ * The absolute error of the values, or their bits of precision when
+ * zfp_is_relative is set as with zfp_stream_set_precision. The error is at
+ * most 2^-16 of the largest value of a block, whatever the tolerance.
+ * @return
+ * The bytes of the compressed values.
+ */
+size_t compressBFP(const float *array, size_t n, double tolerance,
+                   bool zfp_is_relative, char *buffer);
+/*!
+ * Decompresses the n values compressed to the buffer.
+ * @return
+ * The bytes of the compressed values.
+ */
+size_t decompressBFP(float *array, size_t n, const char *buffer);
+/*!
+ * Compresses the values to a file, or decompresses them from it, as
+ * applyZFPOperation does.
+ * @return
+ * The bytes of the compressed values.
+ */
+size_t applyBFPOperation(float *array, size_t n, double tolerance,
+                         const char *filename, int decompress,
+                         bool zfp_is_relative);
+} // namespace zfp
+
+#endif
@@ -6,6 +6,14 @@ namespace zfp {
 
 void setPath(std::string path) { zfp::write_path = path; }
 
+bool isZFPAvailable() {
+#ifdef ZFP_COMPRESSION
+  return true;
+#else
+  return false;
+#endif
+}
+
 // Supporting function for creating compressed filename
 // concatenating the given model name and timestep
 char *getFileName(const char *model, unsigned int curTimestep) {
@@ -584,6 +592,13 @@ void compression(float *array, int nx, int ny, int nz, double tolerance,
   char *filename = getFileName(
       inputModel,
       curTimestep); // returns the file name where this time step is recorded
+  // The built in codec doesn't need zfp.
+  if (codecType == BFP_CODEC) {
+    *resultSize = applyBFPOperation(array, (size_t)nx * ny * nz, tolerance,
+                                    filename, 0, zfp_is_relative);
+    free(filename);
+    return;
+  }
 #ifdef ZFP_COMPRESSION
   switch (codecType) {
 
@@ -624,6 +639,12 @@ void decompression(float *array, int nx, int ny, int nz, double tolerance,
                    size_t *resultSize, const char *inputModel,
                    bool zfp_is_relative) {
   char *filename = getFileName(inputModel, curTimestep);
+  if (codecType == BFP_CODEC) {
+    *resultSize = applyBFPOperation(array, (size_t)nx * ny * nz, tolerance,
+                                    filename, 1, zfp_is_relative);
+    free(filename);
+    return;
+  }
 #ifdef ZFP_COMPRESSION
   switch (codecType) {
 
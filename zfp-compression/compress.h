@@ -1,6 +1,7 @@
 #ifndef COMPRESS_H
 #define COMPRESS_H
 
+#include "bfp.h"
 #include "omp.h"
 #include <cmath>
 #include <cstdio>
@@ -18,6 +19,9 @@
 
 namespace zfp {
 static std::string write_path = ".";
+// Whether zfp is part of the build, the codec types other than BFP_CODEC
+// storing the wavefields uncompressed otherwise.
+bool isZFPAvailable();
 // Supporting function for creating compressed filename
 // concatenating the given model name and timestep
 void setPath(std::string path);
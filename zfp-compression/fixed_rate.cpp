@@ -0,0 +1,150 @@
+#include "fixed_rate.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace zfp {
+
+#ifdef ZFP_COMPRESSION
+struct FixedRateCodec::Context {
+  zfp_stream *zfp;
+  zfp_field *field;
+};
+
+// Sets the field to the rows of a block, the wavefield is split in blocks of
+// MINBLOCKSIZE rows as in compressZFP_Parallel.
+static void SetBlockSize(zfp_field *field, int nx, int ny, int nz, int blocks,
+                         int block) {
+  int rows = (block < (blocks - 1)) ? MINBLOCKSIZE : nz % MINBLOCKSIZE;
+  if (rows == 0) {
+    rows = MINBLOCKSIZE;
+  }
+  if ((nx > 1) && (ny > 1) && (nz > 1)) {
+    zfp_field_set_size_3d(field, nx, ny, rows);
+  } else {
+    zfp_field_set_size_2d(field, nx, rows);
+  }
+}
+
+static void SetBlockField(zfp_field *field, float *array, int nx, int ny,
+                          int nz, int blocks, int block) {
+  SetBlockSize(field, nx, ny, nz, blocks, block);
+  zfp_field_set_pointer(field, &array[(size_t)block * MINBLOCKSIZE * ny * nx]);
+}
+#endif
+
+FixedRateCodec::FixedRateCodec(double rate) {
+  this->rate = rate;
+  this->nx = 0;
+  this->ny = 0;
+  this->nz = 0;
+}
+
+FixedRateCodec::~FixedRateCodec() {
+#ifdef ZFP_COMPRESSION
+  for (Context *context : contexts) {
+    zfp_field_free(context->field);
+    zfp_stream_close(context->zfp);
+    delete context;
+  }
+#endif
+}
+
+bool FixedRateCodec::IsAvailable() {
+#ifdef ZFP_COMPRESSION
+  return true;
+#else
+  return false;
+#endif
+}
+
+void FixedRateCodec::SetSize(int nx, int ny, int nz) {
+  if (nx == this->nx && ny == this->ny && nz == this->nz) {
+    return;
+  }
+  this->nx = nx;
+  this->ny = ny;
+  this->nz = nz;
+#ifdef ZFP_COMPRESSION
+  int threads = omp_get_max_threads();
+  while ((int)contexts.size() < threads) {
+    Context *context = new Context;
+    context->zfp = zfp_stream_open(NULL);
+    context->field = zfp_field_alloc();
+    zfp_field_set_type(context->field, zfp_type_float);
+    contexts.push_back(context);
+  }
+  // Each block takes the maximum size of its compressed stream, which is a
+  // whole number of words, so the blocks are written at fixed offsets.
+  int blocks = (nz + MINBLOCKSIZE - 1) / MINBLOCKSIZE;
+  int dims = ((nx > 1) && (ny > 1) && (nz > 1)) ? 3 : 2;
+  Context *context = contexts[0];
+  zfp_stream_set_rate(context->zfp, rate, zfp_type_float, dims, 0);
+  block_offsets.resize(blocks + 1);
+  block_offsets[0] = 0;
+  for (int block = 0; block < blocks; block++) {
+    SetBlockSize(context->field, nx, ny, nz, blocks, block);
+    block_offsets[block + 1] =
+        block_offsets[block] +
+        zfp_stream_maximum_size(context->zfp, context->field) * CHAR_BIT;
+  }
+#endif
+}
+
+size_t FixedRateCodec::GetSize(int nx, int ny, int nz) {
+  SetSize(nx, ny, nz);
+  if (block_offsets.empty()) {
+    return 0;
+  }
+  return block_offsets.back() / CHAR_BIT;
+}
+
+void FixedRateCodec::Compress(float *array, int nx, int ny, int nz,
+                              void *buffer) {
+  Apply(array, nx, ny, nz, buffer, false);
+}
+
+void FixedRateCodec::Decompress(float *array, int nx, int ny, int nz,
+                                const void *buffer) {
+  Apply(array, nx, ny, nz, (void *)buffer, true);
+}
+
+void FixedRateCodec::Apply(float *array, int nx, int ny, int nz,
+                           void *buffer, bool decompress) {
+#ifdef ZFP_COMPRESSION
+  size_t size = GetSize(nx, ny, nz);
+  int blocks = block_offsets.size() - 1;
+  int dims = ((nx > 1) && (ny > 1) && (nz > 1)) ? 3 : 2;
+  int threads = std::min(blocks, (int)contexts.size());
+#pragma omp parallel num_threads(threads)
+  {
+    int thread = omp_get_thread_num();
+    int first = (long)blocks * thread / threads;
+    int last = (long)blocks * (thread + 1) / threads;
+    Context &context = *contexts[thread];
+    zfp_stream_set_rate(context.zfp, rate, zfp_type_float, dims, 0);
+    bitstream *stream = stream_open(buffer, size);
+    zfp_stream_set_bit_stream(context.zfp, stream);
+    for (int block = first; block < last; block++) {
+      SetBlockField(context.field, array, nx, ny, nz, blocks, block);
+      if (decompress) {
+        stream_rseek(stream, block_offsets[block]);
+        if (!zfp_decompress(context.zfp, context.field)) {
+          fprintf(stderr, "decompression failed\n");
+        }
+      } else {
+        stream_wseek(stream, block_offsets[block]);
+        if (!zfp_compress(context.zfp, context.field)) {
+          fprintf(stderr, "compression failed\n");
+        }
+      }
+    }
+    zfp_stream_set_bit_stream(context.zfp, NULL);
+    stream_close(stream);
+  }
+#else
+  fprintf(stderr, "the fixed rate codec needs zfp\n");
+  exit(EXIT_FAILURE);
+#endif
+}
+} // namespace zfp
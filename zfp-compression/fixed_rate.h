@@ -0,0 +1,55 @@
+#ifndef FIXED_RATE_CODEC_H
+#define FIXED_RATE_CODEC_H
+
+#include "compress.h"
+
+#include <vector>
+
+namespace zfp {
+/*!
+ * Compresses wavefields in memory with the fixed rate mode of zfp, so that all
+ * the wavefields of a size take the same number of bytes, known before
+ * compressing them. The rows are split in blocks compressed by the threads
+ * at fixed offsets, and the zfp streams of the threads are kept from one call
+ * to the next.
+ */
+class FixedRateCodec {
+public:
+  /*!
+   * @param rate
+   * The bits of a compressed value.
+   */
+  explicit FixedRateCodec(double rate);
+  ~FixedRateCodec();
+  /*!
+   * @return
+   * Whether zfp is part of the build, the codec can't be used otherwise.
+   */
+  static bool IsAvailable();
+  /*!
+   * @return
+   * The bytes of a compressed wavefield of the given size.
+   */
+  size_t GetSize(int nx, int ny, int nz);
+  void Compress(float *array, int nx, int ny, int nz, void *buffer);
+  void Decompress(float *array, int nx, int ny, int nz, const void *buffer);
+
+private:
+  // The compression state of a thread, only defined with zfp.
+  struct Context;
+
+  double rate;
+  std::vector<Context *> contexts;
+  // The bit offsets of the blocks of the last wavefield size.
+  std::vector<size_t> block_offsets;
+  int nx;
+  int ny;
+  int nz;
+
+  void SetSize(int nx, int ny, int nz);
+  void Apply(float *array, int nx, int ny, int nz, void *buffer,
+             bool decompress);
+};
+} // namespace zfp
+
+#endif
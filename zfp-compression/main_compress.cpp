@@ -1,7 +1,9 @@
 //
 // Created by amr on 20/01/2020.
 //
+#include "archive.h"
 #include "compress.h"
+#include "fixed_rate.h"
 
 int main(int argc, char *argv[]) {
   uint nx = 5000;
@@ -44,4 +46,60 @@ int main(int argc, char *argv[]) {
     }
   }
   printf("Success : wrong nums are %d\n", wrong_counter);
+
+  // The archive appends the time steps to a single file and reads them back
+  // in reverse, as the backward propagation does.
+  uint steps = 4;
+  zfp::WavefieldArchive archive;
+  archive.Open(zfp::write_path + "/bp.zfp");
+  for (uint t = 0; t < steps; t++) {
+    for (uint i = 0; i < nx * nz * ny; i++) {
+      pressure[i] = sinf(0.001f * i + t);
+    }
+    archive.Append(pressure, nx, ny, nz, tolerance, 2, t, false);
+  }
+  wrong_counter = 0;
+  for (int t = steps - 1; t >= 0; t--) {
+    archive.Read(pressure_2, nx, ny, nz, tolerance, 2, t, false);
+    for (uint i = 0; i < nx * nz * ny; i++) {
+      if (fabs(sinf(0.001f * i + t) - pressure_2[i]) > tolerance) {
+        wrong_counter++;
+      }
+    }
+  }
+  archive.Close();
+  printf("Archive : wrong nums are %d\n", wrong_counter);
+
+  // The built in codec goes through the same interface as zfp.
+  zfp::compression(pressure, nx, ny, nz, tolerance, BFP_CODEC, 1, &result_size,
+                   "bp", false);
+  zfp::decompression(pressure_2, nx, ny, nz, tolerance, BFP_CODEC, 1,
+                     &result_size, "bp", false);
+  wrong_counter = 0;
+  for (uint i = 0; i < nx * nz * ny; i++) {
+    if (fabs(pressure[i] - pressure_2[i]) > tolerance) {
+      wrong_counter++;
+    }
+  }
+  printf("BFP : %zu bytes for %zu, wrong nums are %d\n", result_size,
+         (size_t)nx * ny * nz * sizeof(float), wrong_counter);
+
+  // The fixed rate codec compresses to a size known beforehand, checked at 16
+  // bits per value.
+  if (zfp::FixedRateCodec::IsAvailable()) {
+    zfp::FixedRateCodec codec(16);
+    size_t size = codec.GetSize(nx, ny, nz);
+    char *buffer = new char[size];
+    codec.Compress(pressure, nx, ny, nz, buffer);
+    codec.Decompress(pressure_2, nx, ny, nz, buffer);
+    wrong_counter = 0;
+    for (uint i = 0; i < nx * nz * ny; i++) {
+      if (fabs(pressure[i] - pressure_2[i]) > tolerance) {
+        wrong_counter++;
+      }
+    }
+    delete[] buffer;
+    printf("Fixed rate : %zu bytes for %zu, wrong nums are %d\n", size,
+           (size_t)nx * ny * nz * sizeof(float), wrong_counter);
+  }
 }